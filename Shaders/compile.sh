@@ -1,4 +1,5 @@
 glslc shader.vert -o vert.spv
+glslc shader_quantized.vert -o quantized_vert.spv
 glslc shader.frag -o frag.spv
 
 $SHELL
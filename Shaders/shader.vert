@@ -5,9 +5,10 @@ layout(binding = 0) uniform UniformBufferObject {
 	mat4 proj;
 } ubo;
 
-layout(push_constant, std430) uniform pc {
-    mat4 transform;
-};
+//one model transform per instance, draws of shared geometry read consecutive entries
+layout(std430, binding = 3) readonly buffer InstanceBuffer {
+	mat4 transforms[];
+} instances;
 
 layout(location = 0) in vec3 inPosition;
 layout(location = 1) in vec3 inColor;
@@ -17,7 +18,7 @@ layout(location = 0) out vec3 fragColor;
 layout(location = 1) out vec2 fragTexCoord;
 
 void main() {
-	gl_Position = ubo.proj * ubo.view * transform * vec4(inPosition, 1.0);
+	gl_Position = ubo.proj * ubo.view * instances.transforms[gl_InstanceIndex] * vec4(inPosition, 1.0);
 	fragColor = inColor;
 	fragTexCoord = inTexCoord;
 }
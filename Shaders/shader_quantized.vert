@@ -0,0 +1,24 @@
+#version 450
+
+layout(binding = 0) uniform UniformBufferObject {
+	mat4 view;
+	mat4 proj;
+} ubo;
+
+//transforms already hold the scale and offset that undo position quantization
+layout(std430, binding = 3) readonly buffer InstanceBuffer {
+	mat4 transforms[];
+} instances;
+
+//R16G16B16A16_UNORM position inside the mesh bounds and R16G16_SFLOAT texture coordinates
+layout(location = 0) in vec4 inPosition;
+layout(location = 2) in vec2 inTexCoord;
+
+layout(location = 0) out vec3 fragColor;
+layout(location = 1) out vec2 fragTexCoord;
+
+void main() {
+	gl_Position = ubo.proj * ubo.view * instances.transforms[gl_InstanceIndex] * vec4(inPosition.xyz, 1.0);
+	fragColor = vec3(1.0);
+	fragTexCoord = inTexCoord;
+}
@@ -3,6 +3,9 @@
 #include "Graphics/Rend.hpp"
 #include "Graphics/Vertex.hpp"
 #include "Resources/Loader.hpp"
+#include "Resources/AssetCache.hpp"
+#include "Resources/AssetServer.hpp"
+#include "Resources/StaticBatcher.hpp"
 #include "Input/Input.hpp"
 #include "Physics/Phys.hpp"
 
@@ -50,21 +53,35 @@ App::App(std::string projectDirectory) {
 
 	std::string modelPath = "/home/vi/Documents/Game-Engines/Skadi-Engine/Models/Scene.glb";
 	Loader loader;
-	auto [meshes, materials] = loader.loadModels(modelPath);
-
-	for (Material material : materials) {
-		rend.registerMaterial(material);
-	}
+	AssetCache assetCache(std::filesystem::path(modelPath).parent_path() / ".skadi_cache", loader);
 
 	Scene scene(10);
+	scene.enter(rend);
 
-	SparseSet<Mesh>* meshComponents = scene.componentManager.getComponents<Mesh>();
-	for (auto& mesh : meshes) {
-		Entity box = scene.entityManager.allocEntity();
-		meshComponents->add(box, mesh);
-	}
+	//the scene streams in while the loop runs, meshes are registered when the model arrives
+	std::vector<Mesh> meshes;
+	AssetServer assetServer(assetCache, 512ull * 1024 * 1024);
 
-	scene.enter(rend);
+	//the scene model is static environment art, meshes sharing a material are merged into one entity and one draw
+	bool batchStaticMeshes = true;
+
+	AssetHandle sceneModel = assetServer.request(modelPath, 0.0f, [&rend, &scene, &meshes, batchStaticMeshes](AssetHandle handle) {
+		const auto &[importedMeshes, materials] = handle.get();
+		std::vector<Mesh> loadedMeshes = batchStaticMeshes ? StaticBatcher::batch(importedMeshes) : importedMeshes;
+
+		for (Material material : materials) {
+			rend.registerMaterial(material);
+		}
+
+		SparseSet<Mesh>* meshComponents = scene.componentManager.getComponents<Mesh>();
+		for (const Mesh &mesh : loadedMeshes) {
+			Entity box = scene.entityManager.allocEntity();
+			meshComponents->add(box, mesh);
+			rend.renderMesh(mesh);
+		}
+
+		meshes.insert(meshes.end(), loadedMeshes.begin(), loadedMeshes.end());
+	});
 
 	end = std::chrono::steady_clock::now();
 	auto elapsed_millis = std::chrono::duration_cast<std::chrono::duration<float,std::milli>>(end-start);
@@ -98,6 +115,8 @@ App::App(std::string projectDirectory) {
 	while (true) {
 		auto start = std::chrono::steady_clock::now();
 
+		assetServer.update();
+
 		Vector2 planeAxis = input.getKeyAxis("Left", "Right", "Forward", "Backward");
 		int vertAxis = input.getKeyAxis("Down","Up");
 		int rotAxis = -input.getKeyAxis("RotLeft", "RotRight");
@@ -107,7 +126,7 @@ App::App(std::string projectDirectory) {
 		camMat = translate(camMat, moveDir.glm() * flyspeed);
 		camMat = rotate(camMat, rotAxis * turnspeed, glm::vec3(0,1,0));
 
-		if (flip) {
+		if (flip && !meshes.empty()) {
 			rend.updateMeshTransform(meshes[0].id, camMat);
 		}
 		else {
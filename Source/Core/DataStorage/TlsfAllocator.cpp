@@ -0,0 +1,223 @@
+#include "TlsfAllocator.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <stdexcept>
+
+TlsfAllocator::TlsfAllocator(uint64_t capacity) {
+	for (auto &heads : freeHeads) heads.fill(NONE);
+	grow(capacity);
+}
+
+///sizes below SECOND_LEVEL_COUNT get one list each, larger ones split every power of two into SECOND_LEVEL_COUNT lists
+void TlsfAllocator::mapping(uint64_t size, uint32_t &firstLevel, uint32_t &secondLevel) {
+	if (size < SECOND_LEVEL_COUNT) {
+		firstLevel = 0;
+		secondLevel = static_cast<uint32_t>(size);
+		return;
+	}
+
+	uint32_t highBit = std::bit_width(size) - 1;
+	firstLevel = highBit - SECOND_LEVEL_BITS + 1;
+	secondLevel = static_cast<uint32_t>(size >> (highBit - SECOND_LEVEL_BITS)) & (SECOND_LEVEL_COUNT - 1);
+}
+
+///first block of the first list whose sizes are all at least size
+///when there is none the list size itself falls in is searched, a block there may still be large enough
+uint32_t TlsfAllocator::findFreeBlock(uint64_t size) const {
+	//rounding up to the next list start means any block in the found list fits without walking it
+	uint64_t roundedSize = size;
+	if (size >= SECOND_LEVEL_COUNT) {
+		uint64_t listStep = (uint64_t{1} << (std::bit_width(size) - 1 - SECOND_LEVEL_BITS)) - 1;
+		roundedSize += listStep;
+	}
+
+	uint32_t firstLevel, secondLevel;
+	mapping(roundedSize, firstLevel, secondLevel);
+	uint32_t block = firstLevel < FIRST_LEVEL_COUNT ? findFreeList(firstLevel, secondLevel) : NONE;
+	if (block != NONE) return block;
+
+	mapping(size, firstLevel, secondLevel);
+	for (block = freeHeads[firstLevel][secondLevel]; block != NONE; block = blocks[block].nextFree) {
+		if (blocks[block].size >= size) return block;
+	}
+
+	return NONE;
+}
+
+///head of the first non empty list at or after secondLevel of firstLevel, then of any larger first level
+uint32_t TlsfAllocator::findFreeList(uint32_t firstLevel, uint32_t secondLevel) const {
+	uint32_t secondLevelMap = secondLevelBitmaps[firstLevel] & (~0u << secondLevel);
+	if (!secondLevelMap) {
+		uint64_t firstLevelMap = firstLevel + 1 < FIRST_LEVEL_COUNT ? firstLevelBitmap & (~uint64_t{0} << (firstLevel + 1)) : 0;
+		if (!firstLevelMap) return NONE;
+
+		firstLevel = std::countr_zero(firstLevelMap);
+		secondLevelMap = secondLevelBitmaps[firstLevel];
+	}
+
+	return freeHeads[firstLevel][std::countr_zero(secondLevelMap)];
+}
+
+uint32_t TlsfAllocator::newBlock(uint64_t offset, uint64_t size) {
+	uint32_t index;
+	if (!unusedBlocks.empty()) {
+		index = unusedBlocks.back();
+		unusedBlocks.pop_back();
+		blocks[index] = Block{};
+	}
+	else {
+		index = blocks.size();
+		blocks.emplace_back();
+	}
+
+	blocks[index].offset = offset;
+	blocks[index].size = size;
+	blocks[index].live = true;
+	return index;
+}
+
+void TlsfAllocator::insertFree(uint32_t block) {
+	uint32_t firstLevel, secondLevel;
+	mapping(blocks[block].size, firstLevel, secondLevel);
+
+	uint32_t head = freeHeads[firstLevel][secondLevel];
+	blocks[block].free = true;
+	blocks[block].prevFree = NONE;
+	blocks[block].nextFree = head;
+	if (head != NONE) blocks[head].prevFree = block;
+
+	freeHeads[firstLevel][secondLevel] = block;
+	secondLevelBitmaps[firstLevel] |= 1u << secondLevel;
+	firstLevelBitmap |= uint64_t{1} << firstLevel;
+}
+
+void TlsfAllocator::removeFree(uint32_t block) {
+	uint32_t firstLevel, secondLevel;
+	mapping(blocks[block].size, firstLevel, secondLevel);
+
+	Block &removed = blocks[block];
+	if (removed.prevFree != NONE) blocks[removed.prevFree].nextFree = removed.nextFree;
+	else freeHeads[firstLevel][secondLevel] = removed.nextFree;
+	if (removed.nextFree != NONE) blocks[removed.nextFree].prevFree = removed.prevFree;
+
+	removed.free = false;
+	removed.prevFree = NONE;
+	removed.nextFree = NONE;
+
+	if (freeHeads[firstLevel][secondLevel] == NONE) {
+		secondLevelBitmaps[firstLevel] &= ~(1u << secondLevel);
+		if (!secondLevelBitmaps[firstLevel]) firstLevelBitmap &= ~(uint64_t{1} << firstLevel);
+	}
+}
+
+void TlsfAllocator::absorb(uint32_t block, uint32_t other) {
+	blocks[block].size += blocks[other].size;
+	blocks[block].nextPhysical = blocks[other].nextPhysical;
+	if (blocks[other].nextPhysical != NONE) blocks[blocks[other].nextPhysical].prevPhysical = block;
+	if (lastPhysical == other) lastPhysical = block;
+
+	blocks[other].live = false;
+	unusedBlocks.push_back(other);
+}
+
+uint32_t TlsfAllocator::split(uint32_t block, uint64_t size) {
+	uint32_t rest = newBlock(blocks[block].offset + size, blocks[block].size - size);
+	blocks[rest].prevPhysical = block;
+	blocks[rest].nextPhysical = blocks[block].nextPhysical;
+	if (blocks[block].nextPhysical != NONE) blocks[blocks[block].nextPhysical].prevPhysical = rest;
+	blocks[block].nextPhysical = rest;
+	blocks[block].size = size;
+	if (lastPhysical == block) lastPhysical = rest;
+
+	return rest;
+}
+
+std::optional<TlsfAllocator::Allocation> TlsfAllocator::allocate(uint64_t size, uint64_t alignment) {
+	size = std::max<uint64_t>(size, 1);
+	alignment = std::max<uint64_t>(alignment, 1);
+
+	//any block this large has an aligned start with size units behind it
+	uint32_t block = findFreeBlock(size + alignment - 1);
+	if (block == NONE) return std::nullopt;
+
+	removeFree(block);
+
+	//the units in front of the aligned start go back as a free block of their own
+	uint64_t padding = ((blocks[block].offset + alignment - 1) & ~(alignment - 1)) - blocks[block].offset;
+	if (padding) {
+		uint32_t aligned = split(block, padding);
+		insertFree(block);
+		block = aligned;
+	}
+
+	//the rest of the block goes back as a free block right behind the allocation
+	if (blocks[block].size > size) {
+		insertFree(split(block, size));
+	}
+
+	usedUnits += size;
+	allocationCount++;
+	return Allocation{blocks[block].offset, size, block};
+}
+
+void TlsfAllocator::free(const Allocation &allocation) {
+	uint32_t block = allocation.block;
+	if (block >= blocks.size() || !blocks[block].live || blocks[block].free || blocks[block].offset != allocation.offset || blocks[block].size != allocation.size) {
+		throw std::runtime_error("Freeing a TLSF allocation that is not live");
+	}
+
+	usedUnits -= allocation.size;
+	allocationCount--;
+
+	uint32_t next = blocks[block].nextPhysical;
+	if (next != NONE && blocks[next].free) {
+		removeFree(next);
+		absorb(block, next);
+	}
+
+	uint32_t prev = blocks[block].prevPhysical;
+	if (prev != NONE && blocks[prev].free) {
+		removeFree(prev);
+		absorb(prev, block);
+		block = prev;
+	}
+
+	insertFree(block);
+}
+
+void TlsfAllocator::grow(uint64_t newCapacity) {
+	if (newCapacity <= totalCapacity) return;
+
+	uint64_t added = newCapacity - totalCapacity;
+
+	if (lastPhysical != NONE && blocks[lastPhysical].free) {
+		removeFree(lastPhysical);
+		blocks[lastPhysical].size += added;
+		insertFree(lastPhysical);
+	}
+	else {
+		uint32_t block = newBlock(totalCapacity, added);
+		blocks[block].prevPhysical = lastPhysical;
+		if (lastPhysical != NONE) blocks[lastPhysical].nextPhysical = block;
+		lastPhysical = block;
+		insertFree(block);
+	}
+
+	totalCapacity = newCapacity;
+}
+
+TlsfAllocator::Stats TlsfAllocator::getStats() const {
+	Stats stats{};
+	stats.capacity = totalCapacity;
+	stats.used = usedUnits;
+	stats.allocations = allocationCount;
+
+	for (const Block &block : blocks) {
+		if (!block.live || !block.free) continue;
+		stats.freeBlocks++;
+		stats.largestFree = std::max(stats.largestFree, block.size);
+	}
+
+	return stats;
+}
@@ -0,0 +1,84 @@
+#ifndef TLSFALLOCATOR_HPP
+#define TLSFALLOCATOR_HPP
+
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+///Two level segregated fit sub-allocator over a range of units, allocate and free are O(1) and neighbours merge on free
+///It only hands out offsets, what a unit is (a byte, a vertex, four bytes of indices) is up to the owner
+class TlsfAllocator {
+public:
+	struct Allocation {
+		uint64_t offset;
+		uint64_t size;
+		///internal block handle, free needs it back
+		uint32_t block;
+	};
+
+	struct Stats {
+		uint64_t capacity;
+		uint64_t used;
+		uint64_t largestFree;
+		uint32_t allocations;
+		uint32_t freeBlocks;
+	};
+
+	explicit TlsfAllocator(uint64_t capacity = 0);
+
+	///nullopt when no free block is large enough, grow and try again
+	///alignment is a power of two, the units skipped to reach it stay free
+	std::optional<Allocation> allocate(uint64_t size, uint64_t alignment = 1);
+	///throws std::runtime_error for an allocation that is not live
+	void free(const Allocation &allocation);
+	///extends the range, existing allocations keep their offsets
+	void grow(uint64_t newCapacity);
+
+	uint64_t capacity() const { return totalCapacity; }
+	uint64_t used() const { return usedUnits; }
+	Stats getStats() const;
+
+private:
+	static constexpr uint32_t SECOND_LEVEL_BITS = 4;
+	static constexpr uint32_t SECOND_LEVEL_COUNT = 1u << SECOND_LEVEL_BITS;
+	static constexpr uint32_t FIRST_LEVEL_COUNT = 64;
+	static constexpr uint32_t NONE = UINT32_MAX;
+
+	struct Block {
+		uint64_t offset;
+		uint64_t size;
+		uint32_t prevPhysical = NONE;
+		uint32_t nextPhysical = NONE;
+		uint32_t prevFree = NONE;
+		uint32_t nextFree = NONE;
+		bool free = false;
+		///false once the block merged into a neighbour and its slot waits in unusedBlocks
+		bool live = false;
+	};
+
+	uint64_t totalCapacity = 0;
+	uint64_t usedUnits = 0;
+	uint32_t allocationCount = 0;
+
+	std::vector<Block> blocks;
+	std::vector<uint32_t> unusedBlocks;
+	uint32_t lastPhysical = NONE;
+
+	uint64_t firstLevelBitmap = 0;
+	std::array<uint32_t, FIRST_LEVEL_COUNT> secondLevelBitmaps{};
+	std::array<std::array<uint32_t, SECOND_LEVEL_COUNT>, FIRST_LEVEL_COUNT> freeHeads;
+
+	static void mapping(uint64_t size, uint32_t &firstLevel, uint32_t &secondLevel);
+	uint32_t findFreeBlock(uint64_t size) const;
+	uint32_t findFreeList(uint32_t firstLevel, uint32_t secondLevel) const;
+	uint32_t newBlock(uint64_t offset, uint64_t size);
+	///shrinks block to size and returns a new block for the rest, physically right behind it
+	uint32_t split(uint32_t block, uint64_t size);
+	void insertFree(uint32_t block);
+	void removeFree(uint32_t block);
+	///merges other, the physical successor of block, into block
+	void absorb(uint32_t block, uint32_t other);
+};
+
+#endif //TLSFALLOCATOR_HPP
@@ -0,0 +1,135 @@
+#ifndef THREADPOOL_HPP
+#define THREADPOOL_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+///Fixed set of worker threads that run queued jobs in submission order
+class ThreadPool {
+public:
+	explicit ThreadPool(uint32_t threadCount = std::max(1u, std::thread::hardware_concurrency())) {
+		threadCount = std::max(1u, threadCount);
+		workers.reserve(threadCount);
+
+		for (uint32_t i = 0; i < threadCount; i++) {
+			workers.emplace_back(&ThreadPool::workerLoop, this);
+		}
+	}
+
+	ThreadPool(const ThreadPool &) = delete;
+	ThreadPool &operator=(const ThreadPool &) = delete;
+
+	~ThreadPool() {
+		{
+			std::lock_guard lock(jobMutex);
+			stopping = true;
+		}
+		jobCondition.notify_all();
+
+		for (std::thread &worker : workers) {
+			worker.join();
+		}
+	}
+
+	///number of worker threads
+	uint32_t size() const {
+		return workers.size();
+	}
+
+	///queue a job and get a future for its result, exceptions thrown by the job are rethrown by future.get()
+	template <typename F>
+	std::future<std::invoke_result_t<F>> submit(F &&job) {
+		using Result = std::invoke_result_t<F>;
+
+		auto task = std::make_shared<std::packaged_task<Result()>>(std::forward<F>(job));
+		std::future<Result> result = task->get_future();
+
+		{
+			std::lock_guard lock(jobMutex);
+			jobs.emplace([task] { (*task)(); });
+		}
+		jobCondition.notify_one();
+
+		return result;
+	}
+
+	///run job(i) for every i in [0, count) across the workers and the calling thread, blocks until every index is done
+	///Do not call from inside a pool job, the caller waits on helper jobs that may be queued behind it
+	template <typename F>
+	void parallelFor(uint32_t count, F &&job) {
+		if (count == 0) return;
+
+		auto next = std::make_shared<std::atomic<uint32_t>>(0);
+		auto run = [next, count, &job] {
+			for (uint32_t i = next->fetch_add(1); i < count; i = next->fetch_add(1)) {
+				job(i);
+			}
+		};
+
+		uint32_t helperCount = std::min<uint32_t>(size(), count - 1);
+		std::vector<std::future<void>> helpers;
+		helpers.reserve(helperCount);
+
+		for (uint32_t i = 0; i < helperCount; i++) {
+			helpers.push_back(submit(run));
+		}
+
+		//helpers reference job, so every helper has to finish before an exception can leave this frame
+		std::exception_ptr error;
+		try {
+			run();
+		} catch (...) {
+			error = std::current_exception();
+			next->store(count);
+		}
+
+		for (auto &helper : helpers) {
+			try {
+				helper.get();
+			} catch (...) {
+				if (!error) error = std::current_exception();
+			}
+		}
+
+		if (error) std::rethrow_exception(error);
+	}
+
+private:
+	std::vector<std::thread> workers;
+	std::queue<std::function<void()>> jobs;
+
+	std::mutex jobMutex;
+	std::condition_variable jobCondition;
+	bool stopping = false;
+
+	void workerLoop() {
+		while (true) {
+			std::function<void()> job;
+
+			{
+				std::unique_lock lock(jobMutex);
+				jobCondition.wait(lock, [this] { return stopping || !jobs.empty(); });
+
+				if (stopping && jobs.empty()) return;
+
+				job = std::move(jobs.front());
+				jobs.pop();
+			}
+
+			job();
+		}
+	}
+};
+
+#endif //THREADPOOL_HPP
@@ -0,0 +1,262 @@
+#include "DeviceAllocator.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <iostream>
+#include <stdexcept>
+
+DeviceAllocator::DeviceAllocator(const VkDevice &device, VkPhysicalDevice physicalDevice) : device(device) {
+	vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memoryProperties);
+
+	VkPhysicalDeviceProperties properties;
+	vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+	bufferImageGranularity = properties.limits.bufferImageGranularity;
+
+	pools.resize(memoryProperties.memoryTypeCount * 2);
+	heapStats.resize(memoryProperties.memoryHeapCount);
+	for (uint32_t heap = 0; heap < memoryProperties.memoryHeapCount; heap++) {
+		heapStats[heap].heapSize = memoryProperties.memoryHeaps[heap].size;
+	}
+}
+
+///linear and optimal resources share a pool when the device lets them sit next to each other anyway
+uint32_t DeviceAllocator::poolIndex(uint32_t memoryType, Tiling tiling) const {
+	return memoryType * 2 + (tiling == Tiling::Optimal && bufferImageGranularity > 1 ? 1 : 0);
+}
+
+uint32_t DeviceAllocator::memoryTypeOf(uint32_t pool) const {
+	return pool / 2;
+}
+
+uint32_t DeviceAllocator::heapOf(uint32_t pool) const {
+	return memoryProperties.memoryTypes[memoryTypeOf(pool)].heapIndex;
+}
+
+bool DeviceAllocator::hostVisible(uint32_t memoryType) const {
+	return memoryProperties.memoryTypes[memoryType].propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT;
+}
+
+///VK_NULL_HANDLE when the heap is out of room, host visible memory comes back mapped
+VkDeviceMemory DeviceAllocator::allocateMemory(uint32_t memoryType, VkDeviceSize size, void **mapped) {
+	VkMemoryAllocateInfo allocInfo{};
+	allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+	allocInfo.allocationSize = size;
+	allocInfo.memoryTypeIndex = memoryType;
+
+	VkDeviceMemory memory;
+	if (vkAllocateMemory(device, &allocInfo, nullptr, &memory) != VK_SUCCESS) {
+		return VK_NULL_HANDLE;
+	}
+
+	*mapped = nullptr;
+	if (hostVisible(memoryType)) {
+		vkMapMemory(device, memory, 0, VK_WHOLE_SIZE, 0, mapped);
+	}
+
+	deviceMemoryObjects++;
+	heapStats[memoryProperties.memoryTypes[memoryType].heapIndex].reservedBytes += size;
+	return memory;
+}
+
+void DeviceAllocator::freeMemory(uint32_t memoryType, VkDeviceMemory memory, VkDeviceSize size) {
+	//freeing unmaps as well
+	vkFreeMemory(device, memory, nullptr);
+
+	deviceMemoryObjects--;
+	heapStats[memoryProperties.memoryTypes[memoryType].heapIndex].reservedBytes -= size;
+}
+
+std::optional<DeviceAllocation> DeviceAllocator::allocateFromPage(uint32_t pool, uint32_t page, const VkMemoryRequirements &requirements) {
+	Page &target = pools[pool].pages[page];
+	if (target.memory == VK_NULL_HANDLE) return std::nullopt;
+
+	std::optional<TlsfAllocator::Allocation> range = target.allocator.allocate(requirements.size, requirements.alignment);
+	if (!range) return std::nullopt;
+
+	DeviceAllocation allocation{};
+	allocation.memory = target.memory;
+	allocation.offset = range->offset;
+	allocation.size = range->size;
+	allocation.mapped = target.mapped ? target.mapped + range->offset : nullptr;
+	allocation.pool = pool;
+	allocation.page = page;
+	allocation.range = *range;
+
+	HeapStats &heap = heapStats[heapOf(pool)];
+	heap.usedBytes += range->size;
+	heap.allocations++;
+	return allocation;
+}
+
+///pages double in size up to PAGE_SIZE, small heaps get pages of an eighth of the heap at most
+uint32_t DeviceAllocator::addPage(uint32_t pool, VkDeviceSize minimumSize) {
+	Pool &target = pools[pool];
+	VkDeviceSize limit = std::min(PAGE_SIZE, heapStats[heapOf(pool)].heapSize / 8);
+	VkDeviceSize size = std::max(std::min(target.nextPageSize, limit), std::bit_ceil(minimumSize));
+
+	void *mapped = nullptr;
+	VkDeviceMemory memory = allocateMemory(memoryTypeOf(pool), size, &mapped);
+	//a nearly full heap may still have room for a smaller page
+	while (memory == VK_NULL_HANDLE && size / 2 >= minimumSize) {
+		size /= 2;
+		memory = allocateMemory(memoryTypeOf(pool), size, &mapped);
+	}
+	if (memory == VK_NULL_HANDLE) {
+		throw std::runtime_error("Failed to allocate a device memory page");
+	}
+
+	target.nextPageSize = std::min(size * 2, PAGE_SIZE);
+
+	auto slot = std::find_if(target.pages.begin(), target.pages.end(), [](const Page &page) { return page.memory == VK_NULL_HANDLE; });
+	if (slot == target.pages.end()) slot = target.pages.emplace(target.pages.end());
+
+	slot->memory = memory;
+	slot->mapped = static_cast<uint8_t *>(mapped);
+	slot->allocator = TlsfAllocator(size);
+
+	heapStats[heapOf(pool)].pages++;
+	return slot - target.pages.begin();
+}
+
+DeviceAllocation DeviceAllocator::allocate(const VkMemoryRequirements &requirements, VkMemoryPropertyFlags properties, Tiling tiling) {
+	std::lock_guard lock(mutex);
+
+	uint32_t memoryType = findMemoryTypeLocked(requirements.memoryTypeBits, properties);
+	uint32_t pool = poolIndex(memoryType, tiling);
+
+	VkDeviceSize dedicatedSize = tiling == Tiling::Optimal ? DEDICATED_IMAGE_SIZE : DEDICATED_BUFFER_SIZE;
+	if (requirements.size >= dedicatedSize) {
+		DeviceAllocation allocation{};
+		allocation.memory = allocateMemory(memoryType, requirements.size, &allocation.mapped);
+		if (allocation.memory == VK_NULL_HANDLE) {
+			throw std::runtime_error("Failed to allocate dedicated device memory");
+		}
+		allocation.size = requirements.size;
+		allocation.pool = pool;
+		allocation.page = DEDICATED;
+
+		HeapStats &heap = heapStats[heapOf(pool)];
+		heap.usedBytes += requirements.size;
+		heap.allocations++;
+		heap.dedicatedAllocations++;
+		return allocation;
+	}
+
+	for (uint32_t page = 0; page < pools[pool].pages.size(); page++) {
+		if (std::optional<DeviceAllocation> allocation = allocateFromPage(pool, page, requirements)) return *allocation;
+	}
+
+	//room for the worst case padding, so the new page always fits it
+	uint32_t page = addPage(pool, requirements.size + requirements.alignment);
+	return allocateFromPage(pool, page, requirements).value();
+}
+
+void DeviceAllocator::free(DeviceAllocation &allocation) {
+	if (allocation.memory == VK_NULL_HANDLE) return;
+
+	std::lock_guard lock(mutex);
+
+	HeapStats &heap = heapStats[heapOf(allocation.pool)];
+	heap.usedBytes -= allocation.size;
+	heap.allocations--;
+
+	if (allocation.page == DEDICATED) {
+		heap.dedicatedAllocations--;
+		freeMemory(memoryTypeOf(allocation.pool), allocation.memory, allocation.size);
+		allocation = DeviceAllocation{};
+		return;
+	}
+
+	Pool &pool = pools[allocation.pool];
+	Page &page = pool.pages[allocation.page];
+	page.allocator.free(allocation.range);
+
+	//an empty page goes back to the heap unless it is the pool's last one, which stays to absorb churn
+	bool otherPage = std::any_of(pool.pages.begin(), pool.pages.end(), [&page](const Page &other) { return &other != &page && other.memory != VK_NULL_HANDLE; });
+	if (page.allocator.used() == 0 && otherPage) {
+		freeMemory(memoryTypeOf(allocation.pool), page.memory, page.allocator.capacity());
+		page.memory = VK_NULL_HANDLE;
+		page.mapped = nullptr;
+		page.allocator = TlsfAllocator();
+		heap.pages--;
+	}
+
+	allocation = DeviceAllocation{};
+}
+
+std::optional<DeviceAllocation> DeviceAllocator::relocate(const DeviceAllocation &allocation, const VkMemoryRequirements &requirements) {
+	if (allocation.page == DEDICATED) return std::nullopt;
+
+	std::lock_guard lock(mutex);
+
+	Pool &pool = pools[allocation.pool];
+	auto usage = [](const Page &page) {
+		return static_cast<double>(page.allocator.used()) / static_cast<double>(page.allocator.capacity());
+	};
+
+	double sourceUsage = usage(pool.pages[allocation.page]);
+	if (sourceUsage >= SPARSE_PAGE_USAGE) return std::nullopt;
+
+	//fullest pages first, moving into a page sparser than the source would only shuffle the holes around
+	std::vector<uint32_t> targets;
+	for (uint32_t page = 0; page < pool.pages.size(); page++) {
+		if (page == allocation.page || pool.pages[page].memory == VK_NULL_HANDLE) continue;
+		if (usage(pool.pages[page]) >= sourceUsage) targets.push_back(page);
+	}
+	std::sort(targets.begin(), targets.end(), [&](uint32_t a, uint32_t b) { return usage(pool.pages[a]) > usage(pool.pages[b]); });
+
+	for (uint32_t page : targets) {
+		if (std::optional<DeviceAllocation> moved = allocateFromPage(allocation.pool, page, requirements)) return moved;
+	}
+
+	return std::nullopt;
+}
+
+uint32_t DeviceAllocator::findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties) {
+	std::lock_guard lock(mutex);
+	return findMemoryTypeLocked(typeFilter, properties);
+}
+
+///Returns the index of type of memory requested with typeFilter that has every requested property flag
+uint32_t DeviceAllocator::findMemoryTypeLocked(uint32_t typeFilter, VkMemoryPropertyFlags properties) {
+	uint64_t key = static_cast<uint64_t>(typeFilter) << 32 | properties;
+	auto cached = memoryTypeCache.find(key);
+	if (cached != memoryTypeCache.end()) return cached->second;
+
+	for (uint32_t i = 0; i < memoryProperties.memoryTypeCount; i++) {
+		if (typeFilter & (1 << i) && (memoryProperties.memoryTypes[i].propertyFlags & properties) == properties) {
+			memoryTypeCache.emplace(key, i);
+			return i;
+		}
+	}
+
+	throw std::runtime_error("Failed to find suitable memory type");
+}
+
+DeviceAllocator::Stats DeviceAllocator::getStats() const {
+	std::lock_guard lock(mutex);
+
+	Stats stats{};
+	stats.heaps = heapStats;
+	stats.deviceMemoryObjects = deviceMemoryObjects;
+	return stats;
+}
+
+void DeviceAllocator::cleanup() {
+	std::lock_guard lock(mutex);
+
+	uint32_t leaked = 0;
+	for (HeapStats &heap : heapStats) leaked += heap.allocations;
+	if (leaked) {
+		std::cout << "SKADI: " << leaked << " device allocations still live at cleanup" << "\n";
+	}
+
+	for (uint32_t pool = 0; pool < pools.size(); pool++) {
+		for (Page &page : pools[pool].pages) {
+			if (page.memory == VK_NULL_HANDLE) continue;
+			freeMemory(memoryTypeOf(pool), page.memory, page.allocator.capacity());
+			heapStats[heapOf(pool)].pages--;
+		}
+		pools[pool].pages.clear();
+	}
+}
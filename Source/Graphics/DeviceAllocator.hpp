@@ -0,0 +1,117 @@
+#ifndef DEVICEALLOCATOR_HPP
+#define DEVICEALLOCATOR_HPP
+
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+#include <vulkan/vulkan.h>
+
+#include "Source/Core/DataStorage/TlsfAllocator.hpp"
+
+///A range of device memory a buffer or image is bound to, either part of a shared page or a dedicated allocation
+struct DeviceAllocation {
+	VkDeviceMemory memory = VK_NULL_HANDLE;
+	VkDeviceSize offset = 0;
+	VkDeviceSize size = 0;
+	///points at offset when the memory is host visible, pages stay mapped for their whole life so never map them again
+	void *mapped = nullptr;
+
+	//where it came from, the allocator needs them back on free
+	uint32_t pool = 0;
+	uint32_t page = 0;
+	TlsfAllocator::Allocation range{};
+};
+
+///Sub-allocates buffers and images from a few large pages per memory type instead of one vkAllocateMemory each
+///Pages are TLSF managed byte ranges, start small and double up to PAGE_SIZE, and are released again once empty
+///Resources too big to share a page get a dedicated allocation
+class DeviceAllocator {
+public:
+	///optimal tiling images must not share a bufferImageGranularity sized region with buffers and linear images
+	enum class Tiling {
+		Linear,
+		Optimal
+	};
+
+	struct HeapStats {
+		VkDeviceSize heapSize;
+		///bytes taken from the heap by pages and dedicated allocations
+		VkDeviceSize reservedBytes;
+		///bytes of that bound to resources
+		VkDeviceSize usedBytes;
+		uint32_t pages;
+		uint32_t allocations;
+		uint32_t dedicatedAllocations;
+	};
+
+	struct Stats {
+		std::vector<HeapStats> heaps;
+		///live VkDeviceMemory objects, the count maxMemoryAllocationCount limits
+		uint32_t deviceMemoryObjects;
+	};
+
+	DeviceAllocator(const VkDevice &device, VkPhysicalDevice physicalDevice);
+
+	///throws std::runtime_error when no memory type fits or the heap is out of memory
+	DeviceAllocation allocate(const VkMemoryRequirements &requirements, VkMemoryPropertyFlags properties, Tiling tiling);
+	void free(DeviceAllocation &allocation);
+
+	///a new place for the allocation in a fuller page of the same pool, nullopt unless its page is sparse enough to empty
+	///the caller copies the contents over and frees the old allocation, which releases the page once it is empty
+	std::optional<DeviceAllocation> relocate(const DeviceAllocation &allocation, const VkMemoryRequirements &requirements);
+
+	///memory properties are read once, each filter and property pair is searched for once
+	uint32_t findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties);
+
+	Stats getStats() const;
+	///frees every page, every resource must be destroyed by now
+	void cleanup();
+
+private:
+	static constexpr VkDeviceSize PAGE_SIZE = VkDeviceSize{64} << 20;
+	static constexpr VkDeviceSize FIRST_PAGE_SIZE = PAGE_SIZE / 8;
+	//dedicated from here, a resource this size would waste most of a page's room for others
+	static constexpr VkDeviceSize DEDICATED_BUFFER_SIZE = PAGE_SIZE / 2;
+	static constexpr VkDeviceSize DEDICATED_IMAGE_SIZE = PAGE_SIZE / 8;
+	//pages used less than this are emptied by relocate
+	static constexpr double SPARSE_PAGE_USAGE = 0.25;
+	static constexpr uint32_t DEDICATED = UINT32_MAX;
+
+	struct Page {
+		VkDeviceMemory memory = VK_NULL_HANDLE;
+		uint8_t *mapped = nullptr;
+		TlsfAllocator allocator;
+	};
+
+	///one per memory type and tiling, page slots of released pages are reused
+	struct Pool {
+		std::vector<Page> pages;
+		VkDeviceSize nextPageSize = FIRST_PAGE_SIZE;
+	};
+
+	const VkDevice &device;
+	VkPhysicalDeviceMemoryProperties memoryProperties{};
+	VkDeviceSize bufferImageGranularity;
+
+	std::vector<Pool> pools;
+	std::vector<HeapStats> heapStats;
+	uint32_t deviceMemoryObjects = 0;
+	std::unordered_map<uint64_t, uint32_t> memoryTypeCache;
+
+	mutable std::mutex mutex;
+
+	uint32_t poolIndex(uint32_t memoryType, Tiling tiling) const;
+	uint32_t memoryTypeOf(uint32_t pool) const;
+	uint32_t heapOf(uint32_t pool) const;
+	bool hostVisible(uint32_t memoryType) const;
+
+	VkDeviceMemory allocateMemory(uint32_t memoryType, VkDeviceSize size, void **mapped);
+	void freeMemory(uint32_t memoryType, VkDeviceMemory memory, VkDeviceSize size);
+	std::optional<DeviceAllocation> allocateFromPage(uint32_t pool, uint32_t page, const VkMemoryRequirements &requirements);
+	uint32_t addPage(uint32_t pool, VkDeviceSize minimumSize);
+	uint32_t findMemoryTypeLocked(uint32_t typeFilter, VkMemoryPropertyFlags properties);
+};
+
+#endif //DEVICEALLOCATOR_HPP
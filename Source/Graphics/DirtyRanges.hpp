@@ -0,0 +1,54 @@
+#ifndef DIRTYRANGES_HPP
+#define DIRTYRANGES_HPP
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <vector>
+
+///Byte ranges of a buffer that changed, so an update copies what differs instead of the whole buffer
+namespace DirtyRanges {
+	struct Range {
+		uint64_t offset;
+		uint64_t size;
+	};
+
+	///sorts ranges and merges the ones that overlap, touch or lie at most gap bytes apart
+	///a small gap trades copying a few unchanged bytes for fewer copy regions
+	inline std::vector<Range> coalesce(std::vector<Range> ranges, uint64_t gap = 0) {
+		std::erase_if(ranges, [](const Range &range) { return range.size == 0; });
+		std::sort(ranges.begin(), ranges.end(), [](const Range &a, const Range &b) { return a.offset < b.offset; });
+
+		std::vector<Range> merged;
+		for (const Range &range : ranges) {
+			if (!merged.empty() && range.offset <= merged.back().offset + merged.back().size + gap) {
+				Range &last = merged.back();
+				last.size = std::max(last.offset + last.size, range.offset + range.size) - last.offset;
+			}
+			else {
+				merged.push_back(range);
+			}
+		}
+
+		return merged;
+	}
+
+	///ranges of the elementSize blocks that differ between two buffers of the same size, coalesced
+	inline std::vector<Range> diff(std::span<const uint8_t> before, std::span<const uint8_t> after, uint64_t elementSize, uint64_t gap = 0) {
+		std::vector<Range> ranges;
+		uint64_t size = std::min(before.size(), after.size());
+
+		for (uint64_t offset = 0; offset < size; offset += elementSize) {
+			uint64_t length = std::min(elementSize, size - offset);
+			if (std::memcmp(before.data() + offset, after.data() + offset, length) == 0) continue;
+
+			if (!ranges.empty() && ranges.back().offset + ranges.back().size == offset) ranges.back().size += length;
+			else ranges.push_back({offset, length});
+		}
+
+		return coalesce(std::move(ranges), gap);
+	}
+}
+
+#endif //DIRTYRANGES_HPP
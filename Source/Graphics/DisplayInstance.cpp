@@ -7,7 +7,12 @@
 #include <set>
 #include <vulkan/vulkan_core.h>
 
-DisplayInstance::DisplayInstance() {
+DisplayInstance::DisplayInstance(bool headless) : headless(headless) {
+	if (headless) {
+		deviceExtensions.clear();
+		return;
+	}
+
 	glfwInit();
 }
 
@@ -22,6 +27,12 @@ void DisplayInstance::initDisplay(VkInstance &instance, uint32_t width, uint32_t
 	glfwSetCursorPosCallback(window, windowMouseMoveCallback);
 }
 
+void DisplayInstance::initHeadless(VkInstance &instance, uint32_t width, uint32_t height) {
+	windowWidth = width;
+	windowHeight = height;
+	pickPhysicalDevice(instance, VK_NULL_HANDLE);
+}
+
 GLFWwindow* DisplayInstance::createWindow(uint32_t width, uint32_t height, std::string title, GLFWframebuffersizefun framebufferResizeCallback) {
 	GLFWwindow* window;
 	glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);	
@@ -71,7 +82,8 @@ void DisplayInstance::pickPhysicalDevice(VkInstance instance, VkSurfaceKHR surfa
 			physicalDevice = device;
 			msaaSamples = getMaxUsableSampleCount(physicalDeviceProperties);
 			queueFamilyIndecies = findQueueFamilies(device, surface);
-			swapChainSupport = querySwapChainSupport(device, surface);
+			if (surface != VK_NULL_HANDLE)
+				swapChainSupport = querySwapChainSupport(device, surface);
 			break;
 		}
 	}
@@ -99,10 +111,20 @@ VkSampleCountFlagBits DisplayInstance::getMaxUsableSampleCount(VkPhysicalDeviceP
 }
 
 ///Checks physical device for required queue families, extension support, and swap chain adequacy 
+///Without a surface only a graphics queue is needed, software implementations like lavapipe qualify
+///Devices without BC texture sampling are skipped, imports default to BC7 and cooked packages keep their block format
 bool DisplayInstance::isDeviceSuitable(VkPhysicalDevice device, VkSurfaceKHR surface) {
 	QueueFamilyIndecies indecies = findQueueFamilies(device, surface);
 	bool extensionsSupported = checkDeviceExtensionSupport(device);
 
+	VkPhysicalDeviceFeatures features{};
+	vkGetPhysicalDeviceFeatures(device, &features);
+	if (!features.textureCompressionBC || !features.samplerAnisotropy)
+		return false;
+
+	if (surface == VK_NULL_HANDLE)
+		return indecies.graphicsFamily.has_value() && extensionsSupported;
+
 	bool swapChainAdequate = false;
 	if (extensionsSupported) {
 		SwapChainSupportDetails swapChainSupport = querySwapChainSupport(device, surface);
@@ -161,6 +183,7 @@ DisplayInstance::SwapChainSupportDetails DisplayInstance::querySwapChainSupport(
 
 ///Returns a QueueFamilyIndecies struct that contains the index of a graphics family and the inde of a present family 
 ///Notes: breaks early if a queue is found that supports both graphics and presentation 
+///Without a surface the present family stays empty and the first graphics family is taken
 DisplayInstance::QueueFamilyIndecies DisplayInstance::findQueueFamilies(VkPhysicalDevice device, VkSurfaceKHR surface) {
 	QueueFamilyIndecies indecies;
 
@@ -175,6 +198,14 @@ DisplayInstance::QueueFamilyIndecies DisplayInstance::findQueueFamilies(VkPhysic
 			indecies.graphicsFamily = i;
 		}
 
+		if (surface == VK_NULL_HANDLE) {
+			if (indecies.graphicsFamily.has_value())
+				break;
+
+			i++;
+			continue;
+		}
+
 		VkBool32 presentSupport = false;
 		vkGetPhysicalDeviceSurfaceSupportKHR(device, i, surface, &presentSupport);
 		
@@ -189,6 +220,14 @@ DisplayInstance::QueueFamilyIndecies DisplayInstance::findQueueFamilies(VkPhysic
 		i++;
 	}
 
+	for (uint32_t family = 0; family < queueFamilies.size(); family++) {
+		VkQueueFlags flags = queueFamilies[family].queueFlags;
+		if ((flags & VK_QUEUE_TRANSFER_BIT) && !(flags & (VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT))) {
+			indecies.transferFamily = family;
+			break;
+		}
+	}
+
 	return indecies;
 }
 
@@ -242,6 +281,8 @@ void DisplayInstance::windowMouseScrollCallback(GLFWwindow *window, double xoffs
 }
 
 void DisplayInstance::cleanup(VkInstance &instance) {
+	if (headless) return;
+
 	glfwDestroyWindow(window);
 	vkDestroySurfaceKHR(instance, surface, nullptr);	
 
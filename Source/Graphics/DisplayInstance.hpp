@@ -13,11 +13,14 @@
 
 class DisplayInstance {
 	public:
-		DisplayInstance();
+		///a headless instance never initializes GLFW, it has no window, surface or present queue
+		explicit DisplayInstance(bool headless = false);
 
 		struct QueueFamilyIndecies {
 			std::optional<uint32_t> graphicsFamily;
 			std::optional<uint32_t> presentFamily;
+			///a family that can transfer but not draw, usually a DMA engine that copies alongside rendering
+			std::optional<uint32_t> transferFamily;
 
 			bool isComplete() {
 				return graphicsFamily.has_value() && presentFamily.has_value();
@@ -30,8 +33,9 @@ class DisplayInstance {
 			std::vector<VkPresentModeKHR> presentModes;
 		};
 
-		GLFWwindow *window;
-		VkSurfaceKHR surface;
+		bool headless = false;
+		GLFWwindow *window = nullptr;
+		VkSurfaceKHR surface = VK_NULL_HANDLE;
 
 		VkPhysicalDevice physicalDevice = VK_NULL_HANDLE;
 		VkPhysicalDeviceProperties physicalDeviceProperties;
@@ -39,11 +43,13 @@ class DisplayInstance {
 		SwapChainSupportDetails swapChainSupport;
 		VkSampleCountFlagBits msaaSamples = VK_SAMPLE_COUNT_1_BIT;
 
-		bool windowResized;
+		bool windowResized = false;
 		uint32_t windowWidth;
 		uint32_t windowHeight;
 
 		void initDisplay(VkInstance &instance, uint32_t width, uint32_t height, std::string title);
+		///picks a device with a graphics queue and nothing to present to, for rendering into offscreen images
+		void initHeadless(VkInstance &instance, uint32_t width, uint32_t height);
 		GLFWwindow* createWindow(uint32_t width, uint32_t height, std::string title, GLFWframebuffersizefun framebufferResizeCallback);
 		VkSurfaceKHR createSurface(VkInstance &instance, GLFWwindow *window);
 
@@ -52,7 +58,8 @@ class DisplayInstance {
 		bool isDeviceSuitable(VkPhysicalDevice device, VkSurfaceKHR surface);
 		QueueFamilyIndecies findQueueFamilies(VkPhysicalDevice device, VkSurfaceKHR surface);
 		SwapChainSupportDetails querySwapChainSupport(VkPhysicalDevice device, VkSurfaceKHR surface);
-		const std::vector<const char *> deviceExtensions = { VK_KHR_SWAPCHAIN_EXTENSION_NAME };
+		///empty when headless, offscreen rendering needs no swapchain
+		std::vector<const char *> deviceExtensions = { VK_KHR_SWAPCHAIN_EXTENSION_NAME };
 		bool checkDeviceExtensionSupport(VkPhysicalDevice device);
 		VkSampleCountFlagBits getMaxUsableSampleCount(VkPhysicalDeviceProperties physicalDeviceProperties);
 		void cleanup(VkInstance &instance);
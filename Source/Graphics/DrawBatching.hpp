@@ -0,0 +1,146 @@
+#ifndef DRAWBATCHING_HPP
+#define DRAWBATCHING_HPP
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#include <glm/glm.hpp>
+#include <vulkan/vulkan.h>
+
+#include "Vertex.hpp"
+
+///64 bit draw order, most significant field first: pass, pipeline, material, index width, depth bucket, geometry
+///Sorting by it groups draws by the state they bind, then front to back, then by geometry so instances end up side by side
+namespace SortKey {
+	constexpr uint32_t PASS_BITS = 2;
+	constexpr uint32_t PIPELINE_BITS = 2;
+	constexpr uint32_t MATERIAL_BITS = 20;
+	constexpr uint32_t INDEX_TYPE_BITS = 1;
+	constexpr uint32_t DEPTH_BITS = 4;
+	constexpr uint32_t GEOMETRY_BITS = 35;
+
+	constexpr uint32_t GEOMETRY_SHIFT = 0;
+	constexpr uint32_t DEPTH_SHIFT = GEOMETRY_SHIFT + GEOMETRY_BITS;
+	constexpr uint32_t INDEX_TYPE_SHIFT = DEPTH_SHIFT + DEPTH_BITS;
+	constexpr uint32_t MATERIAL_SHIFT = INDEX_TYPE_SHIFT + INDEX_TYPE_BITS;
+	constexpr uint32_t PIPELINE_SHIFT = MATERIAL_SHIFT + MATERIAL_BITS;
+	constexpr uint32_t PASS_SHIFT = PIPELINE_SHIFT + PIPELINE_BITS;
+	static_assert(PASS_SHIFT + PASS_BITS == 64);
+
+	constexpr uint64_t field(uint64_t value, uint32_t bits, uint32_t shift) {
+		return (value & ((uint64_t{1} << bits) - 1)) << shift;
+	}
+
+	///each bucket covers twice the distance of the one before, from a quarter unit to a few thousand
+	///coarse on purpose, finer buckets would split instanced draws of the same geometry apart
+	inline uint32_t depthBucket(float viewDistance) {
+		if (!(viewDistance > 0.25f)) return 0;
+		return std::min<uint32_t>(static_cast<uint32_t>(std::log2(viewDistance * 4.0f)) + 1, (1u << DEPTH_BITS) - 1);
+	}
+
+	///geometry is any number telling apart different geometry, values beyond its bits only cost instancing, never correctness
+	constexpr uint64_t make(uint32_t pass, VertexLayout pipeline, uint32_t material, VkIndexType indexType, uint32_t depthBucket, uint64_t geometry) {
+		return field(pass, PASS_BITS, PASS_SHIFT)
+			| field(static_cast<uint32_t>(pipeline), PIPELINE_BITS, PIPELINE_SHIFT)
+			| field(material, MATERIAL_BITS, MATERIAL_SHIFT)
+			| field(indexType == VK_INDEX_TYPE_UINT32 ? 1 : 0, INDEX_TYPE_BITS, INDEX_TYPE_SHIFT)
+			| field(depthBucket, DEPTH_BITS, DEPTH_SHIFT)
+			| field(geometry, GEOMETRY_BITS, GEOMETRY_SHIFT);
+	}
+}
+
+///One visible range of a mesh with its transform, what used to be a draw call of its own
+struct DrawItem {
+	uint64_t sortKey;
+	VertexLayout layout;
+	VkDescriptorSet material;
+	VkIndexType indexType;
+	uint32_t firstIndex;
+	uint32_t indexCount;
+	int32_t vertexOffset;
+	glm::mat4 transform;
+};
+
+///Consecutive draws sharing pipeline, material and index width, recorded behind one set of binds
+struct DrawBatch {
+	VertexLayout layout;
+	VkDescriptorSet material;
+	VkIndexType indexType;
+	uint32_t firstDraw;
+	uint32_t drawCount;
+};
+
+///A frame's draw list, laid out the way the instance and indirect buffers take it
+struct InstancedDraws {
+	struct SortEntry {
+		uint64_t key;
+		uint32_t item;
+	};
+
+	///indexed by gl_InstanceIndex, the instances of a draw are consecutive from its firstInstance
+	std::vector<glm::mat4> transforms;
+	std::vector<VkDrawIndexedIndirectCommand> draws;
+	std::vector<DrawBatch> batches;
+
+	///item order by sort key, kept between frames along with the sort's scratch space
+	std::vector<SortEntry> order;
+	std::vector<SortEntry> scratch;
+};
+
+///Stable least significant digit radix sort, a byte per pass, passes where every key has the same byte are skipped
+inline void radixSort(std::vector<InstancedDraws::SortEntry> &entries, std::vector<InstancedDraws::SortEntry> &scratch) {
+	scratch.resize(entries.size());
+
+	for (uint32_t shift = 0; shift < 64; shift += 8) {
+		std::array<uint32_t, 256> counts{};
+		for (const InstancedDraws::SortEntry &entry : entries) counts[(entry.key >> shift) & 0xff]++;
+		if (std::find(counts.begin(), counts.end(), entries.size()) != counts.end()) continue;
+
+		uint32_t offset = 0;
+		for (uint32_t &count : counts) {
+			uint32_t start = offset;
+			offset += count;
+			count = start;
+		}
+
+		for (const InstancedDraws::SortEntry &entry : entries) scratch[counts[(entry.key >> shift) & 0xff]++] = entry;
+		entries.swap(scratch);
+	}
+}
+
+///Orders items by sort key and merges each run of the same geometry with the same state into one instanced draw
+inline void buildInstancedDraws(const std::vector<DrawItem> &items, InstancedDraws &out) {
+	out.transforms.clear();
+	out.draws.clear();
+	out.batches.clear();
+
+	out.order.resize(items.size());
+	for (uint32_t i = 0; i < items.size(); i++) out.order[i] = {items[i].sortKey, i};
+	radixSort(out.order, out.scratch);
+
+	const DrawItem *previous = nullptr;
+	for (const InstancedDraws::SortEntry &entry : out.order) {
+		const DrawItem &item = items[entry.item];
+		bool sameState = previous && previous->layout == item.layout && previous->material == item.material && previous->indexType == item.indexType;
+
+		if (!sameState) {
+			out.batches.push_back({item.layout, item.material, item.indexType, static_cast<uint32_t>(out.draws.size()), 0});
+		}
+
+		if (sameState && previous->vertexOffset == item.vertexOffset && previous->firstIndex == item.firstIndex && previous->indexCount == item.indexCount) {
+			out.draws.back().instanceCount++;
+		}
+		else {
+			out.draws.push_back({item.indexCount, 1, item.firstIndex, item.vertexOffset, static_cast<uint32_t>(out.transforms.size())});
+			out.batches.back().drawCount++;
+		}
+
+		out.transforms.push_back(item.transform);
+		previous = &item;
+	}
+}
+
+#endif //DRAWBATCHING_HPP
@@ -0,0 +1,105 @@
+#include "FrameCapture.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+
+namespace {
+	///next whitespace separated header token, comments run from # to the end of the line
+	std::string readToken(std::istream &file) {
+		std::string token;
+		char c;
+		while (file.get(c)) {
+			if (c == '#') {
+				std::string comment;
+				std::getline(file, comment);
+			}
+			else if (std::isspace(static_cast<unsigned char>(c))) {
+				if (!token.empty()) break;
+			}
+			else {
+				token += c;
+			}
+		}
+		return token;
+	}
+
+	uint32_t readNumber(std::istream &file, const std::filesystem::path &path) {
+		std::string token = readToken(file);
+		if (token.empty() || !std::all_of(token.begin(), token.end(), [](char c) { return c >= '0' && c <= '9'; }))
+			throw std::runtime_error("Malformed PPM header in " + path.string());
+
+		return std::strtoul(token.c_str(), nullptr, 10);
+	}
+}
+
+FrameCapture::Difference FrameCapture::compare(const FrameCapture &reference, uint8_t tolerance) const {
+	if (width != reference.width || height != reference.height || pixels.size() != reference.pixels.size())
+		throw std::runtime_error("Frame capture is " + std::to_string(width) + "x" + std::to_string(height) +
+			", reference is " + std::to_string(reference.width) + "x" + std::to_string(reference.height));
+
+	Difference difference{};
+	for (size_t pixel = 0; pixel + 4 <= pixels.size(); pixel += 4) {
+		bool differs = false;
+		for (size_t c = 0; c < 3; c++) {
+			uint8_t channelDifference = std::abs(pixels[pixel + c] - reference.pixels[pixel + c]);
+			difference.maxChannelDifference = std::max(difference.maxChannelDifference, channelDifference);
+			differs |= channelDifference > tolerance;
+		}
+		difference.differingPixels += differs;
+	}
+
+	return difference;
+}
+
+void FrameCapture::writePPM(const std::filesystem::path &path) const {
+	std::vector<uint8_t> rgb;
+	rgb.reserve(static_cast<size_t>(width) * height * 3);
+	for (size_t pixel = 0; pixel + 4 <= pixels.size(); pixel += 4) {
+		rgb.insert(rgb.end(), pixels.begin() + pixel, pixels.begin() + pixel + 3);
+	}
+
+	std::ofstream file(path, std::ios::binary | std::ios::trunc);
+	file << "P6\n" << width << " " << height << "\n255\n";
+	file.write(reinterpret_cast<const char *>(rgb.data()), rgb.size());
+
+	if (!file) {
+		throw std::runtime_error("Failed to write frame capture " + path.string());
+	}
+}
+
+FrameCapture FrameCapture::readPPM(const std::filesystem::path &path) {
+	std::ifstream file(path, std::ios::binary);
+	if (!file.is_open()) {
+		throw std::runtime_error("Failed to open frame capture " + path.string());
+	}
+
+	if (readToken(file) != "P6")
+		throw std::runtime_error(path.string() + " is not a binary PPM");
+
+	FrameCapture capture{};
+	capture.width = readNumber(file, path);
+	capture.height = readNumber(file, path);
+	if (readNumber(file, path) != 255)
+		throw std::runtime_error("Only 8 bit PPM captures are supported, " + path.string() + " is not one");
+
+	//the single whitespace after the max value was consumed with it, pixel data starts here
+	size_t pixelCount = static_cast<size_t>(capture.width) * capture.height;
+	std::vector<uint8_t> rgb(pixelCount * 3);
+	file.read(reinterpret_cast<char *>(rgb.data()), rgb.size());
+	if (file.gcount() != static_cast<std::streamsize>(rgb.size()))
+		throw std::runtime_error("Frame capture " + path.string() + " is truncated");
+
+	capture.pixels.resize(pixelCount * 4);
+	for (size_t pixel = 0; pixel < pixelCount; pixel++) {
+		capture.pixels[pixel * 4] = rgb[pixel * 3];
+		capture.pixels[pixel * 4 + 1] = rgb[pixel * 3 + 1];
+		capture.pixels[pixel * 4 + 2] = rgb[pixel * 3 + 2];
+		capture.pixels[pixel * 4 + 3] = 255;
+	}
+
+	return capture;
+}
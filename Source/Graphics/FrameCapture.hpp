@@ -0,0 +1,30 @@
+#ifndef FRAMECAPTURE_HPP
+#define FRAMECAPTURE_HPP
+
+#include <cstdint>
+#include <filesystem>
+#include <vector>
+
+///RGBA8 pixels of one rendered frame read back from a headless Rend, rows top to bottom
+///Captures are written and read as binary PPM so CI can keep reference images next to the tests
+struct FrameCapture {
+	uint32_t width = 0;
+	uint32_t height = 0;
+	std::vector<uint8_t> pixels;
+
+	struct Difference {
+		///pixels where any color channel differs by more than the tolerance
+		uint64_t differingPixels;
+		uint8_t maxChannelDifference;
+	};
+
+	///compares the color channels against a reference of the same size, alpha is ignored like it is on write
+	///throws std::runtime_error when the sizes differ
+	Difference compare(const FrameCapture &reference, uint8_t tolerance = 0) const;
+
+	///PPM has no alpha, it is dropped on write and read back as 255
+	void writePPM(const std::filesystem::path &path) const;
+	static FrameCapture readPPM(const std::filesystem::path &path);
+};
+
+#endif //FRAMECAPTURE_HPP
@@ -0,0 +1,46 @@
+#ifndef FRUSTUM_HPP
+#define FRUSTUM_HPP
+
+#include <array>
+#include <cmath>
+
+#include <glm/glm.hpp>
+
+///Six inward facing planes of a view volume, xyz is the unit normal and w the distance
+struct Frustum {
+	std::array<glm::vec4, 6> planes;
+
+	///planes of whatever space clip maps from, pass proj * view * model to test model space bounds directly
+	static Frustum fromMatrix(const glm::mat4 &clip) {
+		glm::vec4 row[4];
+		for (int i = 0; i < 4; i++) {
+			row[i] = glm::vec4(clip[0][i], clip[1][i], clip[2][i], clip[3][i]);
+		}
+
+		Frustum frustum{};
+		frustum.planes[0] = row[3] + row[0];
+		frustum.planes[1] = row[3] - row[0];
+		frustum.planes[2] = row[3] + row[1];
+		frustum.planes[3] = row[3] - row[1];
+		//the -w near plane is looser than the 0 to 1 depth one, so it is right for both conventions
+		frustum.planes[4] = row[3] + row[2];
+		frustum.planes[5] = row[3] - row[2];
+
+		for (glm::vec4 &plane : frustum.planes) {
+			float length = std::sqrt(plane.x * plane.x + plane.y * plane.y + plane.z * plane.z);
+			if (length > 0.0f) plane = plane / length;
+		}
+
+		return frustum;
+	}
+
+	///false only when the sphere is entirely outside one of the planes
+	bool intersectsSphere(const glm::vec3 &center, float radius) const {
+		for (const glm::vec4 &plane : planes) {
+			if (glm::dot(glm::vec3(plane), center) + plane.w < -radius) return false;
+		}
+		return true;
+	}
+};
+
+#endif //FRUSTUM_HPP
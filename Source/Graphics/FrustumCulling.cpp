@@ -0,0 +1,72 @@
+#include "FrustumCulling.hpp"
+
+#include <bit>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#define SKADI_CULLING_SSE
+#include <emmintrin.h>
+#endif
+
+#ifdef __AVX__
+#include <immintrin.h>
+#endif
+
+namespace {
+	///scalar test for spheres the wide loops leave over
+	void cullRange(const Frustum &frustum, const SphereBatch &spheres, uint32_t first, std::vector<uint32_t> &visible) {
+		for (uint32_t i = first; i < spheres.size(); i++) {
+			if (frustum.intersectsSphere(glm::vec3(spheres.x[i], spheres.y[i], spheres.z[i]), spheres.radius[i])) visible.push_back(i);
+		}
+	}
+
+	///one bit per visible lane, lowest lane first
+	void appendLanes(uint32_t first, uint32_t mask, std::vector<uint32_t> &visible) {
+		while (mask != 0) {
+			visible.push_back(first + std::countr_zero(mask));
+			mask &= mask - 1;
+		}
+	}
+}
+
+void FrustumCulling::cullSpheres(const Frustum &frustum, const SphereBatch &spheres, std::vector<uint32_t> &visible) {
+	uint32_t i = 0;
+
+#ifdef __AVX__
+	for (; i + 8 <= spheres.size(); i += 8) {
+		__m256 x = _mm256_loadu_ps(&spheres.x[i]);
+		__m256 y = _mm256_loadu_ps(&spheres.y[i]);
+		__m256 z = _mm256_loadu_ps(&spheres.z[i]);
+		__m256 negativeRadius = _mm256_sub_ps(_mm256_setzero_ps(), _mm256_loadu_ps(&spheres.radius[i]));
+
+		__m256 outside = _mm256_setzero_ps();
+		for (const glm::vec4 &plane : frustum.planes) {
+			//summed in the order of the scalar test, so both agree on spheres touching a plane
+			__m256 distance = _mm256_add_ps(_mm256_mul_ps(x, _mm256_set1_ps(plane.x)), _mm256_mul_ps(y, _mm256_set1_ps(plane.y)));
+			distance = _mm256_add_ps(_mm256_add_ps(distance, _mm256_mul_ps(z, _mm256_set1_ps(plane.z))), _mm256_set1_ps(plane.w));
+			outside = _mm256_or_ps(outside, _mm256_cmp_ps(distance, negativeRadius, _CMP_LT_OQ));
+		}
+
+		appendLanes(i, ~static_cast<uint32_t>(_mm256_movemask_ps(outside)) & 0xff, visible);
+	}
+#endif
+
+#ifdef SKADI_CULLING_SSE
+	for (; i + 4 <= spheres.size(); i += 4) {
+		__m128 x = _mm_loadu_ps(&spheres.x[i]);
+		__m128 y = _mm_loadu_ps(&spheres.y[i]);
+		__m128 z = _mm_loadu_ps(&spheres.z[i]);
+		__m128 negativeRadius = _mm_sub_ps(_mm_setzero_ps(), _mm_loadu_ps(&spheres.radius[i]));
+
+		__m128 outside = _mm_setzero_ps();
+		for (const glm::vec4 &plane : frustum.planes) {
+			__m128 distance = _mm_add_ps(_mm_mul_ps(x, _mm_set1_ps(plane.x)), _mm_mul_ps(y, _mm_set1_ps(plane.y)));
+			distance = _mm_add_ps(_mm_add_ps(distance, _mm_mul_ps(z, _mm_set1_ps(plane.z))), _mm_set1_ps(plane.w));
+			outside = _mm_or_ps(outside, _mm_cmplt_ps(distance, negativeRadius));
+		}
+
+		appendLanes(i, ~static_cast<uint32_t>(_mm_movemask_ps(outside)) & 0xf, visible);
+	}
+#endif
+
+	cullRange(frustum, spheres, i, visible);
+}
@@ -0,0 +1,47 @@
+#ifndef FRUSTUMCULLING_HPP
+#define FRUSTUMCULLING_HPP
+
+#include <cstdint>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "Frustum.hpp"
+#include "Source/Resources/Bounds.hpp"
+
+///Bounding spheres kept as one array per coordinate, so a frustum plane is tested against four or eight at once
+struct SphereBatch {
+	std::vector<float> x;
+	std::vector<float> y;
+	std::vector<float> z;
+	std::vector<float> radius;
+
+	uint32_t size() const { return x.size(); }
+
+	void clear() {
+		x.clear();
+		y.clear();
+		z.clear();
+		radius.clear();
+	}
+
+	void push_back(const glm::vec3 &center, float sphereRadius) {
+		x.push_back(center.x);
+		y.push_back(center.y);
+		z.push_back(center.z);
+		radius.push_back(sphereRadius);
+	}
+};
+
+namespace FrustumCulling {
+	///sphere around bounds after transform, the radius grows with the largest axis scale so it still covers the bounds
+	inline glm::vec4 worldSphere(const glm::mat4 &transform, const Bounds &bounds) {
+		return glm::vec4(glm::vec3(transform * glm::vec4(bounds.center, 1.0f)), bounds.radius * maxAxisScale(transform));
+	}
+
+	///appends the index of every sphere Frustum::intersectsSphere would accept to visible, in ascending order
+	///eight spheres per step with AVX, four with SSE2, one at a time without either
+	void cullSpheres(const Frustum &frustum, const SphereBatch &spheres, std::vector<uint32_t> &visible);
+}
+
+#endif //FRUSTUMCULLING_HPP
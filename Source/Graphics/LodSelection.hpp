@@ -0,0 +1,39 @@
+#ifndef LODSELECTION_HPP
+#define LODSELECTION_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+#include <glm/glm.hpp>
+
+#include "Source/Resources/Mesh.hpp"
+
+///Picks the coarsest level of detail whose error covers at most pixelThreshold pixels on screen
+inline uint32_t selectLod(const Mesh &mesh, const glm::mat4 &view, const glm::mat4 &proj, float viewportHeight, float pixelThreshold = 1.0f) {
+	if (mesh.lods.size() < 2) return 0;
+
+	//errors are in model units, the largest axis scale of the transform carries them to world units
+	const glm::mat4 &transform = mesh.transform;
+	float scale = maxAxisScale(transform);
+
+	float pixelsPerUnit = std::abs(proj[1][1]) * viewportHeight * 0.5f;
+
+	//perspective projections shrink with distance to the nearest point of the bounding sphere
+	if (proj[3][3] == 0.0f) {
+		glm::vec4 viewCenter = view * transform * glm::vec4(mesh.bounds.center, 1.0f);
+		float distance = std::sqrt(glm::dot(glm::vec3(viewCenter), glm::vec3(viewCenter))) - mesh.bounds.radius * scale;
+
+		if (distance <= 0.0f) return 0;
+		pixelsPerUnit /= distance;
+	}
+
+	for (uint32_t level = mesh.lods.size() - 1; level > 0; level--) {
+		if (mesh.lods[level].error * scale * pixelsPerUnit <= pixelThreshold)
+			return level;
+	}
+
+	return 0;
+}
+
+#endif //LODSELECTION_HPP
@@ -0,0 +1,400 @@
+#include "MeshArena.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+#include "DirtyRanges.hpp"
+#include "ResourceManager.hpp"
+#include "Source/Resources/ContentHash.hpp"
+#include "Source/Resources/MeshOptimizer.hpp"
+#include "Source/Resources/VertexStreams.hpp"
+
+namespace {
+	///next power of two, which also keeps attributeBase 16 byte aligned
+	uint64_t roundCapacity(uint64_t units) {
+		return std::bit_ceil(std::max<uint64_t>(units, 16));
+	}
+}
+
+MeshArena::MeshArena(ResourceManager &resourceManager, UploadQueue &uploadQueue, const VkDevice &device) : resourceManager(resourceManager), uploadQueue(uploadQueue), device(device) {
+	vertexPools[static_cast<uint32_t>(VertexLayout::Full)].positionStride = Vertex::POSITION_STRIDE;
+	vertexPools[static_cast<uint32_t>(VertexLayout::Full)].attributeStride = sizeof(Vertex) - Vertex::POSITION_STRIDE;
+	vertexPools[static_cast<uint32_t>(VertexLayout::Quantized)].positionStride = QuantizedVertex::POSITION_STRIDE;
+	vertexPools[static_cast<uint32_t>(VertexLayout::Quantized)].attributeStride = sizeof(QuantizedVertex) - QuantizedVertex::POSITION_STRIDE;
+}
+
+MeshArena::Allocation MeshArena::upload(const Mesh &mesh) {
+	std::span<const uint32_t> indices = mesh.indexData();
+
+	//keyed the way AssetCache shares geometry, 0 is kept for ranges nobody shares
+	std::span<const uint8_t> vertexBytes = mesh.vertexBytes();
+	uint64_t vertexHash = ContentHash::hash(vertexBytes.data(), vertexBytes.size_bytes(), static_cast<uint64_t>(mesh.layout));
+	uint64_t geometryKey = std::max<uint64_t>(ContentHash::hash(indices.data(), indices.size_bytes(), vertexHash), 1);
+
+	auto shared = sharedGeometry.find(geometryKey);
+	if (shared != sharedGeometry.end() && shared->second.allocation.vertices.size == mesh.vertexCount()) {
+		shared->second.users++;
+		sharedUploadCount++;
+		return shared->second.allocation;
+	}
+
+	VertexStreams::Streams streams = VertexStreams::split(mesh);
+
+	Allocation allocation{};
+	allocation.layout = mesh.layout;
+
+	//small meshes get 16 bit indices, half the index memory and bandwidth
+	std::vector<uint16_t> narrowIndices;
+	std::span<const uint8_t> indexBytes;
+	if (MeshOptimizer::fitsIndex16(mesh.vertexCount())) {
+		narrowIndices = MeshOptimizer::narrowIndices(indices);
+		indexBytes = std::span<const uint8_t>(reinterpret_cast<const uint8_t *>(narrowIndices.data()), narrowIndices.size() * sizeof(uint16_t));
+		allocation.indexType = VK_INDEX_TYPE_UINT16;
+	}
+	else {
+		indexBytes = std::span<const uint8_t>(reinterpret_cast<const uint8_t *>(indices.data()), indices.size_bytes());
+		allocation.indexType = VK_INDEX_TYPE_UINT32;
+	}
+
+	VertexPool &pool = vertexPools[static_cast<uint32_t>(mesh.layout)];
+	allocation.vertices = allocateVertices(pool, mesh.vertexCount());
+	allocation.indices = allocateIndexUnits((indexBytes.size() + INDEX_UNIT - 1) / INDEX_UNIT);
+	allocation.vertexOffset = static_cast<int32_t>(allocation.vertices.offset);
+	allocation.firstIndex = allocation.indices.offset * INDEX_UNIT / (allocation.indexType == VK_INDEX_TYPE_UINT16 ? sizeof(uint16_t) : sizeof(uint32_t));
+
+	//one staging range and one batch of copies for the whole mesh, indices go after the two vertex streams
+	VkDeviceSize indexStagingOffset = streams.data.size();
+	UploadQueue::Staging staging = uploadQueue.stage(indexStagingOffset + indexBytes.size());
+	std::memcpy(staging.mapped, streams.data.data(), streams.data.size());
+	std::memcpy(static_cast<uint8_t *>(staging.mapped) + indexStagingOffset, indexBytes.data(), indexBytes.size());
+
+	std::array<VkBufferCopy, 2> vertexCopies{};
+	vertexCopies[0].srcOffset = staging.offset;
+	vertexCopies[0].dstOffset = allocation.vertices.offset * pool.positionStride;
+	vertexCopies[0].size = streams.positionSize;
+	vertexCopies[1].srcOffset = staging.offset + streams.attributeOffset;
+	vertexCopies[1].dstOffset = pool.attributeBase() + allocation.vertices.offset * pool.attributeStride;
+	vertexCopies[1].size = streams.attributeSize;
+
+	VkBufferCopy indexCopy{};
+	indexCopy.srcOffset = staging.offset + indexStagingOffset;
+	indexCopy.dstOffset = allocation.indices.offset * INDEX_UNIT;
+	indexCopy.size = indexBytes.size();
+
+	//frames wait on the batch's semaphore, which makes the copies visible to vertex input without a barrier here
+	VkCommandBuffer commandBuffer = uploadQueue.commandBuffer();
+	if (streams.positionSize > 0) vkCmdCopyBuffer(commandBuffer, staging.buffer, pool.buffer, vertexCopies.size(), vertexCopies.data());
+	if (indexCopy.size > 0) vkCmdCopyBuffer(commandBuffer, staging.buffer, indexPool.buffer, 1, &indexCopy);
+
+	//a colliding key keeps the geometry already shared under it, this copy stays private
+	if (shared == sharedGeometry.end()) {
+		allocation.geometryKey = geometryKey;
+		sharedGeometry[geometryKey] = {allocation, 1};
+	}
+
+	meshCount++;
+	return allocation;
+}
+
+void MeshArena::free(const Allocation &allocation) {
+	if (allocation.geometryKey != 0) {
+		SharedGeometry &shared = sharedGeometry.at(allocation.geometryKey);
+		if (--shared.users > 0) return;
+		sharedGeometry.erase(allocation.geometryKey);
+	}
+
+	vertexPools[static_cast<uint32_t>(allocation.layout)].allocator.free(allocation.vertices);
+	indexPool.allocator.free(allocation.indices);
+	meshCount--;
+}
+
+bool MeshArena::canUpdateInPlace(const Allocation &allocation, const Mesh &previous, const Mesh &mesh) const {
+	if (allocation.geometryKey != 0 && sharedGeometry.at(allocation.geometryKey).users > 1) return false;
+
+	return previous.layout == mesh.layout && previous.vertexCount() == mesh.vertexCount() && previous.indexData().size() == mesh.indexData().size();
+}
+
+void MeshArena::update(Allocation &allocation, const Mesh &previous, const Mesh &mesh) {
+	//the edit makes the ranges differ from what they are keyed by, nothing may share them from here on
+	if (allocation.geometryKey != 0) {
+		sharedGeometry.erase(allocation.geometryKey);
+		allocation.geometryKey = 0;
+	}
+
+	uint32_t poolIndex = static_cast<uint32_t>(mesh.layout);
+	const VertexPool &pool = vertexPools[poolIndex];
+	uint64_t vertexStride = pool.positionStride + pool.attributeStride;
+
+	//whole vertices are compared, every changed run becomes one write per stream
+	std::span<const uint8_t> vertexBytes = mesh.vertexBytes();
+	for (const DirtyRanges::Range &range : DirtyRanges::diff(previous.vertexBytes(), vertexBytes, vertexStride)) {
+		uint64_t vertexCount = range.size / vertexStride;
+		std::vector<uint8_t> positions(vertexCount * pool.positionStride);
+		std::vector<uint8_t> attributes(vertexCount * pool.attributeStride);
+
+		for (uint64_t vertex = 0; vertex < vertexCount; vertex++) {
+			const uint8_t *source = vertexBytes.data() + range.offset + vertex * vertexStride;
+			std::memcpy(positions.data() + vertex * pool.positionStride, source, pool.positionStride);
+			std::memcpy(attributes.data() + vertex * pool.attributeStride, source + pool.positionStride, pool.attributeStride);
+		}
+
+		uint64_t firstVertex = allocation.vertices.offset + range.offset / vertexStride;
+		queueWrite(poolIndex, false, firstVertex * pool.positionStride, positions.data(), positions.size());
+		queueWrite(poolIndex, true, firstVertex * pool.attributeStride, attributes.data(), attributes.size());
+	}
+
+	std::span<const uint32_t> indices = mesh.indexData();
+	std::span<const uint32_t> previousIndices = previous.indexData();
+	std::span<const uint8_t> indexBytes(reinterpret_cast<const uint8_t *>(indices.data()), indices.size_bytes());
+	std::span<const uint8_t> previousIndexBytes(reinterpret_cast<const uint8_t *>(previousIndices.data()), previousIndices.size_bytes());
+	uint64_t indexSize = allocation.indexType == VK_INDEX_TYPE_UINT16 ? sizeof(uint16_t) : sizeof(uint32_t);
+
+	for (const DirtyRanges::Range &range : DirtyRanges::diff(previousIndexBytes, indexBytes, sizeof(uint32_t))) {
+		std::span<const uint32_t> changed = indices.subspan(range.offset / sizeof(uint32_t), range.size / sizeof(uint32_t));
+		VkDeviceSize dstOffset = allocation.indices.offset * INDEX_UNIT + range.offset / sizeof(uint32_t) * indexSize;
+
+		if (allocation.indexType == VK_INDEX_TYPE_UINT16) {
+			std::vector<uint16_t> narrowIndices = MeshOptimizer::narrowIndices(changed);
+			queueWrite(INDEX_POOL, false, dstOffset, reinterpret_cast<const uint8_t *>(narrowIndices.data()), narrowIndices.size() * sizeof(uint16_t));
+		}
+		else {
+			queueWrite(INDEX_POOL, false, dstOffset, reinterpret_cast<const uint8_t *>(changed.data()), changed.size_bytes());
+		}
+	}
+}
+
+void MeshArena::queueWrite(uint32_t pool, bool attributes, VkDeviceSize dstOffset, const uint8_t *data, VkDeviceSize size) {
+	if (size == 0) return;
+
+	writes.push_back({pool, attributes, dstOffset, writeData.size(), size});
+	writeData.insert(writeData.end(), data, data + size);
+}
+
+VkBuffer MeshArena::poolBuffer(uint32_t pool) const {
+	return pool == INDEX_POOL ? indexPool.buffer : vertexPools[pool].buffer;
+}
+
+void MeshArena::recordWrites(VkCommandBuffer commandBuffer, uint32_t frameSlot) {
+	if (writes.empty()) return;
+
+	if (writeStaging.size() <= frameSlot) writeStaging.resize(frameSlot + 1);
+	WriteStaging &staging = writeStaging[frameSlot];
+	if (writeData.size() > staging.capacity) {
+		if (staging.buffer != VK_NULL_HANDLE) resourceManager.destroyBuffer(staging.buffer, staging.memory);
+		staging.capacity = std::bit_ceil(std::max<VkDeviceSize>(writeData.size(), staging.capacity * 2));
+		resourceManager.createBuffer(staging.capacity, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, staging.buffer, staging.memory);
+	}
+	std::memcpy(staging.memory.mapped, writeData.data(), writeData.size());
+
+	//earlier frames may still read the ranges, a write after read only needs the execution dependency
+	vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_VERTEX_INPUT_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 0, nullptr);
+
+	//regions of one copy land in any order, so a write overlapping an earlier one waits behind a barrier
+	std::array<std::vector<VkBufferCopy>, 3> regions;
+	auto flush = [&] {
+		for (uint32_t pool = 0; pool < regions.size(); pool++) {
+			if (regions[pool].empty()) continue;
+			vkCmdCopyBuffer(commandBuffer, staging.buffer, poolBuffer(pool), regions[pool].size(), regions[pool].data());
+			regions[pool].clear();
+		}
+	};
+
+	for (const Write &write : writes) {
+		VkBufferCopy region{};
+		region.srcOffset = write.srcOffset;
+		region.dstOffset = (write.attributes ? vertexPools[write.pool].attributeBase() : 0) + write.dstOffset;
+		region.size = write.size;
+
+		std::vector<VkBufferCopy> &poolRegions = regions[write.pool];
+		bool overlaps = std::any_of(poolRegions.begin(), poolRegions.end(), [&region](const VkBufferCopy &other) {
+			return other.dstOffset < region.dstOffset + region.size && region.dstOffset < other.dstOffset + other.size;
+		});
+		if (overlaps) {
+			flush();
+
+			VkMemoryBarrier barrier{};
+			barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+			barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+			barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+			vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+		}
+
+		//writes queued back to back to neighbouring ranges become one region
+		if (!poolRegions.empty() && poolRegions.back().srcOffset + poolRegions.back().size == region.srcOffset
+				&& poolRegions.back().dstOffset + poolRegions.back().size == region.dstOffset) {
+			poolRegions.back().size += region.size;
+		}
+		else {
+			poolRegions.push_back(region);
+		}
+	}
+	flush();
+
+	VkMemoryBarrier barrier{};
+	barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+	barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	barrier.dstAccessMask = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_INDEX_READ_BIT;
+	vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_VERTEX_INPUT_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+
+	writtenBytes += writeData.size();
+	writes.clear();
+	writeData.clear();
+}
+
+void MeshArena::bindVertexBuffers(VkCommandBuffer commandBuffer, VertexLayout layout) const {
+	const VertexPool &pool = vertexPools[static_cast<uint32_t>(layout)];
+	if (pool.buffer == VK_NULL_HANDLE) return;
+
+	VkBuffer buffers[] = {pool.buffer, pool.buffer};
+	VkDeviceSize offsets[] = {0, pool.attributeBase()};
+	vkCmdBindVertexBuffers(commandBuffer, 0, 2, buffers, offsets);
+}
+
+void MeshArena::bindIndexBuffer(VkCommandBuffer commandBuffer, VkIndexType indexType) const {
+	if (indexPool.buffer == VK_NULL_HANDLE) return;
+
+	vkCmdBindIndexBuffer(commandBuffer, indexPool.buffer, 0, indexType);
+}
+
+TlsfAllocator::Allocation MeshArena::allocateVertices(VertexPool &pool, uint64_t vertexCount) {
+	if (pool.buffer == VK_NULL_HANDLE) growVertexPool(pool, roundCapacity(std::max(vertexCount, INITIAL_VERTICES)));
+
+	std::optional<TlsfAllocator::Allocation> vertices = pool.allocator.allocate(vertexCount);
+	while (!vertices) {
+		growVertexPool(pool, roundCapacity(std::max(pool.allocator.capacity() * 2, pool.allocator.getStats().used + vertexCount)));
+		vertices = pool.allocator.allocate(vertexCount);
+	}
+
+	return vertices.value();
+}
+
+TlsfAllocator::Allocation MeshArena::allocateIndexUnits(uint64_t units) {
+	if (indexPool.buffer == VK_NULL_HANDLE) growIndexPool(roundCapacity(std::max(units, INITIAL_INDEX_UNITS)));
+
+	std::optional<TlsfAllocator::Allocation> indices = indexPool.allocator.allocate(units);
+	while (!indices) {
+		growIndexPool(roundCapacity(std::max(indexPool.allocator.capacity() * 2, indexPool.allocator.getStats().used + units)));
+		indices = indexPool.allocator.allocate(units);
+	}
+
+	return indices.value();
+}
+
+///moves the pool into a larger buffer, vertices keep their index so every vertexOffset handed out stays valid
+void MeshArena::growVertexPool(VertexPool &pool, uint64_t capacity) {
+	VkBuffer buffer;
+	DeviceAllocation memory;
+	resourceManager.createBuffer(capacity * (pool.positionStride + pool.attributeStride), VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+		VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, buffer, memory);
+
+	if (pool.buffer != VK_NULL_HANDLE) {
+		//frames in flight still bind the old buffer and uploads not yet submitted still write to it
+		uploadQueue.waitIdle();
+		vkDeviceWaitIdle(device);
+
+		std::array<VkBufferCopy, 2> copies{};
+		copies[0].size = pool.allocator.capacity() * pool.positionStride;
+		copies[1].srcOffset = pool.attributeBase();
+		copies[1].dstOffset = capacity * pool.positionStride;
+		copies[1].size = pool.allocator.capacity() * pool.attributeStride;
+
+		VkCommandPool commandPool = resourceManager.createCommandPool();
+		VkCommandBuffer commandBuffer = resourceManager.beginSingleTimeCommands(commandPool);
+		vkCmdCopyBuffer(commandBuffer, pool.buffer, buffer, copies.size(), copies.data());
+		resourceManager.endSingleTimeCommands(commandBuffer, commandPool);
+
+		resourceManager.destroyBuffer(pool.buffer, pool.memory);
+		growthCount++;
+	}
+
+	bool grew = pool.buffer != VK_NULL_HANDLE;
+	pool.buffer = buffer;
+	pool.memory = memory;
+	pool.allocator.grow(capacity);
+
+	if (grew) compact();
+}
+
+void MeshArena::growIndexPool(uint64_t capacity) {
+	VkBuffer buffer;
+	DeviceAllocation memory;
+	resourceManager.createBuffer(capacity * INDEX_UNIT, VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+		VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, buffer, memory);
+
+	if (indexPool.buffer != VK_NULL_HANDLE) {
+		uploadQueue.waitIdle();
+		vkDeviceWaitIdle(device);
+		resourceManager.copyBuffer(indexPool.buffer, buffer, indexPool.allocator.capacity() * INDEX_UNIT);
+
+		resourceManager.destroyBuffer(indexPool.buffer, indexPool.memory);
+		growthCount++;
+	}
+
+	bool grew = indexPool.buffer != VK_NULL_HANDLE;
+	indexPool.buffer = buffer;
+	indexPool.memory = memory;
+	indexPool.allocator.grow(capacity);
+
+	if (grew) compact();
+}
+
+void MeshArena::compact() {
+	constexpr VkBufferUsageFlags transferUsage = VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+
+	std::vector<ResourceManager::MovableBuffer> buffers;
+	for (VertexPool &pool : vertexPools) {
+		if (pool.buffer == VK_NULL_HANDLE) continue;
+		buffers.push_back({&pool.buffer, &pool.memory, pool.allocator.capacity() * (pool.positionStride + pool.attributeStride), VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | transferUsage});
+	}
+	if (indexPool.buffer != VK_NULL_HANDLE) {
+		buffers.push_back({&indexPool.buffer, &indexPool.memory, indexPool.allocator.capacity() * INDEX_UNIT, VK_BUFFER_USAGE_INDEX_BUFFER_BIT | transferUsage});
+	}
+
+	resourceManager.defragmentBuffers(buffers);
+}
+
+MeshArena::Stats MeshArena::getStats() const {
+	Stats stats{};
+	stats.meshes = meshCount;
+	stats.growths = growthCount;
+	stats.writtenBytes = writtenBytes;
+	stats.sharedUploads = sharedUploadCount;
+
+	for (const VertexPool &pool : vertexPools) {
+		TlsfAllocator::Stats allocatorStats = pool.allocator.getStats();
+		stats.vertexBytes += allocatorStats.capacity * (pool.positionStride + pool.attributeStride);
+		stats.usedVertexBytes += allocatorStats.used * (pool.positionStride + pool.attributeStride);
+	}
+
+	TlsfAllocator::Stats indexStats = indexPool.allocator.getStats();
+	stats.indexBytes = indexStats.capacity * INDEX_UNIT;
+	stats.usedIndexBytes = indexStats.used * INDEX_UNIT;
+
+	return stats;
+}
+
+void MeshArena::cleanup() {
+	for (WriteStaging &staging : writeStaging) {
+		if (staging.buffer == VK_NULL_HANDLE) continue;
+		resourceManager.destroyBuffer(staging.buffer, staging.memory);
+	}
+	writeStaging.clear();
+	writes.clear();
+	writeData.clear();
+	sharedGeometry.clear();
+
+	for (VertexPool &pool : vertexPools) {
+		if (pool.buffer == VK_NULL_HANDLE) continue;
+		resourceManager.destroyBuffer(pool.buffer, pool.memory);
+		pool.buffer = VK_NULL_HANDLE;
+	}
+
+	if (indexPool.buffer != VK_NULL_HANDLE) {
+		resourceManager.destroyBuffer(indexPool.buffer, indexPool.memory);
+		indexPool.buffer = VK_NULL_HANDLE;
+	}
+
+}
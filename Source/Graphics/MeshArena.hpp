@@ -0,0 +1,151 @@
+#ifndef MESHARENA_HPP
+#define MESHARENA_HPP
+
+#include <array>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+#include <vulkan/vulkan.h>
+
+#include "DeviceAllocator.hpp"
+#include "UploadQueue.hpp"
+#include "Vertex.hpp"
+#include "Source/Core/DataStorage/TlsfAllocator.hpp"
+#include "Source/Resources/Mesh.hpp"
+
+//ResourceManager.hpp includes VulkMesh.hpp, which includes this
+class ResourceManager;
+
+///Every mesh's vertices and indices in a few large device local buffers instead of a buffer pair per mesh
+///Vertices are sub-allocated in whole vertices per VertexLayout, positions and attributes in two halves of the layout's buffer,
+///so a draw finds its mesh through vertexOffset and the buffers are only bound again when the layout changes
+///Indices of both widths share one buffer sub-allocated in 4 byte units and are found through firstIndex
+class MeshArena {
+public:
+	struct Allocation {
+		VertexLayout layout;
+		TlsfAllocator::Allocation vertices;
+		TlsfAllocator::Allocation indices;
+		VkIndexType indexType;
+		///what vkCmdDrawIndexed takes to reach the mesh's first vertex and index
+		int32_t vertexOffset;
+		uint32_t firstIndex;
+		///content hash the ranges are shared under, 0 once they belong to one mesh alone
+		uint64_t geometryKey;
+	};
+
+	struct Stats {
+		///distinct geometry in the arena, meshes sharing it count once
+		uint32_t meshes;
+		///uploads that found their geometry already in the arena and copied nothing
+		uint32_t sharedUploads;
+		uint64_t vertexBytes;
+		uint64_t usedVertexBytes;
+		uint64_t indexBytes;
+		uint64_t usedIndexBytes;
+		///times a buffer was replaced by a larger one
+		uint32_t growths;
+		///bytes written over live meshes by update, what in place edits cost
+		uint64_t writtenBytes;
+	};
+
+	MeshArena(ResourceManager &resourceManager, UploadQueue &uploadQueue, const VkDevice &device);
+
+	///records the mesh's copies into the upload queue's batch, growing the arena when it is full
+	///identical geometry already in the arena is shared instead, so its meshes can be drawn instanced
+	///the ranges hold the mesh once the upload queue's ticket taken after this is complete
+	Allocation upload(const Mesh &mesh);
+	///the range is reused by the next upload once its last user freed it, only free once no frame in flight draws from it
+	void free(const Allocation &allocation);
+
+	///true when mesh can overwrite previous in its allocation, same layout, vertex and index count and no other user
+	bool canUpdateInPlace(const Allocation &allocation, const Mesh &previous, const Mesh &mesh) const;
+	///queues writes of the vertices and indices that differ from previous, which allocation holds right now
+	///nothing is copied until recordWrites, so a frame never draws half an edit
+	void update(Allocation &allocation, const Mesh &previous, const Mesh &mesh);
+	///records the queued writes into a frame's command buffer ahead of its render pass
+	///the staging memory of frameSlot is reused, so only call once the slot's previous frame has finished
+	void recordWrites(VkCommandBuffer commandBuffer, uint32_t frameSlot);
+
+	///binds the layout's position and attribute streams to bindings 0 and 1
+	void bindVertexBuffers(VkCommandBuffer commandBuffer, VertexLayout layout) const;
+	void bindIndexBuffer(VkCommandBuffer commandBuffer, VkIndexType indexType) const;
+
+	Stats getStats() const;
+	void cleanup();
+
+private:
+	//capacities double from here when they run out
+	static constexpr uint64_t INITIAL_VERTICES = 1 << 18;
+	static constexpr uint64_t INITIAL_INDEX_UNITS = 1 << 20;
+	static constexpr uint64_t INDEX_UNIT = 4;
+
+	struct VertexPool {
+		TlsfAllocator allocator;
+		VkBuffer buffer = VK_NULL_HANDLE;
+		DeviceAllocation memory;
+		uint64_t positionStride;
+		uint64_t attributeStride;
+
+		///attributes start right after room for every position
+		VkDeviceSize attributeBase() const { return allocator.capacity() * positionStride; }
+	};
+
+	struct IndexPool {
+		TlsfAllocator allocator;
+		VkBuffer buffer = VK_NULL_HANDLE;
+		DeviceAllocation memory;
+	};
+
+	//writes name their buffer by pool, a growth may replace the buffer before they are recorded
+	static constexpr uint32_t INDEX_POOL = 2;
+
+	struct Write {
+		uint32_t pool;
+		///the attribute half of a vertex pool moves when the pool grows, so offsets are kept per stream
+		bool attributes;
+		VkDeviceSize dstOffset;
+		///where the bytes are in writeData
+		VkDeviceSize srcOffset;
+		VkDeviceSize size;
+	};
+
+	struct WriteStaging {
+		VkBuffer buffer = VK_NULL_HANDLE;
+		DeviceAllocation memory;
+		VkDeviceSize capacity = 0;
+	};
+
+	ResourceManager &resourceManager;
+	UploadQueue &uploadQueue;
+	const VkDevice &device;
+
+	std::array<VertexPool, 2> vertexPools;
+	IndexPool indexPool;
+
+	struct SharedGeometry {
+		Allocation allocation;
+		uint32_t users;
+	};
+	std::unordered_map<uint64_t, SharedGeometry> sharedGeometry;
+
+	uint32_t meshCount = 0;
+	uint32_t sharedUploadCount = 0;
+	uint32_t growthCount = 0;
+	uint64_t writtenBytes = 0;
+
+	std::vector<Write> writes;
+	std::vector<uint8_t> writeData;
+	std::vector<WriteStaging> writeStaging;
+
+	TlsfAllocator::Allocation allocateVertices(VertexPool &pool, uint64_t vertexCount);
+	TlsfAllocator::Allocation allocateIndexUnits(uint64_t units);
+	void queueWrite(uint32_t pool, bool attributes, VkDeviceSize dstOffset, const uint8_t *data, VkDeviceSize size);
+	VkBuffer poolBuffer(uint32_t pool) const;
+	void growVertexPool(VertexPool &pool, uint64_t capacity);
+	void growIndexPool(uint64_t capacity);
+	///moves the pool buffers out of pages a growth left mostly empty, only while the device is idle
+	void compact();
+};
+
+#endif //MESHARENA_HPP
@@ -0,0 +1,79 @@
+#ifndef MESHLETCULLING_HPP
+#define MESHLETCULLING_HPP
+
+#include <cstdint>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "Frustum.hpp"
+#include "Source/Resources/Mesh.hpp"
+
+///Range of index data to draw, neighbouring visible meshlets are merged into one
+struct DrawRange {
+	uint32_t firstIndex;
+	uint32_t indexCount;
+};
+
+///true unless the meshlet is outside the frustum or every triangle in it faces away from the camera
+///frustum and cameraPosition are in the meshlet's model space
+inline bool meshletVisible(const Meshlet &meshlet, const Frustum &frustum, const glm::vec3 &cameraPosition, bool perspective) {
+	if (!frustum.intersectsSphere(meshlet.center, meshlet.radius)) return false;
+
+	//orthographic views look along one direction, a camera position says nothing about facing
+	if (!perspective) return true;
+
+	glm::vec3 toCenter = meshlet.center - cameraPosition;
+	return glm::dot(toCenter, meshlet.coneAxis) < meshlet.coneCutoff * glm::length(toCenter) + meshlet.radius;
+}
+
+///Fills ranges with what has to be drawn of a mesh at a level of detail, empty when the mesh is out of view
+///Level 0 is culled per sub mesh of a static batch and per meshlet, coarser levels are small enough to draw whole
+inline void buildDrawRanges(const Mesh &mesh, uint32_t level, const glm::mat4 &view, const glm::mat4 &proj, std::vector<DrawRange> &ranges) {
+	ranges.clear();
+
+	//all tests run in model space, so nothing in the mesh has to be transformed
+	glm::mat4 modelView = view * mesh.transform;
+	Frustum frustum = Frustum::fromMatrix(proj * modelView);
+	if (!frustum.intersectsSphere(mesh.bounds.center, mesh.bounds.radius)) return;
+
+	LodLevel lod = mesh.lod(level);
+	if (level != 0 || (mesh.meshlets.empty() && mesh.subMeshes.empty())) {
+		ranges.push_back({lod.firstIndex, lod.indexCount});
+		return;
+	}
+
+	bool perspective = proj[3][3] == 0.0f;
+	glm::vec3 cameraPosition = glm::vec3(glm::inverse(modelView)[3]);
+
+	auto append = [&ranges](uint32_t firstIndex, uint32_t indexCount) {
+		if (!ranges.empty() && ranges.back().firstIndex + ranges.back().indexCount == firstIndex) {
+			ranges.back().indexCount += indexCount;
+		}
+		else {
+			ranges.push_back({firstIndex, indexCount});
+		}
+	};
+
+	auto appendMeshlets = [&](uint32_t firstMeshlet, uint32_t meshletCount) {
+		for (uint32_t i = firstMeshlet; i < firstMeshlet + meshletCount; i++) {
+			const Meshlet &meshlet = mesh.meshlets[i];
+			if (meshletVisible(meshlet, frustum, cameraPosition, perspective)) append(meshlet.firstIndex, meshlet.indexCount);
+		}
+	};
+
+	if (mesh.subMeshes.empty()) {
+		appendMeshlets(0, mesh.meshlets.size());
+		return;
+	}
+
+	//a sub mesh out of view skips all of its meshlets, one without meshlets is drawn whole
+	for (const SubMesh &subMesh : mesh.subMeshes) {
+		if (!frustum.intersectsSphere(subMesh.bounds.center, subMesh.bounds.radius)) continue;
+
+		if (subMesh.meshletCount == 0) append(subMesh.firstIndex, subMesh.indexCount);
+		else appendMeshlets(subMesh.firstMeshlet, subMesh.meshletCount);
+	}
+}
+
+#endif //MESHLETCULLING_HPP
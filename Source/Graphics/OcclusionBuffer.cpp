@@ -0,0 +1,318 @@
+#include "OcclusionBuffer.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#define SKADI_OCCLUSION_SSE
+#include <emmintrin.h>
+#endif
+
+uint32_t Occluder::level(const Mesh &mesh) {
+	for (uint32_t level = mesh.lodCount() - 1; level > 0; level--) {
+		if (mesh.lod(level).error <= MAX_ERROR * mesh.bounds.radius) return level;
+	}
+
+	return 0;
+}
+
+Occluder Occluder::fromMesh(const Mesh &mesh) {
+	Occluder occluder;
+	LodLevel lod = mesh.lod(level(mesh));
+	std::span<const uint32_t> indices = mesh.indexData().subspan(lod.firstIndex, lod.indexCount);
+
+	//quantized positions are unit cube coordinates, the dequantize transform puts them back in model space
+	glm::mat4 dequantize = QuantizedVertex::dequantizeTransform(mesh.bounds.min, mesh.bounds.max);
+	auto position = [&mesh, &dequantize](uint32_t index) {
+		if (mesh.layout != VertexLayout::Quantized) return mesh.vertexData()[index].pos;
+
+		const QuantizedVertex &vertex = mesh.quantizedData()[index];
+		glm::vec4 unit(vertex.pos[0] / 65535.0f, vertex.pos[1] / 65535.0f, vertex.pos[2] / 65535.0f, 1.0f);
+		return glm::vec3(dequantize * unit);
+	};
+
+	//coarse levels use few of the mesh's vertices, only those are kept
+	std::vector<uint32_t> remap(mesh.vertexCount(), std::numeric_limits<uint32_t>::max());
+	occluder.indices.reserve(indices.size());
+	for (uint32_t index : indices) {
+		if (remap[index] == std::numeric_limits<uint32_t>::max()) {
+			remap[index] = occluder.positions.size();
+			occluder.positions.push_back(position(index));
+		}
+		occluder.indices.push_back(remap[index]);
+	}
+
+	return occluder;
+}
+
+OcclusionBuffer::OcclusionBuffer(uint32_t width, uint32_t height) : width(width), height(height) {
+	if (width == 0 || height == 0 || width % TILE_WIDTH != 0 || height % TILE_HEIGHT != 0) {
+		throw std::runtime_error("Occlusion buffer size has to be a multiple of its tile size");
+	}
+
+	tilesX = width / TILE_WIDTH;
+	tilesY = height / TILE_HEIGHT;
+
+	uint32_t levelWidth = width;
+	uint32_t levelHeight = height;
+	while (true) {
+		levels.push_back({levelWidth, levelHeight, std::vector<float>(levelWidth * levelHeight, 1.0f)});
+		if (levelWidth == 1 && levelHeight == 1) break;
+
+		levelWidth = std::max(1u, (levelWidth + 1) / 2);
+		levelHeight = std::max(1u, (levelHeight + 1) / 2);
+	}
+}
+
+void OcclusionBuffer::begin(const glm::mat4 &viewProj, uint32_t binSetCount) {
+	this->viewProj = viewProj;
+	std::fill(levels[0].depth.begin(), levels[0].depth.end(), 1.0f);
+
+	binSets.resize(std::max(1u, binSetCount));
+	for (BinSet &binSet : binSets) {
+		binSet.triangles.clear();
+		binSet.tiles.resize(tileCount());
+		for (std::vector<uint32_t> &tile : binSet.tiles) tile.clear();
+	}
+}
+
+void OcclusionBuffer::addOccluder(uint32_t binSet, const Occluder &occluder, const glm::mat4 &transform) {
+	BinSet &set = binSets[binSet];
+	glm::mat4 clip = viewProj * transform;
+
+	set.clipPositions.resize(occluder.positions.size());
+	for (uint32_t i = 0; i < occluder.positions.size(); i++) {
+		set.clipPositions[i] = clip * glm::vec4(occluder.positions[i], 1.0f);
+	}
+
+	for (uint32_t i = 0; i + 2 < occluder.indices.size(); i += 3) {
+		binTriangle(set, set.clipPositions[occluder.indices[i]], set.clipPositions[occluder.indices[i + 1]], set.clipPositions[occluder.indices[i + 2]]);
+	}
+}
+
+void OcclusionBuffer::binTriangle(BinSet &set, const glm::vec4 &a, const glm::vec4 &b, const glm::vec4 &c) {
+	//inside where the dot product with the clip position is positive, near first since it is the one that matters most
+	const std::array<glm::vec4, 5> planes = {
+		glm::vec4(0, 0, 1, 0),
+		glm::vec4(1, 0, 0, 1),
+		glm::vec4(-1, 0, 0, 1),
+		glm::vec4(0, 1, 0, 1),
+		glm::vec4(0, -1, 0, 1)
+	};
+
+	auto outside = [&planes](const glm::vec4 &position) {
+		uint32_t mask = 0;
+		for (uint32_t i = 0; i < planes.size(); i++) {
+			if (glm::dot(planes[i], position) < 0.0f) mask |= 1u << i;
+		}
+		return mask;
+	};
+
+	uint32_t outsideA = outside(a), outsideB = outside(b), outsideC = outside(c);
+	if (outsideA & outsideB & outsideC) return;
+
+	//clipping against each plane adds at most one vertex
+	std::array<glm::vec4, 8> polygon = {a, b, c};
+	uint32_t count = 3;
+
+	if (outsideA | outsideB | outsideC) {
+		std::array<glm::vec4, 8> clipped;
+		for (uint32_t i = 0; i < planes.size(); i++) {
+			if (!((outsideA | outsideB | outsideC) & (1u << i))) continue;
+
+			uint32_t clippedCount = 0;
+			for (uint32_t j = 0; j < count; j++) {
+				const glm::vec4 &from = polygon[j];
+				const glm::vec4 &to = polygon[(j + 1) % count];
+				float fromDistance = glm::dot(planes[i], from);
+				float toDistance = glm::dot(planes[i], to);
+
+				if (fromDistance >= 0.0f) clipped[clippedCount++] = from;
+				if ((fromDistance >= 0.0f) != (toDistance >= 0.0f)) {
+					clipped[clippedCount++] = from + (to - from) * (fromDistance / (fromDistance - toDistance));
+				}
+			}
+
+			polygon = clipped;
+			count = clippedCount;
+			if (count < 3) return;
+		}
+	}
+
+	std::array<glm::vec3, 8> screen;
+	for (uint32_t i = 0; i < count; i++) {
+		glm::vec3 ndc = glm::vec3(polygon[i]) / polygon[i].w;
+		screen[i] = glm::vec3((ndc.x * 0.5f + 0.5f) * width, (ndc.y * 0.5f + 0.5f) * height, ndc.z);
+	}
+
+	for (uint32_t i = 1; i + 1 < count; i++) {
+		const glm::vec3 &p0 = screen[0];
+		const glm::vec3 &p1 = screen[i];
+		const glm::vec3 &p2 = screen[i + 1];
+
+		float area = (p1.x - p0.x) * (p2.y - p0.y) - (p2.x - p0.x) * (p1.y - p0.y);
+		if (std::abs(area) < 1e-6f) continue;
+
+		//pixels whose centre can be inside the triangle
+		float left = std::min({p0.x, p1.x, p2.x}) - 0.5f;
+		float right = std::max({p0.x, p1.x, p2.x}) - 0.5f;
+		float bottom = std::min({p0.y, p1.y, p2.y}) - 0.5f;
+		float top = std::max({p0.y, p1.y, p2.y}) - 0.5f;
+		if (right < 0.0f || top < 0.0f || left > width - 1.0f || bottom > height - 1.0f) continue;
+
+		Triangle triangle{};
+		triangle.minX = static_cast<uint32_t>(std::max(0.0f, std::ceil(left)));
+		triangle.minY = static_cast<uint32_t>(std::max(0.0f, std::ceil(bottom)));
+		triangle.maxX = static_cast<uint32_t>(std::min(width - 1.0f, std::floor(right)));
+		triangle.maxY = static_cast<uint32_t>(std::min(height - 1.0f, std::floor(top)));
+		if (triangle.minX > triangle.maxX || triangle.minY > triangle.maxY) continue;
+
+		//each edge function is zero on its edge and positive towards the opposite vertex
+		const glm::vec3 *vertices[3] = {&p0, &p1, &p2};
+		float sign = area > 0.0f ? 1.0f : -1.0f;
+		for (uint32_t edge = 0; edge < 3; edge++) {
+			const glm::vec3 &from = *vertices[(edge + 1) % 3];
+			const glm::vec3 &to = *vertices[(edge + 2) % 3];
+			triangle.edgeA[edge] = (from.y - to.y) * sign;
+			triangle.edgeB[edge] = (to.x - from.x) * sign;
+			triangle.edgeC[edge] = (from.x * to.y - to.x * from.y) * sign;
+		}
+
+		//depth over z divided by w is linear in screen space
+		triangle.depthA = ((p1.z - p0.z) * (p2.y - p0.y) - (p2.z - p0.z) * (p1.y - p0.y)) / area;
+		triangle.depthB = ((p2.z - p0.z) * (p1.x - p0.x) - (p1.z - p0.z) * (p2.x - p0.x)) / area;
+		triangle.depthC = p0.z - triangle.depthA * p0.x - triangle.depthB * p0.y;
+
+		uint32_t index = set.triangles.size();
+		set.triangles.push_back(triangle);
+		for (uint32_t tileY = triangle.minY / TILE_HEIGHT; tileY <= triangle.maxY / TILE_HEIGHT; tileY++) {
+			for (uint32_t tileX = triangle.minX / TILE_WIDTH; tileX <= triangle.maxX / TILE_WIDTH; tileX++) {
+				set.tiles[tileY * tilesX + tileX].push_back(index);
+			}
+		}
+	}
+}
+
+void OcclusionBuffer::rasterizeTile(uint32_t tile) {
+	uint32_t tileLeft = (tile % tilesX) * TILE_WIDTH;
+	uint32_t tileBottom = (tile / tilesX) * TILE_HEIGHT;
+	float *depth = levels[0].depth.data();
+
+	for (const BinSet &set : binSets) {
+		for (uint32_t index : set.tiles[tile]) {
+			const Triangle &triangle = set.triangles[index];
+			//spans start on a multiple of four, the edge tests reject the pixels left of the triangle
+			uint32_t minX = std::max(triangle.minX, tileLeft) & ~3u;
+			uint32_t maxX = std::min(triangle.maxX, tileLeft + TILE_WIDTH - 1);
+			uint32_t minY = std::max(triangle.minY, tileBottom);
+			uint32_t maxY = std::min(triangle.maxY, tileBottom + TILE_HEIGHT - 1);
+
+			for (uint32_t y = minY; y <= maxY; y++) {
+				float centerY = y + 0.5f;
+				float *row = depth + y * width;
+
+#ifdef SKADI_OCCLUSION_SSE
+				__m128 edgeRow[3];
+				__m128 edgeStep[3];
+				for (uint32_t edge = 0; edge < 3; edge++) {
+					edgeRow[edge] = _mm_set1_ps(triangle.edgeB[edge] * centerY + triangle.edgeC[edge]);
+					edgeStep[edge] = _mm_set1_ps(triangle.edgeA[edge]);
+				}
+				__m128 depthRow = _mm_set1_ps(triangle.depthB * centerY + triangle.depthC);
+				__m128 depthStep = _mm_set1_ps(triangle.depthA);
+				const __m128 zero = _mm_setzero_ps();
+
+				for (uint32_t x = minX; x <= maxX; x += 4) {
+					__m128 centerX = _mm_add_ps(_mm_set1_ps(static_cast<float>(x)), _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f));
+
+					__m128 inside = _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(edgeStep[0], centerX), edgeRow[0]), zero);
+					inside = _mm_and_ps(inside, _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(edgeStep[1], centerX), edgeRow[1]), zero));
+					inside = _mm_and_ps(inside, _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(edgeStep[2], centerX), edgeRow[2]), zero));
+
+					__m128 previous = _mm_loadu_ps(row + x);
+					__m128 nearest = _mm_min_ps(previous, _mm_add_ps(_mm_mul_ps(depthStep, centerX), depthRow));
+					_mm_storeu_ps(row + x, _mm_or_ps(_mm_and_ps(inside, nearest), _mm_andnot_ps(inside, previous)));
+				}
+#else
+				for (uint32_t x = minX; x <= maxX; x++) {
+					float centerX = x + 0.5f;
+					bool inside = true;
+					for (uint32_t edge = 0; edge < 3; edge++) {
+						inside &= triangle.edgeA[edge] * centerX + triangle.edgeB[edge] * centerY + triangle.edgeC[edge] >= 0.0f;
+					}
+					if (inside) row[x] = std::min(row[x], triangle.depthA * centerX + triangle.depthB * centerY + triangle.depthC);
+				}
+#endif
+			}
+		}
+	}
+}
+
+void OcclusionBuffer::buildPyramid() {
+	for (uint32_t level = 1; level < levels.size(); level++) {
+		const Level &source = levels[level - 1];
+		Level &target = levels[level];
+
+		for (uint32_t y = 0; y < target.height; y++) {
+			uint32_t y0 = y * 2;
+			uint32_t y1 = std::min(y0 + 1, source.height - 1);
+			for (uint32_t x = 0; x < target.width; x++) {
+				uint32_t x0 = x * 2;
+				uint32_t x1 = std::min(x0 + 1, source.width - 1);
+				target.depth[y * target.width + x] = std::max({
+					source.depth[y0 * source.width + x0], source.depth[y0 * source.width + x1],
+					source.depth[y1 * source.width + x0], source.depth[y1 * source.width + x1]
+				});
+			}
+		}
+	}
+}
+
+bool OcclusionBuffer::isVisible(const glm::vec3 &min, const glm::vec3 &max, const glm::mat4 &transform) const {
+	glm::mat4 clip = viewProj * transform;
+
+	float nearest = std::numeric_limits<float>::max();
+	glm::vec2 low(std::numeric_limits<float>::max());
+	glm::vec2 high(std::numeric_limits<float>::lowest());
+	for (int corner = 0; corner < 8; corner++) {
+		glm::vec4 position = clip * glm::vec4(corner & 1 ? max.x : min.x, corner & 2 ? max.y : min.y, corner & 4 ? max.z : min.z, 1.0f);
+		//a box reaching past the near plane covers the camera, nothing can hide it
+		if (position.w <= 0.0f || position.z < 0.0f) return true;
+
+		glm::vec3 ndc = glm::vec3(position) / position.w;
+		nearest = std::min(nearest, ndc.z);
+		low = glm::min(low, glm::vec2(ndc.x, ndc.y));
+		high = glm::max(high, glm::vec2(ndc.x, ndc.y));
+	}
+
+	if (high.x < -1.0f || high.y < -1.0f || low.x > 1.0f || low.y > 1.0f) return true;
+
+	//every pixel the box touches, even in part
+	auto pixel = [](float ndc, uint32_t size) {
+		return static_cast<uint32_t>(std::clamp((ndc * 0.5f + 0.5f) * size, 0.0f, size - 1.0f));
+	};
+	uint32_t x0 = pixel(low.x, width), x1 = pixel(high.x, width);
+	uint32_t y0 = pixel(low.y, height), y1 = pixel(high.y, height);
+
+	//the first level where the box spans at most four texels each way, coarser texels reach further past the box
+	uint32_t level = 0;
+	while (level + 1 < levels.size() && ((x1 >> level) - (x0 >> level) > 3 || (y1 >> level) - (y0 >> level) > 3)) level++;
+
+	const Level &texels = levels[level];
+	for (uint32_t y = y0 >> level; y <= std::min(y1 >> level, texels.height - 1); y++) {
+		for (uint32_t x = x0 >> level; x <= std::min(x1 >> level, texels.width - 1); x++) {
+			if (texels.depth[y * texels.width + x] >= nearest) return true;
+		}
+	}
+
+	return false;
+}
+
+uint32_t OcclusionBuffer::triangleCount() const {
+	uint32_t count = 0;
+	for (const BinSet &set : binSets) count += set.triangles.size();
+	return count;
+}
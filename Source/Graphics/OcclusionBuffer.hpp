@@ -0,0 +1,100 @@
+#ifndef OCCLUSIONBUFFER_HPP
+#define OCCLUSIONBUFFER_HPP
+
+#include <cstdint>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "Source/Resources/Mesh.hpp"
+
+///Triangles of a mesh marked as an occluder, what gets rasterized of it every frame
+struct Occluder {
+	///largest LOD error taken, relative to the bounding radius, coarser levels can stick out of the mesh and hide what it does not
+	static constexpr float MAX_ERROR = 0.01f;
+
+	///model space positions used by the chosen level and its triangles, indexing them
+	std::vector<glm::vec3> positions;
+	std::vector<uint32_t> indices;
+
+	///the coarsest level within MAX_ERROR, level 0 when no simplified level is
+	static uint32_t level(const Mesh &mesh);
+
+	static Occluder fromMesh(const Mesh &mesh);
+};
+
+///Low resolution depth buffer of the frame's occluders, rasterized on the CPU, and a pyramid of its farthest depths
+///Bounds whose nearest point lies behind the farthest occluder depth everywhere they cover are hidden
+///Occluders are binned into tiles, a frame goes begin, addOccluder, rasterizeTile for every tile, buildPyramid, isVisible
+///addOccluder calls on different bin sets and rasterizeTile calls on different tiles may run in parallel
+class OcclusionBuffer {
+public:
+	static constexpr uint32_t TILE_WIDTH = 32;
+	static constexpr uint32_t TILE_HEIGHT = 32;
+
+	///width and height have to be multiples of the tile size
+	OcclusionBuffer(uint32_t width = 256, uint32_t height = 128);
+
+	///clears the depth to the far plane, viewProj maps world space to clip space with depth from 0 to 1
+	void begin(const glm::mat4 &viewProj, uint32_t binSetCount);
+	///clips, projects and bins the occluder's triangles, only one thread may add to a bin set at a time
+	void addOccluder(uint32_t binSet, const Occluder &occluder, const glm::mat4 &transform);
+
+	uint32_t tileCount() const { return tilesX * tilesY; }
+	///writes the nearest depth of the triangles binned to the tile, four pixels at a time with SSE2
+	void rasterizeTile(uint32_t tile);
+	void buildPyramid();
+
+	///false only when the box, in the space transform maps from, is certainly behind the occluders
+	bool isVisible(const glm::vec3 &min, const glm::vec3 &max, const glm::mat4 &transform) const;
+
+	uint32_t getWidth() const { return width; }
+	uint32_t getHeight() const { return height; }
+	///nearest occluder depth at a pixel of the full resolution level, 1 where nothing was drawn
+	float depthAt(uint32_t x, uint32_t y) const { return levels[0].depth[y * width + x]; }
+	///triangles binned since begin, after clipping
+	uint32_t triangleCount() const;
+
+private:
+	///screen space triangle, inside where all three edge functions are positive
+	struct Triangle {
+		float edgeA[3];
+		float edgeB[3];
+		float edgeC[3];
+		///depth plane, depth = depthA * x + depthB * y + depthC
+		float depthA;
+		float depthB;
+		float depthC;
+		uint32_t minX;
+		uint32_t minY;
+		uint32_t maxX;
+		uint32_t maxY;
+	};
+
+	///triangles one thread binned, with the indices of the ones touching each tile
+	struct BinSet {
+		std::vector<Triangle> triangles;
+		std::vector<std::vector<uint32_t>> tiles;
+		std::vector<glm::vec4> clipPositions;
+	};
+
+	struct Level {
+		uint32_t width;
+		uint32_t height;
+		std::vector<float> depth;
+	};
+
+	uint32_t width;
+	uint32_t height;
+	uint32_t tilesX;
+	uint32_t tilesY;
+	glm::mat4 viewProj{1.0f};
+
+	std::vector<BinSet> binSets;
+	///level 0 holds the nearest depth per pixel, every level after it the farthest of four texels of the one before
+	std::vector<Level> levels;
+
+	void binTriangle(BinSet &binSet, const glm::vec4 &a, const glm::vec4 &b, const glm::vec4 &c);
+};
+
+#endif //OCCLUSIONBUFFER_HPP
@@ -1,6 +1,7 @@
 #include "Vertex.hpp"
 #include <algorithm>
 #include <array>
+#include <bit>
 #include <bits/fs_fwd.h>
 #include <cstddef>
 #include <cstdint>
@@ -21,29 +22,34 @@
 #include "Rend.hpp"
 
 #include <Source/Resources/Loader.hpp>
+#include "LodSelection.hpp"
+#include "MeshletCulling.hpp"
+#include "Source/Resources/TextureProcessing.hpp"
 
-#include "TransferBuffer.hpp"
 #include "DisplayInstance.hpp"
 #include "VulkanInstance.hpp"
 
-const uint32_t WIDTH = 800;
-const uint32_t HEIGHT = 600;
 const int MAX_FRAMES_IN_FLIGHT = 2;
 
 VkDevice device;
 VkPhysicalDevice physicalDevice;
 GLFWwindow *window;
 
-Rend::Rend() {
-	displayInstance = new DisplayInstance();
-	vInstance = new VulkanInstance();
+Rend::Rend() : Rend(Settings{}) {}
 
-	displayInstance->initDisplay(vInstance->instance, WIDTH, HEIGHT, "Skadi Engine");
+Rend::Rend(const Settings &settings) : settings(settings) {
+	displayInstance = new DisplayInstance(settings.headless);
+	vInstance = new VulkanInstance(settings.headless);
+
+	if (settings.headless)
+		displayInstance->initHeadless(vInstance->instance, settings.width, settings.height);
+	else
+		displayInstance->initDisplay(vInstance->instance, settings.width, settings.height, "Skadi Engine");
 	vInstance->setupDevices(*displayInstance);
 
 	resourceManager = new ResourceManager(*vInstance, *displayInstance);
 
-	camera = Camera(glm::mat4(1), 45, WIDTH, HEIGHT);
+	camera = Camera(glm::mat4(1), 45, settings.width, settings.height);
 
 	device = vInstance->device;
 	physicalDevice = displayInstance->physicalDevice;
@@ -57,16 +63,20 @@ void Rend::beginLoop() {
 }
 
 void Rend::mainLoop() {
-	while (!glfwWindowShouldClose(displayInstance->window)) {
+	while (!stopRequested && (settings.headless || !glfwWindowShouldClose(displayInstance->window))) {
 		auto start = std::chrono::steady_clock::now();
 
-		glfwPollEvents();
+		if (!settings.headless)
+			glfwPollEvents();
 		drawFrame();
 
 
 		processMaterialQueue();
 		processMeshQueue();
+		processMeshTransformQueue();
 		processMeshEraseQueue();
+		//the copies run while the next frame records, it picks the meshes up once they finished
+		uploadQueue->submit();
 
 		auto end = std::chrono::steady_clock::now();
 		auto frame_elapsed_millis = std::chrono::duration_cast<std::chrono::duration<float,std::milli>>(end-start).count();
@@ -79,130 +89,255 @@ void Rend::mainLoop() {
 		std::cout << frame_elapsed_millis << "\n";
 	}
 
-	vkDeviceWaitIdle(device);
-	cleanup();
+	shutdown();
 }
 
 void Rend::setMaxFPS(int fps) {
 	maxFrameTimeMilli = 1.0f / static_cast<float>(fps) * 1000.0f;
 }
 
+void Rend::requestStop() {
+	stopRequested = true;
+}
+
+void Rend::shutdown() {
+	vkDeviceWaitIdle(device);
+	cleanup();
+}
+
+Rend::FrameStats Rend::renderFrames(uint32_t count) {
+	processMaterialQueue();
+	processMeshQueue();
+	processMeshTransformQueue();
+	processMeshEraseQueue();
+	//a benchmark draws the whole scene from the first frame on
+	uploadQueue->waitIdle();
+	promoteUploadedMeshes();
+
+	std::vector<double> frameMillis;
+	frameMillis.reserve(count);
+
+	auto first = std::chrono::steady_clock::now();
+	for (uint32_t i = 0; i < count; i++) {
+		auto start = std::chrono::steady_clock::now();
+		drawFrame();
+		auto end = std::chrono::steady_clock::now();
+
+		frameMillis.push_back(std::chrono::duration_cast<std::chrono::duration<double,std::milli>>(end - start).count());
+	}
+	vkDeviceWaitIdle(device);
+	auto last = std::chrono::steady_clock::now();
+
+	FrameStats stats{};
+	stats.frames = count;
+	stats.totalMillis = std::chrono::duration_cast<std::chrono::duration<double,std::milli>>(last - first).count();
+	if (frameMillis.empty()) return stats;
+
+	std::sort(frameMillis.begin(), frameMillis.end());
+	stats.minMillis = frameMillis.front();
+	stats.maxMillis = frameMillis.back();
+	stats.medianMillis = frameMillis[frameMillis.size() / 2];
+
+	stats.meshes = drawnMeshes.size();
+	stats.visibleMeshes = visibleMeshes;
+	stats.occludedMeshes = occludedMeshes;
+	stats.occluderTriangles = occlusionBuffer.triangleCount();
+	stats.drawItems = drawItems.size();
+	stats.draws = instancedDraws.draws.size();
+	stats.batches = instancedDraws.batches.size();
+	stats.recordChunks = usedRecordChunks;
+
+	return stats;
+}
+
+FrameCapture Rend::captureFrame() {
+	if (!settings.headless) throw std::runtime_error("Frame capture needs a headless renderer");
+	if (!lastRenderedImage.has_value()) throw std::runtime_error("No frame has been rendered to capture");
+
+	vkDeviceWaitIdle(device);
+
+	FrameCapture capture{};
+	capture.width = swapChainExtent.width;
+	capture.height = swapChainExtent.height;
+	capture.pixels.resize(static_cast<size_t>(capture.width) * capture.height * 4);
+
+	VkBuffer readbackBuffer;
+	DeviceAllocation readbackAllocation;
+	resourceManager->createBuffer(capture.pixels.size(), VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, readbackBuffer, readbackAllocation);
+
+	VkCommandPool readbackPool = resourceManager->createCommandPool();
+	VkCommandBuffer commandBuffer = resourceManager->beginSingleTimeCommands(readbackPool);
+
+	//the render pass leaves the image in TRANSFER_SRC_OPTIMAL and its outgoing dependency makes the resolve visible to transfers
+	VkBufferImageCopy region{};
+	region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+	region.imageSubresource.layerCount = 1;
+	region.imageExtent = {capture.width, capture.height, 1};
+	vkCmdCopyImageToBuffer(commandBuffer, swapChainImages[lastRenderedImage.value()], VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, readbackBuffer, 1, &region);
+
+	VkMemoryBarrier hostBarrier{};
+	hostBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+	hostBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	hostBarrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+	vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_HOST_BIT, 0, 1, &hostBarrier, 0, nullptr, 0, nullptr);
+
+	resourceManager->endSingleTimeCommands(commandBuffer, readbackPool);
+
+	memcpy(capture.pixels.data(), readbackAllocation.mapped, capture.pixels.size());
+	resourceManager->destroyBuffer(readbackBuffer, readbackAllocation);
+
+	return capture;
+}
+
 
 void Rend::initVulkan() {
-	createSwapChain(); 
+	if (settings.headless)
+		createOffscreenImages();
+	else
+		createSwapChain(); 
 	createImageViews();
 	createRenderPass();
 
-	uboDescriptorSetLayout = resourceManager->createDescriptorSetLayout(1,0,0);
+	uboDescriptorSetLayout = resourceManager->createDescriptorSetLayout(1,0,0,1);
 	samplerDescriptorSetLayout = resourceManager->createDescriptorSetLayout(0,1,0);
 
-	VkShaderModule vertShader = resourceManager->createShaderModule(resourceManager->readFile("/home/vi/Documents/Game-Engines/Skadi-Engine/Shaders/vert.spv"));
-	VkShaderModule fragShader = resourceManager->createShaderModule(resourceManager->readFile("/home/vi/Documents/Game-Engines/Skadi-Engine/Shaders/frag.spv"));
-	VkPushConstantRange transformRange{};
-	transformRange.offset = 0;
-	transformRange.size = 64;
-	transformRange.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
-
-	graphicsPipeline = resourceManager->createGraphicsPipeline(vertShader, fragShader, swapChainExtent, renderPass, displayInstance->msaaSamples, {uboDescriptorSetLayout, samplerDescriptorSetLayout},{transformRange});
+	VkShaderModule vertShader = resourceManager->createShaderModule(resourceManager->readFile(settings.shaderDirectory / "vert.spv"));
+	VkShaderModule fragShader = resourceManager->createShaderModule(resourceManager->readFile(settings.shaderDirectory / "frag.spv"));
+	//transforms come from the instance buffer, so the pipelines take no push constants
+	graphicsPipeline = resourceManager->createGraphicsPipeline(vertShader, fragShader, swapChainExtent, renderPass, displayInstance->msaaSamples, {uboDescriptorSetLayout, samplerDescriptorSetLayout},{});
 	vkDestroyShaderModule(device, vertShader, nullptr);
+
+	VkShaderModule quantizedVertShader = resourceManager->createShaderModule(resourceManager->readFile(settings.shaderDirectory / "quantized_vert.spv"));
+	quantizedPipeline = resourceManager->createGraphicsPipeline(quantizedVertShader, fragShader, swapChainExtent, renderPass, displayInstance->msaaSamples, {uboDescriptorSetLayout, samplerDescriptorSetLayout},{}, VertexLayout::Quantized);
+	vkDestroyShaderModule(device, quantizedVertShader, nullptr);
 	vkDestroyShaderModule(device, fragShader, nullptr);
 
 	commandPool = resourceManager->createCommandPool();
+	uploadQueue = new UploadQueue(*resourceManager, *vInstance, *displayInstance);
+	meshArena = new MeshArena(*resourceManager, *uploadQueue, device);
 	createColorResources();
 	createDepthResources();
 	createFramebuffers();
 
 	createUniformBuffers();
 	createCommandBuffers();
+	createRecordChunks();
 	createSyncObjects();
 
-	uboDescriptorPool = resourceManager->createDescriptorPool(MAX_FRAMES_IN_FLIGHT, 1, 0);
+	uboDescriptorPool = resourceManager->createDescriptorPool(MAX_FRAMES_IN_FLIGHT, 1, 0, 1);
 	uboDescriptorSets = resourceManager->createUBODescriptorSets(uboDescriptorPool, uboDescriptorSetLayout, uniformBuffers, MAX_FRAMES_IN_FLIGHT);
+	createDrawBuffers();
 
 	std::cout << "Initialized Vulkan\n";
 }
 
 void Rend::renderMesh(Mesh mesh) {
-	meshQueue.push(mesh);
+	std::lock_guard lock(meshRenderMutex);
+	meshQueue.push(std::move(mesh));
 }
 
 void Rend::updateMeshTransform(uuids::uuid uuid, glm::mat4 transform) {
-	if (vulkMeshes.contains(uuid))
-		vulkMeshes[uuid].mesh.transform = transform;
-	else
-		std::cout << "REND: Mesh ID: " << uuid << " is not a model ID\n";
+	std::lock_guard lock(meshRenderMutex);
+	meshTransformQueue.push({uuid, transform});
 }
 
 void Rend::updateMesh(Mesh mesh) {
-	meshQueue.push(mesh);
+	std::lock_guard lock(meshRenderMutex);
+	meshQueue.push(std::move(mesh));
 }
 
 void Rend::eraseMesh(uuids::uuid uuid) {
+	std::lock_guard lock(meshRenderMutex);
 	meshEraseQueue.push(uuid);
 }
 
 //Change to material that has list of textures
 void Rend::registerMaterial(Material &material) {
+	std::lock_guard lock(materialRegisterMutex);
 	materialQueue.push(material);
 }
 
 void Rend::processMaterialQueue() {
-	if (!meshQueue.empty())
-		std::cout << "REND: Queueing " << materialQueue.size() << " materials\n";
+	//like meshes, taken out under the lock so registering never waits on texture uploads
+	std::vector<Material> materials;
+	{
+		std::lock_guard lock(materialRegisterMutex);
+		materials.reserve(materialQueue.size());
+		while (!materialQueue.empty()) {
+			materials.push_back(std::move(materialQueue.front()));
+			materialQueue.pop();
+		}
+	}
+
+	if (!materials.empty())
+		std::cout << "REND: Queueing " << materials.size() << " materials\n";
 
-	while (!materialQueue.empty()) {
-		Material material = materialQueue.front();
+	for (const Material &material : materials) {
+		//cached models hand out content derived material IDs, a repeat reuses the registered material and creates nothing
+		if (vulkMaterials.contains(material.id)) continue;
 
 		VulkMaterial vulkMaterial{};
 		vulkMaterial.pool = resourceManager->createDescriptorPool(MAX_FRAMES_IN_FLIGHT, 0, material.textures.size());
 		vulkMaterial.layout = resourceManager->createDescriptorSetLayout(0,material.textures.size(),0);
 
-		for (auto [id, texture] : material.textures) {
+		for (const auto &[id, texture] : material.textures) {
 			vulkMaterial.textures.push_back(createVulkTexture(texture));
 		}
 
-		if (vulkMaterials.contains(material.id)) {
-			std::cout << "Failed to register material. ID: " << material.id << " is already registered.\n";
-			return;
-		}
-
 		vulkMaterial.sets = resourceManager->createImageDescriptorSets(vulkMaterial.pool, vulkMaterial.layout, vulkMaterial.textures, MAX_FRAMES_IN_FLIGHT);
+		vulkMaterial.sortIndex = registeredMaterials++;
 		vulkMaterials[material.id] = vulkMaterial;
-
-		materialQueue.pop();
 	}
 }
 
 
 void Rend::processMeshQueue() {
-	if (!meshQueue.empty())
-		std::cout << "REND: Queuing " << meshQueue.size() << " meshes\n";
-	while (!meshQueue.empty()) {
-		Mesh mesh = meshQueue.front();
-
-		//if a mesh already exists with this id, free buffers so they can be recreated
-		if (vulkMeshes.contains(mesh.id)) {
-			auto &originalMesh = vulkMeshes.at(mesh.id);
-
-			resourceManager->destroyTransferBuffer(originalMesh.indexBuffer);
-			resourceManager->destroyTransferBuffer(originalMesh.vertexBuffer);
+	//taken out under the lock, callers queueing more meshes never wait on the uploads below
+	std::vector<Mesh> meshes;
+	{
+		std::lock_guard lock(meshRenderMutex);
+		meshes.reserve(meshQueue.size());
+		while (!meshQueue.empty()) {
+			meshes.push_back(std::move(meshQueue.front()));
+			meshQueue.pop();
 		}
+	}
 
-		TransferBuffer vertexBuffer = resourceManager->createTransferBuffer(VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, mesh.vertices.size() * sizeof(Vertex));
-		TransferBuffer indexBuffer = resourceManager->createTransferBuffer(VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT, mesh.indices.size() * sizeof(uint32_t));
+	if (!meshes.empty())
+		std::cout << "REND: Queuing " << meshes.size() << " meshes\n";
+	for (const Mesh &mesh : meshes) {
+
+		//an edit that keeps the mesh's shape only writes what changed over the drawn mesh, in the next frame ahead of its draws
+		if (!pendingMeshes.contains(mesh.id) && vulkMeshes.contains(mesh.id)
+				&& meshArena->canUpdateInPlace(vulkMeshes.at(mesh.id).allocation, vulkMeshes.at(mesh.id).mesh, mesh)) {
+			VulkMesh &vulkMesh = vulkMeshes.at(mesh.id);
+			meshArena->update(vulkMesh.allocation, vulkMesh.mesh, mesh);
+
+			if (mesh.materialID != vulkMesh.mesh.materialID && vulkMaterials.contains(mesh.materialID)) {
+				vulkMesh.textureDescriptors = vulkMaterials.at(mesh.materialID).sets;
+				vulkMesh.materialSortIndex = vulkMaterials.at(mesh.materialID).sortIndex;
+			}
+			vulkMesh.mesh = mesh;
+			vulkMesh.occluder = mesh.occluder ? std::make_shared<const Occluder>(Occluder::fromMesh(mesh)) : nullptr;
+			continue;
+		}
 
-		resourceManager->transferBufferWrite<Vertex>(vertexBuffer, mesh.vertices);
-		resourceManager->transferBufferWrite<uint32_t>(indexBuffer, mesh.indices);
+		//an upload still in flight for this id is superseded, the mesh it replaces stays drawn until this one lands
+		if (pendingMeshes.contains(mesh.id)) {
+			retireMeshAllocation(pendingMeshes.at(mesh.id).vulkMesh.allocation);
+		}
 
+		//packaged meshes hand out spans into the mapped file, so upload reads straight from it
 		VulkMesh vulkMesh{};
 		vulkMesh.mesh = mesh;
-		vulkMesh.vertexBuffer = vertexBuffer;
-		vulkMesh.indexBuffer = indexBuffer;
+		vulkMesh.allocation = meshArena->upload(mesh);
+		if (mesh.occluder) vulkMesh.occluder = std::make_shared<const Occluder>(Occluder::fromMesh(mesh));
 
 		std::vector<VkDescriptorSet> bindSets;
 
 		if (vulkMaterials.contains(mesh.materialID)) {
 			bindSets = vulkMaterials.at(mesh.materialID).sets;
+			vulkMesh.materialSortIndex = vulkMaterials.at(mesh.materialID).sortIndex;
 		}
 		else {
 			std::cout << "Failed to bind texture: " << mesh.materialID << '\n';
@@ -210,23 +345,75 @@ void Rend::processMeshQueue() {
 
 		vulkMesh.textureDescriptors = bindSets;
 
-		vulkMeshes[mesh.id] = vulkMesh;
+		//the ticket also covers the material's textures, they were recorded before
+		pendingMeshes[mesh.id] = {uploadQueue->ticket(), vulkMesh};
+	}
+}
+
+void Rend::promoteUploadedMeshes() {
+	std::erase_if(pendingMeshes, [this](const auto &entry) {
+		const auto &[id, pending] = entry;
+		if (!uploadQueue->isComplete(pending.uploadTicket)) return false;
 
-		meshQueue.pop();
+		//if a mesh already exists with this id, its arena ranges are released once no frame in flight draws from them
+		if (vulkMeshes.contains(id)) {
+			retireMeshAllocation(vulkMeshes.at(id).allocation);
+		}
+		vulkMeshes[id] = pending.vulkMesh;
+		return true;
+	});
+}
+
+void Rend::retireMeshAllocation(const MeshArena::Allocation &allocation) {
+	retiredMeshAllocations.push_back({submittedFrames, allocation});
+}
+
+///Gives ranges back to the arena once every frame that could draw from them has finished
+///Call after waiting on the fence of the frame about to be recorded, that finishes everything up to MAX_FRAMES_IN_FLIGHT frames back
+void Rend::releaseRetiredMeshAllocations() {
+	std::erase_if(retiredMeshAllocations, [this](const RetiredAllocation &retired) {
+		if (submittedFrames + 1 < retired.retiredAt + MAX_FRAMES_IN_FLIGHT) return false;
+
+		meshArena->free(retired.allocation);
+		return true;
+	});
+}
+
+///Runs after processMeshQueue so a transform sent right after its mesh lands on the upload still pending
+void Rend::processMeshTransformQueue() {
+	std::lock_guard lock(meshRenderMutex);
+	while (!meshTransformQueue.empty()) {
+		const MeshTransform &update = meshTransformQueue.front();
+		auto pending = pendingMeshes.find(update.id);
+		auto drawn = vulkMeshes.find(update.id);
+
+		if (pending != pendingMeshes.end())
+			pending->second.vulkMesh.mesh.transform = update.transform;
+		if (drawn != vulkMeshes.end())
+			drawn->second.mesh.transform = update.transform;
+		else if (pending == pendingMeshes.end())
+			std::cout << "REND: Mesh ID: " << update.id << " is not a model ID\n";
+
+		meshTransformQueue.pop();
 	}
 }
 
 void Rend::processMeshEraseQueue() {
+	std::lock_guard lock(meshRenderMutex);
 	if (!meshEraseQueue.empty())
 		std::cout << "REND: Erasing " << meshEraseQueue.size() << " meshes\n";
 	while (!meshEraseQueue.empty()) {
 		uuids::uuid meshID = meshEraseQueue.front();
 
-		auto &mesh = vulkMeshes[meshID];
-		resourceManager->destroyTransferBuffer(mesh.indexBuffer);
-		resourceManager->destroyTransferBuffer(mesh.vertexBuffer);
+		if (pendingMeshes.contains(meshID)) {
+			retireMeshAllocation(pendingMeshes.at(meshID).vulkMesh.allocation);
+			pendingMeshes.erase(meshID);
+		}
 
-		vulkMeshes.erase(meshID);
+		if (vulkMeshes.contains(meshID)) {
+			retireMeshAllocation(vulkMeshes.at(meshID).allocation);
+			vulkMeshes.erase(meshID);
+		}
 
 		meshEraseQueue.pop();
 	}
@@ -324,14 +511,25 @@ void Rend::createSwapChain() {
 	swapChainExtent = extent;
 }
 
+///Stands in for the swapchain when headless, RGBA so a capture reads back in FrameCapture's channel order
+void Rend::createOffscreenImages() {
+	swapChainImageFormat = VK_FORMAT_R8G8B8A8_SRGB;
+	swapChainExtent = {settings.width, settings.height};
+
+	swapChainImages.resize(MAX_FRAMES_IN_FLIGHT);
+	offscreenImageAllocations.resize(MAX_FRAMES_IN_FLIGHT);
+	for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
+		resourceManager->createImage(swapChainExtent.width, swapChainExtent.height, 1, VK_SAMPLE_COUNT_1_BIT, swapChainImageFormat, VK_IMAGE_TILING_OPTIMAL,
+			VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, swapChainImages[i], offscreenImageAllocations[i]);
+	}
+}
+
 void Rend::cleanupSwapChain() {
 	vkDestroyImageView(device, colorImageView, nullptr);
-	vkDestroyImage(device, colorImage, nullptr);
-	vkFreeMemory(device, colorImageMemory, nullptr);
+	resourceManager->destroyImage(colorImage, colorImageAllocation);
 
 	vkDestroyImageView(device, depthImageView, nullptr);
-	vkDestroyImage(device, depthImage, nullptr);
-	vkFreeMemory(device, depthImageMemory, nullptr);
+	resourceManager->destroyImage(depthImage, depthImageAllocation);
 
 	for (auto framebuffer : swapChainFramebuffers) {
 		vkDestroyFramebuffer(device, framebuffer, nullptr);
@@ -341,6 +539,13 @@ void Rend::cleanupSwapChain() {
 		vkDestroyImageView(device, imageView, nullptr);
 	}
 
+	if (settings.headless) {
+		for (size_t i = 0; i < swapChainImages.size(); i++) {
+			resourceManager->destroyImage(swapChainImages[i], offscreenImageAllocations[i]);
+		}
+		return;
+	}
+
 	vkDestroySwapchainKHR(device, swapChain, nullptr);	
 }
 
@@ -427,7 +632,7 @@ bool Rend::hasStencilComponent(VkFormat format) {
 void Rend::createDepthResources() {
 	VkFormat depthFormat = findDepthFormat();
 
-	resourceManager->createImage(swapChainExtent.width, swapChainExtent.height, 1, displayInstance->msaaSamples, depthFormat, VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, depthImage, depthImageMemory);
+	resourceManager->createImage(swapChainExtent.width, swapChainExtent.height, 1, displayInstance->msaaSamples, depthFormat, VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, depthImage, depthImageAllocation);
 	depthImageView = resourceManager->createImageView(depthImage, depthFormat, VK_IMAGE_ASPECT_DEPTH_BIT, 1);
 }
 
@@ -438,12 +643,12 @@ void Rend::createColorResources() {
 			VK_IMAGE_TILING_OPTIMAL, 
 			VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT, 
 			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, 
-			colorImage, colorImageMemory);
+			colorImage, colorImageAllocation);
 
 	colorImageView = resourceManager->createImageView(colorImage, colorFormat, VK_IMAGE_ASPECT_COLOR_BIT, 1);
 }
 
-VulkTexture Rend::createVulkTexture(Texture texture) {
+VulkTexture Rend::createVulkTexture(const Texture &texture) {
 	VulkTexture vulkTexture{};
 
 	updateImage(texture, vulkTexture);
@@ -453,35 +658,43 @@ VulkTexture Rend::createVulkTexture(Texture texture) {
 	return vulkTexture;
 }
 
-void Rend::updateImage(Texture texture, VulkTexture &vulkTexture) {
+void Rend::updateImage(const Texture &texture, VulkTexture &vulkTexture) {
 	vulkTexture.texture = texture;
+	VkFormat format = textureVkFormat(texture.format);
 
-	VkBuffer stagingBuffer{};
-	VkDeviceMemory stagingBufferMemory{};
-	resourceManager->createBuffer(texture.byteSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, stagingBuffer, stagingBufferMemory);
-	
-	void *data;
-	vkMapMemory(device, stagingBufferMemory, 0, texture.byteSize, 0, &data);
-	memcpy(data, texture.pixels, texture.byteSize);
-	vkUnmapMemory(device, stagingBufferMemory);
-
-	resourceManager->createImage(texture.width, texture.height, texture.mipLevels, VK_SAMPLE_COUNT_1_BIT, VK_FORMAT_R8G8B8A8_SRGB, VK_IMAGE_TILING_OPTIMAL,
-			VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, vulkTexture.image, vulkTexture.imageMemory);
+	//block formats cannot be blitted, so they have to arrive with every level
+	if (texture.format != TextureFormat::RGBA8 && texture.mipOffsets.size() != texture.mipLevels) {
+		throw std::runtime_error("Compressed texture is missing mip levels");
+	}
 
-	//Transition image to be able to be copied to
-	resourceManager->transitionImageLayout(vulkTexture.image, VK_FORMAT_R8G8B8A8_SRGB, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, texture.mipLevels);
+	resourceManager->createImage(texture.width, texture.height, texture.mipLevels, VK_SAMPLE_COUNT_1_BIT, format, VK_IMAGE_TILING_OPTIMAL,
+			VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, vulkTexture.image, vulkTexture.imageAllocation);
 
-	//copy to staging buffer to image
-	resourceManager->copyBufferToImage(stagingBuffer, vulkTexture.image, texture.width, texture.height);
+	//cooked textures carry their whole mip chain, copy every level and skip the blit
+	if (texture.mipOffsets.size() == texture.mipLevels) {
+		UploadQueue::Staging staging = uploadQueue->stage(texture.byteSize);
+		memcpy(staging.mapped, texture.pixels, texture.byteSize);
+		uploadQueue->copyToImage(staging, vulkTexture.image, texture.width, texture.height, texture.mipLevels, texture.mipOffsets, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+	}
+	else if (uploadQueue->supportsGraphics()) {
+		UploadQueue::Staging staging = uploadQueue->stage(texture.byteSize);
+		memcpy(staging.mapped, texture.pixels, texture.byteSize);
+		uploadQueue->copyToImage(staging, vulkTexture.image, texture.width, texture.height, texture.mipLevels, {0}, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
 
-	//transition image to be readable by shader
-	//transitionImageLayout(textureImage, VK_FORMAT_R8G8B8A8_SRGB, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, mipLevels);
-	
-	//mipmap generation should not be done at runtime but this does work
-	generateMipMaps(vulkTexture.image, VK_FORMAT_R8G8B8A8_SRGB, texture.width,texture.height, texture.mipLevels);
+		//mipmap generation should not be done at runtime but this does work
+		generateMipMaps(uploadQueue->commandBuffer(), vulkTexture.image, format, texture.width,texture.height, texture.mipLevels);
+	}
+	else {
+		//a transfer queue cannot blit, so the levels are filtered on the CPU straight into staging
+		std::vector<uint64_t> mipOffsets;
+		uint64_t chainSize = TextureProcessing::mipChainLayout(texture.width, texture.height, mipOffsets);
+		UploadQueue::Staging staging = uploadQueue->stage(chainSize);
+		TextureProcessing::generateMipChain(texture.pixels, texture.width, texture.height, static_cast<uint8_t *>(staging.mapped), {.srgb = true});
+		uploadQueue->copyToImage(staging, vulkTexture.image, texture.width, texture.height, texture.mipLevels, mipOffsets, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+	}
 
-	vkDestroyBuffer(device, stagingBuffer, nullptr);
-	vkFreeMemory(device, stagingBufferMemory, nullptr);
+	//the pixels are in staging memory now, so the GPU image is the only copy the renderer needs
+	vulkTexture.texture.releasePixels();
 }
 
 void Rend::updateSampler(VkPhysicalDeviceProperties physicalDeviceProperties, VulkTexture &vulkTexture) {
@@ -516,10 +729,11 @@ void Rend::updateSampler(VkPhysicalDeviceProperties physicalDeviceProperties, Vu
 }
 
 void Rend::updateImageView(VulkTexture &vulkTexture) {
-	vulkTexture.imageView = resourceManager->createImageView(vulkTexture.image, VK_FORMAT_R8G8B8A8_SRGB, VK_IMAGE_ASPECT_COLOR_BIT, vulkTexture.texture.mipLevels);
+	vulkTexture.imageView = resourceManager->createImageView(vulkTexture.image, textureVkFormat(vulkTexture.texture.format), VK_IMAGE_ASPECT_COLOR_BIT, vulkTexture.texture.mipLevels);
 }
 
-void Rend::generateMipMaps(VkImage image, VkFormat imageFormat, uint32_t texWidth, uint32_t texHeight, uint32_t mipLevels) {
+///Records blits that fill every level from level 0, all levels are TRANSFER_DST_OPTIMAL and end SHADER_READ_ONLY_OPTIMAL
+void Rend::generateMipMaps(VkCommandBuffer commandBuffer, VkImage image, VkFormat imageFormat, uint32_t texWidth, uint32_t texHeight, uint32_t mipLevels) {
 	//Make sure image can be mipmapped
 	VkFormatProperties formatProperties;
 	vkGetPhysicalDeviceFormatProperties(physicalDevice, imageFormat, &formatProperties);
@@ -527,9 +741,6 @@ void Rend::generateMipMaps(VkImage image, VkFormat imageFormat, uint32_t texWidt
 	if (!(formatProperties.optimalTilingFeatures & VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT)) {
 		throw std::runtime_error("Texture image format does not support linear blitting");
 	}
-	
-	VkCommandPool commandPool = resourceManager->createCommandPool();
-	VkCommandBuffer commandBuffer = resourceManager->beginSingleTimeCommands(commandPool);
 
 	VkImageMemoryBarrier barrier{};
 	barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
@@ -606,8 +817,6 @@ void Rend::generateMipMaps(VkImage image, VkFormat imageFormat, uint32_t texWidt
 		0, nullptr,
 		0, nullptr,
 		1, &barrier);
-
-	resourceManager->endSingleTimeCommands(commandBuffer, commandPool);
 }
 
 void Rend::createCommandBuffers() {
@@ -624,16 +833,82 @@ void Rend::createCommandBuffers() {
 	}
 }
 
+///A chunk for every thread that records, the render thread included, each with its own pools of secondary buffers
+void Rend::createRecordChunks() {
+	uint32_t threads = settings.recordThreads != 0 ? settings.recordThreads : std::max(1u, std::thread::hardware_concurrency()) - 1;
+	recordPool = new ThreadPool(threads);
+	recordChunks.resize(recordPool->size() + 1);
+
+	for (RecordChunk &chunk : recordChunks) {
+		chunk.pools.resize(MAX_FRAMES_IN_FLIGHT);
+		chunk.commandBuffers.resize(MAX_FRAMES_IN_FLIGHT);
+
+		for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
+			//transient, the pool is reset every time its frame slot records again
+			VkCommandPoolCreateInfo poolInfo{};
+			poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+			poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+			poolInfo.queueFamilyIndex = displayInstance->queueFamilyIndecies.graphicsFamily.value();
+
+			if (vkCreateCommandPool(device, &poolInfo, nullptr, &chunk.pools[i]) != VK_SUCCESS) {
+				throw std::runtime_error("Failed to create record command pool");
+			}
+
+			VkCommandBufferAllocateInfo allocInfo{};
+			allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+			allocInfo.commandPool = chunk.pools[i];
+			allocInfo.level = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+			allocInfo.commandBufferCount = 1;
+
+			if (vkAllocateCommandBuffers(device, &allocInfo, &chunk.commandBuffers[i]) != VK_SUCCESS) {
+				throw std::runtime_error("Failed to allocate secondary command buffers");
+			}
+		}
+	}
+}
+
+///Instance and indirect buffers of every frame slot, the instance buffers are bound through the slot's ubo descriptor set
+void Rend::createDrawBuffers() {
+	//a few hundred draws before anything has to grow
+	constexpr VkDeviceSize initialDraws = 256;
+
+	useIndirectDraws = settings.indirectDraws && vInstance->drawIndirectFirstInstance;
+	instanceBuffers.resize(MAX_FRAMES_IN_FLIGHT);
+	indirectBuffers.resize(MAX_FRAMES_IN_FLIGHT);
+
+	for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
+		reserveFrameBuffer(instanceBuffers[i], initialDraws * sizeof(glm::mat4), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT);
+		resourceManager->updateStorageDescriptor(uboDescriptorSets[i], 3, instanceBuffers[i].buffer, instanceBuffers[i].capacity);
+
+		if (useIndirectDraws) {
+			reserveFrameBuffer(indirectBuffers[i], initialDraws * sizeof(VkDrawIndexedIndirectCommand), VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT);
+		}
+	}
+}
+
+///Only for the slot being recorded, the frame that used it before has finished so the old buffer can go right away
+bool Rend::reserveFrameBuffer(FrameBuffer &frameBuffer, VkDeviceSize size, VkBufferUsageFlags usage) {
+	if (size <= frameBuffer.capacity) return false;
+
+	if (frameBuffer.buffer != VK_NULL_HANDLE) {
+		resourceManager->destroyBuffer(frameBuffer.buffer, frameBuffer.allocation);
+	}
+
+	frameBuffer.capacity = std::bit_ceil(std::max(size, frameBuffer.capacity * 2));
+	resourceManager->createBuffer(frameBuffer.capacity, usage, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, frameBuffer.buffer, frameBuffer.allocation);
+	return true;
+}
+
 void Rend::createUniformBuffers() {
 	VkDeviceSize bufferSize = sizeof(UniformBufferObject);
 
 	uniformBuffers.resize(MAX_FRAMES_IN_FLIGHT);
-	uniformBuffersMemory.resize(MAX_FRAMES_IN_FLIGHT);
+	uniformBufferAllocations.resize(MAX_FRAMES_IN_FLIGHT);
 	uniformBuffersMapped.resize(MAX_FRAMES_IN_FLIGHT);
 
 	for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
-		resourceManager->createBuffer(bufferSize, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, uniformBuffers[i], uniformBuffersMemory[i]);
-		vkMapMemory(device, uniformBuffersMemory[i], 0, bufferSize, 0, &uniformBuffersMapped[i]);
+		resourceManager->createBuffer(bufferSize, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, uniformBuffers[i], uniformBufferAllocations[i]);
+		uniformBuffersMapped[i] = uniformBufferAllocations[i].mapped;
 	}
 }
 
@@ -658,7 +933,8 @@ void Rend::createRenderPass() {
 	colorAttachmentResolve.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
 	colorAttachmentResolve.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
 	colorAttachmentResolve.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-	colorAttachmentResolve.finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+	//headless frames are never presented, they stay ready to be copied out by captureFrame
+	colorAttachmentResolve.finalLayout = settings.headless ? VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL : VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
 
 	VkAttachmentDescription depthAttachment{};
 	depthAttachment.format = findDepthFormat();
@@ -697,6 +973,16 @@ void Rend::createRenderPass() {
 	dependency.dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
 	dependency.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
 
+	VkSubpassDependency readbackDependency{};
+	readbackDependency.srcSubpass = 0;
+	readbackDependency.dstSubpass = VK_SUBPASS_EXTERNAL;
+	readbackDependency.srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+	readbackDependency.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+	readbackDependency.dstStageMask = VK_PIPELINE_STAGE_TRANSFER_BIT;
+	readbackDependency.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+
+	std::array<VkSubpassDependency, 2> dependencies = {dependency, readbackDependency};
+
 	std::array<VkAttachmentDescription, 3> attachments = {colorAttachment, depthAttachment, colorAttachmentResolve};
 	VkRenderPassCreateInfo renderPassInfo{};
 	renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
@@ -704,8 +990,8 @@ void Rend::createRenderPass() {
 	renderPassInfo.pAttachments = attachments.data();
 	renderPassInfo.subpassCount = 1;
 	renderPassInfo.pSubpasses = &subpass;
-	renderPassInfo.dependencyCount = 1;
-	renderPassInfo.pDependencies = &dependency;
+	renderPassInfo.dependencyCount = settings.headless ? 2 : 1;
+	renderPassInfo.pDependencies = dependencies.data();
 
 	if (vkCreateRenderPass(device, &renderPassInfo, nullptr, &renderPass) != VK_SUCCESS) {
 		throw std::runtime_error("failed to create render pass!");
@@ -743,6 +1029,8 @@ void Rend::recordCommandBuffer(VkCommandBuffer commandBuffer, uint32_t imageInde
 		throw std::runtime_error("Failed to begin recording command buffer");
 	}
 
+	meshArena->recordWrites(commandBuffer, frame);
+
 	VkRenderPassBeginInfo renderPassInfo{};
 	renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
 	renderPassInfo.renderPass = renderPass;
@@ -757,22 +1045,6 @@ void Rend::recordCommandBuffer(VkCommandBuffer commandBuffer, uint32_t imageInde
 	renderPassInfo.clearValueCount = static_cast<uint32_t>(clearValues.size());
 	renderPassInfo.pClearValues = clearValues.data();
 
-	vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
-	vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, graphicsPipeline.pipeline);
-
-	VkViewport viewport{};
-	viewport.x = 0.0f;
-	viewport.y = 0.0f;
-	viewport.width = static_cast<float>(swapChainExtent.width);
-	viewport.height = static_cast<float>(swapChainExtent.height);
-	viewport.minDepth = 0.0f;
-	viewport.maxDepth = 1.0f;
-	vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
-
-	VkRect2D scissor{};
-	scissor.extent = swapChainExtent;
-	vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
-
 	// UniformBufferObject ubo{};
 	// //ubo.view = glm::lookAt(glm::vec3(2.0f,2.0f,2.0f), glm::vec3(0.0f,0.0f,0.0f), glm::vec3(0.0f,0.0f,1.0f));
 	// //ubo.view = glm::rotate(translate(glm::mat4(1), glm::vec3(0,0,-4)), glm::radians(-50.0f), glm::vec3(1,0,0));
@@ -785,34 +1057,254 @@ void Rend::recordCommandBuffer(VkCommandBuffer commandBuffer, uint32_t imageInde
 		std::cout << "resize to: " << displayInstance->windowWidth << ", " << displayInstance->windowHeight << "\n";
 	}
 
-	updateUniformBuffer(camera.getUBO());
-
-	//vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, graphicsPipeline.layout, 0, 1, &uboDescriptorSets[frame], 0, nullptr);
+	UniformBufferObject ubo = camera.getUBO();
+	updateUniformBuffer(ubo);
 
+	drawnMeshes.clear();
 	for (const auto & [ id, vulkMesh ] : vulkMeshes) {
-		std::vector sets{uboDescriptorSets[frame],vulkMesh.textureDescriptors[frame]};
-		vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, graphicsPipeline.layout, 0, sets.size(), sets.data(), 0, nullptr);
+		//meshes whose material never registered have nothing to sample
+		if (vulkMesh.textureDescriptors.empty()) continue;
+		drawnMeshes.push_back(&vulkMesh);
+	}
+
+	//below a few hundred meshes or draws per chunk, handing work to another thread costs more than it saves
+	constexpr uint32_t minWorkPerChunk = 256;
+	auto chunkCount = [this](size_t work) {
+		return std::clamp<uint32_t>(static_cast<uint32_t>(work / minWorkPerChunk), 1, static_cast<uint32_t>(recordChunks.size()));
+	};
 
-		VkBuffer vertexBuffers[] = {vulkMesh.vertexBuffer.buffer};
-		VkDeviceSize offsets[] = {0};
-		vkCmdBindVertexBuffers(commandBuffer, 0, 1, vertexBuffers, offsets);
-		vkCmdBindIndexBuffer(commandBuffer, vulkMesh.indexBuffer.buffer, 0, VK_INDEX_TYPE_UINT32);
+	//world space planes, extracted once for every mesh of the frame
+	glm::mat4 viewProj = ubo.proj * ubo.view;
+	Frustum frustum = Frustum::fromMatrix(viewProj);
+
+	//occluders are rasterized before anything is tested against them
+	const OcclusionBuffer *occlusion = settings.occlusionCulling && rasterizeOccluders(viewProj, frustum) ? &occlusionBuffer : nullptr;
+
+	uint32_t meshChunks = chunkCount(drawnMeshes.size());
+	recordPool->parallelFor(meshChunks, [&](uint32_t i) {
+		gatherDrawItems(recordChunks[i], uint64_t{drawnMeshes.size()} * i / meshChunks, uint64_t{drawnMeshes.size()} * (i + 1) / meshChunks, ubo, frustum, occlusion);
+	});
+
+	//chunks hold consecutive meshes, so joining them in order keeps the list the same whatever the chunk count
+	drawItems.clear();
+	visibleMeshes = 0;
+	occludedMeshes = 0;
+	for (uint32_t i = 0; i < meshChunks; i++) {
+		drawItems.insert(drawItems.end(), recordChunks[i].items.begin(), recordChunks[i].items.end());
+		visibleMeshes += recordChunks[i].visible.size();
+		occludedMeshes += recordChunks[i].occluded;
+	}
+
+	//sorted by state, so every bind below happens once per batch, and meshes sharing geometry and material become one draw
+	buildInstancedDraws(drawItems, instancedDraws);
 
+	if (reserveFrameBuffer(instanceBuffers[frame], instancedDraws.transforms.size() * sizeof(glm::mat4), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT)) {
+		resourceManager->updateStorageDescriptor(uboDescriptorSets[frame], 3, instanceBuffers[frame].buffer, instanceBuffers[frame].capacity);
+	}
+	memcpy(instanceBuffers[frame].allocation.mapped, instancedDraws.transforms.data(), instancedDraws.transforms.size() * sizeof(glm::mat4));
 
-		glm::mat4 transform = vulkMesh.mesh.transform;
-		vkCmdPushConstants(commandBuffer, graphicsPipeline.layout, VK_SHADER_STAGE_VERTEX_BIT, 0, 64, &transform);
+	if (useIndirectDraws) {
+		reserveFrameBuffer(indirectBuffers[frame], instancedDraws.draws.size() * sizeof(VkDrawIndexedIndirectCommand), VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT);
+		memcpy(indirectBuffers[frame].allocation.mapped, instancedDraws.draws.data(), instancedDraws.draws.size() * sizeof(VkDrawIndexedIndirectCommand));
+	}
 
-		vkCmdDrawIndexed(commandBuffer, vulkMesh.indexBuffer.objectCount, 1, 0, 0, 0);
+	//descriptor updates are done, the chunks only read what the frame set up from here on
+	uint32_t drawCount = instancedDraws.draws.size();
+	usedRecordChunks = chunkCount(drawCount);
+	VkFramebuffer framebuffer = swapChainFramebuffers[imageIndex];
+	recordPool->parallelFor(usedRecordChunks, [&](uint32_t i) {
+		recordDrawChunk(recordChunks[i], framebuffer, uint64_t{drawCount} * i / usedRecordChunks, uint64_t{drawCount} * (i + 1) / usedRecordChunks);
+	});
+
+	std::vector<VkCommandBuffer> secondaryBuffers(usedRecordChunks);
+	for (uint32_t i = 0; i < usedRecordChunks; i++) {
+		secondaryBuffers[i] = recordChunks[i].commandBuffers[frame];
 	}
 
+	//a render pass with secondary contents may only execute commands, everything else is recorded in the chunks
+	vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+	vkCmdExecuteCommands(commandBuffer, secondaryBuffers.size(), secondaryBuffers.data());
 	vkCmdEndRenderPass(commandBuffer);
+
 	if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS) {
 		throw std::runtime_error("Failed to record command buffer");
 	}
 }
 
+bool Rend::rasterizeOccluders(const glm::mat4 &viewProj, const Frustum &frustum) {
+	occluderMeshes.clear();
+	for (const VulkMesh *vulkMesh : drawnMeshes) {
+		if (!vulkMesh->occluder) continue;
+
+		glm::vec4 sphere = FrustumCulling::worldSphere(vulkMesh->mesh.transform, vulkMesh->mesh.bounds);
+		if (frustum.intersectsSphere(glm::vec3(sphere), sphere.w)) occluderMeshes.push_back(vulkMesh);
+	}
+
+	if (occluderMeshes.empty()) {
+		//cleared anyway, so the frame's stats do not report the triangles of an earlier one
+		occlusionBuffer.begin(viewProj, 0);
+		return false;
+	}
+
+	//every chunk bins its share of occluders apart, then every tile is rasterized from all of their bins
+	uint32_t occluderChunks = std::min<uint32_t>(occluderMeshes.size(), recordChunks.size());
+	occlusionBuffer.begin(viewProj, occluderChunks);
+	recordPool->parallelFor(occluderChunks, [this, occluderChunks](uint32_t i) {
+		uint32_t first = uint64_t{occluderMeshes.size()} * i / occluderChunks;
+		uint32_t end = uint64_t{occluderMeshes.size()} * (i + 1) / occluderChunks;
+		for (uint32_t j = first; j < end; j++) {
+			occlusionBuffer.addOccluder(i, *occluderMeshes[j]->occluder, occluderMeshes[j]->mesh.transform);
+		}
+	});
+
+	recordPool->parallelFor(occlusionBuffer.tileCount(), [this](uint32_t tile) { occlusionBuffer.rasterizeTile(tile); });
+	occlusionBuffer.buildPyramid();
+	return true;
+}
+
+void Rend::gatherDrawItems(RecordChunk &chunk, uint32_t firstMesh, uint32_t endMesh, const UniformBufferObject &ubo, const Frustum &frustum, const OcclusionBuffer *occlusion) {
+	chunk.items.clear();
+	chunk.spheres.clear();
+	chunk.visible.clear();
+	chunk.occluded = 0;
+
+	//whole meshes out of view are dropped in one wide pass, before any per mesh work
+	for (uint32_t i = firstMesh; i < endMesh; i++) {
+		const Mesh &mesh = drawnMeshes[i]->mesh;
+		glm::vec4 sphere = FrustumCulling::worldSphere(mesh.transform, mesh.bounds);
+		chunk.spheres.push_back(glm::vec3(sphere), sphere.w);
+	}
+	FrustumCulling::cullSpheres(frustum, chunk.spheres, chunk.visible);
+
+	for (uint32_t visible : chunk.visible) {
+		const VulkMesh &vulkMesh = *drawnMeshes[firstMesh + visible];
+
+		if (occlusion && !occlusion->isVisible(vulkMesh.mesh.bounds.min, vulkMesh.mesh.bounds.max, vulkMesh.mesh.transform)) {
+			chunk.occluded++;
+			continue;
+		}
+
+		//visible meshes still drop sub meshes and clusters out of view or facing away
+		uint32_t level = selectLod(vulkMesh.mesh, ubo.view, ubo.proj, swapChainExtent.height);
+		buildDrawRanges(vulkMesh.mesh, level, ubo.view, ubo.proj, chunk.drawRanges);
+
+		const MeshArena::Allocation &allocation = vulkMesh.allocation;
+		glm::mat4 transform = vulkMesh.mesh.drawTransform();
+
+		//nearer meshes first within the same state, so early depth testing rejects what they cover
+		glm::vec4 viewCenter = ubo.view * vulkMesh.mesh.transform * glm::vec4(vulkMesh.mesh.bounds.center, 1.0f);
+		uint32_t depthBucket = SortKey::depthBucket(glm::length(glm::vec3(viewCenter)));
+
+		for (const DrawRange &range : chunk.drawRanges) {
+			uint32_t firstIndex = allocation.firstIndex + range.firstIndex;
+			//opaque geometry is the only pass so far
+			uint64_t sortKey = SortKey::make(0, allocation.layout, vulkMesh.materialSortIndex, allocation.indexType, depthBucket, firstIndex);
+			chunk.items.push_back({sortKey, allocation.layout, vulkMesh.textureDescriptors[frame], allocation.indexType, firstIndex, range.indexCount, allocation.vertexOffset, transform});
+		}
+	}
+}
+
+void Rend::recordDrawChunk(RecordChunk &chunk, VkFramebuffer framebuffer, uint32_t firstDraw, uint32_t endDraw) {
+	VkCommandBuffer commandBuffer = chunk.commandBuffers[frame];
+	//the slot's fence was waited on, so the buffer recorded from this pool last time is done
+	vkResetCommandPool(device, chunk.pools[frame], 0);
+
+	VkCommandBufferInheritanceInfo inheritanceInfo{};
+	inheritanceInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+	inheritanceInfo.renderPass = renderPass;
+	inheritanceInfo.subpass = 0;
+	inheritanceInfo.framebuffer = framebuffer;
+
+	VkCommandBufferBeginInfo beginInfo{};
+	beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+	beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT | VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
+	beginInfo.pInheritanceInfo = &inheritanceInfo;
+
+	if (vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS) {
+		throw std::runtime_error("Failed to begin recording secondary command buffer");
+	}
+
+	//secondary buffers inherit no state, each one sets up everything it draws with
+	VkViewport viewport{};
+	viewport.x = 0.0f;
+	viewport.y = 0.0f;
+	viewport.width = static_cast<float>(swapChainExtent.width);
+	viewport.height = static_cast<float>(swapChainExtent.height);
+	viewport.minDepth = 0.0f;
+	viewport.maxDepth = 1.0f;
+	vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
+
+	VkRect2D scissor{};
+	scissor.extent = swapChainExtent;
+	vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
+
+	//both pipelines share a layout, so the frame's descriptor set stays bound across pipeline changes
+	vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, graphicsPipeline.layout, 0, 1, &uboDescriptorSets[frame], 0, nullptr);
+
+	std::optional<VertexLayout> boundLayout;
+	VkDescriptorSet boundMaterial = VK_NULL_HANDLE;
+	std::optional<VkIndexType> boundIndexType;
+
+	//a chunk starts wherever its share of the draws does, usually partway into a batch
+	const std::vector<DrawBatch> &batches = instancedDraws.batches;
+	auto batch = std::upper_bound(batches.begin(), batches.end(), firstDraw, [](uint32_t draw, const DrawBatch &batch) { return draw < batch.firstDraw; });
+	if (batch != batches.begin()) batch--;
+
+	for (; batch != batches.end() && batch->firstDraw < endDraw; batch++) {
+		uint32_t batchFirst = std::max(batch->firstDraw, firstDraw);
+		uint32_t batchEnd = std::min(batch->firstDraw + batch->drawCount, endDraw);
+		if (batchFirst >= batchEnd) continue;
+
+		if (boundLayout != batch->layout) {
+			//every mesh of a layout shares the arena's buffers, they are only bound again when the layout changes
+			boundLayout = batch->layout;
+			VkPipeline pipeline = batch->layout == VertexLayout::Quantized ? quantizedPipeline.pipeline : graphicsPipeline.pipeline;
+			vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
+			meshArena->bindVertexBuffers(commandBuffer, batch->layout);
+		}
+
+		if (batch->material != boundMaterial) {
+			vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, graphicsPipeline.layout, 1, 1, &batch->material, 0, nullptr);
+			boundMaterial = batch->material;
+		}
+
+		if (boundIndexType != batch->indexType) {
+			meshArena->bindIndexBuffer(commandBuffer, batch->indexType);
+			boundIndexType = batch->indexType;
+		}
+
+		if (!useIndirectDraws) {
+			for (uint32_t i = batchFirst; i < batchEnd; i++) {
+				const VkDrawIndexedIndirectCommand &draw = instancedDraws.draws[i];
+				vkCmdDrawIndexed(commandBuffer, draw.indexCount, draw.instanceCount, draw.firstIndex, draw.vertexOffset, draw.firstInstance);
+			}
+		}
+		else if (vInstance->multiDrawIndirect) {
+			vkCmdDrawIndexedIndirect(commandBuffer, indirectBuffers[frame].buffer, batchFirst * sizeof(VkDrawIndexedIndirectCommand), batchEnd - batchFirst, sizeof(VkDrawIndexedIndirectCommand));
+		}
+		else {
+			//without multiDrawIndirect a call may only read a single command
+			for (uint32_t i = batchFirst; i < batchEnd; i++) {
+				vkCmdDrawIndexedIndirect(commandBuffer, indirectBuffers[frame].buffer, i * sizeof(VkDrawIndexedIndirectCommand), 1, sizeof(VkDrawIndexedIndirectCommand));
+			}
+		}
+	}
+
+	if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS) {
+		throw std::runtime_error("Failed to record secondary command buffer");
+	}
+}
+
 void Rend::drawFrame() {
+	if (settings.headless) {
+		drawOffscreenFrame();
+		return;
+	}
+
 	vkWaitForFences(device, 1, &inFlightFences[frame], VK_TRUE, UINT64_MAX);
+	releaseRetiredMeshAllocations();
+	if (submittedFrames >= MAX_FRAMES_IN_FLIGHT) uploadQueue->releaseWaitSemaphores(submittedFrames - MAX_FRAMES_IN_FLIGHT);
+	promoteUploadedMeshes();
 	
 	uint32_t imageIndex;
 	VkResult result = vkAcquireNextImageKHR(device, swapChain, UINT64_MAX, imageAvailableSemaphores[frame], VK_NULL_HANDLE, &imageIndex);
@@ -834,11 +1326,14 @@ void Rend::drawFrame() {
 	VkSubmitInfo submitInfo{};
 	submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
 
-	VkSemaphore waitSemaphores[] = {imageAvailableSemaphores[frame]};
-	VkPipelineStageFlags waitStages[] = {VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT};
-	submitInfo.waitSemaphoreCount = 1;
-	submitInfo.pWaitSemaphores = waitSemaphores;
-	submitInfo.pWaitDstStageMask = waitStages;
+	//uploads submitted since the last frame have to land before vertices are fetched or textures sampled
+	std::vector<VkSemaphore> waitSemaphores = uploadQueue->takeWaitSemaphores(submittedFrames);
+	std::vector<VkPipelineStageFlags> waitStages(waitSemaphores.size(), VK_PIPELINE_STAGE_VERTEX_INPUT_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT);
+	waitSemaphores.push_back(imageAvailableSemaphores[frame]);
+	waitStages.push_back(VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT);
+	submitInfo.waitSemaphoreCount = waitSemaphores.size();
+	submitInfo.pWaitSemaphores = waitSemaphores.data();
+	submitInfo.pWaitDstStageMask = waitStages.data();
 
 	submitInfo.commandBufferCount = 1;
 	submitInfo.pCommandBuffers = &commandBuffers[frame];
@@ -850,6 +1345,7 @@ void Rend::drawFrame() {
 	if (vkQueueSubmit(vInstance->graphicsQueue, 1, &submitInfo, inFlightFences[frame]) != VK_SUCCESS) {
 		throw std::runtime_error("Failed to submit draw command buffer");
 	}
+	submittedFrames++;
 
 	VkPresentInfoKHR presentInfo{};
 	presentInfo.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
@@ -875,19 +1371,48 @@ void Rend::drawFrame() {
 
 }
 
+///Renders into the offscreen image of this frame slot, there is nothing to acquire from or present to
+void Rend::drawOffscreenFrame() {
+	vkWaitForFences(device, 1, &inFlightFences[frame], VK_TRUE, UINT64_MAX);
+	releaseRetiredMeshAllocations();
+	if (submittedFrames >= MAX_FRAMES_IN_FLIGHT) uploadQueue->releaseWaitSemaphores(submittedFrames - MAX_FRAMES_IN_FLIGHT);
+	promoteUploadedMeshes();
+	vkResetFences(device, 1, &inFlightFences[frame]);
+
+	vkResetCommandBuffer(commandBuffers[frame], 0);
+	recordCommandBuffer(commandBuffers[frame], frame);
+
+	std::vector<VkSemaphore> waitSemaphores = uploadQueue->takeWaitSemaphores(submittedFrames);
+	std::vector<VkPipelineStageFlags> waitStages(waitSemaphores.size(), VK_PIPELINE_STAGE_VERTEX_INPUT_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT);
+
+	VkSubmitInfo submitInfo{};
+	submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+	submitInfo.waitSemaphoreCount = waitSemaphores.size();
+	submitInfo.pWaitSemaphores = waitSemaphores.data();
+	submitInfo.pWaitDstStageMask = waitStages.data();
+	submitInfo.commandBufferCount = 1;
+	submitInfo.pCommandBuffers = &commandBuffers[frame];
+
+	if (vkQueueSubmit(vInstance->graphicsQueue, 1, &submitInfo, inFlightFences[frame]) != VK_SUCCESS) {
+		throw std::runtime_error("Failed to submit draw command buffer");
+	}
+	submittedFrames++;
+
+	lastRenderedImage = frame;
+	frame = (frame + 1) % MAX_FRAMES_IN_FLIGHT;
+}
+
 void Rend::updateUniformBuffer(UniformBufferObject ubo) {
 
 	memcpy(uniformBuffersMapped[frame], &ubo, sizeof(ubo));
 }
 
 void Rend::cleanupVulkMaterial(VulkMaterial material) {
-	for (const VulkTexture texture : material.textures) {
+	for (VulkTexture texture : material.textures) {
 		std::cout << "Destroy texture: " << texture.texture.id << "\n";
 		vkDestroySampler(device, texture.imageSampler, nullptr);
 		vkDestroyImageView(device, texture.imageView, nullptr);
-		vkDestroyImage(device, texture.image, nullptr);
-		vkFreeMemory(device, texture.imageMemory, nullptr);
-		stbi_image_free(texture.texture.pixels);
+		resourceManager->destroyImage(texture.image, texture.imageAllocation);
 	}
 
 	vkDestroyDescriptorSetLayout(device, material.layout, nullptr);
@@ -895,10 +1420,14 @@ void Rend::cleanupVulkMaterial(VulkMaterial material) {
 }
 
 void Rend::cleanup() {
-	for (const auto & [ id, vulkMesh ] : vulkMeshes) {
-		resourceManager->destroyTransferBuffer(vulkMesh.vertexBuffer);
-		resourceManager->destroyTransferBuffer(vulkMesh.indexBuffer);
-	}
+	//the device is idle, so retired ranges and live meshes all go with the arena's buffers
+	vulkMeshes.clear();
+	pendingMeshes.clear();
+	retiredMeshAllocations.clear();
+	uploadQueue->cleanup();
+	delete uploadQueue;
+	meshArena->cleanup();
+	delete meshArena;
 
 	for (const auto & [id, vulkMaterial] : vulkMaterials) {
 		cleanupVulkMaterial(vulkMaterial);
@@ -908,8 +1437,11 @@ void Rend::cleanup() {
 	cleanupSwapChain();
 		
 	for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
-		vkDestroyBuffer(device, uniformBuffers[i], nullptr);
-		vkFreeMemory(device, uniformBuffersMemory[i], nullptr);
+		resourceManager->destroyBuffer(uniformBuffers[i], uniformBufferAllocations[i]);
+		resourceManager->destroyBuffer(instanceBuffers[i].buffer, instanceBuffers[i].allocation);
+		if (indirectBuffers[i].buffer != VK_NULL_HANDLE) {
+			resourceManager->destroyBuffer(indirectBuffers[i].buffer, indirectBuffers[i].allocation);
+		}
 	}
 
 	vkDestroyDescriptorPool(device, uboDescriptorPool, nullptr);
@@ -921,9 +1453,17 @@ void Rend::cleanup() {
 		vkDestroyFence(device, inFlightFences[i], nullptr);
 	}
 	
+	for (RecordChunk &chunk : recordChunks) {
+		for (VkCommandPool pool : chunk.pools) vkDestroyCommandPool(device, pool, nullptr);
+	}
+	recordChunks.clear();
+	delete recordPool;
+
 	vkDestroyCommandPool(device, commandPool, nullptr);
 	vkDestroyPipeline(device, graphicsPipeline.pipeline, nullptr);
 	vkDestroyPipelineLayout(device, graphicsPipeline.layout, nullptr);
+	vkDestroyPipeline(device, quantizedPipeline.pipeline, nullptr);
+	vkDestroyPipelineLayout(device, quantizedPipeline.layout, nullptr);
 	vkDestroyRenderPass(device, renderPass, nullptr);
 		
 	resourceManager->cleanup();
@@ -1,7 +1,12 @@
 #ifndef REND
 #define REND
 
+#include <atomic>
 #include <cstdint>
+#include <filesystem>
+#include <mutex>
+#include <optional>
+#include <queue>
 #include <thread>
 #define GLM_FORCE_RADIANS
 #define GLM_FORCE_DEPTH_ZERO_TO_ONE
@@ -23,18 +28,76 @@
 #include "VulkTexture.hpp"
 #include "VulkMaterial.hpp"
 #include "Camera.hpp"
+#include "DrawBatching.hpp"
+#include "FrameCapture.hpp"
+#include "FrustumCulling.hpp"
+#include "MeshArena.hpp"
+#include "MeshletCulling.hpp"
+#include "UploadQueue.hpp"
+#include "Source/Core/Jobs/ThreadPool.hpp"
 
 class Rend {
 	public:
+		struct Settings {
+			uint32_t width = 800;
+			uint32_t height = 600;
+			///render into offscreen images with no window, surface or present queue
+			///runs on software Vulkan like lavapipe, pick it with VK_ICD_FILENAMES
+			bool headless = false;
+			///submit draws with vkCmdDrawIndexedIndirect, direct instanced draws are used when off or when the device cannot
+			bool indirectDraws = true;
+			///threads helping the render thread gather and record draws, 0 picks one less than the hardware has
+			uint32_t recordThreads = 0;
+			///hide meshes behind those marked as occluders, tested against a depth buffer rasterized on the CPU
+			bool occlusionCulling = true;
+			std::filesystem::path shaderDirectory = "/home/vi/Documents/Game-Engines/Skadi-Engine/Shaders";
+		};
+
+		///each draw first waits for the frame that last used its slot, so once frames are in flight the times follow the GPU
+		///totalMillis also waits for the last frame to finish
+		struct FrameStats {
+			uint32_t frames;
+			double totalMillis;
+			double minMillis;
+			double maxMillis;
+			double medianMillis;
+			///meshes of the last frame and how many of them survived frustum culling
+			uint32_t meshes;
+			uint32_t visibleMeshes;
+			///meshes in the frustum hidden behind occluders, and the occluder triangles they were tested against
+			uint32_t occludedMeshes;
+			uint32_t occluderTriangles;
+			///what the last frame drew, visible mesh ranges, the instanced draws they merged into and the batches of binds
+			uint32_t drawItems;
+			uint32_t draws;
+			uint32_t batches;
+			///secondary command buffers the last frame's draws were recorded into
+			uint32_t recordChunks;
+		};
+
 		void beginLoop();
 		void initVulkan();
 		void registerMaterial(Material &material);
 		void renderMesh(Mesh mesh);
 
+		///safe from any thread, the render thread applies queued transforms before its next frame
         void updateMeshTransform(uuids::uuid uuid, glm::mat4 transform);
+		///a mesh keeping its layout, vertex and index count is edited in place and only the changed ranges are copied
         void updateMesh(Mesh mesh);
         void eraseMesh(uuids::uuid uuid);
 		void setMaxFPS(int fps = 120);
+		///ends the render thread's loop after the frame in flight, the thread cleans up before it returns
+		void requestStop();
+
+		///renders count frames on the calling thread after taking in queued materials and meshes
+		///for headless benchmarks, not while the render thread runs
+		FrameStats renderFrames(uint32_t count);
+		///reads back the last frame rendered by a headless Rend, throws std::runtime_error otherwise
+		FrameCapture captureFrame();
+		///waits for the GPU and frees everything, for a Rend that never started the render thread
+		void shutdown();
+		///counters of the upload queue, read them while the render thread is not running
+		UploadQueue::Stats getUploadStats() const { return uploadQueue->getStats(); }
 
 		Camera camera;
 
@@ -45,25 +108,63 @@ class Rend {
 		std::thread renderThread;
 
 		Rend();
+		explicit Rend(const Settings &settings);
 
 	private:
+		Settings settings;
 		float maxFrameTimeMilli = 8.333;
+		std::atomic<bool> stopRequested = false;
 
 		std::mutex materialRegisterMutex;
 		std::mutex meshRenderMutex;
 
+		struct MeshTransform {
+			uuids::uuid id;
+			glm::mat4 transform;
+		};
+
+		///meshQueue, meshEraseQueue and meshTransformQueue are guarded by meshRenderMutex, materialQueue by materialRegisterMutex
 		std::queue<Mesh> meshQueue;
 		std::queue<uuids::uuid> meshEraseQueue;
+		std::queue<MeshTransform> meshTransformQueue;
 		std::queue<Material> materialQueue;
 		std::unordered_map<uuids::uuid, VulkMesh> vulkMeshes;
 		std::unordered_map<uuids::uuid, VulkMaterial> vulkMaterials;
 
 		void processMeshQueue();
 		void processMeshEraseQueue();
+		void processMeshTransformQueue();
 		void processMaterialQueue();
 
-		VkSwapchainKHR swapChain;
+		MeshArena *meshArena;
+		UploadQueue *uploadQueue;
+
+		///uploaded meshes wait here until their copies finished, so no frame waits on them or draws them half written
+		struct PendingMesh {
+			uint64_t uploadTicket;
+			VulkMesh vulkMesh;
+		};
+		std::unordered_map<uuids::uuid, PendingMesh> pendingMeshes;
+		///moves meshes whose upload completed into vulkMeshes, retiring whatever they replace
+		void promoteUploadedMeshes();
+
+		struct RetiredAllocation {
+			///submittedFrames when the mesh was replaced or erased, frames before it may still draw from the ranges
+			uint64_t retiredAt;
+			MeshArena::Allocation allocation;
+		};
+		std::vector<RetiredAllocation> retiredMeshAllocations;
+		uint64_t submittedFrames = 0;
+
+		void retireMeshAllocation(const MeshArena::Allocation &allocation);
+		void releaseRetiredMeshAllocations();
+
+		VkSwapchainKHR swapChain = VK_NULL_HANDLE;
+		///when headless these are offscreen images backed by offscreenImageAllocations, one per frame in flight
 		std::vector<VkImage> swapChainImages;
+		std::vector<DeviceAllocation> offscreenImageAllocations;
+		///image the last headless frame resolved into, what captureFrame reads
+		std::optional<uint32_t> lastRenderedImage;
 		std::vector<VkImageView> swapChainImageViews;
 		VkFormat swapChainImageFormat;
 		VkExtent2D swapChainExtent;
@@ -78,6 +179,8 @@ class Rend {
 
 		VkDescriptorSetLayout samplerDescriptorSetLayout;
 		ResourceManager::GraphicsPipeline graphicsPipeline;
+		///same layout and shaders as graphicsPipeline but reading QuantizedVertex
+		ResourceManager::GraphicsPipeline quantizedPipeline;
 
 		VkCommandPool commandPool;
 		std::vector<VkCommandBuffer> commandBuffers;
@@ -85,17 +188,54 @@ class Rend {
 
 
 		VkImage depthImage;
-		VkDeviceMemory depthImageMemory;
+		DeviceAllocation depthImageAllocation;
 		VkImageView depthImageView;
 
 		VkImage colorImage;
-		VkDeviceMemory colorImageMemory;
+		DeviceAllocation colorImageAllocation;
 		VkImageView colorImageView;
 
 		std::vector<VkBuffer> uniformBuffers;
-		std::vector<VkDeviceMemory> uniformBuffersMemory;
+		std::vector<DeviceAllocation> uniformBufferAllocations;
 		std::vector<void*> uniformBuffersMapped;
 
+		///host visible buffer every frame rewrites, one per frame in flight
+		struct FrameBuffer {
+			VkBuffer buffer = VK_NULL_HANDLE;
+			DeviceAllocation allocation;
+			VkDeviceSize capacity = 0;
+		};
+		///transforms read through gl_InstanceIndex, binding 3 of the frame's ubo descriptor set
+		std::vector<FrameBuffer> instanceBuffers;
+		///the frame's VkDrawIndexedIndirectCommands, built on the CPU
+		std::vector<FrameBuffer> indirectBuffers;
+		bool useIndirectDraws = false;
+		uint32_t registeredMaterials = 0;
+		std::vector<DrawItem> drawItems;
+		InstancedDraws instancedDraws;
+
+		///a slice of the frame's work one thread does at a time, gathering draw items and recording draws
+		///its pools are never shared, so no two threads ever record from the same one
+		struct RecordChunk {
+			///one pool and secondary buffer per frame slot, the pool is reset whole once its slot comes around again
+			std::vector<VkCommandPool> pools;
+			std::vector<VkCommandBuffer> commandBuffers;
+			std::vector<DrawItem> items;
+			std::vector<DrawRange> drawRanges;
+			///world space spheres of the chunk's meshes and the ones inside the frustum, relative to its first mesh
+			SphereBatch spheres;
+			std::vector<uint32_t> visible;
+			uint32_t occluded = 0;
+		};
+		std::vector<RecordChunk> recordChunks;
+		ThreadPool *recordPool;
+		std::vector<const VulkMesh *> drawnMeshes;
+		uint32_t usedRecordChunks = 0;
+		uint32_t visibleMeshes = 0;
+		OcclusionBuffer occlusionBuffer;
+		std::vector<const VulkMesh *> occluderMeshes;
+		uint32_t occludedMeshes = 0;
+
 		VkDescriptorPool descriptorPool;
 		std::vector<VkDescriptorSet> descriptorSets;
 
@@ -113,6 +253,7 @@ class Rend {
 		VkPresentModeKHR chooseSwapPresentMode(const std::vector<VkPresentModeKHR>& availablePresentModes);
 		VkExtent2D chooseSwapExtent(const VkSurfaceCapabilitiesKHR& capabilities);
 		void createSwapChain();
+		void createOffscreenImages();
 		void cleanupSwapChain();
 		void recreateSwapChain();
 		void createImageViews();
@@ -123,18 +264,30 @@ class Rend {
 		void createDepthResources();
 		void createColorResources();
 
-		VulkTexture createVulkTexture(Texture tex);
-		void updateImage(Texture tex, VulkTexture &vulkTexture);
+		VulkTexture createVulkTexture(const Texture &tex);
+		void updateImage(const Texture &tex, VulkTexture &vulkTexture);
 		void updateSampler(VkPhysicalDeviceProperties physicalDeviceProperties, VulkTexture &vulkTexture);
 		void updateImageView(VulkTexture &vulkTexture);
 		
-		void generateMipMaps(VkImage image, VkFormat imageFormat, uint32_t texWidth, uint32_t texHeight, uint32_t mipLevels);	
+		void generateMipMaps(VkCommandBuffer commandBuffer, VkImage image, VkFormat imageFormat, uint32_t texWidth, uint32_t texHeight, uint32_t mipLevels);	
 		void createCommandBuffers();
 		void createUniformBuffers();
+		void createDrawBuffers();
+		///grows the buffer geometrically to hold size bytes, true when it was replaced
+		bool reserveFrameBuffer(FrameBuffer &frameBuffer, VkDeviceSize size, VkBufferUsageFlags usage);
+		void createRecordChunks();
 		void recordCommandBuffer(VkCommandBuffer commandBuffer, uint32_t imageIndex);
+		///frustum culls the meshes of [firstMesh, endMesh) and turns the visible ones into the chunk's items
+		///occlusion is null when nothing occludes this frame
+		void gatherDrawItems(RecordChunk &chunk, uint32_t firstMesh, uint32_t endMesh, const UniformBufferObject &ubo, const Frustum &frustum, const OcclusionBuffer *occlusion);
+		///rasterizes the occluders in view, false when there are none
+		bool rasterizeOccluders(const glm::mat4 &viewProj, const Frustum &frustum);
+		///records the instanced draws [firstDraw, endDraw) into the chunk's secondary buffer of the current frame slot
+		void recordDrawChunk(RecordChunk &chunk, VkFramebuffer framebuffer, uint32_t firstDraw, uint32_t endDraw);
 		void createRenderPass();
 		void createSyncObjects();
 		void drawFrame();
+		void drawOffscreenFrame();
 		void updateUniformBuffer(UniformBufferObject ubo);
 };
 
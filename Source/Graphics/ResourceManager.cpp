@@ -1,16 +1,25 @@
 #include "ResourceManager.hpp"
 #include "Dependencies/json.hpp"
+#include <algorithm>
+#include <bit>
 #include <cstddef>
 #include <cstdint>
 #include <fstream>
 #include <iostream>
+#include <optional>
 #include <queue>
 #include <stdexcept>
 #include <vector>
 #include <vulkan/vulkan_core.h>
 #include <mutex>
 
-ResourceManager::ResourceManager(const VulkanInstance &vulkanInstance, const DisplayInstance &displayInstance) : vulkanInstance(vulkanInstance), displayInstance(displayInstance), device(vulkanInstance.device) {}
+ResourceManager::ResourceManager(const VulkanInstance &vulkanInstance, const DisplayInstance &displayInstance) : vulkanInstance(vulkanInstance), displayInstance(displayInstance), device(vulkanInstance.device),
+	deviceAllocator(vulkanInstance.device, displayInstance.physicalDevice) {
+	const DisplayInstance::QueueFamilyIndecies &families = displayInstance.queueFamilyIndecies;
+	if (families.transferFamily.has_value()) {
+		copyDestinationFamilies = {families.graphicsFamily.value(), families.transferFamily.value()};
+	}
+}
 
 std::vector<VkDescriptorSet> ResourceManager::createUBODescriptorSets(VkDescriptorPool descriptorPool, VkDescriptorSetLayout descriptorSetLayout, const std::vector<VkBuffer>& uniformBuffers, const uint32_t frameCount) {
 	std::vector<VkDescriptorSet> descriptorSets;
@@ -51,6 +60,25 @@ std::vector<VkDescriptorSet> ResourceManager::createUBODescriptorSets(VkDescript
 	return descriptorSets;
 }
 
+///points a storage buffer binding at buffer, only while no pending command buffer uses the set
+void ResourceManager::updateStorageDescriptor(VkDescriptorSet descriptorSet, uint32_t binding, VkBuffer buffer, VkDeviceSize range) {
+	VkDescriptorBufferInfo bufferInfo{};
+	bufferInfo.buffer = buffer;
+	bufferInfo.offset = 0;
+	bufferInfo.range = range;
+
+	VkWriteDescriptorSet descriptorWrite{};
+	descriptorWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+	descriptorWrite.dstSet = descriptorSet;
+	descriptorWrite.dstBinding = binding;
+	descriptorWrite.dstArrayElement = 0;
+	descriptorWrite.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+	descriptorWrite.descriptorCount = 1;
+	descriptorWrite.pBufferInfo = &bufferInfo;
+
+	vkUpdateDescriptorSets(device, 1, &descriptorWrite, 0, nullptr);
+}
+
 std::vector<VkDescriptorSet> ResourceManager::createImageDescriptorSets(VkDescriptorPool descriptorPool,
                                                                         VkDescriptorSetLayout descriptorSetLayout,
                                                                         std::vector<VulkTexture> textures,
@@ -97,7 +125,7 @@ std::vector<VkDescriptorSet> ResourceManager::createImageDescriptorSets(VkDescri
 }
 
 
-VkDescriptorPool ResourceManager::createDescriptorPool(uint32_t frameCount, uint32_t uboCount, uint32_t samplerCount) {
+VkDescriptorPool ResourceManager::createDescriptorPool(uint32_t frameCount, uint32_t uboCount, uint32_t samplerCount, uint32_t storageCount) {
 	std::vector<VkDescriptorPoolSize> poolSizes;
 
 	uint32_t numSets = 0;
@@ -118,6 +146,14 @@ VkDescriptorPool ResourceManager::createDescriptorPool(uint32_t frameCount, uint
 		numSets += frameCount * samplerCount;
 	}
 
+	if (storageCount > 0) {
+		VkDescriptorPoolSize size;
+		size.type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+		size.descriptorCount = static_cast<uint32_t>(frameCount * storageCount);
+		poolSizes.push_back(size);
+		numSets += frameCount * storageCount;
+	}
+
 	VkDescriptorPoolCreateInfo poolInfo{};
 	poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
 	poolInfo.poolSizeCount = static_cast<uint32_t>(poolSizes.size());
@@ -133,7 +169,7 @@ VkDescriptorPool ResourceManager::createDescriptorPool(uint32_t frameCount, uint
 }
 
 //Graphics pipeline depends on descriptor set layout
-VkDescriptorSetLayout ResourceManager::createDescriptorSetLayout(uint32_t uboCount, uint32_t fragSamplerCount, uint32_t vertSamplerCount) {
+VkDescriptorSetLayout ResourceManager::createDescriptorSetLayout(uint32_t uboCount, uint32_t fragSamplerCount, uint32_t vertSamplerCount, uint32_t vertStorageCount) {
 	VkDescriptorSetLayout descriptorSetLayout{};
 	std::vector<VkDescriptorSetLayoutBinding> bindings;
 
@@ -177,6 +213,16 @@ VkDescriptorSetLayout ResourceManager::createDescriptorSetLayout(uint32_t uboCou
 	if (vertSamplerCount != 0)
 		bindings.push_back(vertSamplerLayoutBinding);
 
+	VkDescriptorSetLayoutBinding vertStorageLayoutBinding{};
+	vertStorageLayoutBinding.binding = 3;
+	vertStorageLayoutBinding.descriptorCount = vertStorageCount;
+	vertStorageLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+	vertStorageLayoutBinding.pImmutableSamplers = nullptr;
+	vertStorageLayoutBinding.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+
+	if (vertStorageCount != 0)
+		bindings.push_back(vertStorageLayoutBinding);
+
 	VkDescriptorSetLayoutCreateInfo layoutInfo{};
 	layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
 	layoutInfo.bindingCount = static_cast<uint32_t>(bindings.size());
@@ -189,7 +235,7 @@ VkDescriptorSetLayout ResourceManager::createDescriptorSetLayout(uint32_t uboCou
 	return descriptorSetLayout;
 }
 
-ResourceManager::GraphicsPipeline ResourceManager::createGraphicsPipeline(VkShaderModule vertShader, VkShaderModule fragShader, VkExtent2D windowExtent, VkRenderPass renderPass, VkSampleCountFlagBits msaaSamples, std::vector<VkDescriptorSetLayout> descriptorLayouts, std::vector<VkPushConstantRange> pushConstantRanges) const {
+ResourceManager::GraphicsPipeline ResourceManager::createGraphicsPipeline(VkShaderModule vertShader, VkShaderModule fragShader, VkExtent2D windowExtent, VkRenderPass renderPass, VkSampleCountFlagBits msaaSamples, std::vector<VkDescriptorSetLayout> descriptorLayouts, std::vector<VkPushConstantRange> pushConstantRanges, VertexLayout vertexLayout) const {
 	GraphicsPipeline pipeline{};
 
 	VkPipelineShaderStageCreateInfo vertShaderStageInfo{};
@@ -207,13 +253,26 @@ ResourceManager::GraphicsPipeline ResourceManager::createGraphicsPipeline(VkShad
 	VkPipelineShaderStageCreateInfo shaderStages[] = {vertShaderStageInfo, fragShaderStageInfo};
 
 	//INPUT ASSEMBLY
-	auto bindingDescription = Vertex::getBindingDescription();
-	auto attributeDescriptions = Vertex::getAttributeDescriptions();
+	std::vector<VkVertexInputBindingDescription> bindingDescriptions;
+	std::vector<VkVertexInputAttributeDescription> attributeDescriptions;
+
+	if (vertexLayout == VertexLayout::Quantized) {
+		auto quantizedBindings = QuantizedVertex::getBindingDescriptions();
+		auto quantizedAttributes = QuantizedVertex::getAttributeDescriptions();
+		bindingDescriptions.assign(quantizedBindings.begin(), quantizedBindings.end());
+		attributeDescriptions.assign(quantizedAttributes.begin(), quantizedAttributes.end());
+	}
+	else {
+		auto fullBindings = Vertex::getBindingDescriptions();
+		auto fullAttributes = Vertex::getAttributeDescriptions();
+		bindingDescriptions.assign(fullBindings.begin(), fullBindings.end());
+		attributeDescriptions.assign(fullAttributes.begin(), fullAttributes.end());
+	}
 
 	VkPipelineVertexInputStateCreateInfo vertexInputInfo{};
 	vertexInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
-	vertexInputInfo.vertexBindingDescriptionCount = 1;
-	vertexInputInfo.pVertexBindingDescriptions = &bindingDescription;
+	vertexInputInfo.vertexBindingDescriptionCount = static_cast<uint32_t>(bindingDescriptions.size());
+	vertexInputInfo.pVertexBindingDescriptions = bindingDescriptions.data();
 	vertexInputInfo.vertexAttributeDescriptionCount = static_cast<uint32_t>(attributeDescriptions.size());
 	vertexInputInfo.pVertexAttributeDescriptions = attributeDescriptions.data();
 
@@ -347,7 +406,7 @@ VkShaderModule ResourceManager::createShaderModule(const std::vector<char>& code
 	return shaderModule;
 }
 
-void ResourceManager::createImage(uint32_t width, uint32_t height, uint32_t mipLevels, VkSampleCountFlagBits numSamples, VkFormat format, VkImageTiling tiling, VkImageUsageFlags usageFlags, VkMemoryPropertyFlags properties, VkImage &image, VkDeviceMemory &imageMemory) {
+void ResourceManager::createImage(uint32_t width, uint32_t height, uint32_t mipLevels, VkSampleCountFlagBits numSamples, VkFormat format, VkImageTiling tiling, VkImageUsageFlags usageFlags, VkMemoryPropertyFlags properties, VkImage &image, DeviceAllocation &imageAllocation) {
 	VkImageCreateInfo imageInfo{};
 	imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
 	imageInfo.imageType = VK_IMAGE_TYPE_2D;
@@ -363,6 +422,11 @@ void ResourceManager::createImage(uint32_t width, uint32_t height, uint32_t mipL
 	imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED; //First transition discards the texels
 	imageInfo.usage = usageFlags;
 	imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE; //Only used by one queue family
+	if ((usageFlags & VK_IMAGE_USAGE_TRANSFER_DST_BIT) && !copyDestinationFamilies.empty()) {
+		imageInfo.sharingMode = VK_SHARING_MODE_CONCURRENT;
+		imageInfo.queueFamilyIndexCount = copyDestinationFamilies.size();
+		imageInfo.pQueueFamilyIndices = copyDestinationFamilies.data();
+	}
 
 	imageInfo.samples = numSamples;
 
@@ -374,16 +438,15 @@ void ResourceManager::createImage(uint32_t width, uint32_t height, uint32_t mipL
 	VkMemoryRequirements memRequirements{};
 	vkGetImageMemoryRequirements(device, image, &memRequirements);
 
-	VkMemoryAllocateInfo allocInfo{};
-	allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-	allocInfo.allocationSize = memRequirements.size;
-	allocInfo.memoryTypeIndex = findMemoryType(memRequirements.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+	DeviceAllocator::Tiling allocationTiling = tiling == VK_IMAGE_TILING_OPTIMAL ? DeviceAllocator::Tiling::Optimal : DeviceAllocator::Tiling::Linear;
+	imageAllocation = deviceAllocator.allocate(memRequirements, properties, allocationTiling);
 
-	if (vkAllocateMemory(device, &allocInfo, nullptr, &imageMemory) != VK_SUCCESS) {
-		throw std::runtime_error("Failed to allocated texture memory");
-	}
+	vkBindImageMemory(device, image, imageAllocation.memory, imageAllocation.offset);
+}
 
-	vkBindImageMemory(device, image, imageMemory, 0);
+void ResourceManager::destroyImage(VkImage image, DeviceAllocation &imageAllocation) {
+	vkDestroyImage(device, image, nullptr);
+	deviceAllocator.free(imageAllocation);
 }
 
 VkImageView ResourceManager::createImageView(VkImage image, VkFormat format, VkImageAspectFlags aspectFlags, uint32_t mipLevels) {
@@ -461,38 +524,52 @@ void ResourceManager::transitionImageLayout(VkImage image, VkFormat format, VkIm
 
 TransferBuffer ResourceManager::createTransferBuffer(VkFlags usageFlags, VkDeviceSize capacity) {
 	TransferBuffer transferBuffer{};
+	transferBuffer.usageFlags = usageFlags | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
 	transferBuffer.capacity = capacity;
 
-	createBuffer(transferBuffer.capacity, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, transferBuffer.stagingBuffer, transferBuffer.stagingBufferMemory);
-	createBuffer(transferBuffer.capacity, usageFlags, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, transferBuffer.buffer, transferBuffer.bufferMemory);
+	createBuffer(transferBuffer.capacity, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, transferBuffer.stagingBuffer, transferBuffer.stagingAllocation);
+	createBuffer(transferBuffer.capacity, transferBuffer.usageFlags, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, transferBuffer.buffer, transferBuffer.bufferAllocation);
 
 	return transferBuffer;
 }
 
+void ResourceManager::reserveTransferBuffer(TransferBuffer &transferBuffer, VkDeviceSize size) {
+	if (size <= transferBuffer.capacity) return;
+
+	//doubling keeps a buffer that grows a little every frame from being recreated every frame
+	VkDeviceSize capacity = std::bit_ceil(std::max(size, transferBuffer.capacity * 2));
+	VkBufferUsageFlags usageFlags = transferBuffer.usageFlags;
+
+	destroyTransferBuffer(transferBuffer);
+	transferBuffer = createTransferBuffer(usageFlags, capacity);
+}
+
 void ResourceManager::destroyTransferBuffer(TransferBuffer transferBuffer) {
-	vkDestroyBuffer(device, transferBuffer.stagingBuffer, nullptr);
-	vkDestroyBuffer(device, transferBuffer.buffer, nullptr);
-	vkFreeMemory(device, transferBuffer.stagingBufferMemory, nullptr);
-	vkFreeMemory(device, transferBuffer.bufferMemory, nullptr);
+	destroyBuffer(transferBuffer.stagingBuffer, transferBuffer.stagingAllocation);
+	destroyBuffer(transferBuffer.buffer, transferBuffer.bufferAllocation);
 }
 
-void ResourceManager::copyBufferToImage(VkBuffer buffer, VkImage image, uint32_t width, uint32_t height) {
+void ResourceManager::copyBufferToImage(VkBuffer buffer, VkImage image, uint32_t width, uint32_t height, const std::vector<uint64_t> &mipOffsets) {
 	VkCommandPool commandPool = createCommandPool();
 	VkCommandBuffer commandBuffer = beginSingleTimeCommands(commandPool);
-	VkBufferImageCopy region{};
-	region.bufferOffset = 0;
-	region.bufferRowLength = 0;
-	region.bufferImageHeight = 0;
-
-	region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-	region.imageSubresource.mipLevel = 0;
-	region.imageSubresource.baseArrayLayer = 0;
-	region.imageSubresource.layerCount = 1;
-	
-	region.imageOffset = {0,0,0};
-	region.imageExtent = {width, height, 1};
 
-	vkCmdCopyBufferToImage(commandBuffer, buffer, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+	std::vector<VkBufferImageCopy> regions(mipOffsets.size());
+	for (uint32_t level = 0; level < mipOffsets.size(); level++) {
+		VkBufferImageCopy &region = regions[level];
+		region.bufferOffset = mipOffsets[level];
+		region.bufferRowLength = 0;
+		region.bufferImageHeight = 0;
+
+		region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		region.imageSubresource.mipLevel = level;
+		region.imageSubresource.baseArrayLayer = 0;
+		region.imageSubresource.layerCount = 1;
+
+		region.imageOffset = {0,0,0};
+		region.imageExtent = {std::max(1u, width >> level), std::max(1u, height >> level), 1};
+	}
+
+	vkCmdCopyBufferToImage(commandBuffer, buffer, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, regions.size(), regions.data());
 
 	endSingleTimeCommands(commandBuffer, commandPool);
 }
@@ -510,14 +587,28 @@ void ResourceManager::copyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDevic
 	endSingleTimeCommands(commandBuffer, commandPool);
 }
 
+void ResourceManager::copyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, std::span<const VkBufferCopy> regions) {
+	if (regions.empty()) return;
+
+	VkCommandPool commandPool = createCommandPool();
+	VkCommandBuffer commandBuffer = beginSingleTimeCommands(commandPool);
+	vkCmdCopyBuffer(commandBuffer, srcBuffer, dstBuffer, regions.size(), regions.data());
+	endSingleTimeCommands(commandBuffer, commandPool);
+}
+
 void ResourceManager::createBuffer(VkDeviceSize size, VkBufferUsageFlags usage, 
-	VkMemoryPropertyFlags properties, VkBuffer &buffer, VkDeviceMemory &deviceMemory) {
+	VkMemoryPropertyFlags properties, VkBuffer &buffer, DeviceAllocation &allocation) {
 
 	VkBufferCreateInfo bufferInfo{};
 	bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
 	bufferInfo.size = size;	
 	bufferInfo.usage = usage;
 	bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+	if ((usage & VK_BUFFER_USAGE_TRANSFER_DST_BIT) && !copyDestinationFamilies.empty()) {
+		bufferInfo.sharingMode = VK_SHARING_MODE_CONCURRENT;
+		bufferInfo.queueFamilyIndexCount = copyDestinationFamilies.size();
+		bufferInfo.pQueueFamilyIndices = copyDestinationFamilies.data();
+	}
 
 	if (vkCreateBuffer(device, &bufferInfo, nullptr, &buffer) != VK_SUCCESS) {
 		throw std::runtime_error("Failed to create vertex buffer");
@@ -526,30 +617,79 @@ void ResourceManager::createBuffer(VkDeviceSize size, VkBufferUsageFlags usage,
 	VkMemoryRequirements memRequirements;
 	vkGetBufferMemoryRequirements(device, buffer, &memRequirements);
 
-	VkMemoryAllocateInfo allocInfo{};
-	allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-	allocInfo.allocationSize = memRequirements.size;
-	allocInfo.memoryTypeIndex = findMemoryType(memRequirements.memoryTypeBits, properties);
-	
-	if (vkAllocateMemory(device, &allocInfo, nullptr, &deviceMemory) != VK_SUCCESS) {
-		throw std::runtime_error("Failed to allocate vertex buffer memory");	
-	}
+	allocation = deviceAllocator.allocate(memRequirements, properties, DeviceAllocator::Tiling::Linear);
 
-	vkBindBufferMemory(device, buffer, deviceMemory, 0);	
+	vkBindBufferMemory(device, buffer, allocation.memory, allocation.offset);	
 }
 
-///Returns the index of type of memory requested with typeFilter that has every requested property flag
-uint32_t ResourceManager::findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties) {
-	VkPhysicalDeviceMemoryProperties memProperties;
-	vkGetPhysicalDeviceMemoryProperties(displayInstance.physicalDevice, &memProperties);
+void ResourceManager::destroyBuffer(VkBuffer buffer, DeviceAllocation &allocation) {
+	vkDestroyBuffer(device, buffer, nullptr);
+	deviceAllocator.free(allocation);
+}
+
+uint32_t ResourceManager::defragmentBuffers(std::span<const MovableBuffer> buffers) {
+	struct Move {
+		const MovableBuffer *source;
+		VkBuffer buffer;
+		DeviceAllocation allocation;
+	};
+	std::vector<Move> moves;
+
+	for (const MovableBuffer &movable : buffers) {
+		VkMemoryRequirements memRequirements;
+		vkGetBufferMemoryRequirements(device, *movable.buffer, &memRequirements);
+
+		std::optional<DeviceAllocation> allocation = deviceAllocator.relocate(*movable.allocation, memRequirements);
+		if (!allocation) continue;
+
+		VkBufferCreateInfo bufferInfo{};
+		bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+		bufferInfo.size = movable.size;
+		bufferInfo.usage = movable.usage;
+		bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+		if (!copyDestinationFamilies.empty()) {
+			bufferInfo.sharingMode = VK_SHARING_MODE_CONCURRENT;
+			bufferInfo.queueFamilyIndexCount = copyDestinationFamilies.size();
+			bufferInfo.pQueueFamilyIndices = copyDestinationFamilies.data();
+		}
 
-	for (uint32_t i = 0; i < memProperties.memoryTypeCount; i++) {
-		if (typeFilter & (1 << i) && (memProperties.memoryTypes[i].propertyFlags & properties) == properties) {
-			return i;
+		VkBuffer buffer;
+		if (vkCreateBuffer(device, &bufferInfo, nullptr, &buffer) != VK_SUCCESS) {
+			deviceAllocator.free(*allocation);
+			throw std::runtime_error("Failed to create defragmentation buffer");
 		}
+		vkBindBufferMemory(device, buffer, allocation->memory, allocation->offset);
+
+		moves.push_back({&movable, buffer, *allocation});
+	}
+
+	if (moves.empty()) return 0;
+
+	//every copy in one submit, the old ranges are only freed once it finished
+	VkCommandPool commandPool = createCommandPool();
+	VkCommandBuffer commandBuffer = beginSingleTimeCommands(commandPool);
+	for (const Move &move : moves) {
+		VkBufferCopy copyRegion{};
+		copyRegion.size = move.source->size;
+		vkCmdCopyBuffer(commandBuffer, *move.source->buffer, move.buffer, 1, &copyRegion);
+	}
+	endSingleTimeCommands(commandBuffer, commandPool);
+
+	for (Move &move : moves) {
+		destroyBuffer(*move.source->buffer, *move.source->allocation);
+		*move.source->buffer = move.buffer;
+		*move.source->allocation = move.allocation;
 	}
 
-	throw std::runtime_error("Failed to find suitable memory type");
+	return moves.size();
+}
+
+uint32_t ResourceManager::findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties) {
+	return deviceAllocator.findMemoryType(typeFilter, properties);
+}
+
+DeviceAllocator::Stats ResourceManager::getMemoryStats() const {
+	return deviceAllocator.getStats();
 }
 
 VkCommandPool ResourceManager::createCommandPool() {
@@ -623,5 +763,5 @@ std::vector<char> ResourceManager::readFile(const std::string& filename) {
 }
 
 void ResourceManager::cleanup() {
-
+	deviceAllocator.cleanup();
 }
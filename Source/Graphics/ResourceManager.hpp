@@ -7,12 +7,15 @@
 #include <cstdint>
 #include <mutex>
 #include <queue>
+#include <span>
 #include <vulkan/vulkan.h>
 #include <vector>
 #include <string>
 #include <Source/Resources/Model.hpp>
 #include <vulkan/vulkan_core.h>
 
+#include "DeviceAllocator.hpp"
+#include "DirtyRanges.hpp"
 #include "TransferBuffer.hpp"
 #include "UniformBufferObject.hpp"
 #include "VulkMesh.hpp"
@@ -28,38 +31,80 @@ class ResourceManager {
 			VkPipelineLayout layout;
 		};
 
-		VkDescriptorPool createDescriptorPool(uint32_t frameCount, uint32_t uboCount, uint32_t samplerCount);
-		VkDescriptorSetLayout createDescriptorSetLayout(uint32_t uboCount, uint32_t fragSamplerCount, uint32_t vertSamplerCount);
+		VkDescriptorPool createDescriptorPool(uint32_t frameCount, uint32_t uboCount, uint32_t samplerCount, uint32_t storageCount = 0);
+		///storage buffers are read by the vertex stage at binding 3
+		VkDescriptorSetLayout createDescriptorSetLayout(uint32_t uboCount, uint32_t fragSamplerCount, uint32_t vertSamplerCount, uint32_t vertStorageCount = 0);
         std::vector<VkDescriptorSet> createUBODescriptorSets(VkDescriptorPool descriptorPool, VkDescriptorSetLayout descriptorSetLayout, const std::vector<VkBuffer> &uniformBuffers, uint32_t frameCount);
+        void updateStorageDescriptor(VkDescriptorSet descriptorSet, uint32_t binding, VkBuffer buffer, VkDeviceSize range);
         std::vector<VkDescriptorSet> createImageDescriptorSets(VkDescriptorPool descriptorPool, VkDescriptorSetLayout descriptorSetLayout, std::vector<VulkTexture> textures, uint32_t frameCount);
 
-		GraphicsPipeline createGraphicsPipeline(VkShaderModule vertShader, VkShaderModule fragShader, VkExtent2D windowExtent, VkRenderPass renderPass, VkSampleCountFlagBits , std::vector<VkDescriptorSetLayout> descriptorLayouts, std::vector<VkPushConstantRange> pushConstantRanges) const;
+		GraphicsPipeline createGraphicsPipeline(VkShaderModule vertShader, VkShaderModule fragShader, VkExtent2D windowExtent, VkRenderPass renderPass, VkSampleCountFlagBits , std::vector<VkDescriptorSetLayout> descriptorLayouts, std::vector<VkPushConstantRange> pushConstantRanges, VertexLayout vertexLayout = VertexLayout::Full) const;
         VkShaderModule createShaderModule(const std::vector<char>& code);
 
-		void createImage(uint32_t width, uint32_t height, uint32_t mipLevels, VkSampleCountFlagBits numSamples, VkFormat format, VkImageTiling tiling, VkImageUsageFlags usageFlags, VkMemoryPropertyFlags properties, VkImage &image, VkDeviceMemory &imageMemory);
+		void createImage(uint32_t width, uint32_t height, uint32_t mipLevels, VkSampleCountFlagBits numSamples, VkFormat format, VkImageTiling tiling, VkImageUsageFlags usageFlags, VkMemoryPropertyFlags properties, VkImage &image, DeviceAllocation &imageAllocation);
+		void destroyImage(VkImage image, DeviceAllocation &imageAllocation);
 		VkImageView createImageView(VkImage image, VkFormat format, VkImageAspectFlags aspectFlags, uint32_t mipLevels);
 		void transitionImageLayout(VkImage image, VkFormat format, VkImageLayout oldLayout, VkImageLayout newLayout, uint32_t mipLevels);
 
 		TransferBuffer createTransferBuffer(VkFlags usageFlags, VkDeviceSize capacity);
-        template<typename T> void transferBufferWrite(TransferBuffer &transferBuffer, std::vector<T> inputData) {
+		///replaces the contents with inputData, the buffers are kept while it fits and grow geometrically when it does not
+        template<typename T> void transferBufferWrite(TransferBuffer &transferBuffer, std::span<const T> inputData) {
             transferBuffer.objectCount = inputData.size();
+            if (inputData.empty()) return;
 
-            void *data;
+            reserveTransferBuffer(transferBuffer, inputData.size_bytes());
+            memcpy(transferBuffer.stagingAllocation.mapped, inputData.data(), inputData.size_bytes());
 
-            vkMapMemory(device, transferBuffer.stagingBufferMemory, 0, transferBuffer.capacity, 0, &data);
-            memcpy(data, inputData.data(), transferBuffer.capacity);
-            vkUnmapMemory(device, transferBuffer.stagingBufferMemory);
+            copyBuffer(transferBuffer.stagingBuffer, transferBuffer.buffer, inputData.size_bytes(), 0,0);
+        }
+		///inputData is the whole new contents but only the dirty byte ranges are copied, coalesced into as few regions as possible
+		///the staging buffer mirrors the device buffer, so everything outside the ranges has to be what the last write left
+        template<typename T> void transferBufferUpdate(TransferBuffer &transferBuffer, std::span<const T> inputData, std::span<const DirtyRanges::Range> dirtyRanges) {
+            //a larger buffer starts out empty, so it needs everything
+            if (inputData.size_bytes() > transferBuffer.capacity) {
+                transferBufferWrite(transferBuffer, inputData);
+                return;
+            }
+            transferBuffer.objectCount = inputData.size();
+
+            std::vector<VkBufferCopy> regions;
+            for (const DirtyRanges::Range &range : DirtyRanges::coalesce({dirtyRanges.begin(), dirtyRanges.end()})) {
+                VkDeviceSize size = std::min<VkDeviceSize>(range.size, inputData.size_bytes() - std::min<VkDeviceSize>(range.offset, inputData.size_bytes()));
+                if (size == 0) continue;
 
-            copyBuffer(transferBuffer.stagingBuffer, transferBuffer.buffer, transferBuffer.capacity, 0,0);
+                memcpy(static_cast<uint8_t *>(transferBuffer.stagingAllocation.mapped) + range.offset, reinterpret_cast<const uint8_t *>(inputData.data()) + range.offset, size);
+                regions.push_back({range.offset, range.offset, size});
+            }
+
+            copyBuffer(transferBuffer.stagingBuffer, transferBuffer.buffer, regions);
         }
+		///makes room for at least size bytes, growing replaces both buffers and drops their contents
+		///nothing may still use the device buffer when it grows
+		void reserveTransferBuffer(TransferBuffer &transferBuffer, VkDeviceSize size);
 
 		void destroyTransferBuffer(TransferBuffer transferBuffer);
 
-		void copyBufferToImage(VkBuffer buffer, VkImage image, uint32_t width, uint32_t height);
+		///mipOffsets holds the buffer offset of each level to copy, starting at level 0
+		void copyBufferToImage(VkBuffer buffer, VkImage image, uint32_t width, uint32_t height, const std::vector<uint64_t> &mipOffsets = {0});
 		void copyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size, VkDeviceSize srcOffset = 0, VkDeviceSize dstOffset = 0);
-		void createBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties, VkBuffer &buffer, VkDeviceMemory &deviceMemory);
+		///all regions in one submission, does nothing without regions
+		void copyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, std::span<const VkBufferCopy> regions);
+		void createBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties, VkBuffer &buffer, DeviceAllocation &allocation);
+		void destroyBuffer(VkBuffer buffer, DeviceAllocation &allocation);
+
+		///a buffer defragmentBuffers may recreate elsewhere, usage has to include both transfer bits
+		struct MovableBuffer {
+			VkBuffer *buffer;
+			DeviceAllocation *allocation;
+			VkDeviceSize size;
+			VkBufferUsageFlags usage;
+		};
+		///moves buffers out of sparsely used pages so the pages can be released, handles and allocations are updated in place
+		///nothing may still use the buffers on the device, returns how many moved
+		uint32_t defragmentBuffers(std::span<const MovableBuffer> buffers);
 
 		uint32_t findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties);
+		DeviceAllocator::Stats getMemoryStats() const;
 		VkCommandPool createCommandPool();
 		VkCommandBuffer beginSingleTimeCommands(VkCommandPool &commandPool);
 		void endSingleTimeCommands(VkCommandBuffer &commandBuffer, VkCommandPool &commandPool);
@@ -73,6 +118,10 @@ class ResourceManager {
 		const VulkanInstance &vulkanInstance;
 		const DisplayInstance &displayInstance;
 		const VkDevice &device;
+
+		DeviceAllocator deviceAllocator;
+		///graphics and transfer family when they differ, copy destinations are shared by both so uploads need no ownership transfers
+		std::vector<uint32_t> copyDestinationFamilies;
 };
 
 #endif
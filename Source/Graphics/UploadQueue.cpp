@@ -0,0 +1,254 @@
+#include "UploadQueue.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+#include "ResourceManager.hpp"
+
+UploadQueue::UploadQueue(ResourceManager &resourceManager, const VulkanInstance &vulkanInstance, const DisplayInstance &displayInstance) :
+	resourceManager(resourceManager), device(vulkanInstance.device), queue(vulkanInstance.transferQueue) {
+	const DisplayInstance::QueueFamilyIndecies &families = displayInstance.queueFamilyIndecies;
+	graphicsCapable = !families.transferFamily.has_value();
+
+	VkCommandPoolCreateInfo poolInfo{};
+	poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+	poolInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+	poolInfo.queueFamilyIndex = families.transferFamily.value_or(families.graphicsFamily.value());
+
+	if (vkCreateCommandPool(device, &poolInfo, nullptr, &commandPool) != VK_SUCCESS) {
+		throw std::runtime_error("Failed to create upload command pool");
+	}
+
+	resourceManager.createBuffer(RING_SIZE, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, ringBuffer, ringAllocation);
+}
+
+UploadQueue::Staging UploadQueue::stage(VkDeviceSize size) {
+	stats.stagedBytes += size;
+
+	if (size > RING_SIZE) {
+		Staging staging{};
+		DeviceAllocation allocation;
+		resourceManager.createBuffer(size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, staging.buffer, allocation);
+		staging.mapped = allocation.mapped;
+
+		recordingBatch().oversizedStaging.emplace_back(staging.buffer, allocation);
+		stats.oversizedUploads++;
+		return staging;
+	}
+
+	uint64_t start = (ringHead + STAGING_ALIGNMENT - 1) & ~(STAGING_ALIGNMENT - 1);
+	//a range never wraps, it starts over at the beginning of the ring instead
+	if (start % RING_SIZE + size > RING_SIZE) start += RING_SIZE - start % RING_SIZE;
+
+	if (start + size - ringTail > RING_SIZE) {
+		stats.ringStalls++;
+		//the space may still belong to the batch recording now, it has to go out before it can finish
+		submit();
+		while (start + size - ringTail > RING_SIZE && !submitted.empty()) {
+			retire(true);
+		}
+		//nothing is in flight any more, the whole ring is free from start on
+		if (start + size - ringTail > RING_SIZE) ringTail = start;
+	}
+
+	ringHead = start + size;
+	recordingBatch();
+
+	Staging staging{};
+	staging.buffer = ringBuffer;
+	staging.offset = start % RING_SIZE;
+	staging.mapped = static_cast<uint8_t *>(ringAllocation.mapped) + staging.offset;
+	return staging;
+}
+
+VkCommandBuffer UploadQueue::commandBuffer() {
+	return recordingBatch().commandBuffer;
+}
+
+UploadQueue::Batch &UploadQueue::recordingBatch() {
+	if (recording) return *recording;
+
+	if (!idleBatches.empty()) {
+		recording = std::move(idleBatches.back());
+		idleBatches.pop_back();
+	}
+	else {
+		recording = Batch{};
+
+		VkCommandBufferAllocateInfo allocInfo{};
+		allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+		allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+		allocInfo.commandPool = commandPool;
+		allocInfo.commandBufferCount = 1;
+		vkAllocateCommandBuffers(device, &allocInfo, &recording->commandBuffer);
+
+		VkFenceCreateInfo fenceInfo{};
+		fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+		vkCreateFence(device, &fenceInfo, nullptr, &recording->fence);
+	}
+
+	recording->ticket = nextTicket++;
+
+	VkCommandBufferBeginInfo beginInfo{};
+	beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+	beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+	vkBeginCommandBuffer(recording->commandBuffer, &beginInfo);
+
+	return *recording;
+}
+
+void UploadQueue::copyToImage(const Staging &staging, VkImage image, uint32_t width, uint32_t height, uint32_t mipLevels, const std::vector<uint64_t> &mipOffsets, VkImageLayout finalLayout) {
+	VkCommandBuffer commandBuffer = this->commandBuffer();
+
+	VkImageMemoryBarrier barrier{};
+	barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+	barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+	barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+	barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barrier.image = image;
+	barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+	barrier.subresourceRange.levelCount = mipLevels;
+	barrier.subresourceRange.layerCount = 1;
+	barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+	std::vector<VkBufferImageCopy> regions(mipOffsets.size());
+	for (uint32_t level = 0; level < regions.size(); level++) {
+		regions[level].bufferOffset = staging.offset + mipOffsets[level];
+		regions[level].imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		regions[level].imageSubresource.mipLevel = level;
+		regions[level].imageSubresource.layerCount = 1;
+		regions[level].imageExtent = {std::max(1u, width >> level), std::max(1u, height >> level), 1};
+	}
+	vkCmdCopyBufferToImage(commandBuffer, staging.buffer, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, regions.size(), regions.data());
+
+	if (finalLayout != VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL) return;
+
+	//transfer queues know no shader stages, the frame's wait on the batch semaphore makes the write visible to them
+	barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+	barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+	barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	barrier.dstAccessMask = 0;
+	vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+}
+
+void UploadQueue::submit() {
+	if (!recording) return;
+
+	Batch batch = std::move(*recording);
+	recording.reset();
+	vkEndCommandBuffer(batch.commandBuffer);
+
+	VkSemaphore semaphore;
+	if (!freeSemaphores.empty()) {
+		semaphore = freeSemaphores.back();
+		freeSemaphores.pop_back();
+	}
+	else {
+		VkSemaphoreCreateInfo semaphoreInfo{};
+		semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+		vkCreateSemaphore(device, &semaphoreInfo, nullptr, &semaphore);
+	}
+
+	VkSubmitInfo submitInfo{};
+	submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+	submitInfo.commandBufferCount = 1;
+	submitInfo.pCommandBuffers = &batch.commandBuffer;
+	submitInfo.signalSemaphoreCount = 1;
+	submitInfo.pSignalSemaphores = &semaphore;
+
+	if (vkQueueSubmit(queue, 1, &submitInfo, batch.fence) != VK_SUCCESS) {
+		throw std::runtime_error("Failed to submit upload batch");
+	}
+
+	batch.ringEnd = ringHead;
+	signaledSemaphores.push_back(semaphore);
+	submitted.push_back(std::move(batch));
+	stats.submittedBatches++;
+}
+
+uint64_t UploadQueue::ticket() const {
+	return recording ? recording->ticket : nextTicket - 1;
+}
+
+bool UploadQueue::isComplete(uint64_t ticket) {
+	if (ticket <= completedTicket) return true;
+
+	retire(false);
+	return ticket <= completedTicket;
+}
+
+void UploadQueue::waitIdle() {
+	submit();
+	while (!submitted.empty()) {
+		retire(true);
+	}
+}
+
+void UploadQueue::retire(bool wait) {
+	//one queue finishes its batches in order, so the front is always the oldest
+	while (!submitted.empty()) {
+		Batch &batch = submitted.front();
+		if (wait) {
+			vkWaitForFences(device, 1, &batch.fence, VK_TRUE, UINT64_MAX);
+			wait = false;
+		}
+		else if (vkGetFenceStatus(device, batch.fence) != VK_SUCCESS) {
+			return;
+		}
+
+		ringTail = batch.ringEnd;
+		completedTicket = batch.ticket;
+		recycle(batch);
+		submitted.pop_front();
+	}
+}
+
+void UploadQueue::recycle(Batch &batch) {
+	for (auto &[buffer, allocation] : batch.oversizedStaging) {
+		resourceManager.destroyBuffer(buffer, allocation);
+	}
+	batch.oversizedStaging.clear();
+
+	vkResetFences(device, 1, &batch.fence);
+	vkResetCommandBuffer(batch.commandBuffer, 0);
+	idleBatches.push_back(std::move(batch));
+}
+
+std::vector<VkSemaphore> UploadQueue::takeWaitSemaphores(uint64_t frame) {
+	for (VkSemaphore semaphore : signaledSemaphores) {
+		waitingSemaphores.emplace_back(frame, semaphore);
+	}
+	return std::exchange(signaledSemaphores, {});
+}
+
+///a binary semaphore may only be signaled again once the wait that unsignaled it has executed
+void UploadQueue::releaseWaitSemaphores(uint64_t frame) {
+	std::erase_if(waitingSemaphores, [this, frame](const std::pair<uint64_t, VkSemaphore> &waiting) {
+		if (waiting.first > frame) return false;
+
+		freeSemaphores.push_back(waiting.second);
+		return true;
+	});
+}
+
+void UploadQueue::cleanup() {
+	waitIdle();
+
+	for (Batch &batch : idleBatches) {
+		vkDestroyFence(device, batch.fence, nullptr);
+	}
+	idleBatches.clear();
+
+	//the device is idle, so every semaphore is done with whichever state it is in
+	for (VkSemaphore semaphore : signaledSemaphores) vkDestroySemaphore(device, semaphore, nullptr);
+	for (auto &[frame, semaphore] : waitingSemaphores) vkDestroySemaphore(device, semaphore, nullptr);
+	for (VkSemaphore semaphore : freeSemaphores) vkDestroySemaphore(device, semaphore, nullptr);
+	signaledSemaphores.clear();
+	waitingSemaphores.clear();
+	freeSemaphores.clear();
+
+	vkDestroyCommandPool(device, commandPool, nullptr);
+	resourceManager.destroyBuffer(ringBuffer, ringAllocation);
+}
@@ -0,0 +1,113 @@
+#ifndef UPLOADQUEUE_HPP
+#define UPLOADQUEUE_HPP
+
+#include <cstdint>
+#include <deque>
+#include <optional>
+#include <utility>
+#include <vector>
+#include <vulkan/vulkan.h>
+
+#include "DeviceAllocator.hpp"
+#include "DisplayInstance.hpp"
+#include "VulkanInstance.hpp"
+
+class ResourceManager;
+
+///Copies data to the GPU without waiting for it, through a persistently mapped ring of staging memory
+///Copies are recorded into a batch that goes out on submit, on the dedicated transfer queue when the device has one
+///Every batch signals a fence, polled to learn what finished, and a semaphore the next frame waits on so its writes are visible
+class UploadQueue {
+public:
+	///where staged bytes go, only valid until staging again, so record the copies reading it first
+	struct Staging {
+		VkBuffer buffer;
+		VkDeviceSize offset;
+		void *mapped;
+	};
+
+	struct Stats {
+		uint64_t submittedBatches;
+		uint64_t stagedBytes;
+		///times staging had to wait for the GPU to finish with ring space
+		uint32_t ringStalls;
+		///uploads larger than the ring that got a staging buffer of their own
+		uint32_t oversizedUploads;
+	};
+
+	UploadQueue(ResourceManager &resourceManager, const VulkanInstance &vulkanInstance, const DisplayInstance &displayInstance);
+
+	///room for size bytes the caller fills through mapped, waits only when the ring is full of unfinished uploads
+	Staging stage(VkDeviceSize size);
+	///the batch recording right now, copies recorded into it run in order after everything submitted before
+	VkCommandBuffer commandBuffer();
+
+	///copies the levels at mipOffsets out of staging and leaves the image in finalLayout
+	///anything but SHADER_READ_ONLY_OPTIMAL stays TRANSFER_DST_OPTIMAL, for the caller to record more work on the levels
+	void copyToImage(const Staging &staging, VkImage image, uint32_t width, uint32_t height, uint32_t mipLevels, const std::vector<uint64_t> &mipOffsets, VkImageLayout finalLayout);
+
+	///sends the recording batch off, nothing recorded runs before this
+	void submit();
+	///complete once everything recorded so far has run
+	uint64_t ticket() const;
+	///polls fences, never blocks
+	bool isComplete(uint64_t ticket);
+	void waitIdle();
+
+	///semaphores of batches submitted since the last call, the frame about to be submitted has to wait on all of them
+	std::vector<VkSemaphore> takeWaitSemaphores(uint64_t frame);
+	///semaphores waited on by frames up to frame can be signaled again, call once that frame's fence has been waited on
+	void releaseWaitSemaphores(uint64_t frame);
+
+	///false on a transfer only queue, where blits and graphics stages are not available
+	bool supportsGraphics() const { return graphicsCapable; }
+
+	Stats getStats() const { return stats; }
+	void cleanup();
+
+private:
+	static constexpr VkDeviceSize RING_SIZE = VkDeviceSize{16} << 20;
+	//covers the texel block size of every format copyToImage is used with
+	static constexpr VkDeviceSize STAGING_ALIGNMENT = 16;
+
+	struct Batch {
+		VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+		VkFence fence = VK_NULL_HANDLE;
+		uint64_t ticket = 0;
+		///ring position the batch's staging ends at, freed up to here once the fence signals
+		uint64_t ringEnd = 0;
+		std::vector<std::pair<VkBuffer, DeviceAllocation>> oversizedStaging;
+	};
+
+	ResourceManager &resourceManager;
+	const VkDevice &device;
+	VkQueue queue;
+	bool graphicsCapable;
+
+	VkCommandPool commandPool = VK_NULL_HANDLE;
+
+	VkBuffer ringBuffer = VK_NULL_HANDLE;
+	DeviceAllocation ringAllocation;
+	//running byte counts, the ring position is the remainder by RING_SIZE
+	uint64_t ringHead = 0;
+	uint64_t ringTail = 0;
+
+	std::optional<Batch> recording;
+	std::deque<Batch> submitted;
+	std::vector<Batch> idleBatches;
+	uint64_t nextTicket = 1;
+	uint64_t completedTicket = 0;
+
+	std::vector<VkSemaphore> signaledSemaphores;
+	std::vector<std::pair<uint64_t, VkSemaphore>> waitingSemaphores;
+	std::vector<VkSemaphore> freeSemaphores;
+
+	Stats stats{};
+
+	Batch &recordingBatch();
+	///retires finished batches from the front, waiting for the first one when wait is set
+	void retire(bool wait);
+	void recycle(Batch &batch);
+};
+
+#endif //UPLOADQUEUE_HPP
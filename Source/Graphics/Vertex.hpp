@@ -6,41 +6,58 @@
 #include <glm/gtx/hash.hpp>
 #include <vulkan/vulkan.h>
 #include <array>
+#include <cstdint>
 #include <string>
 
+///How a mesh stores its vertices on the GPU, picked per mesh at import
+enum class VertexLayout : uint32_t {
+	///Vertex, full float position, color and texture coordinates
+	Full = 0,
+	///QuantizedVertex, 16 bit position inside the mesh bounds and half float texture coordinates
+	Quantized = 1
+};
+
 struct Vertex {
 	glm::vec3 pos;
 	glm::vec3 color{1,1,1};
 	glm::vec2 texCoord;
 
-	//Bindings are for the struct and describe how it should be passed into the vertex shader
-	static VkVertexInputBindingDescription getBindingDescription() {
-		VkVertexInputBindingDescription bindingDescription {};
-		bindingDescription.binding = 0;
-		bindingDescription.stride = sizeof(Vertex);
-		bindingDescription.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+	///bytes at the start of the struct that form the position stream, the rest is the attribute stream
+	static constexpr uint32_t POSITION_STRIDE = sizeof(glm::vec3);
+
+	//Bindings describe how each stream is passed into the vertex shader
+	//binding 0 holds positions only so a position only pass binds just that one
+	static std::array<VkVertexInputBindingDescription, 2> getBindingDescriptions() {
+		std::array<VkVertexInputBindingDescription, 2> bindingDescriptions{};
+		bindingDescriptions[0].binding = 0;
+		bindingDescriptions[0].stride = POSITION_STRIDE;
+		bindingDescriptions[0].inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
 
-		return bindingDescription;
+		bindingDescriptions[1].binding = 1;
+		bindingDescriptions[1].stride = sizeof(Vertex) - POSITION_STRIDE;
+		bindingDescriptions[1].inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+
+		return bindingDescriptions;
 	}
 	
-	//Attribute descriptions describe for each property what its format should be and where it will be in memory
+	//Attribute descriptions describe for each property what its format should be and where it will be in its stream
 	static std::array<VkVertexInputAttributeDescription, 3> getAttributeDescriptions() {
 		std::array<VkVertexInputAttributeDescription, 3> attributeDescriptions{};
 		
 		attributeDescriptions[0].binding = 0;
 		attributeDescriptions[0].location = 0;
 		attributeDescriptions[0].format = VK_FORMAT_R32G32B32_SFLOAT;
-		attributeDescriptions[0].offset = offsetof(Vertex, pos);
+		attributeDescriptions[0].offset = 0;
 
-		attributeDescriptions[1].binding = 0;
+		attributeDescriptions[1].binding = 1;
 		attributeDescriptions[1].location = 1;
 		attributeDescriptions[1].format = VK_FORMAT_R32G32B32_SFLOAT;
-		attributeDescriptions[1].offset = offsetof(Vertex, color);
+		attributeDescriptions[1].offset = offsetof(Vertex, color) - POSITION_STRIDE;
 
-		attributeDescriptions[2].binding = 0;
+		attributeDescriptions[2].binding = 1;
 		attributeDescriptions[2].location = 2;
 		attributeDescriptions[2].format = VK_FORMAT_R32G32_SFLOAT;
-		attributeDescriptions[2].offset = offsetof(Vertex, texCoord);
+		attributeDescriptions[2].offset = offsetof(Vertex, texCoord) - POSITION_STRIDE;
 
 		return attributeDescriptions;
 	}
@@ -51,6 +68,62 @@ struct Vertex {
 	}
 };
 
+///12 byte vertex for meshes without vertex colors, positions are normalized to the mesh AABB
+///The shader reads them as UNORM so dequantization is a scale and offset folded into the mesh transform
+struct QuantizedVertex {
+	uint16_t pos[4];
+	uint16_t texCoord[2];
+
+	static constexpr uint32_t POSITION_STRIDE = sizeof(pos);
+
+	static std::array<VkVertexInputBindingDescription, 2> getBindingDescriptions() {
+		std::array<VkVertexInputBindingDescription, 2> bindingDescriptions{};
+		bindingDescriptions[0].binding = 0;
+		bindingDescriptions[0].stride = POSITION_STRIDE;
+		bindingDescriptions[0].inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+
+		bindingDescriptions[1].binding = 1;
+		bindingDescriptions[1].stride = sizeof(QuantizedVertex) - POSITION_STRIDE;
+		bindingDescriptions[1].inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+
+		return bindingDescriptions;
+	}
+
+	//locations match shader.vert, color (location 1) is absent and comes out white
+	static std::array<VkVertexInputAttributeDescription, 2> getAttributeDescriptions() {
+		std::array<VkVertexInputAttributeDescription, 2> attributeDescriptions{};
+
+		attributeDescriptions[0].binding = 0;
+		attributeDescriptions[0].location = 0;
+		attributeDescriptions[0].format = VK_FORMAT_R16G16B16A16_UNORM;
+		attributeDescriptions[0].offset = 0;
+
+		attributeDescriptions[1].binding = 1;
+		attributeDescriptions[1].location = 2;
+		attributeDescriptions[1].format = VK_FORMAT_R16G16_SFLOAT;
+		attributeDescriptions[1].offset = offsetof(QuantizedVertex, texCoord) - POSITION_STRIDE;
+
+		return attributeDescriptions;
+	}
+
+	///maps the unit cube the positions were normalized to back onto the box they came from
+	static glm::mat4 dequantizeTransform(glm::vec3 min, glm::vec3 max) {
+		glm::vec3 extent = max - min;
+
+		glm::mat4 transform(1.0f);
+		transform[0][0] = extent.x;
+		transform[1][1] = extent.y;
+		transform[2][2] = extent.z;
+		transform[3] = glm::vec4(min, 1.0f);
+
+		return transform;
+	}
+};
+
+static_assert(sizeof(QuantizedVertex) == 12);
+//the stream split relies on the position being the first member of both layouts
+static_assert(offsetof(Vertex, pos) == 0 && offsetof(QuantizedVertex, pos) == 0);
+
 //custom hash function for Vertex (uses hashes of vec 2 and 3)
 template <>
 struct std::hash<Vertex>
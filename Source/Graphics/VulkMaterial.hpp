@@ -7,6 +7,8 @@ struct VulkMaterial {
     VkDescriptorPool pool;
     VkDescriptorSetLayout layout;
     std::vector<VkDescriptorSet> sets;
+    ///registration order, the material field of its draws' sort keys
+    uint32_t sortIndex;
 };
 
 #endif //VULKMATERIAL_HPP
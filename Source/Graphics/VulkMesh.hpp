@@ -1,16 +1,23 @@
 #ifndef VULKMESH_HPP
 #define VULKMESH_HPP
 
-#include "TransferBuffer.hpp"
+#include <memory>
+
+#include "MeshArena.hpp"
+#include "OcclusionBuffer.hpp"
 #include "VulkTexture.hpp"
 
 struct VulkMesh {
 	Mesh mesh;
-	TransferBuffer vertexBuffer;
-	TransferBuffer indexBuffer;
+	///where the mesh's vertices and indices live in the Rend's MeshArena
+	MeshArena::Allocation allocation;
 
 	std::vector<VkDescriptorPool> textureDescriptorPools;
 	std::vector<VkDescriptorSet> textureDescriptors;
+	///sortIndex of the material the descriptors belong to
+	uint32_t materialSortIndex;
+	///triangles rasterized into the occlusion buffer, only set for meshes marked as occluders
+	std::shared_ptr<const Occluder> occluder;
 };
 
 #endif //VULKMESH_HPP
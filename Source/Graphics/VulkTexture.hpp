@@ -5,9 +5,20 @@ struct VulkTexture {
 	Texture texture;
 
 	VkImage image;
-	VkDeviceMemory imageMemory;
+	DeviceAllocation imageAllocation;
 	VkImageView imageView;
 	VkSampler imageSampler;
 };
 
+///Vulkan format a texture is uploaded and sampled as, sRGB exactly where isSrgbFormat says so
+inline VkFormat textureVkFormat(TextureFormat format) {
+	switch (format) {
+		case TextureFormat::BC1: return VK_FORMAT_BC1_RGBA_SRGB_BLOCK;
+		case TextureFormat::BC3: return VK_FORMAT_BC3_SRGB_BLOCK;
+		case TextureFormat::BC5: return VK_FORMAT_BC5_UNORM_BLOCK;
+		case TextureFormat::BC7: return VK_FORMAT_BC7_SRGB_BLOCK;
+		default: return VK_FORMAT_R8G8B8A8_SRGB;
+	}
+}
+
 #endif //VULKTEXTURE_HPP
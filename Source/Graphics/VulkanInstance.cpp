@@ -14,7 +14,7 @@ const bool enableValidationLayers = false;
 const bool enableValidationLayers = true;
 #endif
 
-VulkanInstance::VulkanInstance() {
+VulkanInstance::VulkanInstance(bool headless) : headless(headless) {
 	createInstance();
 }
 
@@ -79,10 +79,13 @@ void VulkanInstance::createInstance() {
 
 ///Gets all extensions that vulkan requires: GLFW, Validation layers, etc
 std::vector<const char *> VulkanInstance::getRequiredExtensions() {
-	uint32_t glfwExtensionCount = 0;
-	const char **glfwExtensions = glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
+	std::vector<const char *> extensions;
 
-	std::vector extensions(glfwExtensions, glfwExtensions + glfwExtensionCount);
+	if (!headless) {
+		uint32_t glfwExtensionCount = 0;
+		const char **glfwExtensions = glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
+		extensions.assign(glfwExtensions, glfwExtensions + glfwExtensionCount);
+	}
 
 	if (enableValidationLayers) {
 		extensions.push_back(VK_EXT_DEBUG_UTILS_EXTENSION_NAME);
@@ -96,7 +99,11 @@ void VulkanInstance::createLogicalDevice(const DisplayInstance &displayInstance)
 	DisplayInstance::QueueFamilyIndecies indecies = displayInstance.queueFamilyIndecies;
 
 	std::vector<VkDeviceQueueCreateInfo> queueCreateInfos;
-	std::set<uint32_t> uniqueQueueFamilies = {indecies.graphicsFamily.value(), indecies.presentFamily.value()};
+	std::set<uint32_t> uniqueQueueFamilies = {indecies.graphicsFamily.value()};
+	if (indecies.presentFamily.has_value())
+		uniqueQueueFamilies.insert(indecies.presentFamily.value());
+	if (indecies.transferFamily.has_value())
+		uniqueQueueFamilies.insert(indecies.transferFamily.value());
 
 	// all queues require a priority
 	float queuePriority = 1.0f;
@@ -111,11 +118,22 @@ void VulkanInstance::createLogicalDevice(const DisplayInstance &displayInstance)
 		queueCreateInfos.push_back(queueCreateInfo);
 	}
 
+	VkPhysicalDeviceFeatures supportedFeatures{};
+	vkGetPhysicalDeviceFeatures(displayInstance.physicalDevice, &supportedFeatures);
+
 	// To be filled in
 	VkPhysicalDeviceFeatures deviceFeatures{};
-	deviceFeatures.samplerAnisotropy = VK_TRUE;
-	deviceFeatures.sparseResidencyAliased = VK_TRUE;
-	deviceFeatures.sparseResidencyImage2D = VK_TRUE;
+	//isDeviceSuitable only picks devices that have both
+	deviceFeatures.samplerAnisotropy = supportedFeatures.samplerAnisotropy;
+	deviceFeatures.textureCompressionBC = supportedFeatures.textureCompressionBC;
+	//nothing binds sparse memory yet, software implementations like lavapipe lack it and would fail device creation
+	deviceFeatures.sparseResidencyAliased = supportedFeatures.sparseResidencyAliased;
+	deviceFeatures.sparseResidencyImage2D = supportedFeatures.sparseResidencyImage2D;
+	//indirect draws fall back to direct instanced draws where these are missing
+	deviceFeatures.multiDrawIndirect = supportedFeatures.multiDrawIndirect;
+	deviceFeatures.drawIndirectFirstInstance = supportedFeatures.drawIndirectFirstInstance;
+	multiDrawIndirect = supportedFeatures.multiDrawIndirect;
+	drawIndirectFirstInstance = supportedFeatures.drawIndirectFirstInstance;
 
 	VkDeviceCreateInfo createInfo{};
 	createInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
@@ -138,7 +156,11 @@ void VulkanInstance::createLogicalDevice(const DisplayInstance &displayInstance)
 	}
 
 	vkGetDeviceQueue(device, indecies.graphicsFamily.value(), 0, &graphicsQueue);
-	vkGetDeviceQueue(device, indecies.presentFamily.value(), 0, &presentQueue);
+	if (indecies.presentFamily.has_value())
+		vkGetDeviceQueue(device, indecies.presentFamily.value(), 0, &presentQueue);
+	transferQueue = graphicsQueue;
+	if (indecies.transferFamily.has_value())
+		vkGetDeviceQueue(device, indecies.transferFamily.value(), 0, &transferQueue);
 }
 
 VkResult CreateDebugUtilsMessengerEXT(VkInstance instance, const VkDebugUtilsMessengerCreateInfoEXT *pCreateInfo, const VkAllocationCallbacks *pAllocator, VkDebugUtilsMessengerEXT *pDebugMessenger) {
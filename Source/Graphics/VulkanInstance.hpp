@@ -9,16 +9,24 @@
 
 class VulkanInstance {
 	public:
-		VulkanInstance();
+		///a headless instance enables no window system extensions, so it runs without GLFW or a display
+		explicit VulkanInstance(bool headless = false);
 		void setupDevices(const DisplayInstance &displayInstance);
 		void cleanup();
 
 		VkInstance instance;
 		VkDevice device;
 		VkQueue graphicsQueue;
-		VkQueue presentQueue;
+		///VK_NULL_HANDLE when headless
+		VkQueue presentQueue = VK_NULL_HANDLE;
+		///the dedicated transfer family's queue, the graphics queue when there is none
+		VkQueue transferQueue = VK_NULL_HANDLE;
+		///optional features, enabled whenever the device has them
+		bool multiDrawIndirect = false;
+		bool drawIndirectFirstInstance = false;
 		
 	private:
+		bool headless;
 		const std::vector<const char *> validationLayers = { "VK_LAYER_KHRONOS_validation"};
 		VkDebugUtilsMessengerEXT debugMessenger;
 
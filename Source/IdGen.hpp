@@ -6,6 +6,7 @@
 #define IDGEN_HPP
 #include <algorithm>
 #include <mutex>
+#include <string_view>
 #include "Dependencies/uuid.h"
 
 
@@ -24,6 +25,14 @@ public:
 
         return gen();
     }
+
+    ///Name based ID, the same name always gives the same ID so cooked assets keep their IDs across runs
+    static uuids::uuid genID(std::string_view name) {
+        static const uuids::uuid skadiNamespace{ {0x5b, 0x3e, 0x1c, 0x7a, 0x42, 0x0d, 0x4f, 0x6e, 0x9a, 0x81, 0x2c, 0xd4, 0x6b, 0x17, 0xe0, 0x93} };
+
+        uuids::uuid_name_generator gen{skadiNamespace};
+        return gen(name);
+    }
 };
 
 
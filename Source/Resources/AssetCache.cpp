@@ -0,0 +1,229 @@
+#include "AssetCache.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <iostream>
+#include <stdexcept>
+
+#include "AssetPackage.hpp"
+#include "ContentHash.hpp"
+#include "MappedFile.hpp"
+#include "Source/IdGen.hpp"
+
+AssetCache::AssetCache(std::filesystem::path cacheDirectory, Loader &loader) : cacheDirectory(std::move(cacheDirectory)), loader(loader) {
+	std::filesystem::create_directories(this->cacheDirectory);
+}
+
+std::tuple<std::vector<Mesh>, std::vector<Material>> AssetCache::load(const std::filesystem::path &sourcePath, const ImportSettings &settings) {
+	uint64_t key = cacheKey(hashSource(sourcePath), settings);
+
+	{
+		//one thread reads or cooks a key at a time, so two never write the same cooked file, the others wait for its entry
+		std::unique_lock lock(cacheMutex);
+		keyDone.wait(lock, [this, key] { return !inFlight.contains(key); });
+
+		if (auto entry = loaded.find(key); entry != loaded.end()) {
+			stats.memoryHits++;
+			auto result = entry->second;
+			place(key, std::get<0>(result));
+			return result;
+		}
+
+		inFlight.insert(key);
+	}
+
+	std::filesystem::path cookedPath = cacheDirectory / (ContentHash::toHex(key) + ".skpkg");
+	std::tuple<std::vector<Mesh>, std::vector<Material>> result;
+	bool fromDisk = false;
+
+	try {
+		if (std::filesystem::exists(cookedPath)) {
+			try {
+				result = AssetPackage::load(cookedPath);
+				fromDisk = true;
+			} catch (const std::runtime_error &e) {
+				std::cout << "SKADI: Discarding unreadable cache entry " << cookedPath << ": " << e.what() << "\n";
+			}
+		}
+
+		if (!fromDisk) {
+			result = cook(sourcePath, cookedPath, key, settings);
+		}
+	} catch (...) {
+		std::lock_guard lock(cacheMutex);
+		inFlight.erase(key);
+		keyDone.notify_all();
+		throw;
+	}
+
+	std::lock_guard lock(cacheMutex);
+	inFlight.erase(key);
+	keyDone.notify_all();
+
+	auto &[meshes, materials] = result;
+	if (meshes.empty()) return result;
+
+	fromDisk ? stats.diskHits++ : stats.imports++;
+
+	share(meshes, materials);
+	loaded[key] = result;
+	place(key, meshes);
+
+	return result;
+}
+
+void AssetCache::evict(const std::filesystem::path &sourcePath, const ImportSettings &settings) {
+	uint64_t key = cacheKey(hashSource(sourcePath), settings);
+
+	std::lock_guard lock(cacheMutex);
+	loaded.erase(key);
+}
+
+void AssetCache::clearMemory() {
+	std::lock_guard lock(cacheMutex);
+	loaded.clear();
+	textures.clear();
+	geometry.clear();
+}
+
+AssetCache::Stats AssetCache::getStats() {
+	std::lock_guard lock(cacheMutex);
+	return stats;
+}
+
+///Hashes the file contents, skipped when size and write time match the last hash of the same path
+uint64_t AssetCache::hashSource(const std::filesystem::path &sourcePath) {
+	std::string pathKey = std::filesystem::absolute(sourcePath).string();
+	std::filesystem::file_time_type writeTime = std::filesystem::last_write_time(sourcePath);
+	uintmax_t size = std::filesystem::file_size(sourcePath);
+
+	{
+		std::lock_guard lock(cacheMutex);
+		if (auto stamp = sourceStamps.find(pathKey); stamp != sourceStamps.end()) {
+			if (stamp->second.writeTime == writeTime && stamp->second.size == size)
+				return stamp->second.contentHash;
+		}
+	}
+
+	MappedFile file(sourcePath);
+	uint64_t contentHash = ContentHash::hash(file.data(), file.size());
+
+	std::lock_guard lock(cacheMutex);
+	sourceStamps[pathKey] = {writeTime, size, contentHash};
+
+	return contentHash;
+}
+
+uint64_t AssetCache::cacheKey(uint64_t contentHash, const ImportSettings &settings) {
+	//anything that changes the cooked bytes has to be part of the key
+	const uint32_t keyData[] = {settings.postProcessFlags, settings.optimizeMeshes, settings.lodCount, std::bit_cast<uint32_t>(settings.lodReduction),
+		settings.buildMeshlets, settings.quantizeVertices, static_cast<uint32_t>(settings.mipFilter), static_cast<uint32_t>(settings.textureFormat), settings.nativeGltf, AssetPackage::VERSION, static_cast<uint32_t>(sizeof(Vertex))};
+	return ContentHash::hash(keyData, sizeof(keyData), contentHash);
+}
+
+std::tuple<std::vector<Mesh>, std::vector<Material>> AssetCache::cook(const std::filesystem::path &sourcePath, const std::filesystem::path &cookedPath, uint64_t key, const ImportSettings &settings) {
+	auto [meshes, materials] = loader.loadModels(sourcePath, settings);
+	if (meshes.empty()) return {};
+
+	assignContentIDs(key, meshes, materials);
+
+	//written under a temporary name so a crash never leaves a half written entry behind
+	std::filesystem::path tempPath = cookedPath;
+	tempPath += ".tmp";
+	AssetPackage::write(tempPath, meshes, materials);
+	std::filesystem::rename(tempPath, cookedPath);
+
+	//the imported pixels go back to the loader's pool here, the mapped package replaces them
+	return AssetPackage::load(cookedPath);
+}
+
+void AssetCache::assignContentIDs(uint64_t key, std::vector<Mesh> &meshes, std::vector<Material> &materials) {
+	std::string keyHex = ContentHash::toHex(key);
+	std::unordered_map<uuids::uuid, uuids::uuid> materialIDs;
+
+	for (Material &material : materials) {
+		//textures are named by their pixels so identical images share an ID across models
+		std::vector<std::string> textureNames;
+		for (auto &[name, texture] : material.textures) {
+			texture.id = IDGen::genID("texture/" + ContentHash::toHex(ContentHash::hash(texture.pixels, texture.byteSize)));
+			textureNames.push_back(name + "=" + uuids::to_string(texture.id));
+		}
+
+		std::sort(textureNames.begin(), textureNames.end());
+
+		std::string materialName = keyHex + "/material";
+		for (const std::string &textureName : textureNames) {
+			materialName += "/" + textureName;
+		}
+
+		uuids::uuid materialID = IDGen::genID(materialName);
+		materialIDs[material.id] = materialID;
+		material.id = materialID;
+	}
+
+	for (uint32_t i = 0; i < meshes.size(); i++) {
+		meshes[i].id = IDGen::genID(keyHex + "/mesh/" + std::to_string(i));
+
+		if (auto materialID = materialIDs.find(meshes[i].materialID); materialID != materialIDs.end())
+			meshes[i].materialID = materialID->second;
+	}
+}
+
+///Gives the meshes of every load of a key after the first their own IDs, so one model can be drawn in several places
+///Loads are counted per key, the n-th load of the same content gets the same IDs every run, expects cacheMutex to be held
+void AssetCache::place(uint64_t key, std::vector<Mesh> &meshes) {
+	uint32_t placement = placements[key]++;
+	if (placement == 0) return;
+
+	for (Mesh &mesh : meshes) {
+		mesh.id = IDGen::genID(uuids::to_string(mesh.id) + "/placement/" + std::to_string(placement));
+	}
+}
+
+///Points identical textures and geometry at one copy, expects cacheMutex to be held
+void AssetCache::share(std::vector<Mesh> &meshes, std::vector<Material> &materials) {
+	for (Material &material : materials) {
+		for (auto &[name, texture] : material.textures) {
+			auto shared = textures.find(texture.id);
+
+			if (shared != textures.end()) {
+				if (auto source = shared->second.source.lock()) {
+					texture = shared->second.texture;
+					texture.pixelSource = source;
+					stats.sharedTextures++;
+					continue;
+				}
+			}
+
+			if (texture.pixelSource) {
+				SharedTexture entry{texture.pixelSource, texture};
+				entry.texture.pixelSource.reset();
+				textures[texture.id] = entry;
+			}
+		}
+	}
+
+	for (Mesh &mesh : meshes) {
+		std::span<const uint8_t> vertices = mesh.vertexBytes();
+		std::span<const uint32_t> indices = mesh.indexData();
+		uint64_t vertexHash = ContentHash::hash(vertices.data(), vertices.size_bytes(), static_cast<uint64_t>(mesh.layout));
+		uint64_t geometryHash = ContentHash::hash(indices.data(), indices.size_bytes(), vertexHash);
+
+		auto shared = geometry.find(geometryHash);
+
+		if (shared != geometry.end()) {
+			if (auto source = shared->second.source.lock()) {
+				mesh.source = source;
+				mesh.vertexView = shared->second.vertices;
+				mesh.quantizedView = shared->second.quantizedVertices;
+				mesh.indexView = shared->second.indices;
+				stats.sharedMeshes++;
+				continue;
+			}
+		}
+
+		if (mesh.source) {
+			geometry[geometryHash] = {mesh.source, mesh.vertexView, mesh.quantizedView, indices};
+		}
+	}
+}
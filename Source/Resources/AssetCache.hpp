@@ -0,0 +1,88 @@
+#ifndef ASSETCACHE_HPP
+#define ASSETCACHE_HPP
+
+#include <condition_variable>
+#include <cstdint>
+#include <filesystem>
+#include <mutex>
+#include <string>
+#include <tuple>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "Loader.hpp"
+#include "Model.hpp"
+
+///Imports models once and reuses the cooked result
+///Entries are keyed by a hash of the source file contents and the import settings, cooked packages are kept in cacheDirectory
+///and loaded results are kept in memory, so an unchanged model is neither re-imported nor re-read
+///IDs are derived from the content, the same model gives the same mesh, material and texture IDs every run
+///Only the first load of a model hands out the content mesh IDs, later loads of it get IDs salted with its load count so each is its own placement
+///Textures referenced from outside a model file are not part of its key, re-save the model to pick up changes to them
+class AssetCache {
+public:
+	struct Stats {
+		uint32_t memoryHits;
+		uint32_t diskHits;
+		uint32_t imports;
+		uint32_t sharedTextures;
+		uint32_t sharedMeshes;
+	};
+
+	AssetCache(std::filesystem::path cacheDirectory, Loader &loader);
+
+	std::tuple<std::vector<Mesh>, std::vector<Material>> load(const std::filesystem::path &sourcePath, const ImportSettings &settings = {});
+
+	///drops the in memory entry of one source, its data is freed once nothing else holds it
+	void evict(const std::filesystem::path &sourcePath, const ImportSettings &settings = {});
+	///drops in memory entries, cooked packages on disk are kept
+	void clearMemory();
+	Stats getStats();
+
+	///replaces the random IDs an import produced with IDs derived from key and content
+	static void assignContentIDs(uint64_t key, std::vector<Mesh> &meshes, std::vector<Material> &materials);
+
+private:
+	struct SourceStamp {
+		std::filesystem::file_time_type writeTime;
+		uintmax_t size;
+		uint64_t contentHash;
+	};
+
+	///shared data is tracked weakly so the cache never keeps an evicted package mapped
+	struct SharedTexture {
+		std::weak_ptr<const void> source;
+		Texture texture;
+	};
+
+	struct SharedGeometry {
+		std::weak_ptr<const void> source;
+		std::span<const Vertex> vertices;
+		std::span<const QuantizedVertex> quantizedVertices;
+		std::span<const uint32_t> indices;
+	};
+
+	std::filesystem::path cacheDirectory;
+	Loader &loader;
+
+	std::mutex cacheMutex;
+	std::unordered_map<uint64_t, std::tuple<std::vector<Mesh>, std::vector<Material>>> loaded;
+	std::unordered_map<std::string, SourceStamp> sourceStamps;
+	std::unordered_map<uuids::uuid, SharedTexture> textures;
+	std::unordered_map<uint64_t, SharedGeometry> geometry;
+	Stats stats{};
+	///loads handed out per key, what salts the mesh IDs of repeat loads
+	std::unordered_map<uint64_t, uint32_t> placements;
+	///keys some thread is reading or cooking, keyDone is signalled as each finishes
+	std::unordered_set<uint64_t> inFlight;
+	std::condition_variable keyDone;
+
+	uint64_t hashSource(const std::filesystem::path &sourcePath);
+	static uint64_t cacheKey(uint64_t contentHash, const ImportSettings &settings);
+	std::tuple<std::vector<Mesh>, std::vector<Material>> cook(const std::filesystem::path &sourcePath, const std::filesystem::path &cookedPath, uint64_t key, const ImportSettings &settings);
+	void share(std::vector<Mesh> &meshes, std::vector<Material> &materials);
+	void place(uint64_t key, std::vector<Mesh> &meshes);
+};
+
+#endif //ASSETCACHE_HPP
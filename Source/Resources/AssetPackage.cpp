@@ -0,0 +1,306 @@
+#include "AssetPackage.hpp"
+
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+
+#include "MappedFile.hpp"
+#include "TextureProcessing.hpp"
+
+namespace {
+	uint64_t alignOffset(uint64_t offset) {
+		return (offset + AssetPackage::PACKAGE_ALIGNMENT - 1) & ~(AssetPackage::PACKAGE_ALIGNMENT - 1);
+	}
+
+	///appends bytes at the next aligned offset and returns that offset
+	uint64_t appendBlob(std::vector<uint8_t> &buffer, const void *data, uint64_t size) {
+		uint64_t offset = alignOffset(buffer.size());
+		buffer.resize(offset + size);
+		if (size > 0) std::memcpy(buffer.data() + offset, data, size);
+		return offset;
+	}
+
+	void writeID(uint8_t (&dst)[16], const uuids::uuid &id) {
+		std::memcpy(dst, id.as_bytes().data(), 16);
+	}
+
+	uuids::uuid readID(const uint8_t (&src)[16]) {
+		return uuids::uuid(std::begin(src), std::end(src));
+	}
+
+	void checkRange(const MappedFile &file, uint64_t offset, uint64_t size) {
+		if (offset > file.size() || size > file.size() - offset) {
+			throw std::runtime_error("Asset package is truncated or corrupt");
+		}
+	}
+
+	///index ranges of levels and meshlets are used unchecked later, they have to stay inside the mesh's indices
+	void checkIndexRange(uint32_t firstIndex, uint32_t indexCount, uint32_t meshIndexCount) {
+		if (uint64_t{firstIndex} + indexCount > meshIndexCount) {
+			throw std::runtime_error("Asset package is truncated or corrupt");
+		}
+	}
+}
+
+void AssetPackage::write(const std::filesystem::path &path, const std::vector<Mesh> &meshes, const std::vector<Material> &materials) {
+	std::vector<MeshRecord> meshRecords(meshes.size());
+	std::vector<MaterialRecord> materialRecords(materials.size());
+	std::vector<TextureRecord> textureRecords;
+	std::string strings;
+	std::unordered_map<uuids::uuid, size_t> writtenTextures;
+
+	//blobs are gathered first and placed after the tables once their sizes are known
+	std::vector<uint8_t> blobs;
+
+	for (size_t i = 0; i < meshes.size(); i++) {
+		const Mesh &mesh = meshes[i];
+		MeshRecord &record = meshRecords[i];
+
+		std::span<const uint8_t> vertices = mesh.vertexBytes();
+		std::span<const uint32_t> indices = mesh.indexData();
+
+		writeID(record.id, mesh.id);
+		writeID(record.materialID, mesh.materialID);
+		std::memcpy(record.transform, &mesh.transform, sizeof(record.transform));
+
+		std::memcpy(record.boundsMin, &mesh.bounds.min, sizeof(record.boundsMin));
+		std::memcpy(record.boundsMax, &mesh.bounds.max, sizeof(record.boundsMax));
+		std::memcpy(record.boundsCenter, &mesh.bounds.center, sizeof(record.boundsCenter));
+		record.boundsRadius = mesh.bounds.radius;
+
+		record.vertexCount = mesh.vertexCount();
+		record.layout = static_cast<uint32_t>(mesh.layout);
+		record.occluder = mesh.occluder;
+		record.indexCount = indices.size();
+		record.lodCount = mesh.lods.size();
+		record.vertexOffset = appendBlob(blobs, vertices.data(), vertices.size_bytes());
+		record.indexOffset = appendBlob(blobs, indices.data(), indices.size_bytes());
+		record.lodOffset = appendBlob(blobs, mesh.lods.data(), mesh.lods.size() * sizeof(LodLevel));
+		record.meshletCount = mesh.meshlets.size();
+		record.meshletOffset = appendBlob(blobs, mesh.meshlets.data(), mesh.meshlets.size() * sizeof(Meshlet));
+	}
+
+	for (size_t i = 0; i < materials.size(); i++) {
+		const Material &material = materials[i];
+		MaterialRecord &record = materialRecords[i];
+
+		writeID(record.id, material.id);
+		record.firstTexture = textureRecords.size();
+		record.textureCount = material.textures.size();
+
+		for (const auto &[name, texture] : material.textures) {
+			TextureRecord textureRecord{};
+			writeID(textureRecord.id, texture.id);
+			textureRecord.nameOffset = strings.size();
+			textureRecord.nameLength = name.size();
+			strings += name;
+
+			textureRecord.width = texture.width;
+			textureRecord.height = texture.height;
+			textureRecord.channels = texture.channels;
+
+			//textures shared between materials are stored once
+			if (auto written = writtenTextures.find(texture.id); written != writtenTextures.end()) {
+				const TextureRecord &original = textureRecords[written->second];
+				std::copy(std::begin(original.mipOffsets), std::end(original.mipOffsets), textureRecord.mipOffsets);
+				textureRecord.mipLevels = original.mipLevels;
+				textureRecord.format = original.format;
+				textureRecord.dataOffset = original.dataOffset;
+				textureRecord.dataSize = original.dataSize;
+
+				textureRecords.push_back(textureRecord);
+				continue;
+			}
+
+			std::vector<uint64_t> mipOffsets = texture.mipOffsets;
+			std::vector<uint8_t> mipChain;
+			const uint8_t *pixelData = texture.pixels;
+			uint64_t pixelSize = texture.byteSize;
+
+			//mips are built here so the runtime never has to blit them
+			if (mipOffsets.empty()) {
+				mipChain = TextureProcessing::generateMipChain(texture.pixels, texture.width, texture.height, mipOffsets, {.srgb = isSrgbFormat(texture.format)});
+				pixelData = mipChain.data();
+				pixelSize = mipChain.size();
+			}
+
+			if (mipOffsets.size() > MAX_MIP_LEVELS) {
+				throw std::runtime_error("Texture has too many mip levels for asset package: " + name);
+			}
+
+			textureRecord.mipLevels = mipOffsets.size();
+			textureRecord.format = static_cast<uint32_t>(texture.format);
+			std::copy(mipOffsets.begin(), mipOffsets.end(), textureRecord.mipOffsets);
+			textureRecord.dataSize = pixelSize;
+			textureRecord.dataOffset = appendBlob(blobs, pixelData, pixelSize);
+
+			writtenTextures[texture.id] = textureRecords.size();
+			textureRecords.push_back(textureRecord);
+		}
+	}
+
+	std::vector<uint8_t> buffer(sizeof(Header));
+	Header header{};
+	std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+	header.version = VERSION;
+	header.vertexStride = sizeof(Vertex);
+	header.meshCount = meshRecords.size();
+	header.materialCount = materialRecords.size();
+	header.textureCount = textureRecords.size();
+	header.meshTableOffset = appendBlob(buffer, meshRecords.data(), meshRecords.size() * sizeof(MeshRecord));
+	header.materialTableOffset = appendBlob(buffer, materialRecords.data(), materialRecords.size() * sizeof(MaterialRecord));
+	header.textureTableOffset = appendBlob(buffer, textureRecords.data(), textureRecords.size() * sizeof(TextureRecord));
+	header.stringTableOffset = appendBlob(buffer, strings.data(), strings.size());
+
+	//blob offsets were recorded relative to the blob section, rebase them now
+	uint64_t blobBase = appendBlob(buffer, blobs.data(), blobs.size());
+	header.fileSize = buffer.size();
+
+	for (MeshRecord &record : meshRecords) {
+		record.vertexOffset += blobBase;
+		record.indexOffset += blobBase;
+		record.lodOffset += blobBase;
+		record.meshletOffset += blobBase;
+	}
+	for (TextureRecord &record : textureRecords) {
+		record.dataOffset += blobBase;
+	}
+
+	std::memcpy(buffer.data(), &header, sizeof(Header));
+	if (!meshRecords.empty())
+		std::memcpy(buffer.data() + header.meshTableOffset, meshRecords.data(), meshRecords.size() * sizeof(MeshRecord));
+	if (!textureRecords.empty())
+		std::memcpy(buffer.data() + header.textureTableOffset, textureRecords.data(), textureRecords.size() * sizeof(TextureRecord));
+
+	std::ofstream file(path, std::ios::binary | std::ios::trunc);
+	if (!file.is_open()) {
+		throw std::runtime_error("Failed to open asset package for writing: " + path.string());
+	}
+
+	file.write(reinterpret_cast<const char *>(buffer.data()), buffer.size());
+	if (!file) {
+		throw std::runtime_error("Failed to write asset package: " + path.string());
+	}
+
+	std::cout << "SKADI: Cooked " << meshRecords.size() << " meshes and " << textureRecords.size() << " textures into " << path << "\n";
+}
+
+std::tuple<std::vector<Mesh>, std::vector<Material>> AssetPackage::load(const std::filesystem::path &path) {
+	auto file = std::make_shared<MappedFile>(path);
+
+	checkRange(*file, 0, sizeof(Header));
+	Header header;
+	std::memcpy(&header, file->data(), sizeof(Header));
+
+	if (std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0) {
+		throw std::runtime_error("Not an asset package: " + path.string());
+	}
+	if (header.version != VERSION || header.vertexStride != sizeof(Vertex)) {
+		throw std::runtime_error("Asset package was cooked for a different engine version, recook: " + path.string());
+	}
+	if (header.fileSize != file->size()) {
+		throw std::runtime_error("Asset package is truncated or corrupt");
+	}
+
+	checkRange(*file, header.meshTableOffset, header.meshCount * sizeof(MeshRecord));
+	checkRange(*file, header.materialTableOffset, header.materialCount * sizeof(MaterialRecord));
+	checkRange(*file, header.textureTableOffset, header.textureCount * sizeof(TextureRecord));
+
+	auto meshRecords = reinterpret_cast<const MeshRecord *>(file->data() + header.meshTableOffset);
+	auto materialRecords = reinterpret_cast<const MaterialRecord *>(file->data() + header.materialTableOffset);
+	auto textureRecords = reinterpret_cast<const TextureRecord *>(file->data() + header.textureTableOffset);
+	auto strings = reinterpret_cast<const char *>(file->data() + header.stringTableOffset);
+
+	std::vector<Mesh> meshes(header.meshCount);
+	for (uint32_t i = 0; i < header.meshCount; i++) {
+		const MeshRecord &record = meshRecords[i];
+		Mesh &mesh = meshes[i];
+
+		uint64_t vertexStride;
+		if (record.layout == static_cast<uint32_t>(VertexLayout::Full)) vertexStride = sizeof(Vertex);
+		else if (record.layout == static_cast<uint32_t>(VertexLayout::Quantized)) vertexStride = sizeof(QuantizedVertex);
+		else throw std::runtime_error("Asset package is truncated or corrupt");
+
+		checkRange(*file, record.vertexOffset, record.vertexCount * vertexStride);
+		checkRange(*file, record.indexOffset, record.indexCount * sizeof(uint32_t));
+		checkRange(*file, record.lodOffset, record.lodCount * sizeof(LodLevel));
+		checkRange(*file, record.meshletOffset, record.meshletCount * sizeof(Meshlet));
+
+		mesh.id = readID(record.id);
+		mesh.materialID = readID(record.materialID);
+		std::memcpy(&mesh.transform, record.transform, sizeof(record.transform));
+		std::memcpy(&mesh.bounds.min, record.boundsMin, sizeof(record.boundsMin));
+		std::memcpy(&mesh.bounds.max, record.boundsMax, sizeof(record.boundsMax));
+		std::memcpy(&mesh.bounds.center, record.boundsCenter, sizeof(record.boundsCenter));
+		mesh.bounds.radius = record.boundsRadius;
+		mesh.occluder = record.occluder != 0;
+
+		auto lods = reinterpret_cast<const LodLevel *>(file->data() + record.lodOffset);
+		mesh.lods.assign(lods, lods + record.lodCount);
+		for (const LodLevel &lod : mesh.lods) checkIndexRange(lod.firstIndex, lod.indexCount, record.indexCount);
+
+		auto meshlets = reinterpret_cast<const Meshlet *>(file->data() + record.meshletOffset);
+		mesh.meshlets.assign(meshlets, meshlets + record.meshletCount);
+		for (const Meshlet &meshlet : mesh.meshlets) checkIndexRange(meshlet.firstIndex, meshlet.indexCount, record.indexCount);
+
+		mesh.source = file;
+		mesh.layout = static_cast<VertexLayout>(record.layout);
+		if (mesh.layout == VertexLayout::Quantized)
+			mesh.quantizedView = {reinterpret_cast<const QuantizedVertex *>(file->data() + record.vertexOffset), record.vertexCount};
+		else
+			mesh.vertexView = {reinterpret_cast<const Vertex *>(file->data() + record.vertexOffset), record.vertexCount};
+		mesh.indexView = {reinterpret_cast<const uint32_t *>(file->data() + record.indexOffset), record.indexCount};
+	}
+
+	std::vector<Material> materials(header.materialCount);
+	for (uint32_t i = 0; i < header.materialCount; i++) {
+		const MaterialRecord &record = materialRecords[i];
+		Material &material = materials[i];
+
+		if (record.firstTexture + record.textureCount > header.textureCount) {
+			throw std::runtime_error("Asset package is truncated or corrupt");
+		}
+
+		material.id = readID(record.id);
+
+		for (uint32_t j = record.firstTexture; j < record.firstTexture + record.textureCount; j++) {
+			const TextureRecord &textureRecord = textureRecords[j];
+
+			checkRange(*file, textureRecord.dataOffset, textureRecord.dataSize);
+			checkRange(*file, header.stringTableOffset + textureRecord.nameOffset, textureRecord.nameLength);
+			if (textureRecord.mipLevels == 0 || textureRecord.mipLevels > MAX_MIP_LEVELS || textureRecord.format > static_cast<uint32_t>(TextureFormat::BC7)) {
+				throw std::runtime_error("Asset package is truncated or corrupt");
+			}
+
+			Texture texture{};
+			texture.id = readID(textureRecord.id);
+			texture.width = textureRecord.width;
+			texture.height = textureRecord.height;
+			texture.channels = textureRecord.channels;
+			texture.byteSize = textureRecord.dataSize;
+			texture.mipLevels = textureRecord.mipLevels;
+			texture.format = static_cast<TextureFormat>(textureRecord.format);
+			texture.mipOffsets.assign(textureRecord.mipOffsets, textureRecord.mipOffsets + textureRecord.mipLevels);
+
+			//every level starts past the one before and inside the pixel data, the upload copies from these offsets
+			for (uint32_t level = 0; level < texture.mipOffsets.size(); level++) {
+				if (texture.mipOffsets[level] >= textureRecord.dataSize || (level > 0 && texture.mipOffsets[level] <= texture.mipOffsets[level - 1])) {
+					throw std::runtime_error("Asset package is truncated or corrupt");
+				}
+			}
+
+			texture.pixels = file->data() + textureRecord.dataOffset;
+			texture.pixelSource = file;
+
+			material.textures[std::string(strings + textureRecord.nameOffset, textureRecord.nameLength)] = texture;
+		}
+	}
+
+	std::cout << "SKADI: Mapped asset package " << path << "\n";
+
+	return std::make_tuple(meshes, materials);
+}
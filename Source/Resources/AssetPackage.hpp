@@ -0,0 +1,86 @@
+#ifndef ASSETPACKAGE_HPP
+#define ASSETPACKAGE_HPP
+
+#include <cstdint>
+#include <filesystem>
+#include <tuple>
+#include <vector>
+
+#include "Model.hpp"
+
+///Cooked, GPU ready package of meshes, materials and mipped textures
+///Layout: Header, then mesh, material and texture tables, a string table, then vertex, index, lod, meshlet and pixel blobs
+///Every table and blob starts on a PACKAGE_ALIGNMENT boundary so it can be used in place from a mapping
+class AssetPackage {
+public:
+	static constexpr char MAGIC[4] = {'S', 'K', 'P', 'K'};
+	static constexpr uint32_t VERSION = 6;
+	static constexpr uint64_t PACKAGE_ALIGNMENT = 16;
+	static constexpr uint32_t MAX_MIP_LEVELS = 16;
+
+	struct Header {
+		char magic[4];
+		uint32_t version;
+		uint32_t vertexStride;
+		uint32_t meshCount;
+		uint32_t materialCount;
+		uint32_t textureCount;
+		uint64_t meshTableOffset;
+		uint64_t materialTableOffset;
+		uint64_t textureTableOffset;
+		uint64_t stringTableOffset;
+		uint64_t fileSize;
+	};
+
+	struct MeshRecord {
+		uint8_t id[16];
+		uint8_t materialID[16];
+		float transform[16];
+		float boundsMin[3];
+		float boundsMax[3];
+		float boundsCenter[3];
+		float boundsRadius;
+		uint64_t vertexOffset;
+		uint64_t indexOffset;
+		uint64_t lodOffset;
+		uint32_t vertexCount;
+		uint32_t indexCount;
+		uint32_t lodCount;
+		///VertexLayout of the vertex blob
+		uint32_t layout;
+		uint64_t meshletOffset;
+		uint32_t meshletCount;
+		///1 for meshes marked as occluders
+		uint32_t occluder;
+	};
+
+	struct MaterialRecord {
+		uint8_t id[16];
+		uint32_t firstTexture;
+		uint32_t textureCount;
+	};
+
+	struct TextureRecord {
+		uint8_t id[16];
+		uint32_t nameOffset;
+		uint32_t nameLength;
+		uint32_t width;
+		uint32_t height;
+		uint32_t channels;
+		uint32_t mipLevels;
+		///TextureFormat of every level
+		uint32_t format;
+		uint32_t padding;
+		uint64_t dataOffset;
+		uint64_t dataSize;
+		uint64_t mipOffsets[MAX_MIP_LEVELS];
+	};
+
+	///Cooks meshes and materials into a package at path, textures without prebuilt mips get a full mip chain
+	static void write(const std::filesystem::path &path, const std::vector<Mesh> &meshes, const std::vector<Material> &materials);
+
+	///Maps a package, meshes and textures point straight into the mapping which stays alive while any of them do
+	static std::tuple<std::vector<Mesh>, std::vector<Material>> load(const std::filesystem::path &path);
+};
+
+#endif //ASSETPACKAGE_HPP
@@ -0,0 +1,298 @@
+#include "AssetServer.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <stdexcept>
+
+bool AssetHandle::valid() const {
+	return request != nullptr;
+}
+
+AssetState AssetHandle::state() const {
+	return request->state.load();
+}
+
+bool AssetHandle::ready() const {
+	return request->state.load() == AssetState::Ready;
+}
+
+void AssetHandle::wait() const {
+	std::unique_lock lock(request->stateMutex);
+	request->stateCondition.wait(lock, [this] {
+		AssetState state = request->state.load();
+		return state != AssetState::Queued && state != AssetState::Loading;
+	});
+}
+
+const std::tuple<std::vector<Mesh>, std::vector<Material>> &AssetHandle::get() const {
+	wait();
+
+	if (request->state.load() == AssetState::Failed) {
+		std::rethrow_exception(request->error);
+	}
+	if (request->state.load() == AssetState::Cancelled) {
+		throw std::runtime_error("Asset request was cancelled: " + request->path.string());
+	}
+
+	return request->result;
+}
+
+void AssetHandle::cancel() const {
+	request->cancelled = true;
+
+	//queued requests finish right away, the I/O thread skips them when they reach the front
+	AssetState expected = AssetState::Queued;
+	{
+		std::lock_guard lock(request->stateMutex);
+		request->state.compare_exchange_strong(expected, AssetState::Cancelled);
+	}
+	request->stateCondition.notify_all();
+}
+
+AssetServer::AssetServer(AssetCache &cache, uint64_t memoryBudget, uint32_t ioThreadCount) : cache(cache), memoryBudget(memoryBudget) {
+	ioThreadCount = std::max(1u, ioThreadCount);
+	ioThreads.reserve(ioThreadCount);
+
+	for (uint32_t i = 0; i < ioThreadCount; i++) {
+		ioThreads.emplace_back(&AssetServer::ioLoop, this);
+	}
+}
+
+AssetServer::~AssetServer() {
+	{
+		std::lock_guard lock(serverMutex);
+		stopping = true;
+	}
+	queueCondition.notify_all();
+
+	for (std::thread &ioThread : ioThreads) {
+		ioThread.join();
+	}
+
+	//anything still queued will never load, release whoever is waiting on it
+	for (auto &[path, request] : requests) {
+		AssetState state = request->state.load();
+		if (state == AssetState::Queued || state == AssetState::Loading)
+			finish(*request, AssetState::Cancelled);
+	}
+}
+
+AssetHandle AssetServer::request(const std::filesystem::path &path, float priority, std::function<void(AssetHandle)> onLoaded) {
+	std::string key = std::filesystem::absolute(path).string();
+
+	std::lock_guard lock(serverMutex);
+
+	if (auto existing = requests.find(key); existing != requests.end()) {
+		std::shared_ptr<Request> request = existing->second;
+		AssetState state = request->state.load();
+
+		if (state != AssetState::Cancelled && state != AssetState::Failed) {
+			request->lastUsed = frame;
+
+			if (onLoaded) {
+				request->callbacks.push_back(std::move(onLoaded));
+				//already finished, deliver on the next update
+				if (state == AssetState::Ready)
+					completed.push_back(request);
+			}
+
+			if (state == AssetState::Queued && priority > request->priority) {
+				request->priority = priority;
+				request->generation++;
+				queue.push({priority, request->generation, request});
+				queueCondition.notify_one();
+			}
+
+			return AssetHandle(request);
+		}
+	}
+
+	auto request = std::make_shared<Request>();
+	request->path = path;
+	request->priority = priority;
+	request->generation = 0;
+	request->lastUsed = frame;
+	if (onLoaded) request->callbacks.push_back(std::move(onLoaded));
+
+	requests[key] = request;
+	queue.push({priority, request->generation, request});
+	queueCondition.notify_one();
+
+	return AssetHandle(request);
+}
+
+void AssetServer::setPriority(const AssetHandle &handle, float priority) {
+	std::lock_guard lock(serverMutex);
+	std::shared_ptr<Request> request = handle.request;
+
+	if (request->state.load() != AssetState::Queued || request->priority == priority) return;
+
+	//the old queue entry goes stale and is skipped when popped
+	request->priority = priority;
+	request->generation++;
+	queue.push({priority, request->generation, request});
+	queueCondition.notify_one();
+}
+
+float AssetServer::distancePriority(const glm::vec3 &cameraPosition, const glm::vec3 &assetPosition) {
+	glm::vec3 offset = assetPosition - cameraPosition;
+	return -std::sqrt(glm::dot(offset, offset));
+}
+
+void AssetServer::update() {
+	std::vector<std::pair<std::shared_ptr<Request>, std::vector<std::function<void(AssetHandle)>>>> delivered;
+
+	{
+		std::lock_guard lock(serverMutex);
+		frame++;
+
+		for (std::shared_ptr<Request> &request : completed) {
+			delivered.emplace_back(request, std::move(request->callbacks));
+			request->callbacks.clear();
+		}
+		completed.clear();
+	}
+
+	//callbacks may request more assets, so they run without the lock
+	for (auto &[request, callbacks] : delivered) {
+		if (request->state.load() == AssetState::Cancelled) continue;
+
+		for (auto &callback : callbacks) {
+			callback(AssetHandle(request));
+		}
+	}
+
+	evictOverBudget();
+}
+
+uint64_t AssetServer::residentBytes() {
+	std::lock_guard lock(serverMutex);
+	return totalResidentBytes;
+}
+
+void AssetServer::ioLoop() {
+	while (true) {
+		std::shared_ptr<Request> request;
+
+		{
+			std::unique_lock lock(serverMutex);
+			queueCondition.wait(lock, [this] { return stopping || !queue.empty(); });
+
+			if (stopping) return;
+
+			QueueEntry entry = queue.top();
+			queue.pop();
+
+			request = entry.request.lock();
+			AssetState expected = AssetState::Queued;
+
+			//stale or already taken, let go while still holding the lock like below
+			if (!request || entry.generation != request->generation || !request->state.compare_exchange_strong(expected, AssetState::Loading)) {
+				request.reset();
+				continue;
+			}
+		}
+
+		std::tuple<std::vector<Mesh>, std::vector<Material>> result;
+		std::exception_ptr error;
+
+		try {
+			result = cache.load(request->path);
+			if (std::get<0>(result).empty()) {
+				throw std::runtime_error("Asset has no meshes: " + request->path.string());
+			}
+		} catch (...) {
+			error = std::current_exception();
+		}
+
+		std::lock_guard lock(serverMutex);
+
+		//the reference is dropped under the lock so eviction never sees a finished request as still in use
+		if (request->cancelled) {
+			finish(*request, AssetState::Cancelled);
+			request.reset();
+			continue;
+		}
+
+		if (error) {
+			std::cout << "SKADI: Failed to stream asset " << request->path << "\n";
+			request->error = error;
+			finish(*request, AssetState::Failed);
+		}
+		else {
+			request->result = std::move(result);
+			request->byteSize = modelByteSize(request->result);
+			request->lastUsed = frame;
+			totalResidentBytes += request->byteSize;
+			finish(*request, AssetState::Ready);
+		}
+
+		completed.push_back(std::move(request));
+	}
+}
+
+///Drops least recently used resident models until under budget, models with outstanding handles are kept
+void AssetServer::evictOverBudget() {
+	std::vector<std::filesystem::path> evicted;
+
+	{
+		std::lock_guard lock(serverMutex);
+
+		std::vector<std::shared_ptr<Request>> candidates;
+		for (auto &[key, request] : requests) {
+			//a handle held outside the server counts as a use this frame
+			if (request.use_count() > 1) request->lastUsed = frame;
+
+			if (request->state.load() == AssetState::Ready && request.use_count() == 1)
+				candidates.push_back(request);
+		}
+
+		std::sort(candidates.begin(), candidates.end(), [](const auto &a, const auto &b) {
+			return a->lastUsed < b->lastUsed;
+		});
+
+		for (std::shared_ptr<Request> &request : candidates) {
+			if (totalResidentBytes <= memoryBudget) break;
+
+			totalResidentBytes -= request->byteSize;
+			evicted.push_back(request->path);
+			requests.erase(std::filesystem::absolute(request->path).string());
+		}
+
+		//finished requests nobody wants any more are forgotten as well
+		std::erase_if(requests, [](const auto &entry) {
+			AssetState state = entry.second->state.load();
+			return (state == AssetState::Cancelled || state == AssetState::Failed) && entry.second.use_count() == 1;
+		});
+	}
+
+	for (const std::filesystem::path &path : evicted) {
+		cache.evict(path);
+	}
+}
+
+uint64_t AssetServer::modelByteSize(const std::tuple<std::vector<Mesh>, std::vector<Material>> &model) {
+	const auto &[meshes, materials] = model;
+	uint64_t size = 0;
+
+	for (const Mesh &mesh : meshes) {
+		size += mesh.vertexBytes().size() + mesh.indexData().size_bytes();
+	}
+
+	for (const Material &material : materials) {
+		for (const auto &[name, texture] : material.textures) {
+			size += texture.byteSize;
+		}
+	}
+
+	return size;
+}
+
+void AssetServer::finish(Request &request, AssetState state) {
+	{
+		std::lock_guard lock(request.stateMutex);
+		request.state = state;
+	}
+	request.stateCondition.notify_all();
+}
@@ -0,0 +1,130 @@
+#ifndef ASSETSERVER_HPP
+#define ASSETSERVER_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
+
+#include "AssetCache.hpp"
+
+enum class AssetState {
+	Queued,
+	Loading,
+	Ready,
+	Failed,
+	Cancelled
+};
+
+class AssetServer;
+
+///Future like reference to a requested model, cheap to copy
+class AssetHandle {
+public:
+	AssetHandle() = default;
+
+	bool valid() const;
+	AssetState state() const;
+	bool ready() const;
+
+	///blocks until the request is finished, failed or cancelled
+	void wait() const;
+	///waits, then returns the loaded model or rethrows the load error
+	const std::tuple<std::vector<Mesh>, std::vector<Material>> &get() const;
+
+	///a queued request is dropped, a request already loading has its result discarded
+	void cancel() const;
+
+private:
+	friend class AssetServer;
+
+	struct Request {
+		std::filesystem::path path;
+		float priority;
+		uint64_t generation;
+
+		std::atomic<AssetState> state{AssetState::Queued};
+		std::atomic<bool> cancelled{false};
+		std::tuple<std::vector<Mesh>, std::vector<Material>> result;
+		std::exception_ptr error;
+		uint64_t byteSize = 0;
+		uint64_t lastUsed = 0;
+
+		std::vector<std::function<void(AssetHandle)>> callbacks;
+
+		std::mutex stateMutex;
+		std::condition_variable stateCondition;
+	};
+
+	explicit AssetHandle(std::shared_ptr<Request> request) : request(std::move(request)) {}
+
+	std::shared_ptr<Request> request;
+};
+
+///Loads models on dedicated I/O threads in priority order
+///Callbacks run on whichever thread calls update(), normally the main loop
+///Finished models are kept resident up to memoryBudget bytes, past that the least recently used ones nobody holds a handle to are evicted
+class AssetServer {
+public:
+	AssetServer(AssetCache &cache, uint64_t memoryBudget, uint32_t ioThreadCount = 2);
+	~AssetServer();
+
+	AssetServer(const AssetServer &) = delete;
+	AssetServer &operator=(const AssetServer &) = delete;
+
+	///higher priority loads first, requesting a path that is already queued or resident returns the existing handle
+	AssetHandle request(const std::filesystem::path &path, float priority = 0.0f, std::function<void(AssetHandle)> onLoaded = {});
+	void setPriority(const AssetHandle &handle, float priority);
+
+	///priority for streaming by distance, nearer assets load first
+	static float distancePriority(const glm::vec3 &cameraPosition, const glm::vec3 &assetPosition);
+
+	///delivers completion callbacks and evicts over budget assets, call once per frame
+	void update();
+
+	uint64_t residentBytes();
+
+private:
+	using Request = AssetHandle::Request;
+
+	struct QueueEntry {
+		float priority;
+		uint64_t generation;
+		///weak so stale entries left behind by priority changes never count as a use of the request
+		std::weak_ptr<Request> request;
+
+		bool operator<(const QueueEntry &other) const {
+			return priority < other.priority;
+		}
+	};
+
+	AssetCache &cache;
+	const uint64_t memoryBudget;
+
+	std::mutex serverMutex;
+	std::condition_variable queueCondition;
+	std::priority_queue<QueueEntry> queue;
+	std::unordered_map<std::string, std::shared_ptr<Request>> requests;
+	std::vector<std::shared_ptr<Request>> completed;
+	uint64_t totalResidentBytes = 0;
+	uint64_t frame = 0;
+	bool stopping = false;
+
+	std::vector<std::thread> ioThreads;
+
+	void ioLoop();
+	void evictOverBudget();
+	static uint64_t modelByteSize(const std::tuple<std::vector<Mesh>, std::vector<Material>> &model);
+	static void finish(Request &request, AssetState state);
+};
+
+#endif //ASSETSERVER_HPP
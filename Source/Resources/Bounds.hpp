@@ -0,0 +1,62 @@
+#ifndef BOUNDS_HPP
+#define BOUNDS_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <span>
+
+#include <glm/glm.hpp>
+
+#include "../Graphics/Vertex.hpp"
+
+///Axis aligned box and enclosing sphere of a mesh in model space
+struct Bounds {
+	glm::vec3 min{0};
+	glm::vec3 max{0};
+	glm::vec3 center{0};
+	float radius = 0;
+
+	static Bounds fromVertices(std::span<const Vertex> vertices) {
+		return build(vertices, [](const Vertex &vertex) { return vertex.pos; });
+	}
+
+	///from a position stream, the tight loop over plain vec3s vectorizes
+	static Bounds fromPositions(std::span<const glm::vec3> positions) {
+		return build(positions, [](const glm::vec3 &position) { return position; });
+	}
+
+private:
+	template <typename T, typename F>
+	static Bounds build(std::span<const T> points, F position) {
+		Bounds bounds{};
+		if (points.empty()) return bounds;
+
+		bounds.min = position(points[0]);
+		bounds.max = position(points[0]);
+		for (const T &point : points) {
+			bounds.min = glm::min(bounds.min, position(point));
+			bounds.max = glm::max(bounds.max, position(point));
+		}
+
+		//sphere around the box centre, loose but cheap and stable
+		bounds.center = (bounds.min + bounds.max) * 0.5f;
+		for (const T &point : points) {
+			glm::vec3 offset = position(point) - bounds.center;
+			bounds.radius = std::max(bounds.radius, glm::dot(offset, offset));
+		}
+		bounds.radius = std::sqrt(bounds.radius);
+
+		return bounds;
+	}
+};
+
+///largest axis scale of a transform, what carries model space lengths like radii and LOD errors through it
+inline float maxAxisScale(const glm::mat4 &transform) {
+	return std::sqrt(std::max({
+		glm::dot(glm::vec3(transform[0]), glm::vec3(transform[0])),
+		glm::dot(glm::vec3(transform[1]), glm::vec3(transform[1])),
+		glm::dot(glm::vec3(transform[2]), glm::vec3(transform[2]))
+	}));
+}
+
+#endif //BOUNDS_HPP
@@ -0,0 +1,120 @@
+#ifndef CONTENTHASH_HPP
+#define CONTENTHASH_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+///64 bit xxHash of a byte range, used to key cooked assets by what they contain instead of where they came from
+namespace ContentHash {
+	namespace detail {
+		constexpr uint64_t PRIME1 = 11400714785074694791ULL;
+		constexpr uint64_t PRIME2 = 14029467366897019727ULL;
+		constexpr uint64_t PRIME3 = 1609587929392839161ULL;
+		constexpr uint64_t PRIME4 = 9650029242287828579ULL;
+		constexpr uint64_t PRIME5 = 2870177450012600261ULL;
+
+		inline uint64_t rotl(uint64_t x, int r) {
+			return (x << r) | (x >> (64 - r));
+		}
+
+		inline uint64_t read64(const uint8_t *p) {
+			uint64_t value;
+			std::memcpy(&value, p, sizeof(value));
+			return value;
+		}
+
+		inline uint32_t read32(const uint8_t *p) {
+			uint32_t value;
+			std::memcpy(&value, p, sizeof(value));
+			return value;
+		}
+
+		inline uint64_t round(uint64_t acc, uint64_t input) {
+			acc += input * PRIME2;
+			acc = rotl(acc, 31);
+			return acc * PRIME1;
+		}
+
+		inline uint64_t mergeRound(uint64_t acc, uint64_t value) {
+			acc ^= round(0, value);
+			return acc * PRIME1 + PRIME4;
+		}
+	}
+
+	inline uint64_t hash(const void *data, size_t size, uint64_t seed = 0) {
+		using namespace detail;
+
+		const uint8_t *p = static_cast<const uint8_t *>(data);
+		const uint8_t *end = p + size;
+		uint64_t h;
+
+		if (size >= 32) {
+			uint64_t v1 = seed + PRIME1 + PRIME2;
+			uint64_t v2 = seed + PRIME2;
+			uint64_t v3 = seed;
+			uint64_t v4 = seed - PRIME1;
+
+			//four independent lanes so the loop is not one long dependency chain
+			const uint8_t *limit = end - 32;
+			do {
+				v1 = round(v1, read64(p));
+				v2 = round(v2, read64(p + 8));
+				v3 = round(v3, read64(p + 16));
+				v4 = round(v4, read64(p + 24));
+				p += 32;
+			} while (p <= limit);
+
+			h = rotl(v1, 1) + rotl(v2, 7) + rotl(v3, 12) + rotl(v4, 18);
+			h = mergeRound(h, v1);
+			h = mergeRound(h, v2);
+			h = mergeRound(h, v3);
+			h = mergeRound(h, v4);
+		}
+		else {
+			h = seed + PRIME5;
+		}
+
+		h += static_cast<uint64_t>(size);
+
+		while (p + 8 <= end) {
+			h ^= round(0, read64(p));
+			h = rotl(h, 27) * PRIME1 + PRIME4;
+			p += 8;
+		}
+
+		if (p + 4 <= end) {
+			h ^= static_cast<uint64_t>(read32(p)) * PRIME1;
+			h = rotl(h, 23) * PRIME2 + PRIME3;
+			p += 4;
+		}
+
+		while (p < end) {
+			h ^= (*p) * PRIME5;
+			h = rotl(h, 11) * PRIME1;
+			p++;
+		}
+
+		h ^= h >> 33;
+		h *= PRIME2;
+		h ^= h >> 29;
+		h *= PRIME3;
+		h ^= h >> 32;
+
+		return h;
+	}
+
+	///fixed width lowercase hex, used for cache file names
+	inline std::string toHex(uint64_t value) {
+		static constexpr char DIGITS[] = "0123456789abcdef";
+		std::string hex(16, '0');
+		for (int i = 15; i >= 0; i--) {
+			hex[i] = DIGITS[value & 0xF];
+			value >>= 4;
+		}
+		return hex;
+	}
+}
+
+#endif //CONTENTHASH_HPP
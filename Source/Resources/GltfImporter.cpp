@@ -0,0 +1,428 @@
+//images are decoded by the loader and nothing is ever written back out
+#define TINYGLTF_IMPLEMENTATION
+#define TINYGLTF_NO_STB_IMAGE
+#define TINYGLTF_NO_STB_IMAGE_WRITE
+#include "GltfImporter.hpp"
+
+#include <cstring>
+#include <iostream>
+#include <numeric>
+#include <optional>
+#include <stdexcept>
+
+#include "VertexConversion.hpp"
+#include "MappedFile.hpp"
+#include "TextureProcessing.hpp"
+#include "Source/IdGen.hpp"
+
+namespace {
+	///where the elements of an accessor sit inside its buffer
+	struct AccessorData {
+		const uint8_t *data;
+		size_t stride;
+		size_t count;
+		int componentType;
+		int components;
+		bool normalized;
+	};
+
+	AccessorData accessorData(const tinygltf::Model &model, int index) {
+		if (index < 0 || static_cast<size_t>(index) >= model.accessors.size()) {
+			throw std::runtime_error("glTF accessor index out of range");
+		}
+
+		const tinygltf::Accessor &accessor = model.accessors[index];
+		if (accessor.sparse.isSparse || accessor.bufferView < 0) {
+			throw std::runtime_error("Sparse glTF accessors are not supported");
+		}
+
+		const tinygltf::BufferView &view = model.bufferViews.at(accessor.bufferView);
+		const tinygltf::Buffer &buffer = model.buffers.at(view.buffer);
+
+		int stride = accessor.ByteStride(view);
+		int componentSize = tinygltf::GetComponentSizeInBytes(accessor.componentType);
+		int components = tinygltf::GetNumComponentsInType(accessor.type);
+		if (stride <= 0 || componentSize <= 0 || components <= 0) {
+			throw std::runtime_error("glTF accessor has an invalid layout");
+		}
+
+		size_t elementSize = static_cast<size_t>(componentSize) * components;
+		bool outsideView = accessor.count > 0 && accessor.byteOffset + (accessor.count - 1) * stride + elementSize > view.byteLength;
+		if (outsideView || view.byteOffset + view.byteLength > buffer.data.size()) {
+			throw std::runtime_error("glTF accessor reaches past the end of its buffer");
+		}
+
+		return {buffer.data.data() + view.byteOffset + accessor.byteOffset, static_cast<size_t>(stride), accessor.count, accessor.componentType, components, accessor.normalized};
+	}
+
+	///one component of an element as a float, integer components are mapped to 0..1 or -1..1 when normalized
+	float readComponent(const AccessorData &accessor, size_t element, int component) {
+		const uint8_t *bytes = accessor.data + element * accessor.stride;
+
+		switch (accessor.componentType) {
+			case TINYGLTF_COMPONENT_TYPE_FLOAT: {
+				float value;
+				std::memcpy(&value, bytes + component * sizeof(float), sizeof(float));
+				return value;
+			}
+			case TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE: {
+				uint8_t value = bytes[component];
+				return accessor.normalized ? value / 255.0f : value;
+			}
+			case TINYGLTF_COMPONENT_TYPE_BYTE: {
+				int8_t value = static_cast<int8_t>(bytes[component]);
+				return accessor.normalized ? std::max(value / 127.0f, -1.0f) : value;
+			}
+			case TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT: {
+				uint16_t value;
+				std::memcpy(&value, bytes + component * sizeof(uint16_t), sizeof(uint16_t));
+				return accessor.normalized ? value / 65535.0f : value;
+			}
+			case TINYGLTF_COMPONENT_TYPE_SHORT: {
+				int16_t value;
+				std::memcpy(&value, bytes + component * sizeof(int16_t), sizeof(int16_t));
+				return accessor.normalized ? std::max(value / 32767.0f, -1.0f) : value;
+			}
+			case TINYGLTF_COMPONENT_TYPE_UNSIGNED_INT: {
+				uint32_t value;
+				std::memcpy(&value, bytes + component * sizeof(uint32_t), sizeof(uint32_t));
+				return static_cast<float>(value);
+			}
+			default:
+				throw std::runtime_error("glTF accessor has an unsupported component type");
+		}
+	}
+
+	///fills the N floats at fieldOffset of every vertex from an attribute accessor
+	template <size_t N>
+	void readAttribute(const AccessorData &accessor, std::vector<Vertex> &vertices, size_t fieldOffset) {
+		if (accessor.count < vertices.size()) {
+			throw std::runtime_error("glTF attribute has fewer elements than POSITION");
+		}
+
+		uint8_t *field = reinterpret_cast<uint8_t *>(vertices.data()) + fieldOffset;
+
+		//float data only changes stride, one fixed size copy per vertex
+		if (accessor.componentType == TINYGLTF_COMPONENT_TYPE_FLOAT && accessor.components >= static_cast<int>(N)) {
+			for (size_t i = 0; i < vertices.size(); i++) {
+				std::memcpy(field + i * sizeof(Vertex), accessor.data + i * accessor.stride, N * sizeof(float));
+			}
+			return;
+		}
+
+		const int components = std::min(accessor.components, static_cast<int>(N));
+		for (size_t i = 0; i < vertices.size(); i++) {
+			float values[N] = {};
+			for (int c = 0; c < components; c++) values[c] = readComponent(accessor, i, c);
+			std::memcpy(field + i * sizeof(Vertex), values, N * sizeof(float));
+		}
+	}
+
+	///float elements with at least components floats each, as many as the mesh has vertices
+	bool isFloatStream(const AccessorData &accessor, int components, size_t vertexCount) {
+		return accessor.componentType == TINYGLTF_COMPONENT_TYPE_FLOAT && accessor.components >= components && accessor.count >= vertexCount;
+	}
+
+	const tinygltf::Accessor *attributeAccessor(const tinygltf::Model &model, const tinygltf::Primitive &primitive, const char *name) {
+		auto attribute = primitive.attributes.find(name);
+		if (attribute == primitive.attributes.end()) return nullptr;
+		if (attribute->second < 0 || static_cast<size_t>(attribute->second) >= model.accessors.size()) return nullptr;
+		return &model.accessors[attribute->second];
+	}
+
+	///true when POSITION, COLOR_0 and TEXCOORD_0 are floats interleaved exactly like Vertex
+	bool matchesVertexLayout(const tinygltf::Model &model, const tinygltf::Primitive &primitive) {
+		const tinygltf::Accessor *position = attributeAccessor(model, primitive, "POSITION");
+		const tinygltf::Accessor *color = attributeAccessor(model, primitive, "COLOR_0");
+		const tinygltf::Accessor *texCoord = attributeAccessor(model, primitive, "TEXCOORD_0");
+		if (!position || !color || !texCoord) return false;
+
+		for (const tinygltf::Accessor *accessor : {position, color, texCoord}) {
+			if (accessor->componentType != TINYGLTF_COMPONENT_TYPE_FLOAT || accessor->bufferView != position->bufferView) return false;
+		}
+
+		if (position->type != TINYGLTF_TYPE_VEC3 || color->type != TINYGLTF_TYPE_VEC3 || texCoord->type != TINYGLTF_TYPE_VEC2) return false;
+		if (position->bufferView < 0 || model.bufferViews[position->bufferView].byteStride != sizeof(Vertex)) return false;
+
+		//the copy takes whole Vertex structs, the last one has to fit in the view and every attribute has to cover it
+		if (color->count < position->count || texCoord->count < position->count) return false;
+		if (position->byteOffset + position->count * sizeof(Vertex) > model.bufferViews[position->bufferView].byteLength) return false;
+
+		return color->byteOffset == position->byteOffset + offsetof(Vertex, color)
+			&& texCoord->byteOffset == position->byteOffset + offsetof(Vertex, texCoord);
+	}
+
+	glm::mat4 nodeTransform(const tinygltf::Node &node) {
+		glm::mat4 transform(1.0f);
+
+		if (node.matrix.size() == 16) {
+			for (int column = 0; column < 4; column++) {
+				for (int row = 0; row < 4; row++) transform[column][row] = static_cast<float>(node.matrix[column * 4 + row]);
+			}
+			return transform;
+		}
+
+		//translation * rotation * scale, the rotation is a unit quaternion stored x y z w
+		if (node.rotation.size() == 4) {
+			float x = node.rotation[0], y = node.rotation[1], z = node.rotation[2], w = node.rotation[3];
+			transform[0] = glm::vec4(1 - 2 * (y * y + z * z), 2 * (x * y + w * z), 2 * (x * z - w * y), 0);
+			transform[1] = glm::vec4(2 * (x * y - w * z), 1 - 2 * (x * x + z * z), 2 * (y * z + w * x), 0);
+			transform[2] = glm::vec4(2 * (x * z + w * y), 2 * (y * z - w * x), 1 - 2 * (x * x + y * y), 0);
+		}
+
+		if (node.scale.size() == 3) {
+			for (int axis = 0; axis < 3; axis++) transform[axis] = transform[axis] * static_cast<float>(node.scale[axis]);
+		}
+
+		if (node.translation.size() == 3) {
+			transform[3] = glm::vec4(node.translation[0], node.translation[1], node.translation[2], 1);
+		}
+
+		return transform;
+	}
+
+	///named with Mesh::OCCLUDER_SUFFIX or carrying "occluder": true in its extras
+	bool marksOccluder(const std::string &name, const tinygltf::Value &extras) {
+		if (Mesh::isOccluderName(name)) return true;
+		return extras.IsObject() && extras.Has("occluder") && extras.Get("occluder").IsBool() && extras.Get("occluder").Get<bool>();
+	}
+
+	void collectNode(const tinygltf::Model &model, int index, const glm::mat4 &parentTransform, bool parentOccluder, uint32_t depth, std::vector<GltfImporter::PrimitiveTask> &tasks) {
+		if (index < 0 || static_cast<size_t>(index) >= model.nodes.size() || depth > model.nodes.size()) {
+			throw std::runtime_error("glTF node hierarchy is invalid");
+		}
+
+		const tinygltf::Node &node = model.nodes[index];
+		glm::mat4 transform = parentTransform * nodeTransform(node);
+		bool occluder = parentOccluder || marksOccluder(node.name, node.extras);
+
+		if (node.mesh >= 0) {
+			const tinygltf::Mesh &mesh = model.meshes.at(node.mesh);
+			bool meshOccluder = occluder || marksOccluder(mesh.name, mesh.extras);
+
+			for (const tinygltf::Primitive &primitive : mesh.primitives) {
+				if (primitive.mode != TINYGLTF_MODE_TRIANGLES) {
+					std::cout << "SKADI: Skipping glTF primitive that is not a triangle list in mesh " << node.mesh << "\n";
+					continue;
+				}
+
+				tasks.push_back({&primitive, transform, meshOccluder});
+			}
+		}
+
+		for (int child : node.children) {
+			collectNode(model, child, transform, occluder, depth + 1, tasks);
+		}
+	}
+}
+
+bool GltfImporter::isGltf(const std::filesystem::path &path) {
+	return path.extension() == ".gltf" || path.extension() == ".glb";
+}
+
+tinygltf::Model GltfImporter::parse(const std::filesystem::path &path) {
+	tinygltf::TinyGLTF gltfLoader;
+
+	//images stay encoded, images inside a buffer view are not even copied
+	gltfLoader.SetImageLoader([](tinygltf::Image *image, const int, std::string *, std::string *, int, int, const unsigned char *bytes, int size, void *) {
+		if (image->bufferView < 0) image->image.assign(bytes, bytes + size);
+		image->as_is = true;
+		return true;
+	}, nullptr);
+
+	tinygltf::Model model;
+	std::string error, warning;
+	bool parsed;
+
+	if (path.extension() == ".glb") {
+		//the binary chunk is copied once into the model's buffer, straight out of the mapping
+		MappedFile file(path);
+		parsed = gltfLoader.LoadBinaryFromMemory(&model, &error, &warning, file.data(), file.size(), path.parent_path().string());
+	}
+	else {
+		parsed = gltfLoader.LoadASCIIFromFile(&model, &error, &warning, path.string());
+	}
+
+	if (!warning.empty()) {
+		std::cout << "SKADI: glTF warning in " << path << ": " << warning << "\n";
+	}
+
+	if (!parsed) {
+		throw std::runtime_error("Failed to parse glTF " + path.string() + ": " + error);
+	}
+
+	return model;
+}
+
+std::vector<GltfImporter::PrimitiveTask> GltfImporter::collectPrimitives(const tinygltf::Model &model) {
+	std::vector<PrimitiveTask> tasks;
+	std::vector<int> roots;
+
+	if (!model.scenes.empty()) {
+		int scene = model.defaultScene >= 0 && static_cast<size_t>(model.defaultScene) < model.scenes.size() ? model.defaultScene : 0;
+		roots = model.scenes[scene].nodes;
+	}
+	else {
+		//without scenes every node nobody lists as a child is a root
+		std::vector<bool> isChild(model.nodes.size());
+		for (const tinygltf::Node &node : model.nodes) {
+			for (int child : node.children) {
+				if (child >= 0 && static_cast<size_t>(child) < isChild.size()) isChild[child] = true;
+			}
+		}
+
+		for (uint32_t i = 0; i < model.nodes.size(); i++) {
+			if (!isChild[i]) roots.push_back(i);
+		}
+	}
+
+	for (int root : roots) {
+		collectNode(model, root, glm::mat4(1.0f), false, 0, tasks);
+	}
+
+	return tasks;
+}
+
+Mesh GltfImporter::convertPrimitive(const tinygltf::Model &model, const PrimitiveTask &task) {
+	const tinygltf::Primitive &primitive = *task.primitive;
+
+	auto position = primitive.attributes.find("POSITION");
+	if (position == primitive.attributes.end()) {
+		throw std::runtime_error("glTF primitive has no POSITION attribute");
+	}
+
+	Mesh mesh{};
+	mesh.id = IDGen::genID();
+	mesh.transform = task.transform;
+	mesh.occluder = task.occluder;
+
+	AccessorData positions = accessorData(model, position->second);
+	mesh.vertices.resize(positions.count);
+
+	auto texCoord = primitive.attributes.find("TEXCOORD_0");
+	auto color = primitive.attributes.find("COLOR_0");
+	std::optional<AccessorData> texCoords, colors;
+	if (texCoord != primitive.attributes.end()) texCoords = accessorData(model, texCoord->second);
+	if (color != primitive.attributes.end()) colors = accessorData(model, color->second);
+
+	if (matchesVertexLayout(model, primitive)) {
+		//the buffer already holds Vertex structs
+		std::memcpy(mesh.vertices.data(), positions.data, positions.count * sizeof(Vertex));
+		mesh.bounds = VertexConversion::computeBounds(mesh.vertices);
+	}
+	else if (isFloatStream(positions, 3, mesh.vertices.size()) && (!colors || isFloatStream(*colors, 3, mesh.vertices.size()))
+		&& (!texCoords || isFloatStream(*texCoords, 2, mesh.vertices.size()))) {
+		VertexConversion::FloatStream colorStream = colors ? VertexConversion::FloatStream{colors->data, colors->stride} : VertexConversion::FloatStream{};
+		VertexConversion::FloatStream texCoordStream = texCoords ? VertexConversion::FloatStream{texCoords->data, texCoords->stride} : VertexConversion::FloatStream{};
+		mesh.bounds = VertexConversion::convert({positions.data, positions.stride}, colorStream, texCoordStream, mesh.vertices);
+	}
+	else {
+		//normalized integer attributes are widened one component at a time
+		for (Vertex &vertex : mesh.vertices) {
+			vertex.color = glm::vec3(1.0f);
+			vertex.texCoord = glm::vec2(0.0f);
+		}
+
+		readAttribute<3>(positions, mesh.vertices, offsetof(Vertex, pos));
+		if (texCoords) readAttribute<2>(*texCoords, mesh.vertices, offsetof(Vertex, texCoord));
+		if (colors) readAttribute<3>(*colors, mesh.vertices, offsetof(Vertex, color));
+
+		mesh.bounds = VertexConversion::computeBounds(mesh.vertices);
+	}
+
+	if (primitive.indices < 0) {
+		//non indexed triangle lists draw their vertices in order
+		mesh.indices.resize(mesh.vertices.size());
+		std::iota(mesh.indices.begin(), mesh.indices.end(), 0u);
+	}
+	else {
+		AccessorData indices = accessorData(model, primitive.indices);
+		if (indices.components != 1) {
+			throw std::runtime_error("glTF index accessor is not scalar");
+		}
+
+		mesh.indices.resize(indices.count);
+		switch (indices.componentType) {
+			case TINYGLTF_COMPONENT_TYPE_UNSIGNED_INT:
+				if (indices.stride == sizeof(uint32_t)) {
+					std::memcpy(mesh.indices.data(), indices.data, indices.count * sizeof(uint32_t));
+				}
+				else {
+					for (size_t i = 0; i < indices.count; i++) std::memcpy(&mesh.indices[i], indices.data + i * indices.stride, sizeof(uint32_t));
+				}
+				break;
+			case TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT:
+				for (size_t i = 0; i < indices.count; i++) {
+					uint16_t index;
+					std::memcpy(&index, indices.data + i * indices.stride, sizeof(uint16_t));
+					mesh.indices[i] = index;
+				}
+				break;
+			case TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE:
+				for (size_t i = 0; i < indices.count; i++) mesh.indices[i] = indices.data[i * indices.stride];
+				break;
+			default:
+				throw std::runtime_error("glTF index accessor has an unsupported component type");
+		}
+	}
+
+	if (mesh.indices.size() % 3 != 0) {
+		throw std::runtime_error("glTF triangle list has an index count that is not a multiple of three");
+	}
+
+	for (uint32_t index : mesh.indices) {
+		if (index >= mesh.vertices.size()) throw std::runtime_error("glTF index is out of range of its vertices");
+	}
+
+	return mesh;
+}
+
+int GltfImporter::baseColorImage(const tinygltf::Model &model, int material) {
+	if (material < 0 || static_cast<size_t>(material) >= model.materials.size()) return -1;
+
+	int texture = model.materials[material].pbrMetallicRoughness.baseColorTexture.index;
+	if (texture < 0 || static_cast<size_t>(texture) >= model.textures.size()) return -1;
+
+	int image = model.textures[texture].source;
+	if (image < 0 || static_cast<size_t>(image) >= model.images.size()) return -1;
+
+	return image;
+}
+
+std::string GltfImporter::imageName(const tinygltf::Model &model, int image) {
+	const std::string &uri = model.images.at(image).uri;
+	return uri.empty() ? "*" + std::to_string(image) : uri;
+}
+
+Texture GltfImporter::decodeImage(const tinygltf::Model &model, int image) {
+	const tinygltf::Image &gltfImage = model.images.at(image);
+	const uint8_t *bytes = gltfImage.image.data();
+	size_t size = gltfImage.image.size();
+
+	if (gltfImage.bufferView >= 0) {
+		const tinygltf::BufferView &view = model.bufferViews.at(gltfImage.bufferView);
+		const tinygltf::Buffer &buffer = model.buffers.at(view.buffer);
+		if (view.byteOffset + view.byteLength > buffer.data.size()) {
+			throw std::runtime_error("glTF image reaches past the end of its buffer");
+		}
+
+		bytes = buffer.data.data() + view.byteOffset;
+		size = view.byteLength;
+	}
+
+	int width, height, channels;
+	stbi_uc *pixels = size > 0 ? stbi_load_from_memory(bytes, size, &width, &height, &channels, STBI_rgb_alpha) : nullptr;
+	if (!pixels) {
+		throw std::runtime_error("Failed to load glTF image " + imageName(model, image));
+	}
+
+	Texture texture{};
+	texture.adopt(PixelBuffer::fromStbi(pixels, static_cast<size_t>(width) * height * 4));
+	texture.width = width;
+	texture.height = height;
+	texture.channels = 4;
+	texture.mipLevels = TextureProcessing::mipLevelCount(width, height);
+	texture.id = IDGen::genID();
+
+	return texture;
+}
@@ -0,0 +1,46 @@
+#ifndef GLTFIMPORTER_HPP
+#define GLTFIMPORTER_HPP
+
+#include <filesystem>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "Dependencies/tiny_gltf.h"
+#include "Mesh.hpp"
+#include "Texture.hpp"
+
+///Native .gltf and .glb import through tiny_gltf, accessors are read straight out of the model's buffers
+///Images are kept encoded while parsing so the loader can decode them in parallel
+namespace GltfImporter {
+	///one triangle primitive to convert, transform is the world transform of the node that draws it
+	struct PrimitiveTask {
+		const tinygltf::Primitive *primitive;
+		glm::mat4 transform;
+		///the node, one of its parents or its mesh is marked as an occluder, see Mesh::occluder
+		bool occluder;
+	};
+
+	bool isGltf(const std::filesystem::path &path);
+
+	///parses a .gltf or .glb file, throws std::runtime_error when it is not valid glTF
+	tinygltf::Model parse(const std::filesystem::path &path);
+
+	///walks the default scene down the node hierarchy, multiplying each node's transform into its children's
+	///an occluder node marks everything below it, primitives that are not triangle lists are skipped
+	std::vector<PrimitiveTask> collectPrimitives(const tinygltf::Model &model);
+
+	///Vertex and index data of one primitive, attributes that already match Vertex are copied without conversion
+	Mesh convertPrimitive(const tinygltf::Model &model, const PrimitiveTask &task);
+
+	///image a material samples as base color, -1 when it has none
+	int baseColorImage(const tinygltf::Model &model, int material);
+
+	///name a material's texture is filed under, the uri for external images and *index for embedded ones like assimp
+	std::string imageName(const tinygltf::Model &model, int image);
+
+	///decodes an image to RGBA8
+	Texture decodeImage(const tinygltf::Model &model, int image);
+}
+
+#endif //GLTFIMPORTER_HPP
@@ -0,0 +1,180 @@
+#include "ImportProfiler.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+#include <unistd.h>
+
+namespace {
+	///quotes a string for JSON, control characters are written as \u escapes
+	std::string jsonString(std::string_view text) {
+		std::string quoted = "\"";
+		for (char c : text) {
+			switch (c) {
+				case '"': quoted += "\\\""; break;
+				case '\\': quoted += "\\\\"; break;
+				case '\n': quoted += "\\n"; break;
+				case '\t': quoted += "\\t"; break;
+				default:
+					if (static_cast<unsigned char>(c) < 0x20) {
+						char escaped[8];
+						std::snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+						quoted += escaped;
+					}
+					else {
+						quoted += c;
+					}
+			}
+		}
+		return quoted + "\"";
+	}
+
+	void writeFile(const std::filesystem::path &path, const std::string &contents) {
+		std::ofstream file(path, std::ios::binary | std::ios::trunc);
+		file << contents;
+		if (!file) {
+			throw std::runtime_error("Failed to write import profile " + path.string());
+		}
+	}
+}
+
+ImportProfiler::Scope::Scope(ImportProfiler *profiler, std::string_view stage) : profiler(profiler) {
+	if (!profiler) return;
+
+	this->stage = stage;
+	start = std::chrono::steady_clock::now();
+}
+
+ImportProfiler::Scope::~Scope() {
+	if (profiler) profiler->record(stage, start, std::chrono::steady_clock::now());
+}
+
+ImportProfiler::ImportProfiler(std::string source) : source(std::move(source)), origin(std::chrono::steady_clock::now()) {}
+
+void ImportProfiler::record(std::string_view stage, std::chrono::steady_clock::time_point start, std::chrono::steady_clock::time_point end) {
+	uint64_t startMicros = microsSinceOrigin(start);
+	uint64_t durationMicros = std::max<int64_t>(0, std::chrono::duration_cast<std::chrono::microseconds>(end - start).count());
+
+	std::lock_guard lock(profileMutex);
+	auto thread = threadNumbers.try_emplace(std::this_thread::get_id(), threadNumbers.size()).first;
+	events.push_back({std::string(stage), thread->second, startMicros, durationMicros});
+}
+
+void ImportProfiler::add(std::string_view counter, uint64_t value) {
+	std::lock_guard lock(profileMutex);
+	auto entry = counters.find(counter);
+	if (entry == counters.end()) entry = counters.emplace(std::string(counter), 0).first;
+	entry->second += value;
+}
+
+void ImportProfiler::sampleMemory() {
+	uint64_t bytes = residentMemoryBytes();
+	uint64_t micros = microsSinceOrigin(std::chrono::steady_clock::now());
+
+	std::lock_guard lock(profileMutex);
+	memorySamples.push_back({micros, bytes});
+}
+
+std::map<std::string, ImportProfiler::StageStats> ImportProfiler::stages() {
+	std::lock_guard lock(profileMutex);
+
+	std::map<std::string, StageStats> result;
+	for (const Event &event : events) {
+		StageStats &stats = result[event.stage];
+		stats.calls++;
+		stats.totalMicros += event.durationMicros;
+		stats.maxMicros = std::max(stats.maxMicros, event.durationMicros);
+	}
+
+	return result;
+}
+
+uint64_t ImportProfiler::counter(std::string_view name) {
+	std::lock_guard lock(profileMutex);
+	auto entry = counters.find(name);
+	return entry == counters.end() ? 0 : entry->second;
+}
+
+uint64_t ImportProfiler::peakMemoryBytes() {
+	std::lock_guard lock(profileMutex);
+
+	uint64_t peak = 0;
+	for (const MemorySample &sample : memorySamples) {
+		peak = std::max(peak, sample.bytes);
+	}
+
+	return peak;
+}
+
+std::string ImportProfiler::reportJson() {
+	std::map<std::string, StageStats> stageStats = stages();
+	uint64_t peak = peakMemoryBytes();
+
+	std::lock_guard lock(profileMutex);
+	std::ostringstream json;
+	json << "{\n\t\"source\": " << jsonString(source) << ",\n\t\"stages\": {";
+
+	bool first = true;
+	for (const auto &[name, stats] : stageStats) {
+		json << (first ? "\n" : ",\n") << "\t\t" << jsonString(name) << ": {\"calls\": " << stats.calls
+			<< ", \"totalMs\": " << stats.totalMicros / 1000.0 << ", \"maxMs\": " << stats.maxMicros / 1000.0 << "}";
+		first = false;
+	}
+
+	json << "\n\t},\n\t\"counters\": {";
+
+	first = true;
+	for (const auto &[name, value] : counters) {
+		json << (first ? "\n" : ",\n") << "\t\t" << jsonString(name) << ": " << value;
+		first = false;
+	}
+
+	json << "\n\t},\n\t\"peakMemoryBytes\": " << peak << "\n}\n";
+	return json.str();
+}
+
+std::string ImportProfiler::traceJson() {
+	std::lock_guard lock(profileMutex);
+	std::ostringstream json;
+	json << "{\"traceEvents\": [\n";
+
+	bool first = true;
+	for (const Event &event : events) {
+		json << (first ? "" : ",\n") << "{\"name\": " << jsonString(event.stage) << ", \"cat\": \"import\", \"ph\": \"X\", \"pid\": 1, \"tid\": " << event.thread
+			<< ", \"ts\": " << event.startMicros << ", \"dur\": " << event.durationMicros << "}";
+		first = false;
+	}
+
+	for (const MemorySample &sample : memorySamples) {
+		json << (first ? "" : ",\n") << "{\"name\": \"memory\", \"cat\": \"import\", \"ph\": \"C\", \"pid\": 1, \"ts\": " << sample.micros
+			<< ", \"args\": {\"residentBytes\": " << sample.bytes << "}}";
+		first = false;
+	}
+
+	json << "\n], \"displayTimeUnit\": \"ms\", \"otherData\": {\"source\": " << jsonString(source) << "}}\n";
+	return json.str();
+}
+
+void ImportProfiler::writeReport(const std::filesystem::path &path) {
+	writeFile(path, reportJson());
+}
+
+void ImportProfiler::writeTrace(const std::filesystem::path &path) {
+	writeFile(path, traceJson());
+}
+
+uint64_t ImportProfiler::residentMemoryBytes() {
+	//second field of statm is the resident page count
+	std::ifstream statm("/proc/self/statm");
+	uint64_t totalPages = 0, residentPages = 0;
+	if (!(statm >> totalPages >> residentPages)) return 0;
+
+	return residentPages * static_cast<uint64_t>(sysconf(_SC_PAGESIZE));
+}
+
+uint64_t ImportProfiler::microsSinceOrigin(std::chrono::steady_clock::time_point time) const {
+	return std::max<int64_t>(0, std::chrono::duration_cast<std::chrono::microseconds>(time - origin).count());
+}
@@ -0,0 +1,90 @@
+#ifndef IMPORTPROFILER_HPP
+#define IMPORTPROFILER_HPP
+
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <map>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+///Collects stage timings and counters of one import, pass it to Loader::loadModels
+///Stages may be recorded from any thread, the result is a JSON report and a Chrome trace (chrome://tracing, Perfetto)
+class ImportProfiler {
+public:
+	///every call of one stage summed up, stages on several threads at once add up to more than wall time
+	struct StageStats {
+		uint32_t calls;
+		uint64_t totalMicros;
+		uint64_t maxMicros;
+	};
+
+	///times a stage from construction to destruction, does nothing when profiler is nullptr
+	class Scope {
+	public:
+		Scope(ImportProfiler *profiler, std::string_view stage);
+		~Scope();
+		Scope(const Scope &) = delete;
+		Scope &operator=(const Scope &) = delete;
+
+	private:
+		ImportProfiler *profiler;
+		std::string stage;
+		std::chrono::steady_clock::time_point start;
+	};
+
+	explicit ImportProfiler(std::string source = {});
+	ImportProfiler(const ImportProfiler &) = delete;
+	ImportProfiler &operator=(const ImportProfiler &) = delete;
+
+	void record(std::string_view stage, std::chrono::steady_clock::time_point start, std::chrono::steady_clock::time_point end);
+	///adds to a named counter like bytesRead or triangles
+	void add(std::string_view counter, uint64_t value);
+	///samples resident memory, the report keeps the highest sample
+	void sampleMemory();
+
+	std::map<std::string, StageStats> stages();
+	uint64_t counter(std::string_view name);
+	uint64_t peakMemoryBytes();
+
+	///source, per stage totals, counters and peak memory as one JSON object
+	std::string reportJson();
+	///every recorded stage as a complete event in Chrome trace event format, memory samples as a counter track
+	std::string traceJson();
+	///throws std::runtime_error when the file can not be written
+	void writeReport(const std::filesystem::path &path);
+	void writeTrace(const std::filesystem::path &path);
+
+	///resident set size of this process, 0 where it can not be read
+	static uint64_t residentMemoryBytes();
+
+private:
+	struct Event {
+		std::string stage;
+		uint32_t thread;
+		uint64_t startMicros;
+		uint64_t durationMicros;
+	};
+
+	struct MemorySample {
+		uint64_t micros;
+		uint64_t bytes;
+	};
+
+	std::mutex profileMutex;
+	std::string source;
+	std::chrono::steady_clock::time_point origin;
+	std::vector<Event> events;
+	std::vector<MemorySample> memorySamples;
+	std::map<std::string, uint64_t, std::less<>> counters;
+	///threads are numbered in the order they first record something, the trace shows one row per number
+	std::unordered_map<std::thread::id, uint32_t> threadNumbers;
+
+	uint64_t microsSinceOrigin(std::chrono::steady_clock::time_point time) const;
+};
+
+#endif //IMPORTPROFILER_HPP
@@ -6,6 +6,7 @@
 #include <filesystem>
 #include <glm/common.hpp>
 #include <glm/fwd.hpp>
+#include <chrono>
 #include <iostream>
 #include <string>
 #include <assimp/scene.h>
@@ -22,107 +23,440 @@
 #include "Model.hpp"
 #include "../../Dependencies/stb_image_write.h"
 
-#include "../../Dependencies/tiny_gltf.h"
 #include "Source/IdGen.hpp"
-
-void Loader::processAiNode(const aiScene *scene, aiNode *node, std::vector<Mesh> &meshes, std::unordered_map<uint32_t, Material> &materials) {
-	std::unordered_map<std::string, std::string> texture_paths;
+#include "AssetPackage.hpp"
+#include "MeshOptimizer.hpp"
+#include "MeshSimplifier.hpp"
+#include "MeshletBuilder.hpp"
+#include "VertexQuantizer.hpp"
+#include "VertexConversion.hpp"
+#include "TextureCompression.hpp"
+#include "GltfImporter.hpp"
+
+Loader::Loader(uint32_t threadCount) : pool(threadCount), pixelPool(std::make_shared<PixelPool>()) {}
+
+///Walks the node tree and records every mesh reference, conversion happens later on the pool
+///Occluders are marked by name, or by an "occluder" metadata flag that formats like glTF extras and FBX user properties bring in
+void Loader::collectAiNode(const aiScene *scene, const aiNode *node, bool parentOccluder, std::vector<MeshTask> &tasks) {
 	glm::mat4 nodeTransform = Assimp2Glm(node->mTransformation);
 
+	bool occluder = parentOccluder || Mesh::isOccluderName(node->mName.C_Str());
+	bool flagged = false;
+	if (node->mMetaData && node->mMetaData->Get(std::string("occluder"), flagged)) occluder |= flagged;
+
 	for (uint32_t i = 0; i < node->mNumMeshes; i++) {
-		Mesh mesh{};
+		const aiMesh *assimpMesh = scene->mMeshes[node->mMeshes[i]];
+		tasks.push_back({assimpMesh, nodeTransform, occluder || Mesh::isOccluderName(assimpMesh->mName.C_Str())});
+	}
+
+	for (uint32_t i = 0; i < node->mNumChildren; i++) {
+		collectAiNode(scene, node->mChildren[i], occluder, tasks);
+	}
+}
+
+Mesh Loader::convertAiMesh(const MeshTask &task, ImportProfiler *profiler) {
+	ImportProfiler::Scope convertScope(profiler, "convert");
+	const aiMesh *assimpMesh = task.assimpMesh;
+
+	Mesh mesh{};
+	{
+		ImportProfiler::Scope idScope(profiler, "id generation");
 		mesh.id = IDGen::genID();
-		mesh.transform = nodeTransform;
+	}
+	mesh.transform = task.transform;
+	mesh.occluder = task.occluder;
+
+	static_assert(sizeof(ai_real) == sizeof(float), "VertexConversion reads assimp vertices as floats");
+
+	//only the first color and uv channel are used, texture coordinates are 3d in assimp and z is skipped
+	mesh.vertices.resize(assimpMesh->mNumVertices);
+	VertexConversion::FloatStream positions{assimpMesh->mVertices, sizeof(aiVector3D)};
+	VertexConversion::FloatStream colors{assimpMesh->mColors[0], sizeof(aiColor4D)};
+	VertexConversion::FloatStream texCoords{assimpMesh->mTextureCoords[0], sizeof(aiVector3D)};
+	mesh.bounds = VertexConversion::convert(positions, colors, texCoords, mesh.vertices);
+
+	//faces are triangulated on import so every face has three indices
+	mesh.indices.reserve(assimpMesh->mNumFaces * 3);
+	for (uint32_t j = 0; j < assimpMesh->mNumFaces; j++) {
+		const aiFace& face = assimpMesh->mFaces[j];
+		mesh.indices.insert(mesh.indices.end(), face.mIndices, face.mIndices + face.mNumIndices);
+	}
 
-		aiMesh *assimpMesh = scene->mMeshes[node->mMeshes[i]];
+	return mesh;
+}
 
-		for (uint32_t j = 0; j < assimpMesh->mNumVertices; j++) {
-			Vertex vertex;
-			vertex.pos.x = assimpMesh[i].mVertices[j].x;
-			vertex.pos.y = assimpMesh[i].mVertices[j].y;
-			vertex.pos.z = assimpMesh[i].mVertices[j].z;
+std::tuple<std::vector<Mesh>, std::vector<Material>> Loader::loadModels(std::filesystem::path path, const ImportSettings &settings, ImportProfiler *profiler) {
+	ImportProfiler::Scope importScope(profiler, "import");
+	if (profiler) profiler->sampleMemory();
 
-			vertex.texCoord.x = assimpMesh->mTextureCoords[0][j].x;
-			vertex.texCoord.y = assimpMesh->mTextureCoords[0][j].y;
+	std::tuple<std::vector<Mesh>, std::vector<Material>> result;
 
-			mesh.vertices.push_back(vertex);
-		}
+	//cooked packages are mapped as is, no import work
+	if (path.extension() == ".skpkg") {
+		ImportProfiler::Scope mapScope(profiler, "map package");
+		result = AssetPackage::load(path);
+	}
+	else if (settings.nativeGltf && GltfImporter::isGltf(path)) {
+		result = loadGltf(path, settings, profiler);
+	}
+	else {
+		result = loadAssimp(path, settings, profiler);
+	}
 
-		for (uint32_t j = 0; j < assimpMesh->mNumFaces; j++) {
-			const aiFace& face = assimpMesh->mFaces[j];
-			for (uint32_t k = 0; k < face.mNumIndices; k++) {
-				mesh.indices.push_back(face.mIndices[k]);
-			}
-		}
+	if (profiler) profiler->sampleMemory();
+	return result;
+}
+
+std::tuple<std::vector<Mesh>, std::vector<Material>> Loader::loadAssimp(const std::filesystem::path &path, const ImportSettings &settings, ImportProfiler *profiler) {
+	Assimp::Importer importer;
+	const aiScene *scene;
+
+	//read and post-process separately so the two show up as their own stages
+	{
+		ImportProfiler::Scope readScope(profiler, "read");
+		scene = importer.ReadFile(path, 0);
+	}
+
+	std::cout << "At " << path << "\n";
+
+	if (scene) {
+		if (profiler) profiler->add("bytesRead", std::filesystem::file_size(path));
+
+		ImportProfiler::Scope postProcessScope(profiler, "post-process");
+		scene = importer.ApplyPostProcessing(settings.postProcessFlags);
+	}
+
+	if (!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode) {
+		std::cout << "SKADI: Assimp failed to load model into scene object\n";
+		return {};
+	}
+
+	if (profiler) profiler->sampleMemory();
 
-		uint32_t materialIndex = assimpMesh->mMaterialIndex;
-		if (materialIndex >= 0) {
-			aiMaterial *aiMaterial = scene->mMaterials[assimpMesh->mMaterialIndex];
-			aiString texturePath;
+	std::vector<MeshTask> meshTasks;
+	{
+		ImportProfiler::Scope walkScope(profiler, "node walk");
+		collectAiNode(scene, scene->mRootNode, false, meshTasks);
+	}
 
+	//create one material per referenced assimp material that has a diffuse texture
+	auto materialStart = std::chrono::steady_clock::now();
+	std::unordered_map<uint32_t, Material> material_dict;
+	std::vector<TextureTask> textureTasks;
 
-			if (aiMaterial->GetTexture(aiTextureType_DIFFUSE, 0, &texturePath) == AI_SUCCESS) {
-				std::cout << texturePath.C_Str() << " " << assimpMesh->mMaterialIndex << "\n";
+	for (const MeshTask &meshTask : meshTasks) {
+		uint32_t materialIndex = meshTask.assimpMesh->mMaterialIndex;
+		if (material_dict.contains(materialIndex)) continue;
 
-				//Add texture to material if material exists
-				if (materials.contains(materialIndex)) {
-					if (!materials[materialIndex].textures.contains(texturePath.C_Str())) {
-						const aiTexture *aiTex = scene->GetEmbeddedTexture(texturePath.C_Str());
-						materials[materialIndex].textures[texturePath.C_Str()] = loadTexture(aiTex);
-					}
-				}
-				else { //Create material and add texture
-					Material newMat{};
-					newMat.id = IDGen::genID();
+		aiMaterial *aiMaterial = scene->mMaterials[materialIndex];
+		aiString texturePath;
 
-					//CHECK FOR MEMORY LEAK, DO THESE RESOURCES GET FREED?
-					const aiTexture *aiTex = scene->GetEmbeddedTexture(texturePath.C_Str());
-					newMat.textures[texturePath.C_Str()] = loadTexture(aiTex);
+		if (aiMaterial->GetTexture(aiTextureType_DIFFUSE, 0, &texturePath) == AI_SUCCESS) {
+			std::cout << texturePath.C_Str() << " " << materialIndex << "\n";
 
-					materials[materialIndex] = newMat;
-				}
+			Material newMat{};
+			newMat.id = IDGen::genID();
+			material_dict[materialIndex] = newMat;
 
-				//store material ID in mesh
-				mesh.materialID = materials[materialIndex].id;
-			}
+			textureTasks.push_back({materialIndex, texturePath.C_Str(), scene->GetEmbeddedTexture(texturePath.C_Str())});
 		}
 		else {
-			std::cout << "Mesh does not have material, Material ID: " << assimpMesh->mMaterialIndex << "\n";
+			std::cout << "Material does not have a diffuse texture, Material ID: " << materialIndex << "\n";
 		}
+	}
+
+	if (profiler) profiler->record("materials", materialStart, std::chrono::steady_clock::now());
 
+	//decode textures in the background while meshes are converted
+	std::vector<std::shared_future<Texture>> decodedTextures;
+	decodedTextures.reserve(textureTasks.size());
 
-		meshes.push_back(mesh);
+	for (const TextureTask &textureTask : textureTasks) {
+		std::filesystem::path externalPath = path.parent_path() / textureTask.path;
+
+		decodedTextures.push_back(pool.submit([this, textureTask, externalPath, profiler] {
+			ImportProfiler::Scope decodeScope(profiler, "texture decode");
+			if (textureTask.embedded) return loadTexture(textureTask.embedded);
+
+			std::error_code error;
+			uintmax_t size = std::filesystem::file_size(externalPath, error);
+			if (profiler && !error) profiler->add("bytesRead", size);
+
+			return loadTexture(externalPath);
+		}).share());
 	}
 
-	for (uint32_t i = 0; i < node->mNumChildren; i++) {
-		processAiNode(scene, node->mChildren[i], meshes, materials);
+	std::vector<Mesh> meshes(meshTasks.size());
+	std::vector<MeshOptimizer::Stats> optimizationStats(meshTasks.size());
+
+	convertMeshes(meshTasks.size(), [&meshes, &meshTasks, &optimizationStats, &settings, profiler](uint32_t i) {
+		meshes[i] = convertAiMesh(meshTasks[i], profiler);
+		optimizationStats[i] = processMesh(meshes[i], settings, profiler);
+	}, decodedTextures);
+
+	reportMeshStats(meshes, optimizationStats, settings, profiler);
+
+	for (uint32_t i = 0; i < meshTasks.size(); i++) {
+		uint32_t materialIndex = meshTasks[i].assimpMesh->mMaterialIndex;
+
+		//store material ID in mesh
+		if (material_dict.contains(materialIndex))
+			meshes[i].materialID = material_dict[materialIndex].id;
 	}
+
+	return std::make_tuple(std::move(meshes), collectTextures(decodedTextures, textureTasks, material_dict, settings, profiler));
 }
 
-std::tuple<std::vector<Mesh>, std::vector<Material>> Loader::loadModels(std::filesystem::path path) {
-	Assimp::Importer importer;
+std::tuple<std::vector<Mesh>, std::vector<Material>> Loader::loadGltf(const std::filesystem::path &path, const ImportSettings &settings, ImportProfiler *profiler) {
+	//shared with the decode jobs so a failed conversion cannot free the model under them
+	std::shared_ptr<const tinygltf::Model> model;
+	try {
+		ImportProfiler::Scope parseScope(profiler, "parse");
+		model = std::make_shared<const tinygltf::Model>(GltfImporter::parse(path));
+	} catch (const std::runtime_error &e) {
+		std::cout << "SKADI: " << e.what() << "\n";
+		return {};
+	}
 
-	const aiScene *scene = importer.ReadFile(path, aiProcess_Triangulate | aiProcess_FlipUVs | aiProcess_JoinIdenticalVertices);
+	if (profiler) {
+		uint64_t bytesRead = std::filesystem::file_size(path);
+		for (const tinygltf::Buffer &buffer : model->buffers) {
+			if (!buffer.uri.empty()) bytesRead += buffer.data.size();
+		}
+		for (const tinygltf::Image &image : model->images) {
+			if (!image.uri.empty()) bytesRead += image.image.size();
+		}
 
-	std::cout << "At " << path << "\n";
+		profiler->add("bytesRead", bytesRead);
+		profiler->sampleMemory();
+	}
 
-	if (!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode) {
-		std::cout << "SKADI: Assimp failed to load model into scene object\n";
-		return {};
+	std::vector<GltfImporter::PrimitiveTask> primitiveTasks;
+	{
+		ImportProfiler::Scope walkScope(profiler, "node walk");
+		primitiveTasks = GltfImporter::collectPrimitives(*model);
 	}
 
-	std::vector<Mesh> meshes;
+	//one material per referenced glTF material with a base color image, each image is decoded once
+	auto materialStart = std::chrono::steady_clock::now();
 	std::unordered_map<uint32_t, Material> material_dict;
-	processAiNode(scene, scene->mRootNode, meshes, material_dict);
+	std::vector<TextureTask> textureTasks;
+	std::vector<int> textureImages;
+
+	for (const GltfImporter::PrimitiveTask &primitiveTask : primitiveTasks) {
+		int materialIndex = primitiveTask.primitive->material;
+		if (materialIndex < 0 || material_dict.contains(materialIndex)) continue;
+
+		int image = GltfImporter::baseColorImage(*model, materialIndex);
+		if (image < 0) {
+			std::cout << "Material does not have a diffuse texture, Material ID: " << materialIndex << "\n";
+			continue;
+		}
+
+		Material newMat{};
+		newMat.id = IDGen::genID();
+		material_dict[materialIndex] = newMat;
+
+		textureTasks.push_back({static_cast<uint32_t>(materialIndex), GltfImporter::imageName(*model, image), nullptr});
+		textureImages.push_back(image);
+	}
+
+	if (profiler) profiler->record("materials", materialStart, std::chrono::steady_clock::now());
+
+	//decode images in the background while primitives are converted, materials sharing an image wait on the same decode
+	std::unordered_map<int, std::shared_future<Texture>> imageDecodes;
+	std::vector<std::shared_future<Texture>> decodedTextures;
+	decodedTextures.reserve(textureTasks.size());
+
+	for (int image : textureImages) {
+		if (!imageDecodes.contains(image)) {
+			imageDecodes[image] = pool.submit([model, image, profiler] {
+				ImportProfiler::Scope decodeScope(profiler, "texture decode");
+				return GltfImporter::decodeImage(*model, image);
+			}).share();
+		}
+
+		decodedTextures.push_back(imageDecodes[image]);
+	}
+
+	std::vector<Mesh> meshes(primitiveTasks.size());
+	std::vector<MeshOptimizer::Stats> optimizationStats(primitiveTasks.size());
+
+	convertMeshes(primitiveTasks.size(), [&meshes, &primitiveTasks, &optimizationStats, &settings, &model, profiler](uint32_t i) {
+		{
+			ImportProfiler::Scope convertScope(profiler, "convert");
+			meshes[i] = GltfImporter::convertPrimitive(*model, primitiveTasks[i]);
+		}
+		optimizationStats[i] = processMesh(meshes[i], settings, profiler);
+	}, decodedTextures);
+
+	reportMeshStats(meshes, optimizationStats, settings, profiler);
+
+	for (uint32_t i = 0; i < primitiveTasks.size(); i++) {
+		int materialIndex = primitiveTasks[i].primitive->material;
+
+		if (materialIndex >= 0 && material_dict.contains(materialIndex))
+			meshes[i].materialID = material_dict[materialIndex].id;
+	}
+
+	return std::make_tuple(std::move(meshes), collectTextures(decodedTextures, textureTasks, material_dict, settings, profiler));
+}
+
+MeshOptimizer::Stats Loader::processMesh(Mesh &mesh, const ImportSettings &settings, ImportProfiler *profiler) {
+	MeshOptimizer::Stats stats{};
+
+	if (settings.optimizeMeshes) {
+		ImportProfiler::Scope optimizeScope(profiler, "optimize");
+		stats = MeshOptimizer::optimize(mesh);
+	}
+
+	if (settings.lodCount > 1) {
+		ImportProfiler::Scope lodScope(profiler, "lods");
+		MeshSimplifier::generateLods(mesh, settings.lodCount, settings.lodReduction);
+	}
+
+	if (settings.buildMeshlets) {
+		ImportProfiler::Scope meshletScope(profiler, "meshlets");
+		MeshletBuilder::build(mesh);
+	}
+
+	//last, every pass before works on full precision positions
+	if (settings.quantizeVertices && VertexQuantizer::canQuantize(mesh.vertices)) {
+		ImportProfiler::Scope quantizeScope(profiler, "quantize");
+		VertexQuantizer::quantize(mesh);
+	}
+
+	return stats;
+}
+
+void Loader::reportMeshStats(const std::vector<Mesh> &meshes, const std::vector<MeshOptimizer::Stats> &optimizationStats, const ImportSettings &settings, ImportProfiler *profiler) {
+	if (profiler) {
+		uint64_t vertices = 0, triangles = 0, vertexBytes = 0, indexBytes = 0;
+		for (const Mesh &mesh : meshes) {
+			vertices += mesh.vertexCount();
+			triangles += mesh.lod(0).indexCount / 3;
+			vertexBytes += mesh.vertexBytes().size();
+			indexBytes += mesh.indexData().size_bytes();
+		}
+
+		profiler->add("meshes", meshes.size());
+		profiler->add("vertices", vertices);
+		profiler->add("triangles", triangles);
+		profiler->add("vertexBytes", vertexBytes);
+		profiler->add("indexBytes", indexBytes);
+		profiler->sampleMemory();
+	}
+
+	if (settings.quantizeVertices) {
+		uint64_t fullBytes = 0, storedBytes = 0;
+		for (const Mesh &mesh : meshes) {
+			fullBytes += mesh.vertexCount() * sizeof(Vertex);
+			storedBytes += mesh.vertexBytes().size();
+		}
+
+		if (fullBytes > 0)
+			std::cout << "SKADI: Vertex memory " << fullBytes << " -> " << storedBytes << " bytes\n";
+	}
+
+	if (settings.optimizeMeshes) {
+		//triangle weighted so large meshes dominate the reported ratio
+		double trianglesTotal = 0, missesBefore = 0, missesAfter = 0;
+		for (uint32_t i = 0; i < meshes.size(); i++) {
+			double triangles = meshes[i].lod(0).indexCount / 3;
+			trianglesTotal += triangles;
+			missesBefore += optimizationStats[i].acmrBefore * triangles;
+			missesAfter += optimizationStats[i].acmrAfter * triangles;
+		}
+
+		if (trianglesTotal > 0)
+			std::cout << "SKADI: Vertex cache ACMR " << missesBefore / trianglesTotal << " -> " << missesAfter / trianglesTotal << "\n";
+	}
+}
+
+std::vector<Material> Loader::collectTextures(const std::vector<std::shared_future<Texture>> &decodedTextures, const std::vector<TextureTask> &textureTasks,
+		std::unordered_map<uint32_t, Material> &material_dict, const ImportSettings &settings, ImportProfiler *profiler) {
+	uint64_t decodedBytes = 0, storedTextureBytes = 0;
+	std::unordered_map<uuids::uuid, Texture> processed;
+	PixelPool::Stats poolBefore = pixelPool->getStats();
+
+	for (uint32_t i = 0; i < textureTasks.size(); i++) {
+		Texture texture;
+		try {
+			texture = decodedTextures[i].get();
+		} catch (...) {
+			//the other decodes hold this loader and the profiler, none of them may outlive the import
+			for (const std::shared_future<Texture> &decode : decodedTextures) decode.wait();
+			throw;
+		}
+
+		//a decode shared by several materials is processed once
+		if (auto done = processed.find(texture.id); done != processed.end()) {
+			material_dict[textureTasks[i].materialIndex].textures[textureTasks[i].path] = done->second;
+			continue;
+		}
+
+		decodedBytes += texture.byteSize;
+
+		//each texture is split across the pool by rows and blocks, so they are processed one after another
+		processTexture(texture, settings, profiler);
+		storedTextureBytes += texture.byteSize;
+
+		processed[texture.id] = texture;
+		material_dict[textureTasks[i].materialIndex].textures[textureTasks[i].path] = std::move(texture);
+	}
+
+	if (decodedBytes > 0)
+		std::cout << "SKADI: Texture memory " << decodedBytes << " -> " << storedTextureBytes << " bytes with mips\n";
+
+	if (profiler) {
+		//the pool is shared, imports running at the same time add to each other's allocation counts
+		PixelPool::Stats poolAfter = pixelPool->getStats();
+		profiler->add("textures", processed.size());
+		profiler->add("textureBytes", storedTextureBytes);
+		profiler->add("pixelAllocations", poolAfter.allocations - poolBefore.allocations);
+		profiler->add("pixelReuses", poolAfter.reuses - poolBefore.reuses);
+		profiler->sampleMemory();
+	}
+
+	//blocks only pay off between textures of one import, nothing is held once it returns
+	pixelPool->trim();
 
 	std::vector<Material> materials;
 	materials.reserve(material_dict.size());
 
-	for(auto kv : material_dict) {
-		materials.push_back(kv.second);
+	for(auto &kv : material_dict) {
+		materials.push_back(std::move(kv.second));
+	}
+
+	return materials;
+}
+
+void Loader::processTexture(Texture &texture, const ImportSettings &settings, ImportProfiler *profiler) {
+	//whatever the texture adopts lives until upload, so it is sized exactly, a chain that only feeds compression is pooled scratch
+	std::vector<uint64_t> mipOffsets;
+	size_t chainSize = TextureProcessing::mipChainLayout(texture.width, texture.height, mipOffsets);
+	PixelBuffer chain = settings.textureFormat == TextureFormat::RGBA8 ? pixelPool->allocateExact(chainSize) : pixelPool->allocate(chainSize);
+	{
+		ImportProfiler::Scope mipScope(profiler, "mip generation");
+		TextureProcessing::generateMipChain(texture.pixels, texture.width, texture.height, chain.data(), {settings.mipFilter, isSrgbFormat(settings.textureFormat)}, &pool);
+	}
+
+	if (settings.textureFormat != TextureFormat::RGBA8) {
+		ImportProfiler::Scope compressScope(profiler, "compression");
+		std::vector<uint64_t> compressedOffsets;
+		PixelBuffer compressed = pixelPool->allocateExact(TextureCompression::compressedLayout(settings.textureFormat, texture.width, texture.height, mipOffsets.size(), compressedOffsets));
+		TextureCompression::compressMipChain(chain.data(), texture.width, texture.height, mipOffsets, settings.textureFormat, compressed.data(), &pool);
+
+		//the uncompressed chain goes back to the pool for the next texture
+		chain = std::move(compressed);
+		mipOffsets = std::move(compressedOffsets);
 	}
 
-	return std::make_tuple(meshes, materials);
+	//replaces the decoded image, which is freed here unless another copy still holds it
+	texture.adopt(std::move(chain));
+	texture.mipLevels = mipOffsets.size();
+	texture.mipOffsets = std::move(mipOffsets);
+	texture.format = settings.textureFormat;
 }
 
 Texture Loader::loadTexture(std::filesystem::path filePath) {
@@ -136,11 +470,10 @@ Texture Loader::loadTexture(std::filesystem::path filePath) {
 
 	std::cout << "Loaded texture: " << filePath.c_str() << '\n';
 
-	texture.pixels = pixels;
+	texture.adopt(PixelBuffer::fromStbi(pixels, static_cast<size_t>(texWidth) * texHeight * 4));
 	texture.width = texWidth;
 	texture.height = texHeight;
-	texture.channels = texChannels;;
-	texture.byteSize = texWidth * texHeight * 4;
+	texture.channels = texChannels;
 
 	texture.mipLevels = static_cast<uint32_t>(std::floor(std::log2(std::max(texture.width, texture.height))) + 1);
 	texture.id = IDGen::genID();
@@ -169,11 +502,10 @@ Texture Loader::loadTexture(const aiTexture *aiTexture) {
 		throw std::runtime_error("Failed to load assimp texture image");
 	}
 
-	texture.pixels = data;
+	texture.adopt(PixelBuffer::fromStbi(data, static_cast<size_t>(width) * height * 4));
 	texture.width = width;
 	texture.height = height;
 	texture.channels = 4;
-	texture.byteSize = width * height * 4;
 
 	texture.mipLevels = static_cast<uint32_t>(std::floor(std::log2(std::max(texture.width, texture.height))) + 1);
 	texture.id = IDGen::genID();
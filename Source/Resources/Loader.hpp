@@ -4,17 +4,90 @@
 #include <filesystem>
 #include <assimp/matrix4x4.h>
 #include <assimp/scene.h>
+#include <assimp/postprocess.h>
 
 #include "Model.hpp"
+#include "TextureProcessing.hpp"
+#include "MeshOptimizer.hpp"
+#include "ImportProfiler.hpp"
+#include "Source/Core/Jobs/ThreadPool.hpp"
+
+///Options that change what an import produces, part of the asset cache key
+struct ImportSettings {
+    uint32_t postProcessFlags = aiProcess_Triangulate | aiProcess_FlipUVs | aiProcess_JoinIdenticalVertices;
+    ///vertex cache and vertex fetch reordering, see MeshOptimizer
+    bool optimizeMeshes = true;
+    ///levels of detail per mesh including the full mesh, 1 disables simplification
+    uint32_t lodCount = 4;
+    ///triangle count of each level relative to the one before
+    float lodReduction = 0.5f;
+    ///split the full level into meshlets for per cluster culling, see MeshletBuilder
+    bool buildMeshlets = true;
+    ///store meshes without vertex colors as QuantizedVertex, see VertexQuantizer
+    bool quantizeVertices = true;
+    ///filter used to build texture mip chains at import
+    TextureProcessing::MipFilter mipFilter = TextureProcessing::MipFilter::Kaiser;
+    ///block compression applied to every texture level, RGBA8 keeps them uncompressed
+    TextureFormat textureFormat = TextureFormat::BC7;
+    ///read .gltf and .glb files with GltfImporter instead of assimp, postProcessFlags do not apply to them
+    bool nativeGltf = true;
+};
 
 class Loader {
     public:
-        std::tuple<std::vector<Mesh>, std::vector<Material>> loadModels(std::filesystem::path filePath);
+        ///threadCount is the number of workers used for mesh conversion and texture decoding
+        explicit Loader(uint32_t threadCount = std::max(1u, std::thread::hardware_concurrency()));
+
+        ///imports a model through assimp, or maps it directly when filePath is a cooked .skpkg package
+        ///profiler, when given, receives the time of every import stage along with byte, geometry and texture counts
+        std::tuple<std::vector<Mesh>, std::vector<Material>> loadModels(std::filesystem::path filePath, const ImportSettings &settings = {}, ImportProfiler *profiler = nullptr);
         Texture loadTexture(std::filesystem::path filePath);
         Texture loadTexture(const aiTexture *texture);
 
     private:
-        void processAiNode(const aiScene *scene, aiNode *node, std::vector<Mesh> &meshes, std::unordered_map<std::uint32_t, Material> &materials);
+        ///one mesh reference found while walking the node tree
+        struct MeshTask {
+            const aiMesh *assimpMesh;
+            glm::mat4 transform;
+            ///the node, one of its parents or the mesh is marked as an occluder, see Mesh::occluder
+            bool occluder;
+        };
+
+        ///one texture that has to be decoded for a material
+        struct TextureTask {
+            uint32_t materialIndex;
+            std::string path;
+            const aiTexture *embedded;
+        };
+
+        ThreadPool pool;
+        ///scratch and final storage for texture mip chains, reused from one texture to the next
+        std::shared_ptr<PixelPool> pixelPool;
+
+        void collectAiNode(const aiScene *scene, const aiNode *node, bool parentOccluder, std::vector<MeshTask> &tasks);
+        static Mesh convertAiMesh(const MeshTask &task, ImportProfiler *profiler);
+        std::tuple<std::vector<Mesh>, std::vector<Material>> loadAssimp(const std::filesystem::path &path, const ImportSettings &settings, ImportProfiler *profiler);
+        std::tuple<std::vector<Mesh>, std::vector<Material>> loadGltf(const std::filesystem::path &path, const ImportSettings &settings, ImportProfiler *profiler);
+
+        ///optimization, levels of detail, meshlets and quantization as enabled in settings, runs inside pool jobs
+        static MeshOptimizer::Stats processMesh(Mesh &mesh, const ImportSettings &settings, ImportProfiler *profiler);
+        static void reportMeshStats(const std::vector<Mesh> &meshes, const std::vector<MeshOptimizer::Stats> &optimizationStats, const ImportSettings &settings, ImportProfiler *profiler);
+        ///waits for every decoded texture, processes it and files it under its material
+        std::vector<Material> collectTextures(const std::vector<std::shared_future<Texture>> &decodedTextures, const std::vector<TextureTask> &textureTasks,
+            std::unordered_map<uint32_t, Material> &material_dict, const ImportSettings &settings, ImportProfiler *profiler);
+        ///runs convert(i) for every mesh on the pool, when it throws the texture decodes still running are waited for
+        ///so none of them outlives the import
+        template <typename F>
+        void convertMeshes(uint32_t count, F &&convert, const std::vector<std::shared_future<Texture>> &decodedTextures) {
+            try {
+                pool.parallelFor(count, convert);
+            } catch (...) {
+                for (const std::shared_future<Texture> &decode : decodedTextures) decode.wait();
+                throw;
+            }
+        }
+        ///builds the mip chain and block compresses it, replacing the decoded pixels
+        void processTexture(Texture &texture, const ImportSettings &settings, ImportProfiler *profiler);
 
 
         static glm::mat4 Assimp2Glm(const aiMatrix4x4& from)
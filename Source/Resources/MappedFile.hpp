@@ -0,0 +1,60 @@
+#ifndef MAPPEDFILE_HPP
+#define MAPPEDFILE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+///Read only memory mapping of a whole file, unmapped on destruction
+class MappedFile {
+public:
+	explicit MappedFile(const std::filesystem::path &path) {
+		int fd = open(path.c_str(), O_RDONLY);
+		if (fd < 0) {
+			throw std::runtime_error("Failed to open file for mapping: " + path.string());
+		}
+
+		struct stat fileStat{};
+		if (fstat(fd, &fileStat) != 0 || fileStat.st_size == 0) {
+			close(fd);
+			throw std::runtime_error("Failed to stat mapped file: " + path.string());
+		}
+
+		fileSize = static_cast<size_t>(fileStat.st_size);
+		void *mapping = mmap(nullptr, fileSize, PROT_READ, MAP_PRIVATE, fd, 0);
+		close(fd);
+
+		if (mapping == MAP_FAILED) {
+			throw std::runtime_error("Failed to map file: " + path.string());
+		}
+
+		mappedData = static_cast<const uint8_t *>(mapping);
+	}
+
+	MappedFile(const MappedFile &) = delete;
+	MappedFile &operator=(const MappedFile &) = delete;
+
+	~MappedFile() {
+		munmap(const_cast<uint8_t *>(mappedData), fileSize);
+	}
+
+	const uint8_t *data() const {
+		return mappedData;
+	}
+
+	size_t size() const {
+		return fileSize;
+	}
+
+private:
+	const uint8_t *mappedData = nullptr;
+	size_t fileSize = 0;
+};
+
+#endif //MAPPEDFILE_HPP
@@ -1,20 +1,126 @@
 #ifndef MESH
 #define MESH
 
+#include <algorithm>
 #include <cstdint>
+#include <memory>
+#include <span>
+#include <string_view>
 #include <vector>
 
+#include "Bounds.hpp"
 #include "Texture.hpp"
 #include "../Graphics/Vertex.hpp"
 #include "Dependencies/uuid.h"
 
+///One level of detail, a range of the mesh's index data drawn against the same vertices
+struct LodLevel {
+	uint32_t firstIndex;
+	uint32_t indexCount;
+	///largest distance in model units the level deviates from the full mesh
+	float error;
+};
+
+///Cluster of up to MeshletBuilder::MAX_TRIANGLES triangles, a contiguous range of the full level's indices
+///Bounds are in model space so culling can happen before any vertex is fetched
+struct Meshlet {
+	glm::vec3 center;
+	float radius;
+	///every triangle faces within the cone around coneAxis, coneCutoff is 1 when the normals spread too far to cull by
+	glm::vec3 coneAxis;
+	float coneCutoff;
+	uint32_t firstIndex;
+	uint32_t indexCount;
+};
+
+///Source mesh merged into a static batch, its level 0 triangles are one contiguous index range
+///Bounds are in the batch's model space so each one is culled on its own
+struct SubMesh {
+	uuids::uuid sourceID;
+	Bounds bounds;
+	uint32_t firstIndex;
+	uint32_t indexCount;
+	///meshlets of this range in the batch, meshletCount is 0 when the source had none
+	uint32_t firstMeshlet;
+	uint32_t meshletCount;
+};
+
 struct Mesh {
 	uuids::uuid id;
 	glm::mat4 transform;
 	std::vector<Vertex> vertices;
 	std::vector<uint32_t> indices;
 
+	VertexLayout layout = VertexLayout::Full;
+	///vertex data of Quantized meshes, vertices stays empty for them
+	std::vector<QuantizedVertex> quantizedVertices;
+
 	uuids::uuid materialID;
+
+	Bounds bounds;
+	///set on large solid meshes like walls and terrain, Rend rasterizes them to hide what is behind them
+	///importers set it for nodes and meshes named with OCCLUDER_SUFFIX, and in glTF for those whose extras hold "occluder": true
+	bool occluder = false;
+	///level 0 is the full mesh, empty when the mesh only has one level
+	std::vector<LodLevel> lods;
+	///clusters covering level 0, empty when the mesh is always drawn whole
+	std::vector<Meshlet> meshlets;
+	///meshes merged into this one by StaticBatcher, empty for meshes drawn as they were imported
+	std::vector<SubMesh> subMeshes;
+
+	///set when the geometry lives in memory owned elsewhere (a mapped package), vertices and indices stay empty
+	std::shared_ptr<const void> source;
+	std::span<const Vertex> vertexView;
+	std::span<const QuantizedVertex> quantizedView;
+	std::span<const uint32_t> indexView;
+
+	std::span<const Vertex> vertexData() const {
+		return source ? vertexView : std::span<const Vertex>(vertices);
+	}
+
+	std::span<const QuantizedVertex> quantizedData() const {
+		return source ? quantizedView : std::span<const QuantizedVertex>(quantizedVertices);
+	}
+
+	///vertex data in whatever layout the mesh uses, what gets uploaded
+	std::span<const uint8_t> vertexBytes() const {
+		if (layout == VertexLayout::Quantized) {
+			std::span<const QuantizedVertex> data = quantizedData();
+			return {reinterpret_cast<const uint8_t *>(data.data()), data.size_bytes()};
+		}
+
+		std::span<const Vertex> data = vertexData();
+		return {reinterpret_cast<const uint8_t *>(data.data()), data.size_bytes()};
+	}
+
+	uint32_t vertexCount() const {
+		return layout == VertexLayout::Quantized ? quantizedData().size() : vertexData().size();
+	}
+
+	///model transform with the layout's dequantization folded in, what the vertex shader gets
+	glm::mat4 drawTransform() const {
+		if (layout == VertexLayout::Quantized) return transform * QuantizedVertex::dequantizeTransform(bounds.min, bounds.max);
+		return transform;
+	}
+
+	std::span<const uint32_t> indexData() const {
+		return source ? indexView : std::span<const uint32_t>(indices);
+	}
+
+	uint32_t lodCount() const {
+		return lods.empty() ? 1 : lods.size();
+	}
+
+	static constexpr std::string_view OCCLUDER_SUFFIX = "_occluder";
+
+	static bool isOccluderName(std::string_view name) {
+		return name.ends_with(OCCLUDER_SUFFIX);
+	}
+
+	LodLevel lod(uint32_t level) const {
+		if (lods.empty()) return {0, static_cast<uint32_t>(indexData().size()), 0.0f};
+		return lods[std::min<uint32_t>(level, lods.size() - 1)];
+	}
 };
 
 #endif
@@ -0,0 +1,190 @@
+#include "MeshOptimizer.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+	constexpr uint32_t CACHE_SIZE = 32;
+	constexpr float CACHE_DECAY_POWER = 1.5f;
+	constexpr float LAST_TRIANGLE_SCORE = 0.75f;
+	constexpr float VALENCE_BOOST_SCALE = 2.0f;
+	constexpr float VALENCE_BOOST_POWER = 0.5f;
+
+	///Forsyth vertex score, recently used vertices and vertices with few triangles left score highest
+	float vertexScore(int32_t cachePosition, uint32_t remainingTriangles) {
+		if (remainingTriangles == 0) return -1.0f;
+
+		float score = 0.0f;
+		if (cachePosition >= 0) {
+			//the last triangle's vertices get a fixed score so the next triangle does not simply reuse the same edge
+			if (cachePosition < 3) {
+				score = LAST_TRIANGLE_SCORE;
+			}
+			else {
+				float scaler = 1.0f / (CACHE_SIZE - 3);
+				score = std::pow(1.0f - (cachePosition - 3) * scaler, CACHE_DECAY_POWER);
+			}
+		}
+
+		score += VALENCE_BOOST_SCALE * std::pow(static_cast<float>(remainingTriangles), -VALENCE_BOOST_POWER);
+		return score;
+	}
+}
+
+float MeshOptimizer::computeACMR(std::span<const uint32_t> indices, uint32_t vertexCount, uint32_t cacheSize) {
+	if (indices.size() < 3) return 0.0f;
+
+	//a vertex is cached while fewer than cacheSize misses happened since it was last loaded
+	std::vector<uint32_t> loadedAt(vertexCount, 0);
+	uint32_t misses = 0;
+
+	for (uint32_t index : indices) {
+		if (loadedAt[index] == 0 || misses - loadedAt[index] >= cacheSize) {
+			misses++;
+			loadedAt[index] = misses;
+		}
+	}
+
+	return static_cast<float>(misses) / (indices.size() / 3);
+}
+
+void MeshOptimizer::optimizeVertexCache(std::vector<uint32_t> &indices, uint32_t vertexCount) {
+	const uint32_t triangleCount = indices.size() / 3;
+	if (triangleCount == 0) return;
+
+	//triangles adjacent to each vertex, packed into one array
+	std::vector<uint32_t> remaining(vertexCount, 0);
+	for (uint32_t index : indices) {
+		remaining[index]++;
+	}
+
+	std::vector<uint32_t> adjacencyOffsets(vertexCount + 1, 0);
+	for (uint32_t v = 0; v < vertexCount; v++) {
+		adjacencyOffsets[v + 1] = adjacencyOffsets[v] + remaining[v];
+	}
+
+	std::vector<uint32_t> adjacency(indices.size());
+	std::vector<uint32_t> fill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+	for (uint32_t t = 0; t < triangleCount; t++) {
+		for (uint32_t k = 0; k < 3; k++) {
+			adjacency[fill[indices[t * 3 + k]]++] = t;
+		}
+	}
+
+	std::vector<int32_t> cachePosition(vertexCount, -1);
+	std::vector<float> scores(vertexCount);
+	for (uint32_t v = 0; v < vertexCount; v++) {
+		scores[v] = vertexScore(-1, remaining[v]);
+	}
+
+	std::vector<bool> emitted(triangleCount, false);
+	std::vector<uint32_t> output;
+	output.reserve(indices.size());
+
+	std::vector<uint32_t> cache;
+	std::vector<uint32_t> nextCache;
+	cache.reserve(CACHE_SIZE + 3);
+	nextCache.reserve(CACHE_SIZE + 3);
+
+	uint32_t nextUnemitted = 0;
+	int64_t best = -1;
+
+	for (uint32_t emittedCount = 0; emittedCount < triangleCount; emittedCount++) {
+		//dead end, nothing in the cache has triangles left so continue in input order
+		if (best < 0) {
+			while (emitted[nextUnemitted]) nextUnemitted++;
+			best = nextUnemitted;
+		}
+
+		const uint32_t triangle = best;
+		emitted[triangle] = true;
+
+		nextCache.clear();
+		for (uint32_t k = 0; k < 3; k++) {
+			uint32_t v = indices[triangle * 3 + k];
+			output.push_back(v);
+			nextCache.push_back(v);
+
+			//drop the triangle from the vertex's adjacency
+			uint32_t begin = adjacencyOffsets[v];
+			uint32_t end = begin + remaining[v];
+			for (uint32_t i = begin; i < end; i++) {
+				if (adjacency[i] == triangle) {
+					std::swap(adjacency[i], adjacency[end - 1]);
+					break;
+				}
+			}
+			remaining[v]--;
+		}
+
+		for (uint32_t v : cache) {
+			if (v != nextCache[0] && v != nextCache[1] && v != nextCache[2])
+				nextCache.push_back(v);
+		}
+
+		//vertices pushed out of the cache lose their cache score
+		for (uint32_t i = CACHE_SIZE; i < nextCache.size(); i++) {
+			cachePosition[nextCache[i]] = -1;
+			scores[nextCache[i]] = vertexScore(-1, remaining[nextCache[i]]);
+		}
+		nextCache.resize(std::min<size_t>(nextCache.size(), CACHE_SIZE));
+		std::swap(cache, nextCache);
+
+		for (uint32_t i = 0; i < cache.size(); i++) {
+			cachePosition[cache[i]] = i;
+			scores[cache[i]] = vertexScore(i, remaining[cache[i]]);
+		}
+
+		//only triangles touching the cache changed score, the best next triangle is among them
+		best = -1;
+		float bestScore = -1.0f;
+
+		for (uint32_t v : cache) {
+			uint32_t begin = adjacencyOffsets[v];
+			for (uint32_t i = begin; i < begin + remaining[v]; i++) {
+				uint32_t t = adjacency[i];
+				float score = scores[indices[t * 3]] + scores[indices[t * 3 + 1]] + scores[indices[t * 3 + 2]];
+
+				if (score > bestScore) {
+					bestScore = score;
+					best = t;
+				}
+			}
+		}
+	}
+
+	indices = std::move(output);
+}
+
+void MeshOptimizer::optimizeVertexFetch(std::vector<Vertex> &vertices, std::vector<uint32_t> &indices) {
+	constexpr uint32_t UNUSED = UINT32_MAX;
+
+	std::vector<uint32_t> remap(vertices.size(), UNUSED);
+	std::vector<Vertex> reordered;
+	reordered.reserve(vertices.size());
+
+	for (uint32_t &index : indices) {
+		if (remap[index] == UNUSED) {
+			remap[index] = reordered.size();
+			reordered.push_back(vertices[index]);
+		}
+		index = remap[index];
+	}
+
+	vertices = std::move(reordered);
+}
+
+MeshOptimizer::Stats MeshOptimizer::optimize(Mesh &mesh) {
+	Stats stats{};
+	stats.acmrBefore = computeACMR(mesh.indices, mesh.vertices.size());
+
+	optimizeVertexCache(mesh.indices, mesh.vertices.size());
+	optimizeVertexFetch(mesh.vertices, mesh.indices);
+
+	stats.acmrAfter = computeACMR(mesh.indices, mesh.vertices.size());
+	return stats;
+}
+
+std::vector<uint16_t> MeshOptimizer::narrowIndices(std::span<const uint32_t> indices) {
+	return std::vector<uint16_t>(indices.begin(), indices.end());
+}
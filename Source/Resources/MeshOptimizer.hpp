@@ -0,0 +1,38 @@
+#ifndef MESHOPTIMIZER_HPP
+#define MESHOPTIMIZER_HPP
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "Mesh.hpp"
+
+///Import time reordering of mesh data for the GPU vertex cache and vertex fetch
+namespace MeshOptimizer {
+	struct Stats {
+		float acmrBefore;
+		float acmrAfter;
+	};
+
+	///average cache miss ratio, transformed vertices per triangle for a FIFO post transform cache
+	///1.0 is very good, 3.0 means every vertex is shaded again for every triangle
+	float computeACMR(std::span<const uint32_t> indices, uint32_t vertexCount, uint32_t cacheSize = 16);
+
+	///reorders triangles with Forsyth's linear speed vertex cache optimisation
+	void optimizeVertexCache(std::vector<uint32_t> &indices, uint32_t vertexCount);
+
+	///reorders vertices into first use order so fetches walk memory forwards, unreferenced vertices are dropped
+	void optimizeVertexFetch(std::vector<Vertex> &vertices, std::vector<uint32_t> &indices);
+
+	///runs every pass on a mesh that owns its geometry
+	Stats optimize(Mesh &mesh);
+
+	///16 bit indices halve index memory, usable while every index fits
+	inline bool fitsIndex16(uint32_t vertexCount) {
+		return vertexCount <= 65535;
+	}
+
+	std::vector<uint16_t> narrowIndices(std::span<const uint32_t> indices);
+}
+
+#endif //MESHOPTIMIZER_HPP
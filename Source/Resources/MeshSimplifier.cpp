@@ -0,0 +1,278 @@
+#include "MeshSimplifier.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <unordered_map>
+
+#include "MeshOptimizer.hpp"
+
+namespace {
+	///symmetric 4x4 matrix summing squared distances to a set of planes
+	struct Quadric {
+		double a2, ab, ac, ad;
+		double b2, bc, bd;
+		double c2, cd;
+		double d2;
+
+		void add(const Quadric &other) {
+			a2 += other.a2; ab += other.ab; ac += other.ac; ad += other.ad;
+			b2 += other.b2; bc += other.bc; bd += other.bd;
+			c2 += other.c2; cd += other.cd;
+			d2 += other.d2;
+		}
+
+		static Quadric fromPlane(double a, double b, double c, double d) {
+			return {a * a, a * b, a * c, a * d, b * b, b * c, b * d, c * c, c * d, d * d};
+		}
+
+		double error(const glm::vec3 &p) const {
+			double x = p.x, y = p.y, z = p.z;
+			double result = a2 * x * x + 2 * ab * x * y + 2 * ac * x * z + 2 * ad * x
+				+ b2 * y * y + 2 * bc * y * z + 2 * bd * y
+				+ c2 * z * z + 2 * cd * z
+				+ d2;
+			return std::max(result, 0.0);
+		}
+	};
+
+	struct Collapse {
+		uint32_t from;
+		uint32_t to;
+		double cost;
+	};
+
+	struct PositionHash {
+		size_t operator()(const glm::vec3 &p) const {
+			uint32_t bits[3];
+			std::memcpy(bits, &p, sizeof(bits));
+			return (bits[0] * 73856093u) ^ (bits[1] * 19349663u) ^ (bits[2] * 83492791u);
+		}
+	};
+
+	struct PositionEqual {
+		bool operator()(const glm::vec3 &a, const glm::vec3 &b) const {
+			return std::memcmp(&a, &b, sizeof(glm::vec3)) == 0;
+		}
+	};
+
+	///true when moving from onto to keeps every triangle around from facing the same way
+	bool keepsOrientation(std::span<const Vertex> vertices, const std::vector<uint32_t> &triangles, std::span<const uint32_t> adjacent, const std::vector<uint32_t> &position, uint32_t from, uint32_t to) {
+		const glm::vec3 &target = vertices[to].pos;
+
+		for (uint32_t t : adjacent) {
+			uint32_t i0 = triangles[t * 3], i1 = triangles[t * 3 + 1], i2 = triangles[t * 3 + 2];
+
+			//triangles on the collapsed edge disappear
+			if (position[i0] == position[to] || position[i1] == position[to] || position[i2] == position[to]) continue;
+
+			glm::vec3 p0 = vertices[i0].pos, p1 = vertices[i1].pos, p2 = vertices[i2].pos;
+			glm::vec3 before = glm::cross(p1 - p0, p2 - p0);
+
+			if (i0 == from) p0 = target;
+			if (i1 == from) p1 = target;
+			if (i2 == from) p2 = target;
+			glm::vec3 after = glm::cross(p1 - p0, p2 - p0);
+
+			if (glm::dot(before, after) <= 0.0f) return false;
+		}
+
+		return true;
+	}
+}
+
+std::vector<uint32_t> MeshSimplifier::simplify(std::span<const Vertex> vertices, std::span<const uint32_t> indices, size_t targetIndexCount, float targetError, float *resultError) {
+	const uint32_t vertexCount = vertices.size();
+	std::vector<uint32_t> triangles(indices.begin(), indices.end());
+	double maxCost = 0.0;
+	const double costLimit = static_cast<double>(targetError) * targetError;
+
+	//vertices sharing a position are one point of the surface, split only by attributes
+	std::vector<uint32_t> position(vertexCount);
+	std::vector<uint32_t> wedgeCount(vertexCount, 0);
+	{
+		std::unordered_map<glm::vec3, uint32_t, PositionHash, PositionEqual> firstAtPosition;
+		for (uint32_t v = 0; v < vertexCount; v++) {
+			position[v] = firstAtPosition.try_emplace(vertices[v].pos, v).first->second;
+		}
+
+		//only referenced vertices count, unused duplicates should not lock a point
+		std::vector<bool> referenced(vertexCount, false);
+		for (uint32_t index : triangles) referenced[index] = true;
+		for (uint32_t v = 0; v < vertexCount; v++) {
+			if (referenced[v]) wedgeCount[position[v]]++;
+		}
+	}
+
+	std::vector<Quadric> quadrics(vertexCount, Quadric{});
+	std::vector<bool> locked(vertexCount, false);
+
+	for (uint32_t v = 0; v < vertexCount; v++) {
+		if (wedgeCount[position[v]] > 1) locked[v] = true;
+	}
+
+	for (size_t t = 0; t < triangles.size(); t += 3) {
+		glm::vec3 p0 = vertices[triangles[t]].pos, p1 = vertices[triangles[t + 1]].pos, p2 = vertices[triangles[t + 2]].pos;
+		glm::vec3 normal = glm::cross(p1 - p0, p2 - p0);
+		float length = std::sqrt(glm::dot(normal, normal));
+		if (length == 0.0f) continue;
+
+		normal = normal / length;
+		Quadric plane = Quadric::fromPlane(normal.x, normal.y, normal.z, -glm::dot(normal, p0));
+		for (uint32_t k = 0; k < 3; k++) {
+			quadrics[position[triangles[t + k]]].add(plane);
+		}
+	}
+
+	//open borders stay put, an edge used by a single triangle is a border
+	{
+		std::unordered_map<uint64_t, uint32_t> edgeUse;
+		for (size_t t = 0; t < triangles.size(); t += 3) {
+			for (uint32_t k = 0; k < 3; k++) {
+				uint32_t a = position[triangles[t + k]], b = position[triangles[t + (k + 1) % 3]];
+				edgeUse[(static_cast<uint64_t>(std::min(a, b)) << 32) | std::max(a, b)]++;
+			}
+		}
+
+		for (size_t t = 0; t < triangles.size(); t += 3) {
+			for (uint32_t k = 0; k < 3; k++) {
+				uint32_t a = triangles[t + k], b = triangles[t + (k + 1) % 3];
+				uint32_t pa = position[a], pb = position[b];
+				if (edgeUse[(static_cast<uint64_t>(std::min(pa, pb)) << 32) | std::max(pa, pb)] == 1) {
+					locked[a] = true;
+					locked[b] = true;
+				}
+			}
+		}
+	}
+
+	std::vector<uint32_t> adjacencyOffsets(vertexCount + 1);
+	std::vector<uint32_t> adjacency;
+	std::vector<Collapse> collapses;
+	std::vector<uint32_t> remap(vertexCount);
+	std::vector<bool> touched(vertexCount);
+
+	while (triangles.size() > targetIndexCount) {
+		const uint32_t triangleCount = triangles.size() / 3;
+
+		std::fill(adjacencyOffsets.begin(), adjacencyOffsets.end(), 0);
+		for (uint32_t index : triangles) adjacencyOffsets[index + 1]++;
+		for (uint32_t v = 0; v < vertexCount; v++) adjacencyOffsets[v + 1] += adjacencyOffsets[v];
+
+		adjacency.resize(triangles.size());
+		std::vector<uint32_t> fill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+		for (uint32_t t = 0; t < triangleCount; t++) {
+			for (uint32_t k = 0; k < 3; k++) adjacency[fill[triangles[t * 3 + k]]++] = t;
+		}
+
+		//cheapest collapse for every vertex that may move
+		collapses.clear();
+		std::vector<int64_t> bestCollapse(vertexCount, -1);
+		for (uint32_t t = 0; t < triangleCount; t++) {
+			for (uint32_t k = 0; k < 3; k++) {
+				uint32_t from = triangles[t * 3 + k];
+				if (locked[from]) continue;
+
+				for (uint32_t offset = 1; offset < 3; offset++) {
+					uint32_t to = triangles[t * 3 + (k + offset) % 3];
+
+					Quadric combined = quadrics[position[from]];
+					combined.add(quadrics[position[to]]);
+					double cost = combined.error(vertices[to].pos);
+
+					if (bestCollapse[from] < 0) {
+						bestCollapse[from] = collapses.size();
+						collapses.push_back({from, to, cost});
+					}
+					else if (cost < collapses[bestCollapse[from]].cost) {
+						collapses[bestCollapse[from]] = {from, to, cost};
+					}
+				}
+			}
+		}
+
+		std::sort(collapses.begin(), collapses.end(), [](const Collapse &a, const Collapse &b) {
+			return a.cost < b.cost;
+		});
+
+		for (uint32_t v = 0; v < vertexCount; v++) remap[v] = v;
+		std::fill(touched.begin(), touched.end(), false);
+
+		size_t remainingIndices = triangles.size();
+		uint32_t applied = 0;
+
+		//independent collapses per pass, a vertex next to a collapse waits for the next pass
+		for (const Collapse &collapse : collapses) {
+			if (remainingIndices <= targetIndexCount || collapse.cost > costLimit) break;
+			if (touched[collapse.from] || touched[collapse.to]) continue;
+
+			std::span<const uint32_t> around(adjacency.data() + adjacencyOffsets[collapse.from], adjacencyOffsets[collapse.from + 1] - adjacencyOffsets[collapse.from]);
+			if (!keepsOrientation(vertices, triangles, around, position, collapse.from, collapse.to)) continue;
+
+			for (uint32_t t : around) {
+				bool removed = false;
+				for (uint32_t k = 0; k < 3; k++) {
+					touched[triangles[t * 3 + k]] = true;
+					if (position[triangles[t * 3 + k]] == position[collapse.to]) removed = true;
+				}
+				if (removed) remainingIndices -= 3;
+			}
+
+			remap[collapse.from] = collapse.to;
+			quadrics[position[collapse.to]].add(quadrics[position[collapse.from]]);
+			maxCost = std::max(maxCost, collapse.cost);
+			applied++;
+		}
+
+		if (applied == 0) break;
+
+		//apply the pass and drop triangles that collapsed to a line
+		size_t write = 0;
+		for (size_t t = 0; t < triangles.size(); t += 3) {
+			uint32_t i0 = remap[triangles[t]], i1 = remap[triangles[t + 1]], i2 = remap[triangles[t + 2]];
+			if (position[i0] == position[i1] || position[i1] == position[i2] || position[i0] == position[i2]) continue;
+
+			triangles[write++] = i0;
+			triangles[write++] = i1;
+			triangles[write++] = i2;
+		}
+		triangles.resize(write);
+	}
+
+	if (resultError) *resultError = static_cast<float>(std::sqrt(maxCost));
+	return triangles;
+}
+
+void MeshSimplifier::generateLods(Mesh &mesh, uint32_t lodCount, float reduction) {
+	mesh.lods.clear();
+	mesh.lods.push_back({0, static_cast<uint32_t>(mesh.indices.size()), 0.0f});
+
+	//error is capped at the mesh size, past that a level is no longer the same object
+	const float errorLimit = std::max(mesh.bounds.radius, std::numeric_limits<float>::min());
+
+	std::vector<uint32_t> previous = mesh.indices;
+	float previousError = 0.0f;
+
+	for (uint32_t level = 1; level < lodCount; level++) {
+		size_t target = static_cast<size_t>(previous.size() / 3 * reduction) * 3;
+		if (target == 0 || previousError >= errorLimit) break;
+
+		float error = 0.0f;
+		std::vector<uint32_t> simplified = simplify(mesh.vertices, previous, target, errorLimit - previousError, &error);
+
+		//stop when a level saves less than a tenth of its parent
+		if (simplified.empty() || simplified.size() > previous.size() * 9 / 10) break;
+
+		MeshOptimizer::optimizeVertexCache(simplified, mesh.vertices.size());
+
+		//levels are built from each other so their error accumulates
+		previousError += error;
+		mesh.lods.push_back({static_cast<uint32_t>(mesh.indices.size()), static_cast<uint32_t>(simplified.size()), previousError});
+		mesh.indices.insert(mesh.indices.end(), simplified.begin(), simplified.end());
+
+		previous = std::move(simplified);
+	}
+
+	if (mesh.lods.size() == 1) mesh.lods.clear();
+}
@@ -0,0 +1,23 @@
+#ifndef MESHSIMPLIFIER_HPP
+#define MESHSIMPLIFIER_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "Mesh.hpp"
+
+///Quadric error edge collapse simplification, used to build LOD chains at import
+namespace MeshSimplifier {
+	///Collapses edges until at most targetIndexCount indices remain or the next collapse would move the surface further than targetError
+	///Vertices are only ever merged onto existing vertices so the result indexes the same vertex array
+	///UV seams and open borders are kept in place, resultError receives the largest error introduced
+	std::vector<uint32_t> simplify(std::span<const Vertex> vertices, std::span<const uint32_t> indices, size_t targetIndexCount, float targetError, float *resultError = nullptr);
+
+	///Appends up to lodCount - 1 simplified index lists to mesh.indices, each targeting reduction times the previous triangle count
+	///Stops early once simplification no longer makes progress
+	void generateLods(Mesh &mesh, uint32_t lodCount, float reduction);
+}
+
+#endif //MESHSIMPLIFIER_HPP
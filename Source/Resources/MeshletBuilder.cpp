@@ -0,0 +1,168 @@
+#include "MeshletBuilder.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace {
+	///normals this close to perpendicular to the cone axis leave too little to cull, the cone is disabled instead
+	constexpr float MIN_CONE_SPREAD = 0.1f;
+}
+
+std::vector<Meshlet> MeshletBuilder::buildMeshlets(std::span<const Vertex> vertices, std::span<uint32_t> indices, uint32_t maxVertices, uint32_t maxTriangles) {
+	uint32_t triangleCount = indices.size() / 3;
+	std::vector<Meshlet> meshlets;
+	if (triangleCount == 0) return meshlets;
+
+	//triangles around each vertex, compressed into one array
+	std::vector<uint32_t> adjacencyOffsets(vertices.size() + 1, 0);
+	for (uint32_t index : indices.first(triangleCount * 3)) adjacencyOffsets[index + 1]++;
+	for (size_t v = 0; v < vertices.size(); v++) adjacencyOffsets[v + 1] += adjacencyOffsets[v];
+
+	std::vector<uint32_t> adjacency(triangleCount * 3);
+	std::vector<uint32_t> fill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+	for (uint32_t triangle = 0; triangle < triangleCount; triangle++) {
+		for (uint32_t k = 0; k < 3; k++) {
+			adjacency[fill[indices[triangle * 3 + k]]++] = triangle;
+		}
+	}
+
+	std::vector<uint32_t> ordered;
+	ordered.reserve(triangleCount * 3);
+
+	std::vector<bool> emitted(triangleCount, false);
+	//meshlet number + 1 a vertex was last added to, so counting unique vertices needs no clearing
+	std::vector<uint32_t> vertexMeshlet(vertices.size(), 0);
+	std::vector<uint32_t> candidates;
+	uint32_t seed = 0;
+
+	while (ordered.size() < triangleCount * 3) {
+		while (emitted[seed]) seed++;
+
+		uint32_t stamp = meshlets.size() + 1;
+		uint32_t meshletVertices = 0;
+		uint32_t meshletTriangles = 0;
+		glm::vec3 centroidSum(0.0f);
+		uint32_t firstIndex = ordered.size();
+
+		candidates.assign(1, seed);
+
+		while (meshletTriangles < maxTriangles) {
+			//grow by the adjacent triangle that adds the fewest new vertices, nearest to the cluster breaks ties
+			glm::vec3 centroid = meshletVertices > 0 ? centroidSum / static_cast<float>(meshletVertices) : glm::vec3(0.0f);
+			uint32_t bestSlot = std::numeric_limits<uint32_t>::max();
+			uint32_t bestNew = 4;
+			float bestDistance = std::numeric_limits<float>::max();
+
+			for (uint32_t slot = 0; slot < candidates.size();) {
+				uint32_t triangle = candidates[slot];
+				if (emitted[triangle]) {
+					candidates[slot] = candidates.back();
+					candidates.pop_back();
+					continue;
+				}
+
+				uint32_t newVertices = 0;
+				glm::vec3 triangleCenter(0.0f);
+				for (uint32_t k = 0; k < 3; k++) {
+					uint32_t vertex = indices[triangle * 3 + k];
+					newVertices += vertexMeshlet[vertex] != stamp;
+					triangleCenter += vertices[vertex].pos;
+				}
+
+				glm::vec3 offset = triangleCenter / 3.0f - centroid;
+				float distance = glm::dot(offset, offset);
+
+				if (newVertices < bestNew || (newVertices == bestNew && distance < bestDistance)) {
+					bestSlot = slot;
+					bestNew = newVertices;
+					bestDistance = distance;
+				}
+				slot++;
+			}
+
+			if (bestSlot == std::numeric_limits<uint32_t>::max() || meshletVertices + bestNew > maxVertices) break;
+
+			uint32_t triangle = candidates[bestSlot];
+			emitted[triangle] = true;
+			meshletTriangles++;
+
+			for (uint32_t k = 0; k < 3; k++) {
+				uint32_t vertex = indices[triangle * 3 + k];
+				ordered.push_back(vertex);
+
+				if (vertexMeshlet[vertex] != stamp) {
+					vertexMeshlet[vertex] = stamp;
+					meshletVertices++;
+					centroidSum += vertices[vertex].pos;
+
+					for (uint32_t a = adjacencyOffsets[vertex]; a < adjacencyOffsets[vertex + 1]; a++) {
+						if (!emitted[adjacency[a]]) candidates.push_back(adjacency[a]);
+					}
+				}
+			}
+		}
+
+		uint32_t indexCount = ordered.size() - firstIndex;
+		Meshlet meshlet = computeBounds(vertices, std::span<const uint32_t>(ordered).subspan(firstIndex, indexCount));
+		meshlet.firstIndex = firstIndex;
+		meshlet.indexCount = indexCount;
+		meshlets.push_back(meshlet);
+	}
+
+	std::copy(ordered.begin(), ordered.end(), indices.begin());
+	return meshlets;
+}
+
+Meshlet MeshletBuilder::computeBounds(std::span<const Vertex> vertices, std::span<const uint32_t> indices) {
+	Meshlet meshlet{};
+
+	std::vector<glm::vec3> positions;
+	positions.reserve(indices.size());
+	for (uint32_t index : indices) positions.push_back(vertices[index].pos);
+
+	Bounds bounds = Bounds::fromPositions(positions);
+	meshlet.center = bounds.center;
+	meshlet.radius = bounds.radius;
+
+	//the cone axis is the average facing, its spread the widest angle any triangle makes with it
+	std::vector<glm::vec3> normals;
+	glm::vec3 normalSum(0.0f);
+	for (size_t i = 0; i + 2 < positions.size(); i += 3) {
+		glm::vec3 normal = glm::cross(positions[i + 1] - positions[i], positions[i + 2] - positions[i]);
+		float length = glm::length(normal);
+		if (length == 0.0f) continue;
+
+		normals.push_back(normal / length);
+		normalSum += normals.back();
+	}
+
+	meshlet.coneAxis = glm::vec3(0.0f);
+	meshlet.coneCutoff = 1.0f;
+
+	float sumLength = glm::length(normalSum);
+	if (normals.empty() || sumLength == 0.0f) return meshlet;
+
+	glm::vec3 axis = normalSum / sumLength;
+	float minDot = 1.0f;
+	for (const glm::vec3 &normal : normals) {
+		minDot = std::min(minDot, glm::dot(axis, normal));
+	}
+
+	if (minDot <= MIN_CONE_SPREAD) return meshlet;
+
+	//sine of the spread, what the sphere based backface test compares against
+	meshlet.coneAxis = axis;
+	meshlet.coneCutoff = std::sqrt(1.0f - minDot * minDot);
+	return meshlet;
+}
+
+void MeshletBuilder::build(Mesh &mesh) {
+	LodLevel full = mesh.lod(0);
+	std::span<uint32_t> fullIndices = std::span<uint32_t>(mesh.indices).subspan(full.firstIndex, full.indexCount);
+
+	mesh.meshlets = buildMeshlets(mesh.vertices, fullIndices);
+	for (Meshlet &meshlet : mesh.meshlets) {
+		meshlet.firstIndex += full.firstIndex;
+	}
+}
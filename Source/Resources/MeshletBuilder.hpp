@@ -0,0 +1,27 @@
+#ifndef MESHLETBUILDER_HPP
+#define MESHLETBUILDER_HPP
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "Mesh.hpp"
+
+///Import time partitioning of meshes into small clusters that can be culled on their own
+namespace MeshletBuilder {
+	constexpr uint32_t MAX_VERTICES = 64;
+	constexpr uint32_t MAX_TRIANGLES = 124;
+
+	///groups triangles into spatially coherent meshlets and reorders indices so each one is a contiguous range
+	///firstIndex of every meshlet is relative to the start of indices
+	std::vector<Meshlet> buildMeshlets(std::span<const Vertex> vertices, std::span<uint32_t> indices,
+		uint32_t maxVertices = MAX_VERTICES, uint32_t maxTriangles = MAX_TRIANGLES);
+
+	///bounding sphere and normal cone of a set of triangles
+	Meshlet computeBounds(std::span<const Vertex> vertices, std::span<const uint32_t> indices);
+
+	///builds meshlets over level 0 of a mesh that owns its full precision geometry
+	void build(Mesh &mesh);
+}
+
+#endif //MESHLETBUILDER_HPP
@@ -0,0 +1,109 @@
+#include "PixelBuffer.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <utility>
+
+#include <Dependencies/stb_image.h>
+
+PixelBuffer PixelBuffer::fromStbi(uint8_t *pixels, size_t size) {
+	PixelBuffer buffer;
+	buffer.bytes = pixels;
+	buffer.length = size;
+	return buffer;
+}
+
+PixelBuffer::PixelBuffer(PixelBuffer &&other) noexcept
+	: bytes(std::exchange(other.bytes, nullptr)), length(std::exchange(other.length, 0)), capacity(std::exchange(other.capacity, 0)), pool(std::move(other.pool)) {}
+
+PixelBuffer &PixelBuffer::operator=(PixelBuffer &&other) noexcept {
+	if (this != &other) {
+		release();
+		bytes = std::exchange(other.bytes, nullptr);
+		length = std::exchange(other.length, 0);
+		capacity = std::exchange(other.capacity, 0);
+		pool = std::move(other.pool);
+	}
+	return *this;
+}
+
+PixelBuffer::~PixelBuffer() {
+	release();
+}
+
+void PixelBuffer::release() {
+	if (!bytes) return;
+
+	if (capacity == 0) {
+		stbi_image_free(bytes);
+	}
+	else if (auto owner = pool.lock()) {
+		owner->recycle(bytes, capacity);
+	}
+	else {
+		delete[] bytes;
+	}
+
+	bytes = nullptr;
+	length = 0;
+	capacity = 0;
+	pool.reset();
+}
+
+PixelPool::PixelPool(uint64_t maxRetainedBytes) : maxRetainedBytes(maxRetainedBytes) {}
+
+PixelBuffer PixelPool::allocate(size_t size) {
+	PixelBuffer buffer;
+	buffer.capacity = std::bit_ceil(std::max<size_t>(size, 1));
+	buffer.length = size;
+	buffer.pool = weak_from_this();
+
+	{
+		std::lock_guard lock(poolMutex);
+		stats.allocations++;
+
+		if (auto blocks = freeBlocks.find(buffer.capacity); blocks != freeBlocks.end() && !blocks->second.empty()) {
+			buffer.bytes = blocks->second.back().release();
+			blocks->second.pop_back();
+			stats.reuses++;
+			stats.retainedBytes -= buffer.capacity;
+			return buffer;
+		}
+	}
+
+	buffer.bytes = new uint8_t[buffer.capacity];
+	return buffer;
+}
+
+PixelBuffer PixelPool::allocateExact(size_t size) {
+	PixelBuffer buffer;
+	buffer.capacity = std::max<size_t>(size, 1);
+	buffer.length = size;
+	//without a pool the block is deleted on release
+	buffer.bytes = new uint8_t[buffer.capacity];
+
+	std::lock_guard lock(poolMutex);
+	stats.allocations++;
+	return buffer;
+}
+
+void PixelPool::trim() {
+	std::lock_guard lock(poolMutex);
+	freeBlocks.clear();
+	stats.retainedBytes = 0;
+}
+
+PixelPool::Stats PixelPool::getStats() {
+	std::lock_guard lock(poolMutex);
+	return stats;
+}
+
+void PixelPool::recycle(uint8_t *block, size_t capacity) {
+	std::unique_ptr<uint8_t[]> owned(block);
+
+	std::lock_guard lock(poolMutex);
+	if (stats.retainedBytes + capacity > maxRetainedBytes) return;
+
+	freeBlocks[capacity].push_back(std::move(owned));
+	stats.retainedBytes += capacity;
+}
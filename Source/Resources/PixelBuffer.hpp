@@ -0,0 +1,89 @@
+#ifndef PIXELBUFFER_HPP
+#define PIXELBUFFER_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+class PixelPool;
+
+///Move only owner of one block of pixel memory, freed or handed back to its pool on destruction
+class PixelBuffer {
+public:
+	PixelBuffer() = default;
+	///takes ownership of memory returned by stbi_load, it is freed with stbi_image_free
+	static PixelBuffer fromStbi(uint8_t *pixels, size_t size);
+
+	PixelBuffer(PixelBuffer &&other) noexcept;
+	PixelBuffer &operator=(PixelBuffer &&other) noexcept;
+	PixelBuffer(const PixelBuffer &) = delete;
+	PixelBuffer &operator=(const PixelBuffer &) = delete;
+	~PixelBuffer();
+
+	uint8_t *data() {
+		return bytes;
+	}
+
+	const uint8_t *data() const {
+		return bytes;
+	}
+
+	size_t size() const {
+		return length;
+	}
+
+	bool empty() const {
+		return length == 0;
+	}
+
+	///gives the memory up now instead of on destruction
+	void release();
+
+private:
+	friend class PixelPool;
+
+	uint8_t *bytes = nullptr;
+	size_t length = 0;
+	///size of the pooled block behind bytes, 0 when the memory came from stb_image
+	size_t capacity = 0;
+	std::weak_ptr<PixelPool> pool;
+};
+
+///Recycles pixel blocks so decoding, mip generation and compression of the next texture reuse the last one's memory
+///scratch blocks are rounded up to a power of two and at most maxRetainedBytes of free blocks are kept
+///has to be owned by a std::shared_ptr, buffers outliving the pool simply free their block
+class PixelPool : public std::enable_shared_from_this<PixelPool> {
+public:
+	struct Stats {
+		uint64_t allocations;
+		uint64_t reuses;
+		uint64_t retainedBytes;
+	};
+
+	explicit PixelPool(uint64_t maxRetainedBytes = 64ull * 1024 * 1024);
+	PixelPool(const PixelPool &) = delete;
+	PixelPool &operator=(const PixelPool &) = delete;
+
+	///size bytes of uninitialised memory
+	PixelBuffer allocate(size_t size);
+	///for memory kept past the import, like the chains textures adopt, sized exactly and freed instead of recycled
+	PixelBuffer allocateExact(size_t size);
+	///frees every retained block
+	void trim();
+	Stats getStats();
+
+private:
+	friend class PixelBuffer;
+
+	void recycle(uint8_t *block, size_t capacity);
+
+	std::mutex poolMutex;
+	uint64_t maxRetainedBytes;
+	std::unordered_map<size_t, std::vector<std::unique_ptr<uint8_t[]>>> freeBlocks;
+	Stats stats{};
+};
+
+#endif //PIXELBUFFER_HPP
@@ -0,0 +1,189 @@
+#include "StaticBatcher.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <string>
+#include <unordered_map>
+
+#include "VertexConversion.hpp"
+#include "VertexQuantizer.hpp"
+#include "Source/IdGen.hpp"
+
+namespace {
+	///rotation times one uniform scale, the only transforms that keep a meshlet's normal cone valid
+	///mirroring flips the normals, shear and non uniform scale bend them
+	bool keepsNormalCones(const glm::mat4 &transform) {
+		glm::vec3 x(transform[0]), y(transform[1]), z(transform[2]);
+		float scale = maxAxisScale(transform);
+		if (scale <= 0.0f) return false;
+
+		float tolerance = 1e-4f * scale * scale;
+		if (std::abs(glm::dot(x, x) - glm::dot(y, y)) > tolerance || std::abs(glm::dot(x, x) - glm::dot(z, z)) > tolerance) return false;
+		if (std::abs(glm::dot(x, y)) > tolerance || std::abs(glm::dot(x, z)) > tolerance || std::abs(glm::dot(y, z)) > tolerance) return false;
+
+		return glm::dot(glm::cross(x, y), z) > 0.0f;
+	}
+
+	Meshlet transformMeshlet(const Meshlet &meshlet, const glm::mat4 &transform, bool keepCone, uint32_t firstIndex) {
+		Meshlet result = meshlet;
+		result.center = glm::vec3(transform * glm::vec4(meshlet.center, 1.0f));
+		result.radius = meshlet.radius * maxAxisScale(transform);
+		result.firstIndex = firstIndex;
+
+		if (meshlet.coneCutoff >= 1.0f) return result;
+
+		if (keepCone) {
+			glm::vec3 axis = glm::vec3(transform[0]) * meshlet.coneAxis.x + glm::vec3(transform[1]) * meshlet.coneAxis.y + glm::vec3(transform[2]) * meshlet.coneAxis.z;
+			result.coneAxis = glm::normalize(axis);
+		}
+		else {
+			//a cutoff of 1 never culls, the meshlet is still tested against the frustum
+			result.coneAxis = glm::vec3(0.0f, 0.0f, 1.0f);
+			result.coneCutoff = 1.0f;
+		}
+
+		return result;
+	}
+
+	Mesh mergeGroup(std::span<const Mesh> meshes, const std::vector<uint32_t> &members, const StaticBatcher::Settings &settings) {
+		Mesh batch{};
+		batch.transform = glm::mat4(1.0f);
+		batch.materialID = meshes[members[0]].materialID;
+		//groups never mix occluders with other meshes, so the batch occludes exactly where its members did
+		batch.occluder = meshes[members[0]].occluder;
+
+		uint32_t levelCount = 1;
+		size_t vertexCount = 0;
+		bool allQuantized = true;
+		std::string name = "batch";
+
+		for (uint32_t member : members) {
+			const Mesh &mesh = meshes[member];
+			levelCount = std::max(levelCount, mesh.lodCount());
+			vertexCount += mesh.vertexCount();
+			allQuantized &= mesh.layout == VertexLayout::Quantized;
+			name += "/" + uuids::to_string(mesh.id);
+		}
+
+		//named by its sources so rebuilding the same scene gives the same batch IDs
+		batch.id = IDGen::genID(name);
+
+		//vertices go to batch space, member by member
+		std::vector<uint32_t> firstVertices;
+		batch.vertices.reserve(vertexCount);
+		for (uint32_t member : members) {
+			const Mesh &mesh = meshes[member];
+			firstVertices.push_back(batch.vertices.size());
+
+			for (Vertex vertex : StaticBatcher::fullVertices(mesh)) {
+				vertex.pos = glm::vec3(mesh.transform * glm::vec4(vertex.pos, 1.0f));
+				batch.vertices.push_back(vertex);
+			}
+		}
+
+		//level by level, so every level of the batch is one range with each member's range of that level inside it
+		//members with fewer levels repeat their coarsest one like Mesh::lod does
+		for (uint32_t level = 0; level < levelCount; level++) {
+			LodLevel batchLevel{static_cast<uint32_t>(batch.indices.size()), 0, 0.0f};
+
+			for (uint32_t i = 0; i < members.size(); i++) {
+				const Mesh &mesh = meshes[members[i]];
+				std::span<const uint32_t> indices = mesh.indexData();
+				LodLevel lod = mesh.lod(level);
+				uint32_t firstIndex = batch.indices.size();
+
+				for (uint32_t index : indices.subspan(lod.firstIndex, lod.indexCount)) {
+					batch.indices.push_back(index + firstVertices[i]);
+				}
+
+				batchLevel.error = std::max(batchLevel.error, lod.error * maxAxisScale(mesh.transform));
+				if (level != 0) continue;
+
+				SubMesh subMesh{};
+				subMesh.sourceID = mesh.id;
+				subMesh.firstIndex = firstIndex;
+				subMesh.indexCount = lod.indexCount;
+				subMesh.firstMeshlet = batch.meshlets.size();
+				subMesh.meshletCount = mesh.meshlets.size();
+
+				size_t memberVertices = (i + 1 < members.size() ? firstVertices[i + 1] : batch.vertices.size()) - firstVertices[i];
+				subMesh.bounds = VertexConversion::computeBounds(std::span<const Vertex>(batch.vertices).subspan(firstVertices[i], memberVertices));
+
+				bool keepCone = keepsNormalCones(mesh.transform);
+				for (const Meshlet &meshlet : mesh.meshlets) {
+					batch.meshlets.push_back(transformMeshlet(meshlet, mesh.transform, keepCone, meshlet.firstIndex - lod.firstIndex + firstIndex));
+				}
+
+				batch.subMeshes.push_back(subMesh);
+			}
+
+			batchLevel.indexCount = batch.indices.size() - batchLevel.firstIndex;
+			if (levelCount > 1) batch.lods.push_back(batchLevel);
+		}
+
+		batch.bounds = VertexConversion::computeBounds(batch.vertices);
+
+		if (settings.quantize && allQuantized && VertexQuantizer::canQuantize(batch.vertices))
+			VertexQuantizer::quantize(batch);
+
+		return batch;
+	}
+}
+
+std::vector<Mesh> StaticBatcher::batch(std::span<const Mesh> meshes, const Settings &settings) {
+	//meshes per material and occluder flag in order of first appearance
+	std::vector<std::vector<uint32_t>> groups;
+	std::unordered_map<uuids::uuid, uint32_t> groupOfMaterial[2];
+
+	for (uint32_t i = 0; i < meshes.size(); i++) {
+		auto group = groupOfMaterial[meshes[i].occluder].try_emplace(meshes[i].materialID, groups.size());
+		if (group.second) groups.emplace_back();
+		groups[group.first->second].push_back(i);
+	}
+
+	std::vector<Mesh> batches;
+
+	auto flush = [&](std::vector<uint32_t> &members) {
+		if (members.size() == 1) batches.push_back(meshes[members[0]]);
+		else if (members.size() > 1) batches.push_back(mergeGroup(meshes, members, settings));
+		members.clear();
+	};
+
+	for (const std::vector<uint32_t> &group : groups) {
+		std::vector<uint32_t> members;
+		uint64_t memberVertices = 0;
+
+		for (uint32_t i : group) {
+			uint32_t vertexCount = meshes[i].vertexCount();
+			if (memberVertices + vertexCount > settings.maxVertices) {
+				flush(members);
+				memberVertices = 0;
+			}
+
+			members.push_back(i);
+			memberVertices += vertexCount;
+		}
+
+		flush(members);
+	}
+
+	return batches;
+}
+
+std::vector<Vertex> StaticBatcher::fullVertices(const Mesh &mesh) {
+	if (mesh.layout != VertexLayout::Quantized) {
+		std::span<const Vertex> vertices = mesh.vertexData();
+		return {vertices.begin(), vertices.end()};
+	}
+
+	std::span<const QuantizedVertex> quantized = mesh.quantizedData();
+	std::vector<Vertex> vertices(quantized.size());
+
+	for (size_t i = 0; i < quantized.size(); i++) {
+		vertices[i].pos = VertexQuantizer::dequantizePosition(quantized[i], mesh.bounds);
+		vertices[i].color = glm::vec3(1.0f);
+		vertices[i].texCoord = glm::vec2(VertexQuantizer::halfToFloat(quantized[i].texCoord[0]), VertexQuantizer::halfToFloat(quantized[i].texCoord[1]));
+	}
+
+	return vertices;
+}
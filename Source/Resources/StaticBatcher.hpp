@@ -0,0 +1,28 @@
+#ifndef STATICBATCHER_HPP
+#define STATICBATCHER_HPP
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "Mesh.hpp"
+
+///Scene build time merging of static meshes that share a material, one batch is one bind and one set of draws
+///Occluders are only merged with other occluders, a batch keeps the occluder flag of its members
+///Transforms are applied to the vertices, every source mesh stays a SubMesh range so it is still culled on its own
+namespace StaticBatcher {
+	struct Settings {
+		///a batch is closed before it would pass this many vertices, the default keeps batches on 16 bit indices
+		uint32_t maxVertices = 65536;
+		///quantize batches whose sources were all quantized, positions lose precision over the batch's larger extent
+		bool quantize = false;
+	};
+
+	///batches come out in the order of their first mesh, a mesh that has nothing to merge with is returned unchanged
+	std::vector<Mesh> batch(std::span<const Mesh> meshes, const Settings &settings = {});
+
+	///a mesh's vertices in full precision, dequantized for Quantized meshes
+	std::vector<Vertex> fullVertices(const Mesh &mesh);
+}
+
+#endif //STATICBATCHER_HPP
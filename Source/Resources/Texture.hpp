@@ -2,25 +2,68 @@
 #define TEXTURE
 
 #include <cstdint>
+#include <memory>
 #include <string>
+#include <vector>
 #include <Dependencies/stb_image.h>
 #include <Dependencies/uuid.h>
 
+#include "PixelBuffer.hpp"
+
 enum TextureType {
 
 };
 
+///How pixels are stored, block formats hold 4x4 texel blocks per mip level
+enum class TextureFormat : uint32_t {
+	RGBA8 = 0,
+	///RGB at 4 bits per texel
+	BC1 = 1,
+	///BC1 color plus interpolated alpha, 8 bits per texel
+	BC3 = 2,
+	///two independent channels (red, green) for data like normal maps, stored linear
+	BC5 = 3,
+	///RGBA at 8 bits per texel with much better quality than BC3
+	BC7 = 4
+};
+
+///whether a format is sampled as sRGB color, mips are filtered in linear space only for those
+inline bool isSrgbFormat(TextureFormat format) {
+	return format != TextureFormat::BC5;
+}
+
 struct Texture {
 	uuids::uuid id;
 	TextureType type;
 
-	stbi_uc* pixels;
+	///read only view of the pixel data, kept alive by pixelSource
+	const uint8_t *pixels = nullptr;
 	uint32_t width;
 	uint32_t height;
 	uint32_t channels;
 	uint32_t byteSize;
 
 	uint32_t mipLevels;
+	TextureFormat format = TextureFormat::RGBA8;
+
+	///byte offset of each prebuilt mip level inside pixels, empty when mips are generated on upload
+	std::vector<uint64_t> mipOffsets;
+	///owner of pixels, a PixelBuffer or a mapped package, shared by every copy of the texture
+	std::shared_ptr<const void> pixelSource;
+
+	///makes buffer the pixel storage of this texture and every copy made from it afterwards
+	void adopt(PixelBuffer &&buffer) {
+		auto owner = std::make_shared<PixelBuffer>(std::move(buffer));
+		pixels = owner->data();
+		byteSize = owner->size();
+		pixelSource = std::move(owner);
+	}
+
+	///drops this copy's hold on the pixels, e.g. once they are on the GPU, the memory goes with the last copy
+	void releasePixels() {
+		pixels = nullptr;
+		pixelSource.reset();
+	}
 };
 
 #endif
@@ -0,0 +1,468 @@
+#include "TextureCompression.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <utility>
+
+namespace {
+	constexpr uint32_t BLOCK_TEXELS = 16;
+	constexpr uint32_t POWER_ITERATIONS = 8;
+	constexpr uint8_t BC7_WEIGHTS[16] = {0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64};
+	///how far towards endpoint 1 each BC1 index sits
+	constexpr float BC1_WEIGHTS[4] = {0.0f, 1.0f, 1.0f / 3.0f, 2.0f / 3.0f};
+
+	///mean and principal axis of the block's texels over the first channels, the line the endpoints are picked on
+	void fitLine(const uint8_t *rgba, uint32_t channels, float mean[4], float axis[4]) {
+		for (uint32_t c = 0; c < 4; c++) {
+			mean[c] = 0.0f;
+			axis[c] = 0.0f;
+		}
+
+		for (uint32_t i = 0; i < BLOCK_TEXELS; i++) {
+			for (uint32_t c = 0; c < channels; c++) mean[c] += rgba[i * 4 + c];
+		}
+		for (uint32_t c = 0; c < channels; c++) mean[c] /= BLOCK_TEXELS;
+
+		float covariance[4][4] = {};
+		for (uint32_t i = 0; i < BLOCK_TEXELS; i++) {
+			float offset[4];
+			for (uint32_t c = 0; c < channels; c++) offset[c] = rgba[i * 4 + c] - mean[c];
+
+			for (uint32_t a = 0; a < channels; a++) {
+				for (uint32_t b = 0; b < channels; b++) covariance[a][b] += offset[a] * offset[b];
+			}
+		}
+
+		//power iteration from the channel that varies the most
+		uint32_t widest = 0;
+		for (uint32_t c = 1; c < channels; c++) {
+			if (covariance[c][c] > covariance[widest][widest]) widest = c;
+		}
+		axis[widest] = 1.0f;
+
+		for (uint32_t iteration = 0; iteration < POWER_ITERATIONS; iteration++) {
+			float next[4] = {};
+			float length = 0.0f;
+			for (uint32_t a = 0; a < channels; a++) {
+				for (uint32_t b = 0; b < channels; b++) next[a] += covariance[a][b] * axis[b];
+				length += next[a] * next[a];
+			}
+
+			if (length <= 0.0f) break;
+			length = std::sqrt(length);
+			for (uint32_t c = 0; c < channels; c++) axis[c] = next[c] / length;
+		}
+	}
+
+	///the two ends of the block's texels projected onto the fitted line
+	void lineEndpoints(const uint8_t *rgba, uint32_t channels, float start[4], float end[4]) {
+		float mean[4], axis[4];
+		fitLine(rgba, channels, mean, axis);
+
+		float minProjection = std::numeric_limits<float>::max();
+		float maxProjection = std::numeric_limits<float>::lowest();
+		for (uint32_t i = 0; i < BLOCK_TEXELS; i++) {
+			float projection = 0.0f;
+			for (uint32_t c = 0; c < channels; c++) projection += (rgba[i * 4 + c] - mean[c]) * axis[c];
+
+			minProjection = std::min(minProjection, projection);
+			maxProjection = std::max(maxProjection, projection);
+		}
+
+		for (uint32_t c = 0; c < 4; c++) {
+			start[c] = std::clamp(mean[c] + axis[c] * minProjection, 0.0f, 255.0f);
+			end[c] = std::clamp(mean[c] + axis[c] * maxProjection, 0.0f, 255.0f);
+		}
+	}
+
+	///least squares endpoints for fixed interpolation weights, weights[i] is how much of end texel i takes
+	bool refitEndpoints(const uint8_t *rgba, uint32_t channels, const float weights[BLOCK_TEXELS], float start[4], float end[4]) {
+		float aa = 0.0f, ab = 0.0f, bb = 0.0f;
+		float ax[4] = {}, bx[4] = {};
+
+		for (uint32_t i = 0; i < BLOCK_TEXELS; i++) {
+			float b = weights[i];
+			float a = 1.0f - b;
+			aa += a * a;
+			ab += a * b;
+			bb += b * b;
+
+			for (uint32_t c = 0; c < channels; c++) {
+				ax[c] += a * rgba[i * 4 + c];
+				bx[c] += b * rgba[i * 4 + c];
+			}
+		}
+
+		float determinant = aa * bb - ab * ab;
+		if (std::abs(determinant) < 1e-6f) return false;
+
+		for (uint32_t c = 0; c < channels; c++) {
+			start[c] = std::clamp((ax[c] * bb - bx[c] * ab) / determinant, 0.0f, 255.0f);
+			end[c] = std::clamp((bx[c] * aa - ax[c] * ab) / determinant, 0.0f, 255.0f);
+		}
+		return true;
+	}
+
+	uint16_t pack565(const float color[4]) {
+		uint32_t r = std::lround(color[0] * 31.0f / 255.0f);
+		uint32_t g = std::lround(color[1] * 63.0f / 255.0f);
+		uint32_t b = std::lround(color[2] * 31.0f / 255.0f);
+		return static_cast<uint16_t>(r << 11 | g << 5 | b);
+	}
+
+	void unpack565(uint16_t packed, int color[3]) {
+		int r = packed >> 11, g = (packed >> 5) & 63, b = packed & 31;
+		color[0] = r << 3 | r >> 2;
+		color[1] = g << 2 | g >> 4;
+		color[2] = b << 3 | b >> 2;
+	}
+
+	///nearest entry of the 4 color palette for every texel, returns the summed squared error
+	uint32_t bc1Indices(const uint8_t *rgba, uint16_t color0, uint16_t color1, uint32_t &indices) {
+		int palette[4][3];
+		unpack565(color0, palette[0]);
+		unpack565(color1, palette[1]);
+		for (uint32_t c = 0; c < 3; c++) {
+			palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+			palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+		}
+
+		uint32_t error = 0;
+		indices = 0;
+		for (uint32_t i = 0; i < BLOCK_TEXELS; i++) {
+			uint32_t best = 0, bestError = std::numeric_limits<uint32_t>::max();
+
+			for (uint32_t p = 0; p < 4; p++) {
+				uint32_t distance = 0;
+				for (uint32_t c = 0; c < 3; c++) {
+					int offset = rgba[i * 4 + c] - palette[p][c];
+					distance += offset * offset;
+				}
+				if (distance < bestError) {
+					best = p;
+					bestError = distance;
+				}
+			}
+
+			indices |= best << (i * 2);
+			error += bestError;
+		}
+
+		return error;
+	}
+
+	///nearest entry of a BC7 palette for every texel, returns the summed squared error
+	uint32_t bc7Indices(const uint8_t *rgba, const int start[4], const int end[4], uint8_t indices[BLOCK_TEXELS]) {
+		int palette[16][4];
+		for (uint32_t p = 0; p < 16; p++) {
+			for (uint32_t c = 0; c < 4; c++) {
+				palette[p][c] = ((64 - BC7_WEIGHTS[p]) * start[c] + BC7_WEIGHTS[p] * end[c] + 32) >> 6;
+			}
+		}
+
+		uint32_t error = 0;
+		for (uint32_t i = 0; i < BLOCK_TEXELS; i++) {
+			uint32_t best = 0, bestError = std::numeric_limits<uint32_t>::max();
+
+			for (uint32_t p = 0; p < 16; p++) {
+				uint32_t distance = 0;
+				for (uint32_t c = 0; c < 4; c++) {
+					int offset = rgba[i * 4 + c] - palette[p][c];
+					distance += offset * offset;
+				}
+				if (distance < bestError) {
+					best = p;
+					bestError = distance;
+				}
+			}
+
+			indices[i] = best;
+			error += bestError;
+		}
+
+		return error;
+	}
+
+	///mode 6 endpoints, 7 bits per channel plus one p bit shared by each endpoint's channels
+	struct BC7Endpoints {
+		uint8_t quantized[2][4];
+		uint8_t pBits[2];
+		uint8_t indices[BLOCK_TEXELS];
+		uint32_t error;
+	};
+
+	///tries all four p bit combinations for the endpoints and keeps the closest fit
+	BC7Endpoints fitBC7(const uint8_t *rgba, const float start[4], const float end[4]) {
+		BC7Endpoints best{};
+		best.error = std::numeric_limits<uint32_t>::max();
+		const float *endpoints[2] = {start, end};
+
+		for (uint32_t pBits = 0; pBits < 4; pBits++) {
+			BC7Endpoints candidate{};
+			int expanded[2][4];
+
+			for (uint32_t e = 0; e < 2; e++) {
+				candidate.pBits[e] = (pBits >> e) & 1;
+				for (uint32_t c = 0; c < 4; c++) {
+					long quantized = std::lround((endpoints[e][c] - candidate.pBits[e]) / 2.0f);
+					candidate.quantized[e][c] = static_cast<uint8_t>(std::clamp(quantized, 0L, 127L));
+					expanded[e][c] = candidate.quantized[e][c] << 1 | candidate.pBits[e];
+				}
+			}
+
+			candidate.error = bc7Indices(rgba, expanded[0], expanded[1], candidate.indices);
+			if (candidate.error < best.error) best = candidate;
+		}
+
+		return best;
+	}
+
+	///little endian bit packing for BC7 blocks
+	struct BitWriter {
+		uint8_t *block;
+		uint32_t position = 0;
+
+		void write(uint32_t value, uint32_t bits) {
+			for (uint32_t i = 0; i < bits; i++, position++) {
+				block[position >> 3] |= ((value >> i) & 1) << (position & 7);
+			}
+		}
+	};
+
+	void encodeBlock(TextureFormat format, const uint8_t *rgba, uint8_t *block) {
+		switch (format) {
+			case TextureFormat::BC1: TextureCompression::encodeBC1(rgba, block); break;
+			case TextureFormat::BC3: TextureCompression::encodeBC3(rgba, block); break;
+			case TextureFormat::BC5: TextureCompression::encodeBC5(rgba, block); break;
+			case TextureFormat::BC7: TextureCompression::encodeBC7(rgba, block); break;
+			default: throw std::runtime_error("Texture format is not block compressed");
+		}
+	}
+}
+
+uint32_t TextureCompression::blockBytes(TextureFormat format) {
+	switch (format) {
+		case TextureFormat::BC1: return 8;
+		case TextureFormat::BC3: return 16;
+		case TextureFormat::BC5: return 16;
+		case TextureFormat::BC7: return 16;
+		default: return 0;
+	}
+}
+
+uint64_t TextureCompression::levelSize(TextureFormat format, uint32_t width, uint32_t height) {
+	uint32_t bytes = blockBytes(format);
+	if (bytes == 0) return static_cast<uint64_t>(width) * height * 4;
+
+	return static_cast<uint64_t>((width + 3) / 4) * ((height + 3) / 4) * bytes;
+}
+
+void TextureCompression::encodeBC1(const uint8_t *rgba, uint8_t *block) {
+	float start[4], end[4];
+	lineEndpoints(rgba, 3, start, end);
+
+	uint16_t color0 = pack565(end);
+	uint16_t color1 = pack565(start);
+	uint32_t indices;
+	uint32_t error = bc1Indices(rgba, color0, color1, indices);
+
+	//one least squares pass against the chosen indices usually pulls the endpoints closer
+	float weights[BLOCK_TEXELS];
+	for (uint32_t i = 0; i < BLOCK_TEXELS; i++) weights[i] = BC1_WEIGHTS[(indices >> (i * 2)) & 3];
+
+	if (error > 0 && refitEndpoints(rgba, 3, weights, end, start)) {
+		uint16_t refit0 = pack565(end);
+		uint16_t refit1 = pack565(start);
+		uint32_t refitIndices;
+		uint32_t refitError = bc1Indices(rgba, refit0, refit1, refitIndices);
+
+		if (refitError < error) {
+			color0 = refit0;
+			color1 = refit1;
+			indices = refitIndices;
+		}
+	}
+
+	//4 color mode needs color0 > color1, swapping the endpoints swaps index 0 with 1 and 2 with 3
+	if (color0 < color1) {
+		std::swap(color0, color1);
+		indices ^= 0x55555555;
+	}
+	else if (color0 == color1) {
+		indices = 0;
+	}
+
+	block[0] = color0 & 0xff;
+	block[1] = color0 >> 8;
+	block[2] = color1 & 0xff;
+	block[3] = color1 >> 8;
+	std::memcpy(block + 4, &indices, 4);
+}
+
+void TextureCompression::encodeBC4(const uint8_t *values, uint32_t stride, uint8_t *block) {
+	uint8_t minValue = 255, maxValue = 0;
+	for (uint32_t i = 0; i < BLOCK_TEXELS; i++) {
+		minValue = std::min(minValue, values[i * stride]);
+		maxValue = std::max(maxValue, values[i * stride]);
+	}
+
+	//max first selects the 8 value mode, index 0 is max, 1 is min and 2 to 7 step between them
+	block[0] = maxValue;
+	block[1] = minValue;
+
+	uint64_t bits = 0;
+	if (maxValue > minValue) {
+		float palette[8];
+		palette[0] = maxValue;
+		palette[1] = minValue;
+		for (uint32_t p = 2; p < 8; p++) {
+			palette[p] = ((8 - p) * maxValue + (p - 1) * minValue) / 7.0f;
+		}
+
+		for (uint32_t i = 0; i < BLOCK_TEXELS; i++) {
+			uint64_t best = 0;
+			float bestError = std::numeric_limits<float>::max();
+			for (uint32_t p = 0; p < 8; p++) {
+				float error = std::abs(values[i * stride] - palette[p]);
+				if (error < bestError) {
+					best = p;
+					bestError = error;
+				}
+			}
+			bits |= best << (i * 3);
+		}
+	}
+
+	for (uint32_t i = 0; i < 6; i++) {
+		block[2 + i] = (bits >> (i * 8)) & 0xff;
+	}
+}
+
+void TextureCompression::encodeBC3(const uint8_t *rgba, uint8_t *block) {
+	encodeBC4(rgba + 3, 4, block);
+	encodeBC1(rgba, block + 8);
+}
+
+void TextureCompression::encodeBC5(const uint8_t *rgba, uint8_t *block) {
+	encodeBC4(rgba, 4, block);
+	encodeBC4(rgba + 1, 4, block + 8);
+}
+
+void TextureCompression::encodeBC7(const uint8_t *rgba, uint8_t *block) {
+	float start[4], end[4];
+	lineEndpoints(rgba, 4, start, end);
+	BC7Endpoints fit = fitBC7(rgba, start, end);
+
+	float weights[BLOCK_TEXELS];
+	for (uint32_t i = 0; i < BLOCK_TEXELS; i++) weights[i] = BC7_WEIGHTS[fit.indices[i]] / 64.0f;
+
+	if (fit.error > 0 && refitEndpoints(rgba, 4, weights, start, end)) {
+		BC7Endpoints refit = fitBC7(rgba, start, end);
+		if (refit.error < fit.error) fit = refit;
+	}
+
+	//the anchor texel stores only 3 index bits, so its index has to be in the lower half
+	if (fit.indices[0] >= 8) {
+		std::swap(fit.quantized[0], fit.quantized[1]);
+		std::swap(fit.pBits[0], fit.pBits[1]);
+		for (uint8_t &index : fit.indices) index = 15 - index;
+	}
+
+	std::memset(block, 0, 16);
+	BitWriter writer{block};
+	writer.write(1 << 6, 7);
+
+	for (uint32_t c = 0; c < 4; c++) {
+		writer.write(fit.quantized[0][c], 7);
+		writer.write(fit.quantized[1][c], 7);
+	}
+
+	writer.write(fit.pBits[0], 1);
+	writer.write(fit.pBits[1], 1);
+
+	writer.write(fit.indices[0], 3);
+	for (uint32_t i = 1; i < BLOCK_TEXELS; i++) writer.write(fit.indices[i], 4);
+}
+
+uint64_t TextureCompression::compressedLayout(TextureFormat format, uint32_t width, uint32_t height, uint32_t levels, std::vector<uint64_t> &compressedOffsets) {
+	compressedOffsets.resize(levels);
+	uint64_t totalSize = 0;
+
+	for (uint32_t level = 0, w = width, h = height; level < levels; level++) {
+		compressedOffsets[level] = totalSize;
+		totalSize += levelSize(format, w, h);
+
+		w = std::max(1u, w / 2);
+		h = std::max(1u, h / 2);
+	}
+
+	return totalSize;
+}
+
+std::vector<uint8_t> TextureCompression::compressMipChain(const uint8_t *chain, uint32_t width, uint32_t height, const std::vector<uint64_t> &mipOffsets,
+		TextureFormat format, std::vector<uint64_t> &compressedOffsets, ThreadPool *pool) {
+	std::vector<uint8_t> compressed(compressedLayout(format, width, height, mipOffsets.size(), compressedOffsets));
+	compressMipChain(chain, width, height, mipOffsets, format, compressed.data(), pool);
+	return compressed;
+}
+
+void TextureCompression::compressMipChain(const uint8_t *chain, uint32_t width, uint32_t height, const std::vector<uint64_t> &mipOffsets,
+		TextureFormat format, uint8_t *compressed, ThreadPool *pool) {
+	const uint32_t bytes = blockBytes(format);
+	if (bytes == 0) throw std::runtime_error("Texture format is not block compressed");
+
+	struct BlockRow {
+		uint32_t level;
+		uint32_t row;
+	};
+
+	std::vector<uint64_t> compressedOffsets;
+	compressedLayout(format, width, height, mipOffsets.size(), compressedOffsets);
+
+	std::vector<BlockRow> rows;
+	std::vector<uint32_t> levelWidths, levelHeights;
+
+	for (uint32_t level = 0, w = width, h = height; level < mipOffsets.size(); level++) {
+		levelWidths.push_back(w);
+		levelHeights.push_back(h);
+
+		for (uint32_t row = 0; row < (h + 3) / 4; row++) rows.push_back({level, row});
+
+		w = std::max(1u, w / 2);
+		h = std::max(1u, h / 2);
+	}
+
+	//rows of every level are independent, so they all go into one parallel pass
+	auto encodeRow = [&](uint32_t job) {
+		const BlockRow &blockRow = rows[job];
+		uint32_t w = levelWidths[blockRow.level];
+		uint32_t h = levelHeights[blockRow.level];
+		uint32_t blocksWide = (w + 3) / 4;
+		const uint8_t *level = chain + mipOffsets[blockRow.level];
+		uint8_t *out = compressed + compressedOffsets[blockRow.level] + static_cast<uint64_t>(blockRow.row) * blocksWide * bytes;
+
+		uint8_t rgba[BLOCK_TEXELS * 4];
+		for (uint32_t bx = 0; bx < blocksWide; bx++) {
+			//blocks hanging over the edge repeat the last row and column
+			for (uint32_t y = 0; y < 4; y++) {
+				uint32_t sy = std::min(blockRow.row * 4 + y, h - 1);
+				for (uint32_t x = 0; x < 4; x++) {
+					uint32_t sx = std::min(bx * 4 + x, w - 1);
+					std::memcpy(rgba + (y * 4 + x) * 4, level + (static_cast<uint64_t>(sy) * w + sx) * 4, 4);
+				}
+			}
+
+			encodeBlock(format, rgba, out + bx * bytes);
+		}
+	};
+
+	if (pool) {
+		pool->parallelFor(rows.size(), encodeRow);
+	}
+	else {
+		for (uint32_t job = 0; job < rows.size(); job++) encodeRow(job);
+	}
+}
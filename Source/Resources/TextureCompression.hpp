@@ -0,0 +1,39 @@
+#ifndef TEXTURECOMPRESSION_HPP
+#define TEXTURECOMPRESSION_HPP
+
+#include <cstdint>
+#include <vector>
+
+#include "Texture.hpp"
+#include "Source/Core/Jobs/ThreadPool.hpp"
+
+///Import time BCn block compression, blocks are 4x4 texels given as 64 bytes of RGBA8
+namespace TextureCompression {
+	///bytes per 4x4 block, 0 for uncompressed formats
+	uint32_t blockBytes(TextureFormat format);
+
+	///bytes one mip level takes in a format, partial blocks at the edges count as whole ones
+	uint64_t levelSize(TextureFormat format, uint32_t width, uint32_t height);
+
+	///4 color mode BC1, alpha is ignored
+	void encodeBC1(const uint8_t *rgba, uint8_t *block);
+	///one channel, values holds 16 bytes with the given stride between them
+	void encodeBC4(const uint8_t *values, uint32_t stride, uint8_t *block);
+	void encodeBC3(const uint8_t *rgba, uint8_t *block);
+	void encodeBC5(const uint8_t *rgba, uint8_t *block);
+	///mode 6, one RGBA subset with 4 bit indices
+	void encodeBC7(const uint8_t *rgba, uint8_t *block);
+
+	///byte offset of each level of a compressed mip chain, returns the size of the whole chain
+	uint64_t compressedLayout(TextureFormat format, uint32_t width, uint32_t height, uint32_t levels, std::vector<uint64_t> &compressedOffsets);
+
+	///compresses every level of an RGBA8 mip chain, compressedOffsets receives each level's offset in the result
+	///blocks are encoded in parallel when a pool is given, must not be called from inside a pool job
+	std::vector<uint8_t> compressMipChain(const uint8_t *chain, uint32_t width, uint32_t height, const std::vector<uint64_t> &mipOffsets,
+		TextureFormat format, std::vector<uint64_t> &compressedOffsets, ThreadPool *pool = nullptr);
+	///same as above into caller owned memory of at least compressedLayout bytes
+	void compressMipChain(const uint8_t *chain, uint32_t width, uint32_t height, const std::vector<uint64_t> &mipOffsets,
+		TextureFormat format, uint8_t *compressed, ThreadPool *pool = nullptr);
+}
+
+#endif //TEXTURECOMPRESSION_HPP
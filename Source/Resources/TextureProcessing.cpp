@@ -0,0 +1,200 @@
+#include "TextureProcessing.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+
+namespace {
+	constexpr uint32_t KAISER_TAPS = 8;
+	constexpr double KAISER_ALPHA = 4.0;
+	constexpr double PI = 3.14159265358979323846;
+	///linear values are looked up at 16 bit precision, fine enough that every 8 bit sRGB value round trips
+	constexpr uint32_t SRGB_ENCODE_STEPS = 65536;
+
+	///one row at a time across the pool, or inline without one
+	template <typename F>
+	void forEachRow(ThreadPool *pool, uint32_t rows, F &&job) {
+		if (pool) {
+			pool->parallelFor(rows, job);
+			return;
+		}
+
+		for (uint32_t row = 0; row < rows; row++) job(row);
+	}
+
+	double besselI0(double x) {
+		double sum = 1.0, term = 1.0;
+		for (int k = 1; k < 32; k++) {
+			double factor = x / (2.0 * k);
+			term *= factor * factor;
+			sum += term;
+		}
+		return sum;
+	}
+
+	///taps sit half a texel either side of the destination texel centre, out to 3.5 source texels
+	std::array<float, KAISER_TAPS> computeKaiserWeights() {
+		std::array<float, KAISER_TAPS> weights{};
+		double total = 0.0;
+
+		for (uint32_t i = 0; i < KAISER_TAPS; i++) {
+			double distance = std::abs(i - (KAISER_TAPS - 1) / 2.0);
+			double x = distance / 2.0;
+			double sinc = std::sin(PI * x) / (PI * x);
+			double edge = distance / (KAISER_TAPS / 2.0);
+			double window = besselI0(KAISER_ALPHA * std::sqrt(1.0 - edge * edge)) / besselI0(KAISER_ALPHA);
+
+			weights[i] = static_cast<float>(sinc * window);
+			total += weights[i];
+		}
+
+		for (float &weight : weights) weight = static_cast<float>(weight / total);
+		return weights;
+	}
+
+	const std::array<float, KAISER_TAPS> &kaiserWeights() {
+		static const std::array<float, KAISER_TAPS> weights = computeKaiserWeights();
+		return weights;
+	}
+
+	const std::array<float, 256> &srgbDecodeTable() {
+		static const std::array<float, 256> table = [] {
+			std::array<float, 256> values{};
+			for (uint32_t i = 0; i < 256; i++) {
+				double encoded = i / 255.0;
+				values[i] = static_cast<float>(encoded <= 0.04045 ? encoded / 12.92 : std::pow((encoded + 0.055) / 1.055, 2.4));
+			}
+			return values;
+		}();
+		return table;
+	}
+
+	const std::vector<uint8_t> &srgbEncodeTable() {
+		static const std::vector<uint8_t> table = [] {
+			std::vector<uint8_t> values(SRGB_ENCODE_STEPS);
+			for (uint32_t i = 0; i < SRGB_ENCODE_STEPS; i++) {
+				double linear = static_cast<double>(i) / (SRGB_ENCODE_STEPS - 1);
+				double encoded = linear <= 0.0031308 ? linear * 12.92 : 1.055 * std::pow(linear, 1.0 / 2.4) - 0.055;
+				values[i] = static_cast<uint8_t>(std::lround(std::clamp(encoded, 0.0, 1.0) * 255.0));
+			}
+			return values;
+		}();
+		return table;
+	}
+}
+
+float TextureProcessing::srgbToLinear(uint8_t value) {
+	return srgbDecodeTable()[value];
+}
+
+uint8_t TextureProcessing::linearToSrgb(float value) {
+	return srgbEncodeTable()[std::lround(std::clamp(value, 0.0f, 1.0f) * (SRGB_ENCODE_STEPS - 1))];
+}
+
+uint32_t TextureProcessing::mipLevelCount(uint32_t width, uint32_t height) {
+	return static_cast<uint32_t>(std::floor(std::log2(std::max(width, height)))) + 1;
+}
+
+uint64_t TextureProcessing::mipChainLayout(uint32_t width, uint32_t height, std::vector<uint64_t> &mipOffsets) {
+	const uint32_t levels = mipLevelCount(width, height);
+
+	mipOffsets.resize(levels);
+	uint64_t totalSize = 0;
+	for (uint32_t level = 0, w = width, h = height; level < levels; level++) {
+		mipOffsets[level] = totalSize;
+		totalSize += static_cast<uint64_t>(w) * h * 4;
+
+		w = std::max(1u, w / 2);
+		h = std::max(1u, h / 2);
+	}
+
+	return totalSize;
+}
+
+std::vector<uint8_t> TextureProcessing::generateMipChain(const uint8_t *pixels, uint32_t width, uint32_t height, std::vector<uint64_t> &mipOffsets,
+		const MipSettings &settings, ThreadPool *pool) {
+	std::vector<uint8_t> chain(mipChainLayout(width, height, mipOffsets));
+	generateMipChain(pixels, width, height, chain.data(), settings, pool);
+	return chain;
+}
+
+void TextureProcessing::generateMipChain(const uint8_t *pixels, uint32_t width, uint32_t height, uint8_t *chain, const MipSettings &settings, ThreadPool *pool) {
+	std::vector<uint64_t> mipOffsets;
+	mipChainLayout(width, height, mipOffsets);
+	const uint32_t levels = mipOffsets.size();
+
+	std::memcpy(chain, pixels, static_cast<size_t>(width) * height * 4);
+	if (levels == 1) return;
+
+	auto decode = [&settings](uint8_t value, uint32_t channel) {
+		return settings.srgb && channel < 3 ? srgbToLinear(value) : value / 255.0f;
+	};
+	auto encode = [&settings](float value, uint32_t channel) {
+		if (settings.srgb && channel < 3) return linearToSrgb(value);
+		return static_cast<uint8_t>(std::lround(std::clamp(value, 0.0f, 1.0f) * 255.0f));
+	};
+
+	//every level is filtered from full precision linear values so rounding never builds up down the chain
+	std::vector<float> source(static_cast<size_t>(width) * height * 4);
+	forEachRow(pool, height, [&](uint32_t y) {
+		for (uint32_t i = y * width * 4; i < (y + 1) * width * 4; i++) {
+			source[i] = decode(pixels[i], i % 4);
+		}
+	});
+
+	const std::array<float, KAISER_TAPS> &weights = kaiserWeights();
+	uint32_t srcWidth = width;
+	uint32_t srcHeight = height;
+
+	for (uint32_t level = 1; level < levels; level++) {
+		uint8_t *dst = chain + mipOffsets[level];
+
+		uint32_t dstWidth = std::max(1u, srcWidth / 2);
+		uint32_t dstHeight = std::max(1u, srcHeight / 2);
+		std::vector<float> filtered(static_cast<size_t>(dstWidth) * dstHeight * 4);
+
+		forEachRow(pool, dstHeight, [&](uint32_t y) {
+			for (uint32_t x = 0; x < dstWidth; x++) {
+				float sum[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+
+				if (settings.filter == MipFilter::Kaiser) {
+					//separable weights applied as one 8x8 footprint, edges clamp
+					for (uint32_t ty = 0; ty < KAISER_TAPS; ty++) {
+						int64_t sy = std::clamp<int64_t>(static_cast<int64_t>(y) * 2 + ty - (KAISER_TAPS / 2 - 1), 0, srcHeight - 1);
+						const float *row = source.data() + sy * srcWidth * 4;
+
+						for (uint32_t tx = 0; tx < KAISER_TAPS; tx++) {
+							int64_t sx = std::clamp<int64_t>(static_cast<int64_t>(x) * 2 + tx - (KAISER_TAPS / 2 - 1), 0, srcWidth - 1);
+							float weight = weights[ty] * weights[tx];
+
+							for (uint32_t c = 0; c < 4; c++) sum[c] += row[sx * 4 + c] * weight;
+						}
+					}
+				}
+				else {
+					//2x2 box filter from the previous level, odd edges reuse the last row or column
+					uint32_t y0 = std::min(y * 2, srcHeight - 1);
+					uint32_t y1 = std::min(y * 2 + 1, srcHeight - 1);
+					uint32_t x0 = std::min(x * 2, srcWidth - 1);
+					uint32_t x1 = std::min(x * 2 + 1, srcWidth - 1);
+
+					for (uint32_t c = 0; c < 4; c++) {
+						sum[c] = (source[(y0 * srcWidth + x0) * 4 + c] + source[(y0 * srcWidth + x1) * 4 + c]
+							+ source[(y1 * srcWidth + x0) * 4 + c] + source[(y1 * srcWidth + x1) * 4 + c]) * 0.25f;
+					}
+				}
+
+				size_t texel = (static_cast<size_t>(y) * dstWidth + x) * 4;
+				for (uint32_t c = 0; c < 4; c++) {
+					filtered[texel + c] = std::clamp(sum[c], 0.0f, 1.0f);
+					dst[texel + c] = encode(sum[c], c);
+				}
+			}
+		});
+
+		source = std::move(filtered);
+		srcWidth = dstWidth;
+		srcHeight = dstHeight;
+	}
+}
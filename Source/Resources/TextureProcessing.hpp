@@ -0,0 +1,42 @@
+#ifndef TEXTUREPROCESSING_HPP
+#define TEXTUREPROCESSING_HPP
+
+#include <cstdint>
+#include <vector>
+
+#include "Texture.hpp"
+#include "Source/Core/Jobs/ThreadPool.hpp"
+
+namespace TextureProcessing {
+	enum class MipFilter : uint32_t {
+		///2x2 average, cheap but soft
+		Box = 0,
+		///8x8 Kaiser windowed sinc, keeps detail and avoids aliasing in the smaller levels
+		Kaiser = 1
+	};
+
+	struct MipSettings {
+		MipFilter filter = MipFilter::Box;
+		///color channels are sRGB encoded, they are filtered in linear space, alpha is always linear
+		bool srgb = false;
+	};
+
+	///number of mip levels down to 1x1
+	uint32_t mipLevelCount(uint32_t width, uint32_t height);
+
+	///byte offset of every level of a tightly packed RGBA8 mip chain, returns the size of the whole chain
+	uint64_t mipChainLayout(uint32_t width, uint32_t height, std::vector<uint64_t> &mipOffsets);
+
+	///Builds every mip level of an RGBA8 image into one tightly packed buffer, level 0 first
+	///mipOffsets receives the byte offset of each level inside the returned buffer
+	///rows of each level are filtered in parallel when a pool is given, must not be called from inside a pool job
+	std::vector<uint8_t> generateMipChain(const uint8_t *pixels, uint32_t width, uint32_t height, std::vector<uint64_t> &mipOffsets,
+		const MipSettings &settings = {}, ThreadPool *pool = nullptr);
+	///same as above into caller owned memory of at least mipChainLayout bytes
+	void generateMipChain(const uint8_t *pixels, uint32_t width, uint32_t height, uint8_t *chain, const MipSettings &settings = {}, ThreadPool *pool = nullptr);
+
+	float srgbToLinear(uint8_t value);
+	uint8_t linearToSrgb(float value);
+}
+
+#endif //TEXTUREPROCESSING_HPP
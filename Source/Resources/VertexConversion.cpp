@@ -0,0 +1,151 @@
+#include "VertexConversion.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#define SKADI_VERTEX_SSE
+#include <emmintrin.h>
+#endif
+
+static_assert(sizeof(Vertex) == 8 * sizeof(float) && offsetof(Vertex, color) == 3 * sizeof(float) && offsetof(Vertex, texCoord) == 6 * sizeof(float),
+	"VertexConversion writes Vertex as eight packed floats");
+
+namespace {
+#ifdef SKADI_VERTEX_SSE
+	__m128 load4(const void *element) {
+		return _mm_loadu_ps(static_cast<const float *>(element));
+	}
+
+	///the last element of an array is copied out first so the 16 byte load can not run past its end
+	__m128 loadLast(const uint8_t *element, size_t floats) {
+		float padded[4] = {};
+		std::memcpy(padded, element, floats * sizeof(float));
+		return _mm_loadu_ps(padded);
+	}
+
+	///packs xyz of position, rgb of color and uv of texCoord into the two halves of a Vertex
+	void store(Vertex &vertex, __m128 position, __m128 color, __m128 texCoord) {
+		__m128 zr = _mm_shuffle_ps(position, color, _MM_SHUFFLE(0, 0, 2, 2));
+		__m128 low = _mm_shuffle_ps(position, zr, _MM_SHUFFLE(2, 0, 1, 0));
+		__m128 high = _mm_shuffle_ps(color, texCoord, _MM_SHUFFLE(1, 0, 2, 1));
+
+		float *out = reinterpret_cast<float *>(&vertex);
+		_mm_storeu_ps(out, low);
+		_mm_storeu_ps(out + 4, high);
+	}
+
+	///sphere around the box centre like Bounds::build, four vertices are transposed to x, y and z lanes at a time
+	Bounds finish(__m128 min, __m128 max, std::span<const Vertex> vertices) {
+		float lanes[4];
+		Bounds bounds{};
+		_mm_storeu_ps(lanes, min);
+		bounds.min = glm::vec3(lanes[0], lanes[1], lanes[2]);
+		_mm_storeu_ps(lanes, max);
+		bounds.max = glm::vec3(lanes[0], lanes[1], lanes[2]);
+		bounds.center = (bounds.min + bounds.max) * 0.5f;
+
+		const __m128 centerX = _mm_set1_ps(bounds.center.x);
+		const __m128 centerY = _mm_set1_ps(bounds.center.y);
+		const __m128 centerZ = _mm_set1_ps(bounds.center.z);
+		__m128 farthest = _mm_setzero_ps();
+
+		size_t i = 0;
+		for (; i + 4 <= vertices.size(); i += 4) {
+			__m128 x = load4(&vertices[i]);
+			__m128 y = load4(&vertices[i + 1]);
+			__m128 z = load4(&vertices[i + 2]);
+			__m128 unused = load4(&vertices[i + 3]);
+			_MM_TRANSPOSE4_PS(x, y, z, unused);
+
+			__m128 dx = _mm_sub_ps(x, centerX);
+			__m128 dy = _mm_sub_ps(y, centerY);
+			__m128 dz = _mm_sub_ps(z, centerZ);
+			__m128 distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz));
+			farthest = _mm_max_ps(farthest, distance);
+		}
+
+		_mm_storeu_ps(lanes, farthest);
+		float radius = std::max(std::max(lanes[0], lanes[1]), std::max(lanes[2], lanes[3]));
+		for (; i < vertices.size(); i++) {
+			glm::vec3 offset = vertices[i].pos - bounds.center;
+			radius = std::max(radius, glm::dot(offset, offset));
+		}
+		bounds.radius = std::sqrt(radius);
+
+		return bounds;
+	}
+#endif
+}
+
+Bounds VertexConversion::convert(FloatStream positions, FloatStream colors, FloatStream texCoords, std::span<Vertex> vertices) {
+	if (vertices.empty()) return {};
+	if (!positions.data) throw std::runtime_error("Vertex conversion needs a position stream");
+
+	const uint8_t *position = static_cast<const uint8_t *>(positions.data);
+	const uint8_t *color = static_cast<const uint8_t *>(colors.data);
+	const uint8_t *texCoord = static_cast<const uint8_t *>(texCoords.data);
+	const size_t last = vertices.size() - 1;
+
+#ifdef SKADI_VERTEX_SSE
+	const __m128 white = _mm_set1_ps(1.0f);
+	const __m128 zero = _mm_setzero_ps();
+	__m128 min = _mm_set1_ps(std::numeric_limits<float>::infinity());
+	__m128 max = _mm_set1_ps(-std::numeric_limits<float>::infinity());
+
+	//every element before the last has another one behind it, so a 16 byte load from it stays inside the array
+	for (size_t i = 0; i < last; i++) {
+		__m128 p = load4(position + i * positions.stride);
+		__m128 c = color ? load4(color + i * colors.stride) : white;
+		__m128 t = texCoord ? load4(texCoord + i * texCoords.stride) : zero;
+
+		store(vertices[i], p, c, t);
+		min = _mm_min_ps(min, p);
+		max = _mm_max_ps(max, p);
+	}
+
+	__m128 p = loadLast(position + last * positions.stride, 3);
+	__m128 c = color ? loadLast(color + last * colors.stride, 3) : white;
+	__m128 t = texCoord ? loadLast(texCoord + last * texCoords.stride, 2) : zero;
+	store(vertices[last], p, c, t);
+	min = _mm_min_ps(min, p);
+	max = _mm_max_ps(max, p);
+
+	return finish(min, max, vertices);
+#else
+	for (size_t i = 0; i <= last; i++) {
+		Vertex &vertex = vertices[i];
+		std::memcpy(&vertex.pos, position + i * positions.stride, sizeof(glm::vec3));
+		vertex.color = glm::vec3(1.0f);
+		vertex.texCoord = glm::vec2(0.0f);
+
+		if (color) std::memcpy(&vertex.color, color + i * colors.stride, sizeof(glm::vec3));
+		if (texCoord) std::memcpy(&vertex.texCoord, texCoord + i * texCoords.stride, sizeof(glm::vec2));
+	}
+
+	return Bounds::fromVertices(vertices);
+#endif
+}
+
+Bounds VertexConversion::computeBounds(std::span<const Vertex> vertices) {
+	if (vertices.empty()) return {};
+
+#ifdef SKADI_VERTEX_SSE
+	//the fourth lane is color.r, it never leaves the register
+	__m128 min = load4(&vertices[0]);
+	__m128 max = min;
+	for (const Vertex &vertex : vertices) {
+		__m128 p = load4(&vertex);
+		min = _mm_min_ps(min, p);
+		max = _mm_max_ps(max, p);
+	}
+
+	return finish(min, max, vertices);
+#else
+	return Bounds::fromVertices(vertices);
+#endif
+}
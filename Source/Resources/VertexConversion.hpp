@@ -0,0 +1,26 @@
+#ifndef VERTEXCONVERSION_HPP
+#define VERTEXCONVERSION_HPP
+
+#include <cstddef>
+#include <span>
+
+#include "Bounds.hpp"
+#include "../Graphics/Vertex.hpp"
+
+///Bulk conversion of importer vertex arrays into Vertex, SSE on x86-64 and plain loops elsewhere
+namespace VertexConversion {
+	///float attribute in an importer's array, stride is in bytes and data is nullptr when the attribute is missing
+	struct FloatStream {
+		const void *data = nullptr;
+		size_t stride = 0;
+	};
+
+	///fills every vertex from at least 3 position, 3 color and 2 texture coordinate floats per element
+	///missing color or texture coordinates keep the Vertex defaults, the box is grown in the same pass
+	Bounds convert(FloatStream positions, FloatStream colors, FloatStream texCoords, std::span<Vertex> vertices);
+
+	///same result as Bounds::fromVertices for vertices that are already converted
+	Bounds computeBounds(std::span<const Vertex> vertices);
+}
+
+#endif //VERTEXCONVERSION_HPP
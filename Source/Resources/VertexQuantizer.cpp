@@ -0,0 +1,100 @@
+#include "VertexQuantizer.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+
+namespace {
+	constexpr float UNORM16_MAX = 65535.0f;
+	constexpr float HALF_MAX = 65504.0f;
+
+	uint16_t quantizeUnorm16(float value) {
+		return static_cast<uint16_t>(std::lround(std::clamp(value, 0.0f, 1.0f) * UNORM16_MAX));
+	}
+}
+
+uint16_t VertexQuantizer::floatToHalf(float value) {
+	uint32_t bits = std::bit_cast<uint32_t>(value);
+	uint16_t sign = (bits >> 16) & 0x8000;
+	uint32_t magnitude = bits & 0x7fffffff;
+
+	//nan stays nan, anything that rounds past the largest half becomes infinity
+	if (magnitude > 0x7f800000) return sign | 0x7e00;
+	if (magnitude >= 0x477ff000) return sign | 0x7c00;
+
+	//too small for a normal half, scaling by 2^24 gives the denormal mantissa exactly
+	if (magnitude < 0x38800000) {
+		float scaled = std::bit_cast<float>(magnitude) * 16777216.0f;
+		return sign | static_cast<uint16_t>(std::nearbyint(scaled));
+	}
+
+	//rebias the exponent from 127 to 15, then round the mantissa from 23 to 10 bits to nearest even
+	uint32_t rebased = magnitude - 0x38000000;
+	uint32_t rounded = rebased + 0xfff + ((rebased >> 13) & 1);
+	return sign | static_cast<uint16_t>(rounded >> 13);
+}
+
+float VertexQuantizer::halfToFloat(uint16_t value) {
+	uint32_t sign = static_cast<uint32_t>(value & 0x8000) << 16;
+	uint32_t exponent = (value >> 10) & 0x1f;
+	uint32_t mantissa = value & 0x3ff;
+
+	if (exponent == 0) {
+		float denormal = std::ldexp(static_cast<float>(mantissa), -24);
+		return sign ? -denormal : denormal;
+	}
+	if (exponent == 31) {
+		return std::bit_cast<float>(sign | 0x7f800000 | (mantissa << 13));
+	}
+
+	return std::bit_cast<float>(sign | ((exponent + 112) << 23) | (mantissa << 13));
+}
+
+bool VertexQuantizer::canQuantize(std::span<const Vertex> vertices) {
+	if (vertices.empty()) return false;
+
+	for (const Vertex &vertex : vertices) {
+		//the quantized layout has no color, white is what the shader falls back to
+		if (vertex.color != glm::vec3(1.0f)) return false;
+
+		for (int i = 0; i < 2; i++) {
+			if (!std::isfinite(vertex.texCoord[i]) || std::abs(vertex.texCoord[i]) > HALF_MAX) return false;
+		}
+	}
+
+	return true;
+}
+
+void VertexQuantizer::quantize(Mesh &mesh) {
+	glm::vec3 extent = mesh.bounds.max - mesh.bounds.min;
+
+	//flat meshes have no extent on some axis, everything there sits on the minimum
+	glm::vec3 scale{};
+	for (int i = 0; i < 3; i++) {
+		scale[i] = extent[i] > 0.0f ? 1.0f / extent[i] : 0.0f;
+	}
+
+	mesh.quantizedVertices.resize(mesh.vertices.size());
+	for (size_t i = 0; i < mesh.vertices.size(); i++) {
+		const Vertex &vertex = mesh.vertices[i];
+		QuantizedVertex &quantized = mesh.quantizedVertices[i];
+
+		glm::vec3 normalized = (vertex.pos - mesh.bounds.min) * scale;
+		quantized.pos[0] = quantizeUnorm16(normalized.x);
+		quantized.pos[1] = quantizeUnorm16(normalized.y);
+		quantized.pos[2] = quantizeUnorm16(normalized.z);
+		quantized.pos[3] = 0;
+
+		quantized.texCoord[0] = floatToHalf(vertex.texCoord.x);
+		quantized.texCoord[1] = floatToHalf(vertex.texCoord.y);
+	}
+
+	mesh.vertices.clear();
+	mesh.vertices.shrink_to_fit();
+	mesh.layout = VertexLayout::Quantized;
+}
+
+glm::vec3 VertexQuantizer::dequantizePosition(const QuantizedVertex &vertex, const Bounds &bounds) {
+	glm::vec3 normalized(vertex.pos[0], vertex.pos[1], vertex.pos[2]);
+	return bounds.min + normalized / UNORM16_MAX * (bounds.max - bounds.min);
+}
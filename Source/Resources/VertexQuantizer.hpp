@@ -0,0 +1,25 @@
+#ifndef VERTEXQUANTIZER_HPP
+#define VERTEXQUANTIZER_HPP
+
+#include <cstdint>
+#include <span>
+
+#include "Mesh.hpp"
+
+///Import time conversion of meshes to the compact QuantizedVertex layout
+namespace VertexQuantizer {
+	///IEEE half precision, rounds to nearest even and saturates to infinity past 65504
+	uint16_t floatToHalf(float value);
+	float halfToFloat(uint16_t value);
+
+	///false when the vertices carry color or texture coordinates a half float can not hold
+	bool canQuantize(std::span<const Vertex> vertices);
+
+	///replaces the vertices of a mesh that owns its geometry with quantized ones, bounds must enclose every vertex
+	void quantize(Mesh &mesh);
+
+	///model space position of a quantized vertex, what the dequantize transform gives the shader
+	glm::vec3 dequantizePosition(const QuantizedVertex &vertex, const Bounds &bounds);
+}
+
+#endif //VERTEXQUANTIZER_HPP
@@ -0,0 +1,56 @@
+#include "VertexStreams.hpp"
+
+#include <cstring>
+
+#include "VertexQuantizer.hpp"
+
+namespace {
+	constexpr uint64_t STREAM_ALIGNMENT = 16;
+
+	template <typename V>
+	VertexStreams::Streams splitVertices(std::span<const V> vertices) {
+		constexpr uint64_t attributeStride = sizeof(V) - V::POSITION_STRIDE;
+
+		VertexStreams::Streams streams{};
+		streams.positionSize = vertices.size() * V::POSITION_STRIDE;
+		streams.attributeOffset = (streams.positionSize + STREAM_ALIGNMENT - 1) & ~(STREAM_ALIGNMENT - 1);
+		streams.attributeSize = vertices.size() * attributeStride;
+		streams.data.resize(streams.attributeOffset + streams.attributeSize);
+
+		uint8_t *positions = streams.data.data();
+		uint8_t *attributes = streams.data.data() + streams.attributeOffset;
+
+		for (const V &vertex : vertices) {
+			const uint8_t *bytes = reinterpret_cast<const uint8_t *>(&vertex);
+			std::memcpy(positions, bytes, V::POSITION_STRIDE);
+			std::memcpy(attributes, bytes + V::POSITION_STRIDE, attributeStride);
+			positions += V::POSITION_STRIDE;
+			attributes += attributeStride;
+		}
+
+		return streams;
+	}
+}
+
+VertexStreams::Streams VertexStreams::split(const Mesh &mesh) {
+	if (mesh.layout == VertexLayout::Quantized) return splitVertices(mesh.quantizedData());
+	return splitVertices(mesh.vertexData());
+}
+
+std::vector<glm::vec3> VertexStreams::positions(const Mesh &mesh) {
+	std::vector<glm::vec3> positions;
+	positions.reserve(mesh.vertexCount());
+
+	if (mesh.layout == VertexLayout::Quantized) {
+		for (const QuantizedVertex &vertex : mesh.quantizedData()) {
+			positions.push_back(VertexQuantizer::dequantizePosition(vertex, mesh.bounds));
+		}
+	}
+	else {
+		for (const Vertex &vertex : mesh.vertexData()) {
+			positions.push_back(vertex.pos);
+		}
+	}
+
+	return positions;
+}
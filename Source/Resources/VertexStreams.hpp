@@ -0,0 +1,28 @@
+#ifndef VERTEXSTREAMS_HPP
+#define VERTEXSTREAMS_HPP
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "Mesh.hpp"
+
+///Split of interleaved vertices into a position stream and an attribute stream
+namespace VertexStreams {
+	///both streams in one allocation, positions first so a position only pass reads a single tight range
+	struct Streams {
+		std::vector<uint8_t> data;
+		uint64_t positionSize;
+		///aligned start of the attribute stream inside data
+		uint64_t attributeOffset;
+		uint64_t attributeSize;
+	};
+
+	///deinterleaves a mesh's vertices in whatever layout it uses, bindings 0 and 1 of getBindingDescriptions()
+	Streams split(const Mesh &mesh);
+
+	///contiguous model space positions, dequantized for Quantized meshes
+	std::vector<glm::vec3> positions(const Mesh &mesh);
+}
+
+#endif //VERTEXSTREAMS_HPP
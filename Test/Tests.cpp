@@ -1,18 +1,51 @@
 #include "Tests.hpp"
 
 #include <assert.h>
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <thread>
 #include <Source/Resources/Vector.hpp>
 
 #include "Source/Core/ECS/ECS.hpp"
 #include "Source/Core/DataStorage/SparseSet.hpp"
+#include "Source/Core/DataStorage/TlsfAllocator.hpp"
 #include "Source/Core/Messaging/Event.hpp"
 #include "Source/Core/Messaging/Lambda.hpp"
+#include "Source/Core/Jobs/ThreadPool.hpp"
+#include "Source/Resources/AssetPackage.hpp"
+#include "Source/Resources/AssetCache.hpp"
+#include "Source/Resources/AssetServer.hpp"
+#include "Source/Resources/ContentHash.hpp"
+#include "Source/Resources/MeshOptimizer.hpp"
+#include "Source/Resources/MeshSimplifier.hpp"
+#include "Source/Resources/MeshletBuilder.hpp"
+#include "Source/Resources/StaticBatcher.hpp"
+#include "Source/Resources/VertexQuantizer.hpp"
+#include "Source/Resources/VertexStreams.hpp"
+#include "Source/Graphics/DirtyRanges.hpp"
+#include "Source/Graphics/DrawBatching.hpp"
+#include "Source/Graphics/FrustumCulling.hpp"
+#include "Source/Graphics/LodSelection.hpp"
+#include "Source/Graphics/OcclusionBuffer.hpp"
+#include "Source/Graphics/MeshletCulling.hpp"
+#include "Source/Graphics/FrameCapture.hpp"
+#include "Source/Resources/TextureProcessing.hpp"
+#include "Source/Resources/TextureCompression.hpp"
+#include "Source/Resources/GltfImporter.hpp"
+#include "Source/Resources/VertexConversion.hpp"
+#include "Source/Resources/ImportProfiler.hpp"
+#include "Source/IdGen.hpp"
 
 void Test::testAll() {
 	std::cout << "---Test All---\n";
 
 	testECS();
 	testMessaging();
+	testJobs();
+	testResources();
 
 	std::cout << "---Success---\n";
 }
@@ -678,3 +711,1620 @@ void Test::testLambdaPerformance() {
 	a = 0;
 }
 
+
+void Test::testJobs() {
+	testThreadPoolSubmit();
+	testThreadPoolParallelFor();
+}
+
+void Test::testThreadPoolSubmit() {
+	ThreadPool pool(4);
+
+	std::vector<std::future<int>> results;
+	for (int i = 0; i < 100; i++) {
+		results.push_back(pool.submit([i] { return i * i; }));
+	}
+
+	for (int i = 0; i < 100; i++) {
+		assert(results[i].get() == i * i);
+	}
+
+	//exceptions are carried through the future
+	auto failed = pool.submit([]() -> int { throw std::runtime_error("Boop"); });
+	bool caught = false;
+	try {
+		failed.get();
+	} catch (const std::runtime_error &) {
+		caught = true;
+	}
+	assert(caught);
+}
+
+void Test::testThreadPoolParallelFor() {
+	ThreadPool pool(4);
+
+	std::vector<uint32_t> values(10000, 0);
+	pool.parallelFor(values.size(), [&values](uint32_t i) {
+		values[i] += i;
+	});
+
+	for (uint32_t i = 0; i < values.size(); i++) {
+		assert(values[i] == i);
+	}
+
+	//empty and single element ranges
+	int calls = 0;
+	pool.parallelFor(0, [&calls](uint32_t) { calls++; });
+	pool.parallelFor(1, [&calls](uint32_t) { calls++; });
+	assert(calls == 1);
+
+	bool caught = false;
+	try {
+		pool.parallelFor(100, [](uint32_t i) {
+			if (i == 50) throw std::runtime_error("Bonk");
+		});
+	} catch (const std::runtime_error &) {
+		caught = true;
+	}
+	assert(caught);
+}
+
+void Test::testResources() {
+	testTextureMipChain();
+	testTextureMipFiltering();
+	testTextureCompression();
+	testPixelPool();
+	testGltfImport();
+	testVertexConversion();
+	testImportProfiler();
+	testAssetPackageRoundTrip();
+	testContentHash();
+	testAssetContentIDs();
+	testAssetCacheReuse();
+	testAssetServer();
+	testMeshOptimizer();
+	testMeshSimplifier();
+	testLodSelection();
+	testVertexQuantization();
+	testVertexStreams();
+	testMeshletBuilder();
+	testMeshletCulling();
+	testStaticBatching();
+	testFrameCapture();
+	testTlsfAllocator();
+	testDirtyRanges();
+	testDrawBatching();
+	testFrustumCulling();
+	testOcclusionBuffer();
+}
+
+void Test::testTextureMipChain() {
+	//4x2 image, every texel of the left half is 0 and the right half 200
+	std::vector<uint8_t> pixels(4 * 2 * 4);
+	for (uint32_t y = 0; y < 2; y++) {
+		for (uint32_t x = 0; x < 4; x++) {
+			for (uint32_t c = 0; c < 4; c++) {
+				pixels[(y * 4 + x) * 4 + c] = x < 2 ? 0 : 200;
+			}
+		}
+	}
+
+	std::vector<uint64_t> mipOffsets;
+	std::vector<uint8_t> chain = TextureProcessing::generateMipChain(pixels.data(), 4, 2, mipOffsets);
+
+	assert(TextureProcessing::mipLevelCount(4, 2) == 3);
+	assert(mipOffsets.size() == 3);
+	assert(mipOffsets[0] == 0 && mipOffsets[1] == 32 && mipOffsets[2] == 40);
+	assert(chain.size() == 44);
+
+	//2x1 level keeps the halves apart, 1x1 level averages them
+	assert(chain[mipOffsets[1]] == 0);
+	assert(chain[mipOffsets[1] + 4] == 200);
+	assert(chain[mipOffsets[2]] == 100);
+}
+
+void Test::testTextureMipFiltering() {
+	for (uint32_t value = 0; value < 256; value++) {
+		assert(TextureProcessing::linearToSrgb(TextureProcessing::srgbToLinear(value)) == value);
+	}
+
+	//black and white average to mid grey in linear light, which is 188 in sRGB, alpha stays linear
+	std::vector<uint8_t> pixels = {0, 0, 0, 0, 255, 255, 255, 255};
+	std::vector<uint64_t> mipOffsets;
+	std::vector<uint8_t> chain = TextureProcessing::generateMipChain(pixels.data(), 2, 1, mipOffsets, {.srgb = true});
+	assert(chain[mipOffsets[1]] == 188);
+	assert(chain[mipOffsets[1] + 3] == 128);
+
+	//the Kaiser weights sum to one, so a flat image stays flat down the chain
+	std::vector<uint8_t> flat(16 * 8 * 4, 90);
+	TextureProcessing::MipSettings kaiser{TextureProcessing::MipFilter::Kaiser, true};
+	chain = TextureProcessing::generateMipChain(flat.data(), 16, 8, mipOffsets, kaiser);
+	assert(mipOffsets.size() == 5);
+	assert(std::all_of(chain.begin(), chain.end(), [](uint8_t value) { return value == 90; }));
+
+	//rows filtered on the pool match the serial result
+	for (uint32_t i = 0; i < flat.size(); i++) flat[i] = (i * 37) % 251;
+
+	ThreadPool pool(4);
+	std::vector<uint64_t> pooledOffsets;
+	std::vector<uint8_t> serial = TextureProcessing::generateMipChain(flat.data(), 16, 8, mipOffsets, kaiser);
+	std::vector<uint8_t> pooled = TextureProcessing::generateMipChain(flat.data(), 16, 8, pooledOffsets, kaiser, &pool);
+	assert(serial == pooled);
+	assert(mipOffsets == pooledOffsets);
+}
+
+void Test::testTextureCompression() {
+	auto decodeBC1 = [](const uint8_t *block, uint8_t out[16][4]) {
+		uint16_t color0 = block[0] | block[1] << 8;
+		uint16_t color1 = block[2] | block[3] << 8;
+
+		int palette[4][3];
+		for (uint32_t e = 0; e < 2; e++) {
+			uint16_t color = e == 0 ? color0 : color1;
+			int r = color >> 11, g = (color >> 5) & 63, b = color & 31;
+			palette[e][0] = r << 3 | r >> 2;
+			palette[e][1] = g << 2 | g >> 4;
+			palette[e][2] = b << 3 | b >> 2;
+		}
+		for (uint32_t c = 0; c < 3; c++) {
+			palette[2][c] = color0 > color1 ? (2 * palette[0][c] + palette[1][c]) / 3 : (palette[0][c] + palette[1][c]) / 2;
+			palette[3][c] = color0 > color1 ? (palette[0][c] + 2 * palette[1][c]) / 3 : 0;
+		}
+
+		uint32_t indices = block[4] | block[5] << 8 | block[6] << 16 | static_cast<uint32_t>(block[7]) << 24;
+		for (uint32_t i = 0; i < 16; i++) {
+			for (uint32_t c = 0; c < 3; c++) out[i][c] = palette[(indices >> (i * 2)) & 3][c];
+			out[i][3] = 255;
+		}
+	};
+
+	auto decodeBC7 = [](const uint8_t *block, uint8_t out[16][4]) {
+		uint32_t position = 0;
+		auto read = [&](uint32_t bits) {
+			uint32_t value = 0;
+			for (uint32_t i = 0; i < bits; i++, position++) value |= ((block[position >> 3] >> (position & 7)) & 1) << i;
+			return value;
+		};
+
+		//mode 6 is six zero bits followed by a one
+		assert(read(7) == 1 << 6);
+
+		int endpoints[2][4];
+		for (uint32_t c = 0; c < 4; c++) {
+			endpoints[0][c] = read(7) << 1;
+			endpoints[1][c] = read(7) << 1;
+		}
+		uint32_t p0 = read(1), p1 = read(1);
+		for (uint32_t c = 0; c < 4; c++) {
+			endpoints[0][c] |= p0;
+			endpoints[1][c] |= p1;
+		}
+
+		const int weights[16] = {0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64};
+		for (uint32_t i = 0; i < 16; i++) {
+			uint32_t index = read(i == 0 ? 3 : 4);
+			for (uint32_t c = 0; c < 4; c++) {
+				out[i][c] = ((64 - weights[index]) * endpoints[0][c] + weights[index] * endpoints[1][c] + 32) >> 6;
+			}
+		}
+	};
+
+	assert(TextureCompression::blockBytes(TextureFormat::RGBA8) == 0);
+	assert(TextureCompression::levelSize(TextureFormat::RGBA8, 4, 4) == 64);
+	assert(TextureCompression::levelSize(TextureFormat::BC1, 5, 3) == 16);
+	assert(TextureCompression::levelSize(TextureFormat::BC7, 1, 1) == 16);
+
+	uint8_t rgba[64];
+	uint8_t block[16];
+	uint8_t decoded[16][4];
+
+	//a flat color whose channels share a parity is exact in BC7 mode 6
+	for (uint32_t i = 0; i < 16; i++) {
+		rgba[i * 4 + 0] = 10;
+		rgba[i * 4 + 1] = 200;
+		rgba[i * 4 + 2] = 76;
+		rgba[i * 4 + 3] = 128;
+	}
+	TextureCompression::encodeBC7(rgba, block);
+	decodeBC7(block, decoded);
+	for (uint32_t i = 0; i < 16; i++) assert(std::memcmp(decoded[i], rgba + i * 4, 4) == 0);
+
+	//16 step grey ramp stays within a few levels, the anchor texel is the bright end
+	for (uint32_t i = 0; i < 16; i++) {
+		uint8_t grey = (15 - i) * 17;
+		rgba[i * 4 + 0] = rgba[i * 4 + 1] = rgba[i * 4 + 2] = grey;
+		rgba[i * 4 + 3] = 255;
+	}
+	TextureCompression::encodeBC7(rgba, block);
+	decodeBC7(block, decoded);
+	for (uint32_t i = 0; i < 16; i++) {
+		for (uint32_t c = 0; c < 4; c++) assert(std::abs(decoded[i][c] - rgba[i * 4 + c]) <= 4);
+	}
+
+	//two colors that 565 holds exactly decode without loss in BC1
+	for (uint32_t i = 0; i < 16; i++) {
+		bool red = (i / 4 + i) % 2 == 0;
+		rgba[i * 4 + 0] = red ? 255 : 0;
+		rgba[i * 4 + 1] = 0;
+		rgba[i * 4 + 2] = red ? 0 : 255;
+		rgba[i * 4 + 3] = 255;
+	}
+	TextureCompression::encodeBC1(rgba, block);
+	decodeBC1(block, decoded);
+	for (uint32_t i = 0; i < 16; i++) assert(std::memcmp(decoded[i], rgba + i * 4, 4) == 0);
+
+	//BC4 stores max then min and every value lands within half a palette step
+	uint8_t values[16];
+	for (uint32_t i = 0; i < 16; i++) values[i] = i * 17;
+	TextureCompression::encodeBC4(values, 1, block);
+	assert(block[0] == 255 && block[1] == 0);
+
+	uint64_t bits = 0;
+	for (uint32_t i = 0; i < 6; i++) bits |= static_cast<uint64_t>(block[2 + i]) << (i * 8);
+	for (uint32_t i = 0; i < 16; i++) {
+		uint32_t index = (bits >> (i * 3)) & 7;
+		float value = index == 0 ? 255.0f : index == 1 ? 0.0f : (8 - index) * 255.0f / 7.0f;
+		assert(std::abs(value - values[i]) <= 255.0f / 14.0f + 0.5f);
+	}
+
+	//BC5 is BC4 of red followed by BC4 of green
+	for (uint32_t i = 0; i < 16; i++) {
+		rgba[i * 4 + 0] = values[i];
+		rgba[i * 4 + 1] = 255 - values[i];
+	}
+	uint8_t channel[8];
+	TextureCompression::encodeBC5(rgba, block);
+	TextureCompression::encodeBC4(rgba + 1, 4, channel);
+	assert(std::memcmp(block + 8, channel, 8) == 0);
+	//and holds linear data, its mips are not filtered through the sRGB curve
+	assert(!isSrgbFormat(TextureFormat::BC5) && isSrgbFormat(TextureFormat::BC7) && isSrgbFormat(TextureFormat::RGBA8));
+
+	//6x6 base level has partial blocks, its levels are 2x2, 1x1 and 1x1 blocks
+	std::vector<uint8_t> pixels(6 * 6 * 4);
+	for (uint32_t i = 0; i < pixels.size(); i += 4) {
+		pixels[i + 0] = 40;
+		pixels[i + 1] = 120;
+		pixels[i + 2] = 220;
+		pixels[i + 3] = 64;
+	}
+
+	std::vector<uint64_t> mipOffsets, compressedOffsets, pooledOffsets;
+	std::vector<uint8_t> chain = TextureProcessing::generateMipChain(pixels.data(), 6, 6, mipOffsets);
+	std::vector<uint8_t> compressed = TextureCompression::compressMipChain(chain.data(), 6, 6, mipOffsets, TextureFormat::BC7, compressedOffsets);
+
+	assert(compressedOffsets.size() == 3);
+	assert(compressedOffsets[0] == 0 && compressedOffsets[1] == 64 && compressedOffsets[2] == 80);
+	assert(compressed.size() == 96);
+
+	for (uint32_t offset = 0; offset < compressed.size(); offset += 16) {
+		decodeBC7(compressed.data() + offset, decoded);
+		for (uint32_t i = 0; i < 16; i++) assert(std::memcmp(decoded[i], pixels.data(), 4) == 0);
+	}
+
+	ThreadPool pool(4);
+	assert(TextureCompression::compressMipChain(chain.data(), 6, 6, mipOffsets, TextureFormat::BC7, pooledOffsets, &pool) == compressed);
+	assert(pooledOffsets == compressedOffsets);
+
+	compressed = TextureCompression::compressMipChain(chain.data(), 6, 6, mipOffsets, TextureFormat::BC1, compressedOffsets);
+	assert(compressed.size() == 48);
+	assert(compressedOffsets[1] == 32 && compressedOffsets[2] == 40);
+}
+
+void Test::testPixelPool() {
+	auto pool = std::make_shared<PixelPool>(1024);
+
+	//a released block is handed out again for any size in its power of two class
+	PixelBuffer first = pool->allocate(100);
+	assert(first.size() == 100 && first.data());
+	std::memset(first.data(), 1, first.size());
+	const uint8_t *block = first.data();
+
+	first.release();
+	assert(first.empty() && !first.data());
+	assert(pool->getStats().retainedBytes == 128);
+
+	PixelBuffer second = pool->allocate(120);
+	assert(second.data() == block);
+	assert(pool->getStats().reuses == 1);
+	assert(pool->getStats().retainedBytes == 0);
+
+	PixelBuffer moved = std::move(second);
+	assert(second.empty() && moved.data() == block);
+
+	//blocks past the retention limit are freed instead of kept
+	pool->allocate(2000).release();
+	assert(pool->getStats().retainedBytes == 0);
+
+	//every copy of a texture shares its pixels, the block returns once the last copy lets go
+	Texture texture{};
+	texture.adopt(std::move(moved));
+	assert(texture.pixels == block && texture.byteSize == 120);
+
+	Texture copy = texture;
+	texture.releasePixels();
+	assert(!texture.pixels && pool->getStats().retainedBytes == 0);
+	assert(copy.pixels[0] == 1);
+
+	copy.releasePixels();
+	assert(pool->getStats().retainedBytes == 128);
+
+	pool->trim();
+	assert(pool->getStats().retainedBytes == 0);
+
+	//exact blocks keep their size and are freed rather than retained
+	PixelBuffer exact = pool->allocateExact(100);
+	assert(exact.size() == 100 && exact.data());
+	exact.release();
+	assert(pool->getStats().retainedBytes == 0);
+
+	//a buffer can outlive its pool
+	PixelBuffer orphan = pool->allocate(16);
+	pool.reset();
+	orphan.release();
+}
+
+void Test::testGltfImport() {
+	std::filesystem::path path = std::filesystem::temp_directory_path() / "skadi_test_import.glb";
+
+	//mesh 0 has separate position, uv and uint16 index streams, mesh 1 is interleaved exactly like Vertex
+	const glm::vec3 positions[3] = {{0, 0, 0}, {1, 0, 0}, {0, 1, 0}};
+	const glm::vec2 texCoords[3] = {{0, 0}, {1, 0}, {0, 1}};
+	const uint16_t shortIndices[4] = {0, 1, 2, 0};
+	Vertex interleaved[3]{};
+	for (uint32_t i = 0; i < 3; i++) {
+		interleaved[i].pos = positions[i] * 3.0f;
+		interleaved[i].color = glm::vec3(0.25f * i);
+		interleaved[i].texCoord = texCoords[i];
+	}
+	const uint32_t intIndices[3] = {2, 1, 0};
+
+	std::vector<uint8_t> bin(176);
+	std::memcpy(bin.data(), positions, 36);
+	std::memcpy(bin.data() + 36, texCoords, 24);
+	std::memcpy(bin.data() + 60, shortIndices, 6);
+	std::memcpy(bin.data() + 68, interleaved, 96);
+	std::memcpy(bin.data() + 164, intIndices, 12);
+
+	//node 0 moves its children, node 1 scales mesh 0 and node 2 turns mesh 1 a quarter around z, node 3 is not in the scene
+	std::string json = R"({"asset":{"version":"2.0"},"scene":0,"scenes":[{"nodes":[0]}],
+		"nodes":[{"translation":[1,2,3],"children":[1,2]},{"scale":[2,2,2],"mesh":0,"extras":{"occluder":true}},{"rotation":[0,0,0.70710678,0.70710678],"mesh":1},{"mesh":0}],
+		"meshes":[{"primitives":[{"attributes":{"POSITION":0,"TEXCOORD_0":1},"indices":2}]},{"primitives":[{"attributes":{"POSITION":3,"COLOR_0":4,"TEXCOORD_0":5},"indices":6}]}],
+		"buffers":[{"byteLength":176}],
+		"bufferViews":[{"buffer":0,"byteOffset":0,"byteLength":36},{"buffer":0,"byteOffset":36,"byteLength":24},{"buffer":0,"byteOffset":60,"byteLength":6},
+			{"buffer":0,"byteOffset":68,"byteLength":96,"byteStride":32},{"buffer":0,"byteOffset":164,"byteLength":12}],
+		"accessors":[{"bufferView":0,"componentType":5126,"count":3,"type":"VEC3"},{"bufferView":1,"componentType":5126,"count":3,"type":"VEC2"},
+			{"bufferView":2,"componentType":5123,"count":3,"type":"SCALAR"},{"bufferView":3,"byteOffset":0,"componentType":5126,"count":3,"type":"VEC3"},
+			{"bufferView":3,"byteOffset":12,"componentType":5126,"count":3,"type":"VEC3"},{"bufferView":3,"byteOffset":24,"componentType":5126,"count":3,"type":"VEC2"},
+			{"bufferView":4,"componentType":5125,"count":3,"type":"SCALAR"}]})";
+	while (json.size() % 4 != 0) json += ' ';
+
+	auto writeU32 = [](std::ofstream &out, uint32_t value) {
+		out.write(reinterpret_cast<const char *>(&value), sizeof(value));
+	};
+
+	{
+		std::ofstream out(path, std::ios::binary);
+		writeU32(out, 0x46546C67);
+		writeU32(out, 2);
+		writeU32(out, 12 + 8 + json.size() + 8 + bin.size());
+		writeU32(out, json.size());
+		writeU32(out, 0x4E4F534A);
+		out.write(json.data(), json.size());
+		writeU32(out, bin.size());
+		writeU32(out, 0x004E4942);
+		out.write(reinterpret_cast<const char *>(bin.data()), bin.size());
+	}
+
+	assert(GltfImporter::isGltf(path));
+	assert(!GltfImporter::isGltf("model.fbx"));
+
+	tinygltf::Model model = GltfImporter::parse(path);
+	std::vector<GltfImporter::PrimitiveTask> tasks = GltfImporter::collectPrimitives(model);
+	assert(tasks.size() == 2);
+
+	//parent translation times child scale
+	assert(tasks[0].transform[0][0] == 2.0f && tasks[0].transform[1][1] == 2.0f);
+	assert(tasks[0].transform[3] == glm::vec4(1, 2, 3, 1));
+
+	//the rotated x axis points along y
+	assert(std::abs(tasks[1].transform[0][0]) < 1e-5f && std::abs(tasks[1].transform[0][1] - 1.0f) < 1e-5f);
+	assert(tasks[1].transform[3] == glm::vec4(1, 2, 3, 1));
+
+	//node 1 is marked through its extras, the name convention works on node and mesh names
+	assert(tasks[0].occluder && !tasks[1].occluder);
+	assert(Mesh::isOccluderName("wall_occluder") && !Mesh::isOccluderName("occluder_wall"));
+
+	Mesh separate = GltfImporter::convertPrimitive(model, tasks[0]);
+	assert(separate.vertices.size() == 3);
+	assert(separate.vertices[1].pos == glm::vec3(1, 0, 0));
+	assert(separate.vertices[2].texCoord == glm::vec2(0, 1));
+	assert(separate.vertices[0].color == glm::vec3(1, 1, 1));
+	assert((separate.indices == std::vector<uint32_t>{0, 1, 2}));
+	assert(separate.bounds.max == glm::vec3(1, 1, 0));
+	assert(separate.transform == tasks[0].transform);
+	assert(separate.occluder);
+
+	Mesh matching = GltfImporter::convertPrimitive(model, tasks[1]);
+	assert(matching.vertices.size() == 3);
+	assert(std::memcmp(matching.vertices.data(), interleaved, sizeof(interleaved)) == 0);
+	assert((matching.indices == std::vector<uint32_t>{2, 1, 0}));
+
+	//a short color stream rules out the whole Vertex copy and is rejected instead of read past
+	model.accessors[4].count = 2;
+	bool threw = false;
+	try {
+		GltfImporter::convertPrimitive(model, tasks[1]);
+	} catch (const std::runtime_error &) {
+		threw = true;
+	}
+	assert(threw);
+
+	std::filesystem::remove(path);
+}
+
+void Test::testVertexConversion() {
+	//laid out like assimp, 3d texture coordinates and rgba colors, 7 vertices leave a tail past the groups of four
+	const uint32_t count = 7;
+	std::vector<glm::vec3> positions, texCoords;
+	std::vector<glm::vec4> colors;
+	for (uint32_t i = 0; i < count; i++) {
+		positions.emplace_back(i * 1.5f - 4.0f, std::sin(float(i)) * 3.0f, i == 5 ? 9.0f : -float(i));
+		texCoords.emplace_back(i * 0.1f, 1.0f - i * 0.1f, 7.0f);
+		colors.emplace_back(i / 7.0f, 0.5f, 1.0f - i / 7.0f, 0.25f);
+	}
+
+	std::vector<Vertex> vertices(count);
+	Bounds bounds = VertexConversion::convert({positions.data(), sizeof(glm::vec3)}, {colors.data(), sizeof(glm::vec4)},
+		{texCoords.data(), sizeof(glm::vec3)}, vertices);
+
+	for (uint32_t i = 0; i < count; i++) {
+		assert(vertices[i].pos == positions[i]);
+		assert(vertices[i].color == glm::vec3(colors[i]));
+		assert(vertices[i].texCoord == glm::vec2(texCoords[i].x, texCoords[i].y));
+	}
+
+	Bounds expected = Bounds::fromVertices(vertices);
+	assert(bounds.min == expected.min && bounds.max == expected.max && bounds.center == expected.center);
+	assert(std::abs(bounds.radius - expected.radius) < 1e-5f);
+	assert(bounds.max.z == 9.0f && bounds.min.x == -4.0f);
+
+	//missing streams keep the defaults
+	std::vector<Vertex> plain(count);
+	VertexConversion::convert({positions.data(), sizeof(glm::vec3)}, {}, {}, plain);
+	for (uint32_t i = 0; i < count; i++) {
+		assert(plain[i].pos == positions[i]);
+		assert(plain[i].color == glm::vec3(1.0f));
+		assert(plain[i].texCoord == glm::vec2(0.0f));
+	}
+
+	Bounds recomputed = VertexConversion::computeBounds(vertices);
+	assert(recomputed.min == expected.min && recomputed.max == expected.max);
+	assert(std::abs(recomputed.radius - expected.radius) < 1e-5f);
+
+	assert(VertexConversion::computeBounds({}).radius == 0.0f);
+}
+
+void Test::testImportProfiler() {
+	ImportProfiler profiler("models/\"quoted\".fbx");
+
+	//stages recorded from several threads at once
+	ThreadPool pool(4);
+	pool.parallelFor(16, [&profiler](uint32_t i) {
+		ImportProfiler::Scope scope(&profiler, "convert");
+		profiler.add("triangles", i);
+	});
+
+	{
+		ImportProfiler::Scope scope(&profiler, "read");
+		profiler.add("bytesRead", 4096);
+		profiler.sampleMemory();
+	}
+
+	//a null profiler makes scopes free to leave in place
+	{
+		ImportProfiler::Scope scope(nullptr, "ignored");
+	}
+
+	std::map<std::string, ImportProfiler::StageStats> stages = profiler.stages();
+	assert(stages.size() == 2);
+	assert(stages["convert"].calls == 16);
+	assert(stages["read"].calls == 1);
+	assert(stages["convert"].maxMicros <= stages["convert"].totalMicros);
+	assert(profiler.counter("triangles") == 120);
+	assert(profiler.counter("bytesRead") == 4096);
+	assert(profiler.counter("missing") == 0);
+	assert(profiler.peakMemoryBytes() > 0);
+
+	std::string report = profiler.reportJson();
+	assert(report.find("\"source\": \"models/\\\"quoted\\\".fbx\"") != std::string::npos);
+	assert(report.find("\"convert\": {\"calls\": 16") != std::string::npos);
+	assert(report.find("\"bytesRead\": 4096") != std::string::npos);
+	assert(report.find("\"peakMemoryBytes\"") != std::string::npos);
+
+	std::string trace = profiler.traceJson();
+	size_t completeEvents = 0;
+	for (size_t at = trace.find("\"ph\": \"X\""); at != std::string::npos; at = trace.find("\"ph\": \"X\"", at + 1)) completeEvents++;
+	assert(completeEvents == 17);
+	assert(trace.find("\"ph\": \"C\"") != std::string::npos);
+
+	std::filesystem::path tracePath = std::filesystem::temp_directory_path() / "skadi_test_import_trace.json";
+	profiler.writeTrace(tracePath);
+	std::ifstream traceFile(tracePath);
+	std::string written((std::istreambuf_iterator<char>(traceFile)), std::istreambuf_iterator<char>());
+	assert(written == trace);
+	std::filesystem::remove(tracePath);
+}
+
+void Test::testAssetPackageRoundTrip() {
+	std::filesystem::path path = std::filesystem::temp_directory_path() / "skadi_test_package.skpkg";
+
+	Mesh mesh{};
+	mesh.id = IDGen::genID();
+	mesh.transform = glm::mat4(2.0f);
+	mesh.vertices.resize(3);
+	mesh.vertices[1].pos = glm::vec3(1.0f, 2.0f, 3.0f);
+	mesh.vertices[2].texCoord = glm::vec2(0.5f, 0.25f);
+	mesh.indices = {0, 1, 2};
+	mesh.occluder = true;
+
+	std::vector<uint8_t> pixels(8 * 8 * 4, 77);
+	Texture texture{};
+	texture.id = IDGen::genID();
+	texture.pixels = pixels.data();
+	texture.width = 8;
+	texture.height = 8;
+	texture.channels = 4;
+	texture.byteSize = pixels.size();
+	texture.mipLevels = 4;
+
+	Material material{};
+	material.id = IDGen::genID();
+	material.textures["diffuse.png"] = texture;
+	mesh.materialID = material.id;
+
+	Material sharedMaterial{};
+	sharedMaterial.id = IDGen::genID();
+	sharedMaterial.textures["diffuse.png"] = texture;
+
+	AssetPackage::write(path, {mesh}, {material, sharedMaterial});
+
+	{
+		auto [meshes, materials] = AssetPackage::load(path);
+		assert(meshes.size() == 1 && materials.size() == 2);
+
+		const Mesh &loaded = meshes[0];
+		assert(loaded.id == mesh.id);
+		assert(loaded.materialID == material.id);
+		assert(loaded.transform[0][0] == 2.0f);
+		assert(loaded.vertices.empty());
+		assert(loaded.vertexData().size() == 3 && loaded.indexData().size() == 3);
+		assert(loaded.vertexData()[1].pos.y == 2.0f);
+		assert(loaded.vertexData()[2].texCoord.x == 0.5f);
+		assert(loaded.indexData()[2] == 2);
+		assert(loaded.occluder);
+
+		//geometry is used in place and aligned for upload
+		assert(reinterpret_cast<uintptr_t>(loaded.vertexData().data()) % AssetPackage::PACKAGE_ALIGNMENT == 0);
+
+		const Texture &loadedTexture = materials[0].textures.at("diffuse.png");
+		assert(loadedTexture.id == texture.id);
+		assert(loadedTexture.mipLevels == 4 && loadedTexture.mipOffsets.size() == 4);
+		assert(loadedTexture.byteSize == (64 + 16 + 4 + 1) * 4);
+		assert(loadedTexture.pixelSource);
+		assert(loadedTexture.pixels[loadedTexture.mipOffsets[3]] == 77);
+
+		//a texture used by two materials is stored once
+		assert(materials[1].textures.at("diffuse.png").pixels == loadedTexture.pixels);
+	}
+
+	auto rejects = [&path]() {
+		try {
+			AssetPackage::load(path);
+		} catch (const std::runtime_error &) {
+			return true;
+		}
+		return false;
+	};
+
+	//a mip offset past the pixel data is rejected before anything uploads from it
+	{
+		std::vector<uint8_t> bytes(std::filesystem::file_size(path));
+		std::ifstream(path, std::ios::binary).read(reinterpret_cast<char *>(bytes.data()), bytes.size());
+
+		AssetPackage::Header header;
+		std::memcpy(&header, bytes.data(), sizeof(header));
+		AssetPackage::TextureRecord textureRecord;
+		std::memcpy(&textureRecord, bytes.data() + header.textureTableOffset, sizeof(textureRecord));
+		textureRecord.mipOffsets[2] = textureRecord.dataSize;
+		std::memcpy(bytes.data() + header.textureTableOffset, &textureRecord, sizeof(textureRecord));
+
+		std::ofstream(path, std::ios::binary | std::ios::trunc).write(reinterpret_cast<const char *>(bytes.data()), bytes.size());
+		assert(rejects());
+	}
+
+	//so is a level reaching past the mesh's indices
+	mesh.lods = {{0, 3, 0.0f}, {3, 3, 1.0f}};
+	AssetPackage::write(path, {mesh}, {});
+	assert(rejects());
+
+	//anything that is not a package is rejected
+	std::ofstream(path, std::ios::binary | std::ios::trunc) << "definitely not a package";
+	assert(rejects());
+
+	std::filesystem::remove(path);
+}
+
+void Test::testContentHash() {
+	//reference values of 64 bit xxHash
+	assert(ContentHash::hash("", 0) == 0xef46db3751d8e999ULL);
+	assert(ContentHash::hash("Nobody inspects the spammish repetition", 39) == 0xfbcea83c8a378bf1ULL);
+
+	std::vector<uint8_t> data(1000, 3);
+	uint64_t original = ContentHash::hash(data.data(), data.size());
+	assert(ContentHash::hash(data.data(), data.size()) == original);
+	assert(ContentHash::hash(data.data(), data.size(), 1) != original);
+
+	data[999] = 4;
+	assert(ContentHash::hash(data.data(), data.size()) != original);
+
+	assert(ContentHash::toHex(0xab) == "00000000000000ab");
+}
+
+void Test::testAssetContentIDs() {
+	std::vector<uint8_t> pixels(4 * 4 * 4, 9);
+
+	auto makeModel = [&pixels]() {
+		Texture texture{};
+		texture.id = IDGen::genID();
+		texture.pixels = pixels.data();
+		texture.width = 4;
+		texture.height = 4;
+		texture.byteSize = pixels.size();
+
+		Material material{};
+		material.id = IDGen::genID();
+		material.textures["albedo"] = texture;
+
+		Mesh mesh{};
+		mesh.id = IDGen::genID();
+		mesh.materialID = material.id;
+
+		return std::make_tuple(std::vector<Mesh>{mesh, mesh}, std::vector<Material>{material});
+	};
+
+	auto [meshesA, materialsA] = makeModel();
+	auto [meshesB, materialsB] = makeModel();
+	auto [meshesC, materialsC] = makeModel();
+
+	AssetCache::assignContentIDs(1, meshesA, materialsA);
+	AssetCache::assignContentIDs(1, meshesB, materialsB);
+	AssetCache::assignContentIDs(2, meshesC, materialsC);
+
+	//same key gives the same IDs
+	assert(meshesA[0].id == meshesB[0].id);
+	assert(meshesA[0].id != meshesA[1].id);
+	assert(materialsA[0].id == materialsB[0].id);
+	assert(meshesA[0].materialID == materialsA[0].id);
+
+	//different models get their own meshes and materials but share identical textures
+	assert(meshesA[0].id != meshesC[0].id);
+	assert(materialsA[0].id != materialsC[0].id);
+	assert(materialsA[0].textures["albedo"].id == materialsC[0].textures["albedo"].id);
+}
+
+///writes a one triangle package to use as a source asset
+static std::filesystem::path writeTestPackage(const std::string &name, float x) {
+	std::filesystem::path path = std::filesystem::temp_directory_path() / name;
+
+	Mesh mesh{};
+	mesh.id = IDGen::genID();
+	mesh.transform = glm::mat4(1.0f);
+	mesh.vertices.resize(3);
+	mesh.vertices[0].pos.x = x;
+	mesh.indices = {0, 1, 2};
+
+	AssetPackage::write(path, {mesh}, {});
+	return path;
+}
+
+void Test::testAssetCacheReuse() {
+	std::filesystem::path cacheDirectory = std::filesystem::temp_directory_path() / "skadi_test_cache";
+	std::filesystem::remove_all(cacheDirectory);
+
+	std::filesystem::path first = writeTestPackage("skadi_cache_a.skpkg", 1.0f);
+	std::filesystem::path copy = std::filesystem::temp_directory_path() / "skadi_cache_b.skpkg";
+	std::filesystem::copy_file(first, copy, std::filesystem::copy_options::overwrite_existing);
+
+	Loader loader(1);
+	uuids::uuid meshID;
+
+	{
+		AssetCache cache(cacheDirectory, loader);
+
+		auto [meshes, materials] = cache.load(first);
+		auto [again, againMaterials] = cache.load(first);
+		meshID = meshes[0].id;
+
+		//a second placement draws the same data under its own mesh ID
+		assert(again[0].id != meshID);
+		assert(again[0].vertexData().data() == meshes[0].vertexData().data());
+		assert(cache.getStats().imports == 1);
+		assert(cache.getStats().memoryHits == 1);
+
+		//identical contents under another name share the cooked entry
+		auto [copied, copiedMaterials] = cache.load(copy);
+		assert(copied[0].id != meshID && copied[0].id != again[0].id);
+		assert(copied[0].vertexData().data() == meshes[0].vertexData().data());
+		assert(cache.getStats().memoryHits == 2);
+	}
+
+	{
+		//a fresh cache finds the cooked package on disk and keeps the IDs, loading another model first changes nothing
+		AssetCache cache(cacheDirectory, loader);
+		std::filesystem::path other = writeTestPackage("skadi_cache_c.skpkg", 3.0f);
+		auto [otherMeshes, otherMaterials] = cache.load(other);
+		auto [meshes, materials] = cache.load(first);
+
+		assert(meshes[0].id == meshID);
+		assert(meshes[0].vertexData()[0].pos.x == 1.0f);
+		assert(cache.getStats().diskHits == 1 && cache.getStats().imports == 1);
+		std::filesystem::remove(other);
+	}
+
+	{
+		//threads asking for the same uncooked model wait for one import instead of writing the same file
+		std::filesystem::remove_all(cacheDirectory);
+		AssetCache cache(cacheDirectory, loader);
+
+		std::vector<std::thread> threads;
+		for (int i = 0; i < 4; i++) {
+			threads.emplace_back([&cache, &first] {
+				assert(std::get<0>(cache.load(first))[0].vertexData()[0].pos.x == 1.0f);
+			});
+		}
+		for (std::thread &thread : threads) thread.join();
+
+		assert(cache.getStats().imports == 1 && cache.getStats().memoryHits == 3);
+	}
+
+	std::filesystem::remove_all(cacheDirectory);
+	std::filesystem::remove(first);
+	std::filesystem::remove(copy);
+}
+
+void Test::testAssetServer() {
+	std::filesystem::path cacheDirectory = std::filesystem::temp_directory_path() / "skadi_test_server_cache";
+	std::filesystem::remove_all(cacheDirectory);
+
+	std::filesystem::path near = writeTestPackage("skadi_server_near.skpkg", 1.0f);
+	std::filesystem::path far = writeTestPackage("skadi_server_far.skpkg", 2.0f);
+
+	Loader loader(1);
+	AssetCache cache(cacheDirectory, loader);
+
+	{
+		AssetServer server(cache, 0, 1);
+
+		int callbacks = 0;
+		AssetHandle nearHandle = server.request(near, AssetServer::distancePriority(glm::vec3(0), glm::vec3(1, 0, 0)), [&callbacks](AssetHandle handle) {
+			assert(handle.ready());
+			callbacks++;
+		});
+
+		//asking again hands back the same request
+		AssetHandle sameHandle = server.request(near);
+		nearHandle.wait();
+		assert(sameHandle.ready());
+		assert(std::get<0>(nearHandle.get())[0].vertexData()[0].pos.x == 1.0f);
+
+		//callbacks only run from update
+		assert(callbacks == 0);
+		server.update();
+		assert(callbacks == 1);
+
+		//held handles are never evicted even over budget
+		assert(server.residentBytes() > 0);
+		server.update();
+		assert(server.residentBytes() > 0);
+
+		nearHandle = AssetHandle();
+		sameHandle = AssetHandle();
+		server.update();
+		assert(server.residentBytes() == 0);
+
+		AssetHandle missing = server.request(std::filesystem::temp_directory_path() / "skadi_does_not_exist.skpkg");
+		missing.wait();
+		assert(missing.state() == AssetState::Failed);
+
+		bool caught = false;
+		try {
+			missing.get();
+		} catch (const std::exception &) {
+			caught = true;
+		}
+		assert(caught);
+
+		AssetHandle farHandle = server.request(far, -10.0f);
+		farHandle.cancel();
+		farHandle.wait();
+		assert(farHandle.state() == AssetState::Cancelled || farHandle.state() == AssetState::Ready);
+	}
+
+	std::filesystem::remove_all(cacheDirectory);
+	std::filesystem::remove(near);
+	std::filesystem::remove(far);
+}
+
+void Test::testMeshOptimizer() {
+	//64x64 quad grid with triangles in a scrambled order
+	const uint32_t gridSize = 64;
+	Mesh mesh{};
+
+	for (uint32_t y = 0; y <= gridSize; y++) {
+		for (uint32_t x = 0; x <= gridSize; x++) {
+			Vertex vertex{};
+			vertex.pos = glm::vec3(x, y, 0);
+			mesh.vertices.push_back(vertex);
+		}
+	}
+
+	std::vector<std::array<uint32_t, 3>> triangles;
+	for (uint32_t y = 0; y < gridSize; y++) {
+		for (uint32_t x = 0; x < gridSize; x++) {
+			uint32_t corner = y * (gridSize + 1) + x;
+			triangles.push_back({corner, corner + 1, corner + gridSize + 1});
+			triangles.push_back({corner + 1, corner + gridSize + 2, corner + gridSize + 1});
+		}
+	}
+
+	for (uint32_t i = 0; i < triangles.size(); i++) {
+		std::swap(triangles[i], triangles[(i * 7919) % triangles.size()]);
+	}
+	for (const auto &triangle : triangles) {
+		mesh.indices.insert(mesh.indices.end(), triangle.begin(), triangle.end());
+	}
+
+	//an unused vertex is dropped by the fetch pass
+	mesh.vertices.push_back(Vertex{});
+
+	auto trianglePositions = [](const Mesh &mesh) {
+		std::vector<std::array<float, 6>> positions;
+		for (uint32_t i = 0; i < mesh.indices.size(); i += 3) {
+			std::array<float, 6> triangle{};
+			for (uint32_t k = 0; k < 3; k++) {
+				triangle[k * 2] = mesh.vertices[mesh.indices[i + k]].pos.x;
+				triangle[k * 2 + 1] = mesh.vertices[mesh.indices[i + k]].pos.y;
+			}
+			positions.push_back(triangle);
+		}
+		std::sort(positions.begin(), positions.end());
+		return positions;
+	};
+
+	auto before = trianglePositions(mesh);
+	MeshOptimizer::Stats stats = MeshOptimizer::optimize(mesh);
+
+	assert(stats.acmrAfter < stats.acmrBefore);
+	assert(stats.acmrAfter < 1.0f);
+	assert(mesh.vertices.size() == (gridSize + 1) * (gridSize + 1));
+
+	//same triangles with the same winding, only the order changed
+	assert(trianglePositions(mesh) == before);
+
+	//fetch order means every new vertex is the next one in memory
+	uint32_t highest = 0;
+	for (uint32_t index : mesh.indices) {
+		assert(index <= highest + 1);
+		highest = std::max(highest, index);
+	}
+
+	assert(MeshOptimizer::fitsIndex16(65535) && !MeshOptimizer::fitsIndex16(65536));
+	std::vector<uint16_t> narrow = MeshOptimizer::narrowIndices(mesh.indices);
+	assert(narrow.size() == mesh.indices.size() && narrow.back() == mesh.indices.back());
+}
+
+///square grid in the xy plane facing +z, height gives the z of each grid point
+template <typename F>
+static Mesh makeGridMesh(uint32_t gridSize, F height) {
+	Mesh mesh{};
+	mesh.transform = glm::mat4(1.0f);
+
+	for (uint32_t y = 0; y <= gridSize; y++) {
+		for (uint32_t x = 0; x <= gridSize; x++) {
+			Vertex vertex{};
+			vertex.pos = glm::vec3(x, y, height(x, y));
+			mesh.vertices.push_back(vertex);
+		}
+	}
+
+	for (uint32_t y = 0; y < gridSize; y++) {
+		for (uint32_t x = 0; x < gridSize; x++) {
+			uint32_t corner = y * (gridSize + 1) + x;
+			mesh.indices.insert(mesh.indices.end(), {corner, corner + 1, corner + gridSize + 1});
+			mesh.indices.insert(mesh.indices.end(), {corner + 1, corner + gridSize + 2, corner + gridSize + 1});
+		}
+	}
+
+	mesh.bounds = Bounds::fromVertices(mesh.vertices);
+	return mesh;
+}
+
+void Test::testMeshSimplifier() {
+	//a flat grid simplifies without any error and keeps facing the same way
+	Mesh flat = makeGridMesh(32, [](uint32_t, uint32_t) { return 0.0f; });
+
+	float error = -1.0f;
+	std::vector<uint32_t> simplified = MeshSimplifier::simplify(flat.vertices, flat.indices, flat.indices.size() / 4, 1.0f, &error);
+
+	assert(simplified.size() <= flat.indices.size() / 4);
+	assert(simplified.size() % 3 == 0);
+	assert(error < 1e-3f);
+
+	for (uint32_t i = 0; i < simplified.size(); i += 3) {
+		glm::vec3 p0 = flat.vertices[simplified[i]].pos, p1 = flat.vertices[simplified[i + 1]].pos, p2 = flat.vertices[simplified[i + 2]].pos;
+		assert(glm::cross(p1 - p0, p2 - p0).z > 0.0f);
+	}
+
+	//the border is kept so the outline does not shrink
+	auto onBorder = [](const Vertex &vertex) {
+		return vertex.pos.x == 0 || vertex.pos.y == 0 || vertex.pos.x == 32 || vertex.pos.y == 32;
+	};
+	std::vector<bool> used(flat.vertices.size(), false);
+	for (uint32_t index : simplified) used[index] = true;
+	for (uint32_t v = 0; v < flat.vertices.size(); v++) {
+		if (onBorder(flat.vertices[v])) assert(used[v]);
+	}
+
+	//an error budget of zero on a curved surface leaves it untouched
+	Mesh bumpy = makeGridMesh(16, [](uint32_t x, uint32_t y) { return std::sin(x * 0.7f) * std::cos(y * 0.9f); });
+	std::vector<uint32_t> untouched = MeshSimplifier::simplify(bumpy.vertices, bumpy.indices, 0, 0.0f, &error);
+	assert(untouched.size() == bumpy.indices.size());
+
+	MeshSimplifier::generateLods(bumpy, 4, 0.5f);
+	assert(bumpy.lods.size() >= 2);
+	assert(bumpy.lods[0].firstIndex == 0 && bumpy.lods[0].indexCount == 16 * 16 * 6);
+
+	for (uint32_t level = 1; level < bumpy.lods.size(); level++) {
+		const LodLevel &lod = bumpy.lods[level];
+		assert(lod.firstIndex == bumpy.lods[level - 1].firstIndex + bumpy.lods[level - 1].indexCount);
+		assert(lod.indexCount < bumpy.lods[level - 1].indexCount);
+		assert(lod.error >= bumpy.lods[level - 1].error);
+	}
+	assert(bumpy.lods.back().firstIndex + bumpy.lods.back().indexCount == bumpy.indices.size());
+	assert(bumpy.lods.back().error > 0.0f);
+	assert(bumpy.lods.back().error <= bumpy.bounds.radius);
+}
+
+void Test::testLodSelection() {
+	Mesh mesh = makeGridMesh(16, [](uint32_t x, uint32_t y) { return std::sin(x * 0.7f) * std::cos(y * 0.9f); });
+	MeshSimplifier::generateLods(mesh, 4, 0.5f);
+
+	glm::mat4 proj = glm::perspective(glm::radians(60.0f), 1.0f, 0.1f, 100000.0f);
+	uint32_t coarsest = mesh.lods.size() - 1;
+
+	//camera inside the bounds draws the full mesh, far away draws the coarsest level
+	glm::mat4 near = glm::translate(glm::mat4(1.0f), -mesh.bounds.center);
+	glm::mat4 far = glm::translate(glm::mat4(1.0f), glm::vec3(0, 0, -50000.0f) - mesh.bounds.center);
+
+	assert(selectLod(mesh, near, proj, 1080.0f) == 0);
+	assert(selectLod(mesh, far, proj, 1080.0f) == coarsest);
+
+	//a stricter threshold never picks a coarser level
+	glm::mat4 middle = glm::translate(glm::mat4(1.0f), glm::vec3(0, 0, -200.0f) - mesh.bounds.center);
+	assert(selectLod(mesh, middle, proj, 1080.0f, 0.1f) <= selectLod(mesh, middle, proj, 1080.0f, 4.0f));
+
+	assert(mesh.lod(coarsest).indexCount < mesh.lod(0).indexCount);
+	assert(mesh.lod(100).firstIndex == mesh.lods.back().firstIndex);
+}
+
+void Test::testVertexQuantization() {
+	using namespace VertexQuantizer;
+
+	assert(floatToHalf(1.0f) == 0x3c00 && floatToHalf(-2.0f) == 0xc000 && floatToHalf(0.0f) == 0);
+	assert(floatToHalf(65504.0f) == 0x7bff && floatToHalf(1e6f) == 0x7c00);
+	for (float value : {0.5f, 0.25f, 3.0f, -0.125f, 1000.0f, 1.0f / 16777216.0f}) {
+		assert(halfToFloat(floatToHalf(value)) == value);
+	}
+	//rounds to the nearest representable half, texture coordinates in [0, 1] land within 1/2048
+	assert(std::abs(halfToFloat(floatToHalf(0.1f)) - 0.1f) < 1.0f / 2048.0f);
+
+	Mesh mesh = makeGridMesh(8, [](uint32_t x, uint32_t y) { return std::sin(x * 0.7f) * std::cos(y * 0.9f); });
+	for (Vertex &vertex : mesh.vertices) {
+		vertex.texCoord = glm::vec2(vertex.pos.x / 8.0f, vertex.pos.y / 8.0f);
+	}
+	std::vector<Vertex> original = mesh.vertices;
+
+	assert(canQuantize(mesh.vertices));
+	quantize(mesh);
+
+	assert(mesh.layout == VertexLayout::Quantized && mesh.vertices.empty());
+	assert(mesh.vertexCount() == original.size());
+	assert(mesh.vertexBytes().size() == original.size() * sizeof(QuantizedVertex));
+	assert(mesh.vertexBytes().size() * 8 < original.size() * sizeof(Vertex) * 5);
+
+	//what the shader computes from the folded transform has to match the source positions
+	glm::vec3 step = (mesh.bounds.max - mesh.bounds.min) / 65535.0f;
+	for (size_t i = 0; i < original.size(); i++) {
+		const QuantizedVertex &quantized = mesh.quantizedVertices[i];
+		glm::vec4 unorm(quantized.pos[0] / 65535.0f, quantized.pos[1] / 65535.0f, quantized.pos[2] / 65535.0f, 1.0f);
+		glm::vec3 drawn = glm::vec3(mesh.drawTransform() * unorm);
+
+		for (int axis = 0; axis < 3; axis++) {
+			assert(std::abs(drawn[axis] - original[i].pos[axis]) <= step[axis] + 1e-5f);
+			assert(std::abs(dequantizePosition(quantized, mesh.bounds)[axis] - original[i].pos[axis]) <= step[axis] + 1e-5f);
+		}
+		assert(halfToFloat(quantized.texCoord[0]) == original[i].texCoord.x);
+	}
+
+	//vertex colors keep the full layout
+	std::vector<Vertex> colored = original;
+	colored[3].color = glm::vec3(1.0f, 0.0f, 0.0f);
+	assert(!canQuantize(colored));
+
+	//packages keep the layout and serve the quantized data in place
+	mesh.id = IDGen::genID();
+	std::filesystem::path packagePath = std::filesystem::temp_directory_path() / "skadi_test_quantized.skpkg";
+	AssetPackage::write(packagePath, {mesh}, {});
+	{
+		auto [meshes, materials] = AssetPackage::load(packagePath);
+		assert(meshes.size() == 1 && meshes[0].layout == VertexLayout::Quantized);
+		assert(meshes[0].vertexData().empty() && meshes[0].vertexCount() == original.size());
+		assert(std::equal(meshes[0].vertexBytes().begin(), meshes[0].vertexBytes().end(), mesh.vertexBytes().begin()));
+		assert(meshes[0].drawTransform() == mesh.drawTransform());
+	}
+	std::filesystem::remove(packagePath);
+}
+
+void Test::testVertexStreams() {
+	Mesh mesh = makeGridMesh(4, [](uint32_t x, uint32_t y) { return x * 0.5f - y; });
+	for (uint32_t i = 0; i < mesh.vertices.size(); i++) {
+		mesh.vertices[i].texCoord = glm::vec2(i, -1.0f * i);
+	}
+
+	//positions are a third of a full vertex and come first, attributes follow aligned
+	VertexStreams::Streams streams = VertexStreams::split(mesh);
+	assert(streams.positionSize == mesh.vertices.size() * sizeof(glm::vec3));
+	assert(streams.attributeSize == mesh.vertices.size() * (sizeof(Vertex) - sizeof(glm::vec3)));
+	assert(streams.attributeOffset >= streams.positionSize && streams.attributeOffset % 16 == 0);
+
+	auto bindings = Vertex::getBindingDescriptions();
+	auto attributes = Vertex::getAttributeDescriptions();
+	for (uint32_t i = 0; i < mesh.vertices.size(); i++) {
+		glm::vec3 position;
+		glm::vec2 texCoord;
+		std::memcpy(&position, streams.data.data() + i * bindings[0].stride + attributes[0].offset, sizeof(position));
+		std::memcpy(&texCoord, streams.data.data() + streams.attributeOffset + i * bindings[1].stride + attributes[2].offset, sizeof(texCoord));
+		assert(position == mesh.vertices[i].pos && texCoord == mesh.vertices[i].texCoord);
+	}
+
+	std::vector<glm::vec3> positions = VertexStreams::positions(mesh);
+	assert(positions.size() == mesh.vertices.size() && positions[7] == mesh.vertices[7].pos);
+
+	Bounds fromPositions = Bounds::fromPositions(positions);
+	assert(fromPositions.min == mesh.bounds.min && fromPositions.max == mesh.bounds.max && fromPositions.radius == mesh.bounds.radius);
+
+	//quantized meshes split the same way and hand back dequantized positions
+	VertexQuantizer::quantize(mesh);
+	VertexStreams::Streams quantizedStreams = VertexStreams::split(mesh);
+	assert(quantizedStreams.positionSize == mesh.vertexCount() * QuantizedVertex::POSITION_STRIDE);
+	assert(quantizedStreams.attributeOffset + quantizedStreams.attributeSize == quantizedStreams.data.size());
+
+	std::vector<glm::vec3> dequantized = VertexStreams::positions(mesh);
+	for (uint32_t i = 0; i < positions.size(); i++) {
+		assert(glm::length(dequantized[i] - positions[i]) < 1e-3f);
+	}
+}
+
+void Test::testMeshletBuilder() {
+	Mesh mesh = makeGridMesh(32, [](uint32_t, uint32_t) { return 0.0f; });
+
+	//the same triangles come back, only their order changes
+	auto sortedTriangles = [](const std::vector<uint32_t> &indices) {
+		std::vector<std::array<uint32_t, 3>> triangles;
+		for (size_t i = 0; i < indices.size(); i += 3) {
+			std::array<uint32_t, 3> triangle{indices[i], indices[i + 1], indices[i + 2]};
+			std::rotate(triangle.begin(), std::min_element(triangle.begin(), triangle.end()), triangle.end());
+			triangles.push_back(triangle);
+		}
+		std::sort(triangles.begin(), triangles.end());
+		return triangles;
+	};
+	auto before = sortedTriangles(mesh.indices);
+
+	MeshletBuilder::build(mesh);
+	assert(sortedTriangles(mesh.indices) == before);
+	assert(mesh.meshlets.size() >= 32 * 32 * 2 / MeshletBuilder::MAX_TRIANGLES);
+
+	uint32_t nextIndex = 0;
+	for (const Meshlet &meshlet : mesh.meshlets) {
+		assert(meshlet.firstIndex == nextIndex && meshlet.indexCount > 0 && meshlet.indexCount % 3 == 0);
+		assert(meshlet.indexCount / 3 <= MeshletBuilder::MAX_TRIANGLES);
+		nextIndex += meshlet.indexCount;
+
+		std::vector<uint32_t> unique(mesh.indices.begin() + meshlet.firstIndex, mesh.indices.begin() + meshlet.firstIndex + meshlet.indexCount);
+		std::sort(unique.begin(), unique.end());
+		unique.erase(std::unique(unique.begin(), unique.end()), unique.end());
+		assert(unique.size() <= MeshletBuilder::MAX_VERTICES);
+
+		for (uint32_t vertex : unique) {
+			assert(glm::length(mesh.vertices[vertex].pos - meshlet.center) <= meshlet.radius + 1e-4f);
+		}
+
+		//a flat grid facing +z has a zero width cone around +z
+		assert(glm::length(meshlet.coneAxis - glm::vec3(0, 0, 1)) < 1e-5f && meshlet.coneCutoff < 1e-3f);
+	}
+	assert(nextIndex == mesh.indices.size());
+
+	//clusters should be compact, not strips across the whole grid
+	float averageRadius = 0.0f;
+	for (const Meshlet &meshlet : mesh.meshlets) averageRadius += meshlet.radius / mesh.meshlets.size();
+	assert(averageRadius < mesh.bounds.radius / 3.0f);
+
+	//meshlets survive a package round trip
+	mesh.id = IDGen::genID();
+	std::filesystem::path packagePath = std::filesystem::temp_directory_path() / "skadi_test_meshlets.skpkg";
+	AssetPackage::write(packagePath, {mesh}, {});
+	{
+		auto [meshes, materials] = AssetPackage::load(packagePath);
+		assert(meshes[0].meshlets.size() == mesh.meshlets.size());
+		assert(meshes[0].meshlets.back().firstIndex == mesh.meshlets.back().firstIndex);
+		assert(meshes[0].meshlets.back().radius == mesh.meshlets.back().radius);
+	}
+	std::filesystem::remove(packagePath);
+}
+
+void Test::testStaticBatching() {
+	uuids::uuid stone = IDGen::genID(), wood = IDGen::genID();
+
+	//a has two levels and meshlets, b is quantized and scaled, c uses another material
+	Mesh a = makeGridMesh(8, [](uint32_t, uint32_t) { return 0.0f; });
+	a.id = IDGen::genID();
+	a.materialID = stone;
+	MeshSimplifier::generateLods(a, 2, 0.5f);
+	MeshletBuilder::build(a);
+	a.transform = glm::translate(glm::mat4(1.0f), glm::vec3(100, 0, 0));
+	assert(a.lodCount() == 2 && !a.meshlets.empty());
+
+	Mesh b = makeGridMesh(4, [](uint32_t, uint32_t) { return 0.0f; });
+	b.id = IDGen::genID();
+	b.materialID = stone;
+	VertexQuantizer::quantize(b);
+	b.transform = glm::mat4(1.0f);
+	b.transform[0][0] = b.transform[1][1] = b.transform[2][2] = 2.0f;
+
+	Mesh c = makeGridMesh(2, [](uint32_t, uint32_t) { return 0.0f; });
+	c.id = IDGen::genID();
+	c.materialID = wood;
+	c.transform = glm::mat4(1.0f);
+
+	std::vector<Mesh> meshes{a, b, c};
+	std::vector<Mesh> batches = StaticBatcher::batch(meshes);
+	assert(batches.size() == 2);
+	assert(batches[1].id == c.id);
+
+	const Mesh &batch = batches[0];
+	assert(batch.materialID == stone && batch.layout == VertexLayout::Full);
+	assert(batch.transform == glm::mat4(1.0f));
+	assert(batch.vertices.size() == a.vertices.size() + b.vertexCount());
+	assert(batch.vertices[0].pos == a.vertices[0].pos + glm::vec3(100, 0, 0));
+	assert(glm::length(batch.vertices.back().pos - glm::vec3(8, 8, 0)) < 1e-3f);
+	assert(batch.bounds.min.x == 0.0f && batch.bounds.max.x == 108.0f);
+	assert(StaticBatcher::batch(meshes)[0].id == batch.id);
+
+	//level 0 holds both members' full meshes, level 1 a's coarser level and b's only one
+	assert(batch.lods.size() == 2);
+	assert(batch.lods[0].indexCount == a.lod(0).indexCount + b.indices.size());
+	assert(batch.lods[1].indexCount == a.lod(1).indexCount + b.indices.size());
+	assert(batch.lods[1].error == a.lods[1].error);
+
+	assert(batch.subMeshes.size() == 2);
+	const SubMesh &first = batch.subMeshes[0], &second = batch.subMeshes[1];
+	assert(first.sourceID == a.id && first.firstIndex == 0 && first.indexCount == a.lod(0).indexCount);
+	assert(first.meshletCount == a.meshlets.size() && second.meshletCount == 0);
+	assert(second.firstIndex == first.indexCount && second.indexCount == b.indices.size());
+	assert(batch.indices[second.firstIndex] == b.indices[0] + a.vertices.size());
+	assert(glm::length(batch.meshlets[0].center - (a.meshlets[0].center + glm::vec3(100, 0, 0))) < 1e-4f);
+	assert(first.bounds.min.x == 100.0f && second.bounds.max.x == 8.0f);
+
+	//looking at a only, nothing of b is drawn
+	glm::mat4 proj = glm::perspective(glm::radians(60.0f), 1.0f, 0.1f, 1000.0f);
+	glm::mat4 view = glm::translate(glm::mat4(1.0f), -glm::vec3(104, 4, 10));
+	std::vector<DrawRange> ranges;
+	buildDrawRanges(batch, 0, view, proj, ranges);
+	assert(!ranges.empty());
+	for (const DrawRange &range : ranges) {
+		assert(range.firstIndex + range.indexCount <= first.indexCount);
+	}
+
+	//a vertex budget that only fits one member leaves every mesh on its own and unchanged
+	StaticBatcher::Settings tight;
+	tight.maxVertices = a.vertices.size();
+	std::vector<Mesh> unbatched = StaticBatcher::batch(meshes, tight);
+	assert(unbatched.size() == 3);
+	assert(unbatched[0].id == a.id && unbatched[1].id == b.id && unbatched[1].layout == VertexLayout::Quantized);
+
+	//quantized again only when asked and every member was quantized
+	StaticBatcher::Settings quantize;
+	quantize.quantize = true;
+	Mesh b2 = b;
+	b2.id = IDGen::genID();
+	b2.transform = glm::translate(glm::mat4(1.0f), glm::vec3(0, 20, 0));
+	std::vector<Mesh> quantizedMeshes{b, b2};
+	assert(StaticBatcher::batch(quantizedMeshes, quantize)[0].layout == VertexLayout::Quantized);
+	assert(StaticBatcher::batch(meshes, quantize)[0].layout == VertexLayout::Full);
+
+	//occluders only merge with occluders and the batch stays one
+	Mesh a2 = a, b3 = b;
+	a2.id = IDGen::genID();
+	b3.id = IDGen::genID();
+	a2.occluder = b3.occluder = true;
+	std::vector<Mesh> occluderMeshes{a, a2, b, b3};
+	std::vector<Mesh> occluderBatches = StaticBatcher::batch(occluderMeshes);
+	assert(occluderBatches.size() == 2);
+	assert(!occluderBatches[0].occluder && occluderBatches[0].subMeshes[1].sourceID == b.id);
+	assert(occluderBatches[1].occluder && occluderBatches[1].subMeshes[1].sourceID == b3.id);
+}
+
+void Test::testMeshletCulling() {
+	Mesh mesh = makeGridMesh(32, [](uint32_t, uint32_t) { return 0.0f; });
+	MeshletBuilder::build(mesh);
+	uint32_t fullCount = mesh.indices.size();
+
+	glm::mat4 proj = glm::perspective(glm::radians(60.0f), 1.0f, 0.1f, 1000.0f);
+	std::vector<DrawRange> ranges;
+	auto drawnIndices = [&ranges] {
+		uint32_t count = 0;
+		for (const DrawRange &range : ranges) count += range.indexCount;
+		return count;
+	};
+
+	//far in front of the grid, everything is drawn as one merged range
+	glm::mat4 front = glm::translate(glm::mat4(1.0f), -glm::vec3(16, 16, 100));
+	buildDrawRanges(mesh, 0, front, proj, ranges);
+	assert(ranges.size() == 1 && drawnIndices() == fullCount);
+
+	//close in front, only the clusters under the camera survive the frustum
+	glm::mat4 close = glm::translate(glm::mat4(1.0f), -glm::vec3(4, 4, 3));
+	buildDrawRanges(mesh, 0, close, proj, ranges);
+	assert(drawnIndices() > 0 && drawnIndices() < fullCount / 2);
+
+	//behind the grid looking at it, every cluster faces away
+	glm::mat4 behind(1.0f);
+	behind[0][0] = -1.0f;
+	behind[2][2] = -1.0f;
+	behind[3] = glm::vec4(16, -16, -100, 1);
+	assert(glm::length(glm::vec3(glm::inverse(behind)[3]) - glm::vec3(16, 16, -100)) < 1e-3f);
+	buildDrawRanges(mesh, 0, behind, proj, ranges);
+	assert(ranges.empty());
+
+	//looking away from the grid culls the whole mesh
+	glm::mat4 away = glm::translate(glm::mat4(1.0f), -glm::vec3(16, 16, -100));
+	buildDrawRanges(mesh, 0, away, proj, ranges);
+	assert(ranges.empty());
+
+	//coarser levels are drawn whole once the mesh is in view
+	mesh.lods = {{0, fullCount, 0.0f}, {0, 6, 1.0f}};
+	buildDrawRanges(mesh, 1, front, proj, ranges);
+	assert(ranges.size() == 1 && ranges[0].indexCount == 6);
+
+	Frustum frustum = Frustum::fromMatrix(proj);
+	assert(frustum.intersectsSphere(glm::vec3(0, 0, -10), 1.0f));
+	assert(!frustum.intersectsSphere(glm::vec3(0, 0, 10), 1.0f));
+	assert(!frustum.intersectsSphere(glm::vec3(100, 0, -10), 1.0f));
+	assert(frustum.intersectsSphere(glm::vec3(0, 0, -0.05f), 0.1f));
+}
+
+void Test::testFrameCapture() {
+	//3x2 gradient with an alpha that PPM does not keep
+	FrameCapture capture{3, 2, {}};
+	for (uint32_t i = 0; i < 6; i++) {
+		capture.pixels.insert(capture.pixels.end(), {static_cast<uint8_t>(i * 40), static_cast<uint8_t>(255 - i * 40), 7, 128});
+	}
+
+	FrameCapture::Difference same = capture.compare(capture);
+	assert(same.differingPixels == 0 && same.maxChannelDifference == 0);
+
+	std::filesystem::path capturePath = std::filesystem::temp_directory_path() / "skadi_test_capture.ppm";
+	capture.writePPM(capturePath);
+	FrameCapture readBack = FrameCapture::readPPM(capturePath);
+	std::filesystem::remove(capturePath);
+
+	assert(readBack.width == 3 && readBack.height == 2);
+	assert(readBack.pixels.size() == capture.pixels.size());
+	assert(readBack.pixels[3] == 255);
+	assert(readBack.compare(capture).differingPixels == 0);
+
+	//one channel of one pixel off by 5 only counts without enough tolerance
+	readBack.pixels[4 * 4 + 1] += 5;
+	FrameCapture::Difference changed = readBack.compare(capture);
+	assert(changed.differingPixels == 1 && changed.maxChannelDifference == 5);
+	assert(readBack.compare(capture, 5).differingPixels == 0);
+
+	bool threw = false;
+	try {
+		capture.compare(FrameCapture{2, 3, std::vector<uint8_t>(24)});
+	} catch (const std::runtime_error &) {
+		threw = true;
+	}
+	assert(threw);
+}
+
+void Test::testTlsfAllocator() {
+	TlsfAllocator allocator(1000);
+
+	auto a = allocator.allocate(100);
+	auto b = allocator.allocate(200);
+	auto c = allocator.allocate(300);
+	assert(a && b && c);
+	assert(a->offset == 0 && b->offset == 100 && c->offset == 300);
+
+	//a freed hole is reused before the untouched tail
+	allocator.free(*b);
+	auto d = allocator.allocate(150);
+	assert(d && d->offset == 100);
+
+	bool threw = false;
+	try {
+		allocator.free(*b);
+	} catch (const std::runtime_error &) {
+		threw = true;
+	}
+	assert(threw);
+
+	//neighbours merge, so everything freed is one block again
+	allocator.free(*a);
+	allocator.free(*c);
+	allocator.free(*d);
+	TlsfAllocator::Stats stats = allocator.getStats();
+	assert(stats.used == 0 && stats.allocations == 0);
+	assert(stats.freeBlocks == 1 && stats.largestFree == 1000);
+
+	auto whole = allocator.allocate(1000);
+	assert(whole && whole->offset == 0);
+	assert(!allocator.allocate(1));
+
+	//growing keeps existing offsets and appends the new room
+	allocator.grow(1500);
+	auto grown = allocator.allocate(500);
+	assert(grown && grown->offset == 1000);
+	allocator.free(*whole);
+	allocator.free(*grown);
+
+	//aligned allocations skip to the next multiple and leave the skipped units free
+	auto unaligned = allocator.allocate(10);
+	auto aligned = allocator.allocate(100, 256);
+	assert(unaligned && aligned && aligned->offset == 256);
+	auto filler = allocator.allocate(240);
+	assert(filler && filler->offset == 10);
+	allocator.free(*unaligned);
+	allocator.free(*aligned);
+	allocator.free(*filler);
+	assert(allocator.getStats().freeBlocks == 1);
+
+	//random churn never hands out overlapping ranges
+	std::vector<TlsfAllocator::Allocation> live;
+	uint32_t seed = 12345;
+	auto next = [&seed]() {
+		seed = seed * 1664525u + 1013904223u;
+		return seed >> 8;
+	};
+
+	for (uint32_t step = 0; step < 2000; step++) {
+		if (!live.empty() && next() % 3 == 0) {
+			uint32_t index = next() % live.size();
+			allocator.free(live[index]);
+			live.erase(live.begin() + index);
+			continue;
+		}
+
+		auto allocation = allocator.allocate(1 + next() % 40);
+		if (allocation) live.push_back(*allocation);
+	}
+
+	std::sort(live.begin(), live.end(), [](const auto &x, const auto &y) { return x.offset < y.offset; });
+	uint64_t used = 0;
+	for (size_t i = 0; i < live.size(); i++) {
+		used += live[i].size;
+		assert(live[i].offset + live[i].size <= allocator.capacity());
+		if (i > 0) assert(live[i - 1].offset + live[i - 1].size <= live[i].offset);
+	}
+	assert(allocator.getStats().used == used);
+	assert(allocator.getStats().allocations == live.size());
+}
+
+void Test::testDirtyRanges() {
+	//overlapping and touching ranges merge, a gap keeps them apart unless it is within the allowance
+	std::vector<DirtyRanges::Range> merged = DirtyRanges::coalesce({{40, 8}, {0, 16}, {8, 4}, {16, 4}, {60, 0}});
+	assert(merged.size() == 2);
+	assert(merged[0].offset == 0 && merged[0].size == 20);
+	assert(merged[1].offset == 40 && merged[1].size == 8);
+
+	merged = DirtyRanges::coalesce({{0, 16}, {24, 8}}, 8);
+	assert(merged.size() == 1 && merged[0].size == 32);
+
+	//only the changed elements come back, whole elements even when one byte differs
+	std::vector<uint8_t> before(64);
+	for (uint32_t i = 0; i < before.size(); i++) before[i] = i;
+	std::vector<uint8_t> after = before;
+	after[5] = 0xff;
+	after[13] = 0xff;
+	after[50] = 0xff;
+
+	std::vector<DirtyRanges::Range> changed = DirtyRanges::diff(before, after, 8);
+	assert(changed.size() == 2);
+	assert(changed[0].offset == 0 && changed[0].size == 16);
+	assert(changed[1].offset == 48 && changed[1].size == 8);
+
+	assert(DirtyRanges::diff(before, before, 8).empty());
+	assert(DirtyRanges::diff(before, after, 8, 32).size() == 1);
+}
+
+void Test::testDrawBatching() {
+	VkDescriptorSet stone = reinterpret_cast<VkDescriptorSet>(uintptr_t{1});
+	VkDescriptorSet wood = reinterpret_cast<VkDescriptorSet>(uintptr_t{2});
+	auto item = [stone](VkDescriptorSet material, int32_t vertexOffset, float x) {
+		uint64_t sortKey = SortKey::make(0, VertexLayout::Full, material == stone ? 0 : 1, VK_INDEX_TYPE_UINT16, 0, vertexOffset);
+		return DrawItem{sortKey, VertexLayout::Full, material, VK_INDEX_TYPE_UINT16, 0, 36, vertexOffset, glm::translate(glm::mat4(1.0f), glm::vec3(x, 0, 0))};
+	};
+
+	//three rocks and two crates interleaved, plus a rock with a different material
+	std::vector<DrawItem> items = {item(stone, 0, 1), item(wood, 100, 2), item(stone, 0, 3), item(stone, 0, 4), item(wood, 100, 5), item(wood, 0, 6)};
+	InstancedDraws draws;
+	buildInstancedDraws(items, draws);
+
+	assert(draws.transforms.size() == items.size());
+	assert(draws.draws.size() == 3);
+	assert(draws.batches.size() == 2);
+
+	uint32_t instances = 0;
+	for (const DrawBatch &batch : draws.batches) {
+		for (uint32_t i = batch.firstDraw; i < batch.firstDraw + batch.drawCount; i++) {
+			const VkDrawIndexedIndirectCommand &draw = draws.draws[i];
+			assert(draw.firstInstance == instances);
+
+			//every instance of a draw is the same geometry with the same material, the translation tells which item it was
+			for (uint32_t instance = draw.firstInstance; instance < draw.firstInstance + draw.instanceCount; instance++) {
+				const DrawItem &source = items[static_cast<uint32_t>(draws.transforms[instance][3].x) - 1];
+				assert(source.material == batch.material && source.vertexOffset == draw.vertexOffset);
+			}
+			instances += draw.instanceCount;
+		}
+	}
+	assert(instances == items.size());
+
+	const DrawBatch &stoneBatch = draws.batches[0].material == stone ? draws.batches[0] : draws.batches[1];
+	assert(stoneBatch.drawCount == 1 && draws.draws[stoneBatch.firstDraw].instanceCount == 3);
+
+	buildInstancedDraws(items, draws);
+	assert(draws.draws.size() == 3 && draws.transforms.size() == items.size());
+
+	std::vector<DrawItem> none;
+	buildInstancedDraws(none, draws);
+	assert(draws.draws.empty() && draws.batches.empty());
+
+	//state outranks depth, depth outranks geometry
+	uint64_t near = SortKey::make(0, VertexLayout::Full, 1, VK_INDEX_TYPE_UINT16, SortKey::depthBucket(1.0f), 500);
+	uint64_t far = SortKey::make(0, VertexLayout::Full, 1, VK_INDEX_TYPE_UINT16, SortKey::depthBucket(100.0f), 0);
+	uint64_t otherMaterial = SortKey::make(0, VertexLayout::Full, 2, VK_INDEX_TYPE_UINT16, 0, 0);
+	uint64_t quantized = SortKey::make(0, VertexLayout::Quantized, 0, VK_INDEX_TYPE_UINT16, 0, 0);
+	assert(near < far && far < otherMaterial && otherMaterial < quantized);
+	assert(SortKey::depthBucket(0.0f) == 0 && SortKey::depthBucket(1e9f) == 15);
+
+	//the radix sort is stable and agrees with std::sort on random keys
+	std::vector<InstancedDraws::SortEntry> entries, scratch;
+	uint64_t seed = 99;
+	for (uint32_t i = 0; i < 5000; i++) {
+		seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+		entries.push_back({(seed >> 20) & 0xff0000ff00ffULL, i});
+	}
+	std::vector<InstancedDraws::SortEntry> expected = entries;
+	std::stable_sort(expected.begin(), expected.end(), [](const auto &a, const auto &b) { return a.key < b.key; });
+	radixSort(entries, scratch);
+	for (uint32_t i = 0; i < entries.size(); i++) {
+		assert(entries[i].key == expected[i].key && entries[i].item == expected[i].item);
+	}
+}
+
+void Test::testFrustumCulling() {
+	//camera at the origin looking down -z
+	glm::mat4 view(1.0f);
+	glm::mat4 proj = glm::perspective(glm::radians(60.0f), 1.0f, 0.1f, 100.0f);
+	Frustum frustum = Frustum::fromMatrix(proj * view);
+
+	//scale and translation carry the bounds sphere into world space
+	Bounds bounds{};
+	bounds.center = glm::vec3(1, 0, 0);
+	bounds.radius = 1.0f;
+	glm::mat4 transform = glm::scale(glm::translate(glm::mat4(1.0f), glm::vec3(0, 0, -10)), glm::vec3(1, 3, 2));
+	glm::vec4 sphere = FrustumCulling::worldSphere(transform, bounds);
+	assert(glm::length(glm::vec3(sphere) - glm::vec3(1, 0, -10)) < 1e-5f && std::abs(sphere.w - 3.0f) < 1e-5f);
+
+	//the wide paths and the scalar tail agree with the plain sphere test, including spheres touching a plane
+	SphereBatch spheres;
+	uint64_t seed = 7;
+	auto random = [&seed](float range) {
+		seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+		return (static_cast<float>(seed >> 40) / static_cast<float>(1 << 24) - 0.5f) * range;
+	};
+	for (uint32_t i = 0; i < 1003; i++) {
+		spheres.push_back(glm::vec3(random(200.0f), random(200.0f), random(200.0f)), std::abs(random(20.0f)));
+	}
+	spheres.push_back(glm::vec3(0, 0, -100.5f), 0.5f);
+
+	std::vector<uint32_t> visible;
+	FrustumCulling::cullSpheres(frustum, spheres, visible);
+	std::vector<uint32_t> expected;
+	for (uint32_t i = 0; i < spheres.size(); i++) {
+		if (frustum.intersectsSphere(glm::vec3(spheres.x[i], spheres.y[i], spheres.z[i]), spheres.radius[i])) expected.push_back(i);
+	}
+	assert(visible == expected);
+	assert(!visible.empty() && visible.size() < spheres.size());
+
+	//indices are appended, what was already in the list stays
+	visible = {42};
+	SphereBatch behind;
+	behind.push_back(glm::vec3(0, 0, 10), 1.0f);
+	behind.push_back(glm::vec3(0, 0, -10), 1.0f);
+	FrustumCulling::cullSpheres(frustum, behind, visible);
+	assert(visible == std::vector<uint32_t>({42, 1}));
+}
+
+void Test::testOcclusionBuffer() {
+	//level 1 is a 10 by 10 wall at z -10 made of the last four vertices, the only ones the occluder keeps
+	//level 2 strays too far from the full mesh to occlude with
+	Mesh wall{};
+	for (int i = 0; i < 4; i++) wall.vertices.push_back({glm::vec3(0.0f), glm::vec3(1.0f), glm::vec2(0.0f)});
+	for (glm::vec3 corner : {glm::vec3(-5, -5, -10), glm::vec3(5, -5, -10), glm::vec3(5, 5, -10), glm::vec3(-5, 5, -10)}) {
+		wall.vertices.push_back({corner, glm::vec3(1.0f), glm::vec2(0.0f)});
+	}
+	wall.indices = {0, 1, 2, 4, 5, 6, 4, 6, 7};
+	wall.bounds = Bounds::fromVertices(wall.vertices);
+	wall.lods = {{0, 9, 0.0f}, {3, 6, 0.05f}, {0, 3, 1.0f}};
+	assert(Occluder::level(wall) == 1);
+
+	Occluder occluder = Occluder::fromMesh(wall);
+	assert(occluder.positions.size() == 4 && occluder.indices == std::vector<uint32_t>({0, 1, 2, 0, 2, 3}));
+	assert(occluder.positions[3] == glm::vec3(-5, 5, -10));
+
+	//camera at the origin looking down -z, the wall covers the middle of the view
+	glm::mat4 proj = glm::perspective(glm::radians(60.0f), 2.0f, 0.1f, 100.0f);
+	OcclusionBuffer buffer(128, 64);
+	buffer.begin(proj, 2);
+	buffer.addOccluder(1, occluder, glm::mat4(1.0f));
+	for (uint32_t tile = 0; tile < buffer.tileCount(); tile++) buffer.rasterizeTile(tile);
+	buffer.buildPyramid();
+	assert(buffer.triangleCount() == 2);
+
+	glm::vec4 wallClip = proj * glm::vec4(0, 0, -10, 1);
+	assert(std::abs(buffer.depthAt(64, 32) - wallClip.z / wallClip.w) < 1e-4f);
+	assert(buffer.depthAt(0, 0) == 1.0f && buffer.depthAt(127, 63) == 1.0f);
+
+	glm::mat4 identity(1.0f);
+	assert(!buffer.isVisible(glm::vec3(-1, -1, -21), glm::vec3(1, 1, -19), identity));
+	assert(!buffer.isVisible(glm::vec3(-4, -1, -21), glm::vec3(4, 1, -19), identity));
+	//the transform moves the same box in front of the wall
+	assert(buffer.isVisible(glm::vec3(-1, -1, -21), glm::vec3(1, 1, -19), glm::translate(identity, glm::vec3(0, 0, 15))));
+	//peeking out from behind the wall, beside it, or around the camera
+	assert(buffer.isVisible(glm::vec3(-12, -1, -21), glm::vec3(12, 1, -19), identity));
+	assert(buffer.isVisible(glm::vec3(12, -1, -21), glm::vec3(13, 1, -19), identity));
+	assert(buffer.isVisible(glm::vec3(-1, -1, -1), glm::vec3(1, 1, 1), identity));
+
+	//a floor reaching behind the camera is clipped at the near plane, every depth written stays in range
+	Occluder floor{{glm::vec3(-5, -1, -10), glm::vec3(5, -1, -10), glm::vec3(0, -1, 10)}, {0, 1, 2}};
+	buffer.begin(proj, 1);
+	buffer.addOccluder(0, floor, identity);
+	for (uint32_t tile = 0; tile < buffer.tileCount(); tile++) buffer.rasterizeTile(tile);
+	buffer.buildPyramid();
+	assert(buffer.triangleCount() >= 1);
+
+	bool drawn = false;
+	for (uint32_t y = 0; y < buffer.getHeight(); y++) {
+		for (uint32_t x = 0; x < buffer.getWidth(); x++) {
+			float depth = buffer.depthAt(x, y);
+			assert(depth >= -1e-5f && depth <= 1.0f);
+			drawn |= depth < 1.0f;
+		}
+	}
+	assert(drawn);
+	assert(buffer.isVisible(glm::vec3(-1, -1, -21), glm::vec3(1, 1, -19), identity));
+}
@@ -54,6 +54,38 @@ public:
 	static void testOnceEvent();
 	static void testLambdaPerformance();
 
+	static void testJobs();
+	static void testThreadPoolSubmit();
+	static void testThreadPoolParallelFor();
+
+	static void testResources();
+	static void testTextureMipChain();
+	static void testTextureMipFiltering();
+	static void testTextureCompression();
+	static void testPixelPool();
+	static void testGltfImport();
+	static void testVertexConversion();
+	static void testImportProfiler();
+	static void testAssetPackageRoundTrip();
+	static void testContentHash();
+	static void testAssetContentIDs();
+	static void testAssetCacheReuse();
+	static void testAssetServer();
+	static void testMeshOptimizer();
+	static void testMeshSimplifier();
+	static void testLodSelection();
+	static void testVertexQuantization();
+	static void testVertexStreams();
+	static void testMeshletBuilder();
+	static void testMeshletCulling();
+	static void testStaticBatching();
+	static void testFrameCapture();
+	static void testTlsfAllocator();
+	static void testDirtyRanges();
+	static void testDrawBatching();
+	static void testFrustumCulling();
+	static void testOcclusionBuffer();
+
 	static void testAll();
 };
 
@@ -0,0 +1,39 @@
+#include <exception>
+#include <filesystem>
+#include <iostream>
+
+#include "Source/Resources/AssetPackage.hpp"
+#include "Source/Resources/Loader.hpp"
+
+///Imports a source model and writes it out as a cooked .skpkg package
+///Optionally writes a JSON report of the import stages and counters, and a Chrome trace of the stages
+int main(int argc, char **argv) {
+	if (argc < 3 || argc > 5) {
+		std::cout << "Usage: SkadiCook <source model> <output .skpkg> [report .json] [trace .json]\n";
+		return 1;
+	}
+
+	std::filesystem::path sourcePath = argv[1];
+	std::filesystem::path packagePath = argv[2];
+
+	try {
+		Loader loader;
+		ImportProfiler profiler(sourcePath.string());
+		auto [meshes, materials] = loader.loadModels(sourcePath, {}, &profiler);
+
+		if (argc >= 4) profiler.writeReport(argv[3]);
+		if (argc >= 5) profiler.writeTrace(argv[4]);
+
+		if (meshes.empty()) {
+			std::cout << "SKADI: Nothing to cook in " << sourcePath << "\n";
+			return 1;
+		}
+
+		AssetPackage::write(packagePath, meshes, materials);
+	} catch (const std::exception &e) {
+		std::cerr << e.what() << std::endl;
+		return 1;
+	}
+
+	return 0;
+}
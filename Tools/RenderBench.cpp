@@ -0,0 +1,116 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <exception>
+#include <filesystem>
+#include <iostream>
+#include <limits>
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "Source/Graphics/Rend.hpp"
+#include "Source/Resources/Loader.hpp"
+
+//software rasterizers are deterministic, the slack covers small driver differences in filtering and resolve
+const uint8_t channelTolerance = 8;
+const double maxDifferingFraction = 0.001;
+
+///Renders a model headless for a fixed number of frames and prints frame times
+///Optionally writes the last frame as a PPM and compares it against a reference, failing when they differ
+///Runs without a GPU or display on lavapipe, e.g. VK_ICD_FILENAMES=/usr/share/vulkan/icd.d/lvp_icd.x86_64.json
+int main(int argc, char **argv) {
+	if (argc < 4 || argc > 6) {
+		std::cout << "Usage: SkadiBench <model> <shader directory> <frames> [capture .ppm] [reference .ppm]\n";
+		return 1;
+	}
+
+	std::filesystem::path modelPath = argv[1];
+	uint32_t frameCount = std::max(1l, std::strtol(argv[3], nullptr, 10));
+
+	try {
+		Loader loader;
+		auto [meshes, materials] = loader.loadModels(modelPath);
+
+		if (meshes.empty()) {
+			std::cout << "SKADI: Nothing to render in " << modelPath << "\n";
+			return 1;
+		}
+
+		Rend::Settings settings{};
+		settings.headless = true;
+		settings.shaderDirectory = argv[2];
+		Rend rend(settings);
+		rend.initVulkan();
+
+		//frame the whole model from +z so the same model always gives the same picture
+		glm::vec3 min(std::numeric_limits<float>::max());
+		glm::vec3 max(std::numeric_limits<float>::lowest());
+		for (const Mesh &mesh : meshes) {
+			for (int corner = 0; corner < 8; corner++) {
+				glm::vec3 local(corner & 1 ? mesh.bounds.max.x : mesh.bounds.min.x, corner & 2 ? mesh.bounds.max.y : mesh.bounds.min.y, corner & 4 ? mesh.bounds.max.z : mesh.bounds.min.z);
+				glm::vec3 world = glm::vec3(mesh.transform * glm::vec4(local, 1.0f));
+				min = glm::min(min, world);
+				max = glm::max(max, world);
+			}
+		}
+
+		glm::vec3 center = (min + max) * 0.5f;
+		float radius = std::max(glm::length(max - min) * 0.5f, 0.01f);
+		rend.camera.setNearFar(radius * 0.01f, radius * 10.0f);
+		rend.camera.setTransform(glm::translate(glm::mat4(1.0f), center + glm::vec3(0.0f, 0.0f, radius * 3.0f)));
+
+		for (Material &material : materials) {
+			rend.registerMaterial(material);
+		}
+		for (const Mesh &mesh : meshes) {
+			rend.renderMesh(mesh);
+		}
+
+		Rend::FrameStats stats = rend.renderFrames(frameCount);
+		std::cout << "Frames: " << stats.frames << "\n";
+		std::cout << "Total ms: " << stats.totalMillis << "\n";
+		std::cout << "Average ms: " << stats.totalMillis / stats.frames << "\n";
+		std::cout << "Median ms: " << stats.medianMillis << "\n";
+		std::cout << "Min ms: " << stats.minMillis << "\n";
+		std::cout << "Max ms: " << stats.maxMillis << "\n";
+		std::cout << "Culling: " << stats.visibleMeshes << " of " << stats.meshes << " meshes in view, " << stats.occludedMeshes << " of them behind " << stats.occluderTriangles << " occluder triangles\n";
+		std::cout << "Draws: " << stats.drawItems << " mesh ranges in " << stats.draws << " instanced draws, " << stats.batches << " batches, recorded in " << stats.recordChunks << " chunks\n";
+
+		DeviceAllocator::Stats memoryStats = rend.resourceManager->getMemoryStats();
+		std::cout << "Device memory objects: " << memoryStats.deviceMemoryObjects << "\n";
+		for (uint32_t heap = 0; heap < memoryStats.heaps.size(); heap++) {
+			const DeviceAllocator::HeapStats &heapStats = memoryStats.heaps[heap];
+			if (!heapStats.reservedBytes) continue;
+			std::cout << "Heap " << heap << ": " << heapStats.usedBytes << " of " << heapStats.reservedBytes << " bytes used in " << heapStats.pages << " pages, "
+				<< heapStats.allocations << " allocations (" << heapStats.dedicatedAllocations << " dedicated)\n";
+		}
+
+		UploadQueue::Stats uploadStats = rend.getUploadStats();
+		std::cout << "Uploads: " << uploadStats.stagedBytes << " bytes in " << uploadStats.submittedBatches << " batches, "
+			<< uploadStats.ringStalls << " ring stalls, " << uploadStats.oversizedUploads << " oversized\n";
+
+		int result = 0;
+		if (argc >= 5) {
+			FrameCapture capture = rend.captureFrame();
+			capture.writePPM(argv[4]);
+
+			if (argc >= 6) {
+				FrameCapture reference = FrameCapture::readPPM(argv[5]);
+				FrameCapture::Difference difference = capture.compare(reference, channelTolerance);
+				double differingFraction = static_cast<double>(difference.differingPixels) / (static_cast<double>(capture.width) * capture.height);
+
+				std::cout << "Differing pixels: " << difference.differingPixels << " (max channel difference " << static_cast<int>(difference.maxChannelDifference) << ")\n";
+				if (differingFraction > maxDifferingFraction) {
+					std::cout << "SKADI: Capture does not match " << argv[5] << "\n";
+					result = 1;
+				}
+			}
+		}
+
+		rend.shutdown();
+		return result;
+	} catch (const std::exception &e) {
+		std::cerr << e.what() << std::endl;
+		return 1;
+	}
+}